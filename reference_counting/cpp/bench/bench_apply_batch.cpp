@@ -0,0 +1,280 @@
+/**
+ * Бенчмарк пакетного выполнения операций RCHeap::apply_batch().
+ *
+ * Генерирует трассу с высокой текучестью ссылок поверх набора долгоживущих
+ * корней:
+ *   - add_ref(a, b), которому через несколько операций отвечает remove_ref(a, b);
+ *   - серии ссылок на один «горячий» объект;
+ *   - короткоживущие цепочки: allocate, add_ref, снятие ссылки с каскадом.
+ * Сравнивает последовательный apply() и apply_batch() пачками по B операций
+ * с логом в файл (JSON-строки) и без лога. Проверяет, что итоговое состояние
+ * кучи совпадает в обоих режимах освобождения (Eager и Deferred).
+ *
+ * Сборка (из каталога cpp/):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target bench_apply_batch
+ * Запуск:
+ *   build/bench_apply_batch [ops] [batch] [dir]   (по умолчанию 2000000, 256 и /tmp)
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "event_logger.h"
+#include "rc_heap.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const int kLongLived = 4096;
+
+    struct Pending
+    {
+        size_t at;      ///< Номер операции, после которой снять ссылку
+        ScenarioOp op;
+
+        bool operator>(const Pending &other) const { return at > other.at; }
+    };
+
+    /**
+     * Трасса: kLongLived корней, затем churn-операции до ops штук
+     */
+    std::vector<ScenarioOp> generate(size_t ops, unsigned seed)
+    {
+        std::mt19937 rng(seed);
+        std::vector<ScenarioOp> trace;
+        trace.reserve(ops + 64);
+        for (int id = 1; id <= kLongLived; ++id)
+        {
+            trace.emplace_back(OpCode::Allocate, id);
+            trace.emplace_back(OpCode::AddRoot, id);
+        }
+
+        std::set<std::pair<int, int>> edges;
+        std::vector<Pending> pending; // min-куча по at
+        int next_temp = kLongLived + 1;
+        auto schedule = [&](size_t delay, const ScenarioOp &op)
+        {
+            pending.push_back({trace.size() + delay, op});
+            std::push_heap(pending.begin(), pending.end(), std::greater<Pending>());
+        };
+        auto add_ref = [&](int from, int to, size_t delay)
+        {
+            if (from != to && edges.insert({from, to}).second)
+            {
+                trace.emplace_back(OpCode::AddRef, -1, from, to);
+                schedule(delay, ScenarioOp(OpCode::RemoveRef, -1, from, to));
+            }
+        };
+        auto long_lived = [&]()
+        { return 1 + static_cast<int>(rng() % kLongLived); };
+
+        while (trace.size() < ops)
+        {
+            while (!pending.empty() && pending.front().at <= trace.size())
+            {
+                std::pop_heap(pending.begin(), pending.end(), std::greater<Pending>());
+                const ScenarioOp &op = pending.back().op;
+                if (op.op == OpCode::RemoveRef)
+                {
+                    edges.erase({op.from, op.to});
+                }
+                trace.push_back(op);
+                pending.pop_back();
+            }
+
+            unsigned kind = rng() % 10;
+            if (kind < 6)
+            {
+                add_ref(long_lived(), long_lived(), 1 + rng() % 32);
+            }
+            else if (kind < 8)
+            {
+                int hot = long_lived();
+                for (int k = 0; k < 4; ++k)
+                {
+                    add_ref(long_lived(), hot, 1 + rng() % 64);
+                }
+            }
+            else
+            {
+                // Цепочка из трёх временных объектов умрёт каскадом при снятии ссылки
+                int owner = long_lived();
+                int head = next_temp;
+                for (int k = 0; k < 3; ++k)
+                {
+                    trace.emplace_back(OpCode::Allocate, next_temp);
+                    if (k == 0)
+                    {
+                        edges.insert({owner, head});
+                        trace.emplace_back(OpCode::AddRef, -1, owner, head);
+                    }
+                    else
+                    {
+                        trace.emplace_back(OpCode::AddRef, -1, next_temp - 1, next_temp);
+                    }
+                    next_temp++;
+                }
+                schedule(1 + rng() % 16, ScenarioOp(OpCode::RemoveRef, -1, owner, head));
+            }
+        }
+        return trace;
+    }
+
+    /**
+     * Состояние кучи как текст dump_state(); корни отсортированы, т.к. порядок
+     * обхода unordered_set зависит от истории вставок
+     */
+    std::string fingerprint(const RCHeap &heap)
+    {
+        std::ostringstream captured;
+        std::streambuf *saved = std::cout.rdbuf(captured.rdbuf());
+        heap.dump_state();
+        std::cout.rdbuf(saved);
+
+        std::string text = captured.str();
+        size_t roots_begin = text.find("ROOTS: ");
+        size_t roots_end = text.find('\n', roots_begin);
+        std::istringstream roots_line(text.substr(roots_begin + 7, roots_end - roots_begin - 7));
+        std::vector<std::string> roots;
+        std::string token;
+        while (roots_line >> token)
+        {
+            roots.push_back(token);
+        }
+        std::sort(roots.begin(), roots.end());
+        std::string sorted;
+        for (const std::string &root : roots)
+        {
+            sorted += root + " ";
+        }
+        return text.substr(0, roots_begin + 7) + sorted + text.substr(roots_end);
+    }
+
+    void run_sequential(RCHeap &heap, const std::vector<ScenarioOp> &trace)
+    {
+        for (const ScenarioOp &op : trace)
+        {
+            heap.apply(op);
+        }
+    }
+
+    void run_batched(RCHeap &heap, const std::vector<ScenarioOp> &trace, size_t batch)
+    {
+        for (size_t i = 0; i < trace.size(); i += batch)
+        {
+            heap.apply_batch(trace.data() + i, std::min(batch, trace.size() - i));
+        }
+    }
+
+    bool same_state(const std::vector<ScenarioOp> &trace, size_t batch, bool deferred)
+    {
+        EventLogger logger{std::unique_ptr<LogSink>(new NullLogSink())};
+        RCHeap sequential(logger);
+        RCHeap batched(logger);
+        sequential.set_deferred(deferred);
+        batched.set_deferred(deferred);
+        run_sequential(sequential, trace);
+        run_batched(batched, trace, batch);
+        if (deferred)
+        {
+            sequential.collect();
+            batched.collect();
+        }
+        return fingerprint(sequential) == fingerprint(batched);
+    }
+
+    double seconds_since(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    /**
+     * Время выполнения трассы; batch == 0 — последовательный apply()
+     */
+    double measure(const std::vector<ScenarioOp> &trace, size_t batch, const std::string &log_path)
+    {
+        std::unique_ptr<LogSink> sink;
+        if (log_path.empty())
+        {
+            sink.reset(new NullLogSink());
+        }
+        else
+        {
+            sink.reset(new JsonLinesSink(log_path));
+        }
+        EventLogger logger{std::move(sink)};
+        RCHeap heap(logger);
+        auto start = Clock::now();
+        if (batch == 0)
+        {
+            run_sequential(heap, trace);
+        }
+        else
+        {
+            run_batched(heap, trace, batch);
+        }
+        return seconds_since(start);
+    }
+
+    size_t file_size(const std::string &path)
+    {
+        std::FILE *file = std::fopen(path.c_str(), "rb");
+        if (file == nullptr)
+        {
+            return 0;
+        }
+        std::fseek(file, 0, SEEK_END);
+        long size = std::ftell(file);
+        std::fclose(file);
+        return static_cast<size_t>(size);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t ops = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+    size_t batch = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 256;
+    std::string dir = argc > 3 ? argv[3] : "/tmp";
+    const std::string log_path = dir + "/bench_apply_batch.log";
+    batch = std::max<size_t>(batch, 1);
+
+    // Проверка эквивалентности на нескольких трассах и размерах пачек
+    bool ok = true;
+    for (unsigned seed = 1; seed <= 4; ++seed)
+    {
+        std::vector<ScenarioOp> trace = generate(50000, seed);
+        for (size_t size : {size_t(1), size_t(7), size_t(64), batch, trace.size()})
+        {
+            ok = same_state(trace, size, false) && same_state(trace, size, true) && ok;
+        }
+    }
+    std::printf("final state matches sequential apply: %s\n", ok ? "ok" : "MISMATCH");
+
+    std::vector<ScenarioOp> trace = generate(ops, 42);
+    std::printf("trace: %zu ops, batch %zu\n", trace.size(), batch);
+
+    double seq_null = measure(trace, 0, "");
+    double batch_null = measure(trace, batch, "");
+    std::printf("no log    | sequential %12.0f ops/s | batch %12.0f ops/s | x%.2f\n", trace.size() / seq_null,
+                trace.size() / batch_null, seq_null / batch_null);
+
+    double seq_log = measure(trace, 0, log_path);
+    size_t seq_bytes = file_size(log_path);
+    double batch_log = measure(trace, batch, log_path);
+    size_t batch_bytes = file_size(log_path);
+    std::printf("json log  | sequential %12.0f ops/s | batch %12.0f ops/s | x%.2f\n", trace.size() / seq_log,
+                trace.size() / batch_log, seq_log / batch_log);
+    std::printf("log size  | sequential %9.1f MB    | batch %9.1f MB\n", seq_bytes / 1e6, batch_bytes / 1e6);
+    std::remove(log_path.c_str());
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+/**
+ * Бенчмарк пропускной способности мутатора при разных режимах логирования.
+ *
+ * Нагрузка: мутатор строит под корнем 0 цепочки по chain объектов и сразу
+ * отпускает их (allocate + add_ref на объект, затем каскад delete), пока не
+ * будет создано objects объектов. Сравниваются: логирование выключено
+ * (NullLogSink), синхронные JsonLines/Binary и AsyncLogSink поверх них с
+ * разными политиками переполнения. Для асинхронных режимов время включает
+ * ожидание sync() в конце — то есть все события действительно записаны.
+ *
+ * Сборка (из каталога cpp/):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target bench_async_logging
+ * Запуск:
+ *   build/bench_async_logging [objects] [chain] [dir]   (по умолчанию 2000000, 64, /tmp)
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "rc_heap.h"
+#include "event_logger.h"
+#include "async_log_sink.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    void mutate(RCHeap &heap, int objects, int chain)
+    {
+        heap.allocate(0);
+        heap.add_root(0);
+        int next_id = 1;
+        while (next_id < objects)
+        {
+            int head = next_id;
+            int prev = 0;
+            for (int k = 0; k < chain && next_id < objects; ++k)
+            {
+                heap.allocate(next_id);
+                heap.add_ref(prev, next_id);
+                prev = next_id++;
+            }
+            heap.remove_ref(0, head);
+        }
+    }
+
+    void run(const char *name, const std::function<std::unique_ptr<LogSink>()> &make_sink,
+             int objects, int chain)
+    {
+        std::unique_ptr<LogSink> sink = make_sink();
+        AsyncLogSink *async = dynamic_cast<AsyncLogSink *>(sink.get());
+        EventLogger logger(std::move(sink));
+        RCHeap heap(logger);
+        heap.reserve(static_cast<size_t>(chain) + 1);
+
+        auto start = Clock::now();
+        mutate(heap, objects, chain);
+        double mutator_sec = std::chrono::duration<double>(Clock::now() - start).count();
+        logger.sync();
+        double total_sec = std::chrono::duration<double>(Clock::now() - start).count();
+
+        uint64_t events = logger.get_event_count();
+        std::printf("%-22s | %9.2f M ops/s | mutator %6.3f s | +sync %6.3f s | %10llu events",
+                    name, (3.0 * objects) / mutator_sec / 1e6, mutator_sec, total_sec,
+                    static_cast<unsigned long long>(events));
+        if (async != nullptr)
+        {
+            std::printf(" | dropped %llu | overflowed %llu",
+                        static_cast<unsigned long long>(async->get_dropped()),
+                        static_cast<unsigned long long>(async->get_overflowed()));
+        }
+        std::printf("\n");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int objects = argc > 1 ? std::atoi(argv[1]) : 2000000;
+    int chain = argc > 2 ? std::atoi(argv[2]) : 64;
+    std::string dir = argc > 3 ? argv[3] : "/tmp";
+    std::string json_path = dir + "/bench_async.log";
+    std::string bin_path = dir + "/bench_async.bin";
+
+    std::printf("objects=%d chain=%d (ops = allocate + add_ref + delete per object)\n", objects, chain);
+
+    run("off", []
+        { return std::unique_ptr<LogSink>(new NullLogSink()); }, objects, chain);
+    run("json sync", [&]
+        { return std::unique_ptr<LogSink>(new JsonLinesSink(json_path)); }, objects, chain);
+    run("binary sync", [&]
+        { return std::unique_ptr<LogSink>(new BinaryLogSink(bin_path)); }, objects, chain);
+
+    auto async = [&](const std::string &path, bool binary, size_t capacity, OverflowPolicy policy)
+    {
+        return [=]
+        {
+            std::unique_ptr<LogSink> inner;
+            if (binary)
+            {
+                inner.reset(new BinaryLogSink(path));
+            }
+            else
+            {
+                inner.reset(new JsonLinesSink(path));
+            }
+            return std::unique_ptr<LogSink>(new AsyncLogSink(std::move(inner), capacity, policy));
+        };
+    };
+
+    run("json async block", async(json_path, false, 1 << 16, OverflowPolicy::Block), objects, chain);
+    run("json async drop", async(json_path, false, 1 << 16, OverflowPolicy::Drop), objects, chain);
+    run("json async grow", async(json_path, false, 1 << 16, OverflowPolicy::Grow), objects, chain);
+    run("binary async block", async(bin_path, true, 1 << 16, OverflowPolicy::Block), objects, chain);
+    run("binary async drop", async(bin_path, true, 1 << 16, OverflowPolicy::Drop), objects, chain);
+    run("binary async grow", async(bin_path, true, 1 << 16, OverflowPolicy::Grow), objects, chain);
+    return 0;
+}
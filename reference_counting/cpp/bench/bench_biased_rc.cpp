@@ -0,0 +1,197 @@
+/**
+ * Бенчмарк смещённого подсчёта ссылок (CountMode::Biased) против обычных
+ * атомарных счётчиков (CountMode::Atomic).
+ *
+ * 1. Счётчик отдельно: каждый поток увеличивает и уменьшает счётчики своих
+ *    объектов — BiasedRefCount владельца против std::atomic<int> с fetch_add.
+ * 2. Куча целиком: каждый поток держит корень-якорь и набор «горячих»
+ *    объектов, которые сам создал, и гоняет add_ref/remove_ref от якоря
+ *    к ним. Доля cross_percent операций идёт к общим объектам, созданным
+ *    главным потоком, — для них поток чужой, и счётчик меняется атомарно.
+ *    После прогона куча разбирается, и проверяется, что она пуста.
+ *
+ * Число потоков: 1, 4, 16. На машине с меньшим числом ядер потоки
+ * вытесняют друг друга, и масштабирование не показательно, но стоимость
+ * атомарных RMW против обычных записей видна и на одном ядре.
+ *
+ * Сборка (из каталога cpp/):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target bench_biased_rc
+ * Запуск:
+ *   build/bench_biased_rc [ops_per_thread] [cross_percent]
+ */
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "biased_ref_count.h"
+#include "concurrent_rc_heap.h"
+#include "event_logger.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const int kHotObjects = 64;    ///< «Горячих» объектов на поток
+    const int kSharedObjects = 16; ///< Общих объектов главного потока
+    const int kThreadStride = 1 << 16;
+
+    template <typename Fn>
+    void run_threads(unsigned threads, Fn &&body)
+    {
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < threads; ++t)
+        {
+            workers.emplace_back(body, t);
+        }
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    /**
+     * Счётчики на отдельных кеш-линиях, чтобы мерить RMW, а не ложное разделение
+     */
+    struct alignas(64) PaddedAtomic
+    {
+        std::atomic<int> value{1};
+    };
+
+    struct alignas(64) PaddedBiased
+    {
+        BiasedRefCount value;
+    };
+
+    double counter_atomic(unsigned threads, int ops_per_thread)
+    {
+        std::vector<PaddedAtomic> counters(threads);
+        auto start = Clock::now();
+        run_threads(threads, [&](unsigned t)
+                    {
+                        std::atomic<int> &counter = counters[t].value;
+                        for (int i = 0; i < ops_per_thread; i += 2)
+                        {
+                            counter.fetch_add(1, std::memory_order_acq_rel);
+                            counter.fetch_sub(1, std::memory_order_acq_rel);
+                        } });
+        double sec = std::chrono::duration<double>(Clock::now() - start).count();
+        return static_cast<double>(threads) * ops_per_thread / sec / 1e6;
+    }
+
+    double counter_biased(unsigned threads, int ops_per_thread)
+    {
+        std::vector<PaddedBiased> counters(threads);
+        auto start = Clock::now();
+        run_threads(threads, [&](unsigned t)
+                    {
+                        BiasedRefCount &counter = counters[t].value;
+                        const uint32_t self = t + 1;
+                        int count;
+                        counter.init(self, true);
+                        counter.increment(self, count); // держим 1, чтобы не сливать на каждом шаге
+                        for (int i = 0; i < ops_per_thread; i += 2)
+                        {
+                            counter.increment(self, count);
+                            counter.decrement(self, count);
+                        } });
+        double sec = std::chrono::duration<double>(Clock::now() - start).count();
+        return static_cast<double>(threads) * ops_per_thread / sec / 1e6;
+    }
+
+    /**
+     * @param ok Сбрасывается в false, если после разбора куча не пуста
+     */
+    double heap_workload(CountMode mode, unsigned threads, int ops_per_thread, int cross_percent, bool &ok)
+    {
+        EventLogger logger{std::unique_ptr<LogSink>(new NullLogSink())};
+        ConcurrentRCHeap heap(logger, 64, mode);
+
+        // Общие объекты создаёт главный поток: для рабочих потоков они чужие
+        for (int k = 1; k <= kSharedObjects; ++k)
+        {
+            heap.allocate(k);
+            heap.add_root(k);
+        }
+
+        auto start = Clock::now();
+        run_threads(threads, [&](unsigned t)
+                    {
+                        const int anchor = static_cast<int>(t + 1) * kThreadStride;
+                        heap.allocate(anchor);
+                        heap.add_root(anchor);
+                        for (int k = 1; k <= kHotObjects; ++k)
+                        {
+                            // Горячий объект держится ссылкой от якоря и живёт весь прогон
+                            heap.allocate(anchor + k);
+                            heap.add_ref(anchor, anchor + k);
+                        }
+
+                        std::mt19937 rng(7 + t);
+                        std::uniform_int_distribution<int> percent(0, 99);
+                        std::uniform_int_distribution<int> hot(1, kHotObjects);
+                        std::uniform_int_distribution<int> shared(1, kSharedObjects);
+                        for (int i = 0; i < ops_per_thread; i += 2)
+                        {
+                            // Лишняя ссылка от соседнего горячего объекта: +1 и -1 к счётчику цели
+                            int from = anchor + hot(rng);
+                            int to = percent(rng) < cross_percent ? shared(rng) : anchor + hot(rng);
+                            if (heap.add_ref(from, to))
+                            {
+                                heap.remove_ref(from, to);
+                            }
+                        }
+
+                        heap.remove_root(anchor);
+                        heap.merge_pending(); });
+        double sec = std::chrono::duration<double>(Clock::now() - start).count();
+
+        for (int k = 1; k <= kSharedObjects; ++k)
+        {
+            heap.remove_root(k);
+        }
+        heap.settle();
+        if (heap.get_heap_size() != 0)
+        {
+            std::printf("  %s, %u threads: %zu objects survived\n",
+                        mode == CountMode::Biased ? "biased" : "atomic", threads, heap.get_heap_size());
+            ok = false;
+        }
+        return static_cast<double>(threads) * ops_per_thread / sec / 1e6;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int ops = argc > 1 ? std::atoi(argv[1]) : 2000000;
+    int cross_percent = argc > 2 ? std::atoi(argv[2]) : 5;
+    const unsigned thread_counts[] = {1, 4, 16};
+    bool ok = true;
+
+    std::printf("counter only, M ops/s\n");
+    std::printf("%7s | %14s | %14s | %7s\n", "threads", "atomic", "biased", "speedup");
+    for (unsigned threads : thread_counts)
+    {
+        double atomic_mops = counter_atomic(threads, ops * 10);
+        double biased_mops = counter_biased(threads, ops * 10);
+        std::printf("%7u | %14.2f | %14.2f | %6.2fx\n", threads, atomic_mops, biased_mops,
+                    biased_mops / atomic_mops);
+    }
+
+    std::printf("\nConcurrentRCHeap, %d%% cross-thread targets, M ops/s\n", cross_percent);
+    std::printf("%7s | %14s | %14s | %7s\n", "threads", "atomic", "biased", "speedup");
+    for (unsigned threads : thread_counts)
+    {
+        double atomic_mops = heap_workload(CountMode::Atomic, threads, ops, cross_percent, ok);
+        double biased_mops = heap_workload(CountMode::Biased, threads, ops, cross_percent, ok);
+        std::printf("%7u | %14.2f | %14.2f | %6.2fx\n", threads, atomic_mops, biased_mops,
+                    biased_mops / atomic_mops);
+    }
+
+    std::printf("\nheap drained after every run: %s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,253 @@
+/**
+ * Бенчмарк бинарной трассы против JSON-сценария.
+ *
+ * Генерирует сценарий из N операций (цепочки по 16 объектов с каскадом,
+ * как bench_scenario_replay) в трёх форматах: JSON, бинарная трасса
+ * с упакованными записями и с varint-разностями. Измеряет:
+ *   1. только декодирование операций (ops/s);
+ *   2. выполнение на RCHeap (replay) — здесь предел задаёт сама куча.
+ * Проверяет, что все три формата дают одинаковую последовательность операций
+ * и что трасса, обрезанная на границе записи, отвергается (op_count заголовка).
+ *
+ * Сборка (из каталога cpp/):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target bench_binary_trace
+ * Запуск:
+ *   build/bench_binary_trace [ops] [dir]   (по умолчанию 5000000 и /tmp)
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "binary_trace.h"
+#include "event_logger.h"
+#include "rc_heap.h"
+#include "scenario_reader.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const int kChain = 16;
+
+    /**
+     * Вызывает fn для каждой операции сценария; блок — цепочка с каскадом
+     */
+    template <typename Fn>
+    size_t generate(size_t ops, Fn &&fn)
+    {
+        size_t written = 0;
+        auto emit = [&](OpCode code, int a, int b)
+        {
+            fn(code == OpCode::AddRef ? ScenarioOp(code, -1, a, b) : ScenarioOp(code, a));
+            written++;
+        };
+        int base = 1;
+        while (written + 2 * kChain + 1 <= ops)
+        {
+            emit(OpCode::Allocate, base, 0);
+            emit(OpCode::AddRoot, base, 0);
+            for (int k = 1; k < kChain; ++k)
+            {
+                emit(OpCode::Allocate, base + k, 0);
+                emit(OpCode::AddRef, base + k - 1, base + k);
+            }
+            emit(OpCode::RemoveRoot, base, 0);
+            // ID блоков сдвигаются по кругу, чтобы трасса трогала разные слоты
+            base = base + kChain < 1000000 ? base + kChain : 1;
+        }
+        return written;
+    }
+
+    void write_json(std::FILE *out, const ScenarioOp &op, bool first)
+    {
+        std::fputs(first ? "[\n  " : ",\n  ", out);
+        if (op.op == OpCode::AddRef || op.op == OpCode::RemoveRef)
+        {
+            std::fprintf(out, "{\"op\": \"%s\", \"from\": %d, \"to\": %d}", op_code_name(op.op), op.from, op.to);
+        }
+        else
+        {
+            std::fprintf(out, "{\"op\": \"%s\", \"id\": %d}", op_code_name(op.op), op.id);
+        }
+    }
+
+    uint64_t fold(uint64_t hash, const ScenarioOp &op)
+    {
+        uint64_t value = static_cast<uint64_t>(op.op) ^ static_cast<uint64_t>(static_cast<uint32_t>(op.id)) << 8 ^
+                         static_cast<uint64_t>(static_cast<uint32_t>(op.from)) << 24 ^
+                         static_cast<uint64_t>(static_cast<uint32_t>(op.to)) << 40;
+        return (hash ^ value) * 0x100000001B3ull;
+    }
+
+    double seconds_since(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    size_t file_size(const std::string &path)
+    {
+        std::FILE *file = std::fopen(path.c_str(), "rb");
+        if (file == nullptr)
+        {
+            return 0;
+        }
+        std::fseek(file, 0, SEEK_END);
+        long size = std::ftell(file);
+        std::fclose(file);
+        return static_cast<size_t>(size);
+    }
+
+    void print_decode(const char *name, const std::string &path, size_t ops, double sec)
+    {
+        std::printf("decode %-8s | %7.1f MB | %12.0f ops/s\n", name, file_size(path) / 1e6, ops / sec);
+    }
+
+    /**
+     * Декодирование бинарной трассы; проходов несколько, чтобы мерить не только запуск
+     */
+    double decode_binary(const std::string &path, uint64_t &hash)
+    {
+        BinaryTraceReader reader(path);
+        ScenarioOp op;
+        const int passes = 5;
+        auto start = Clock::now();
+        for (int pass = 0; pass < passes; ++pass)
+        {
+            reader.rewind();
+            hash = 0xCBF29CE484222325ull;
+            while (reader.next(op))
+            {
+                hash = fold(hash, op);
+            }
+        }
+        return seconds_since(start) / passes;
+    }
+
+    /**
+     * Трасса, обрезанная до bytes байт (на границе записи), должна
+     * отвергаться: заголовок обещает больше операций, чем в ней есть
+     */
+    bool truncation_detected(const std::string &path, size_t bytes)
+    {
+        const std::string cut_path = path + ".cut";
+        std::vector<char> head(bytes);
+        std::FILE *in = std::fopen(path.c_str(), "rb");
+        std::FILE *out = std::fopen(cut_path.c_str(), "wb");
+        bool copied = in != nullptr && out != nullptr && std::fread(head.data(), 1, bytes, in) == bytes &&
+                      std::fwrite(head.data(), 1, bytes, out) == bytes;
+        if (in != nullptr)
+        {
+            std::fclose(in);
+        }
+        if (out != nullptr)
+        {
+            std::fclose(out);
+        }
+
+        bool detected = false;
+        try
+        {
+            BinaryTraceReader reader(cut_path);
+            ScenarioOp op;
+            while (reader.next(op))
+            {
+            }
+        }
+        catch (const std::runtime_error &)
+        {
+            detected = true;
+        }
+        std::remove(cut_path.c_str());
+        return copied && detected;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t ops = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 5000000;
+    std::string dir = argc > 2 ? argv[2] : "/tmp";
+    const std::string json_path = dir + "/bench_trace.json";
+    const std::string fixed_path = dir + "/bench_trace.rctr";
+    const std::string varint_path = dir + "/bench_trace_varint.rctr";
+
+    size_t generated;
+    {
+        std::FILE *json = std::fopen(json_path.c_str(), "w");
+        if (json == nullptr)
+        {
+            std::perror(json_path.c_str());
+            return 1;
+        }
+        BinaryTraceWriter fixed(fixed_path);
+        BinaryTraceWriter varint(varint_path, true);
+        bool first = true;
+        generated = generate(ops, [&](const ScenarioOp &op)
+                             {
+                                 write_json(json, op, first);
+                                 first = false;
+                                 fixed.write(op);
+                                 varint.write(op); });
+        std::fputs("\n]\n", json);
+        std::fclose(json);
+    }
+
+    // 1. Только декодирование
+    uint64_t json_hash = 0xCBF29CE484222325ull;
+    auto start = Clock::now();
+    {
+        ScenarioReader reader(json_path);
+        ScenarioOp op;
+        while (reader.next(op))
+        {
+            json_hash = fold(json_hash, op);
+        }
+    }
+    double json_sec = seconds_since(start);
+    print_decode("json", json_path, generated, json_sec);
+
+    uint64_t fixed_hash, varint_hash;
+    double fixed_sec = decode_binary(fixed_path, fixed_hash);
+    print_decode("binary", fixed_path, generated, fixed_sec);
+    double varint_sec = decode_binary(varint_path, varint_hash);
+    print_decode("varint", varint_path, generated, varint_sec);
+    std::printf("decode speedup vs json: binary x%.1f, varint x%.1f\n", json_sec / fixed_sec,
+                json_sec / varint_sec);
+
+    // 2. Выполнение на куче
+    EventLogger logger{std::unique_ptr<LogSink>(new NullLogSink())};
+    double replay_json, replay_fixed;
+    {
+        RCHeap heap(logger);
+        ScenarioReader reader(json_path);
+        start = Clock::now();
+        heap.replay(reader);
+        replay_json = seconds_since(start);
+    }
+    {
+        RCHeap heap(logger);
+        BinaryTraceReader reader(fixed_path);
+        start = Clock::now();
+        heap.replay(reader);
+        replay_fixed = seconds_since(start);
+    }
+    std::printf("replay json    | %12.0f ops/s\n", generated / replay_json);
+    std::printf("replay binary  | %12.0f ops/s | x%.1f\n", generated / replay_fixed, replay_json / replay_fixed);
+
+    bool ok = json_hash == fixed_hash && json_hash == varint_hash;
+    std::printf("same ops in all formats: %s\n", ok ? "ok" : "MISMATCH");
+
+    // 3. Трасса, обрезанная на границе записи, не читается как более короткая
+    bool truncated = truncation_detected(fixed_path, kTraceHeaderSize + kTraceRecordSize * (generated / 2)) &&
+                     truncation_detected(fixed_path, kTraceHeaderSize) &&
+                     truncation_detected(varint_path, kTraceHeaderSize);
+    std::printf("truncated traces rejected: %s\n", truncated ? "ok" : "MISMATCH");
+    ok = ok && truncated;
+    std::remove(json_path.c_str());
+    std::remove(fixed_path.c_str());
+    std::remove(varint_path.c_str());
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+/**
+ * Бенчмарк каскадного удаления: освобождение длинной цепочки 1 -> 2 -> ... -> N.
+ *
+ * Для каждой длины цепочки строит её через RCHeap, затем удаляет корневую
+ * ссылку и измеряет время каскада и количество выделений памяти во время него.
+ * Рекурсивная версия переполняла стек уже на ~10^5 звеньев.
+ *
+ * Сборка (из каталога cpp/):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target bench_cascade
+ * Запуск:
+ *   build/bench_cascade [max_chain_length]   (по умолчанию 10000000)
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "rc_heap.h"
+#include "event_logger.h"
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+namespace
+{
+    size_t g_alloc_calls = 0;
+}
+
+void *operator new(size_t size)
+{
+    void *ptr = std::malloc(size);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    g_alloc_calls++;
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    void run_chain(EventLogger &logger, int length)
+    {
+        RCHeap heap(logger);
+
+        // Объект 0 — владелец цепочки, объекты 1..length — звенья
+        for (int id = 0; id <= length; ++id)
+        {
+            heap.allocate(id);
+        }
+        for (int id = 0; id < length; ++id)
+        {
+            heap.add_ref(id, id + 1);
+        }
+
+        size_t allocs_before = g_alloc_calls;
+        auto start = Clock::now();
+        heap.remove_ref(0, 1);
+        double sec = std::chrono::duration<double>(Clock::now() - start).count();
+        size_t allocs = g_alloc_calls - allocs_before;
+
+        std::printf("chain %10d | cascade %8.3f s | %7.1f ns/object | heap after %zu | allocs/object %.2f\n",
+                    length, sec, sec * 1e9 / length, heap.get_heap_size(),
+                    static_cast<double>(allocs) / length);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int max_length = argc > 1 ? std::atoi(argv[1]) : 10000000;
+
+    // Логи в /dev/null: измеряется сам каскад; выделения в allocs/object
+    // приходятся на форматирование JSON строк в EventLogger.
+    EventLogger logger("/dev/null");
+
+    for (int length = 1000; length <= max_length; length *= 10)
+    {
+        run_chain(logger, length);
+    }
+    return 0;
+}
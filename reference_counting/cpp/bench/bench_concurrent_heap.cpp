@@ -0,0 +1,408 @@
+/**
+ * Стресс-проверка и бенчмарк многопоточной кучи ConcurrentRCHeap.
+ *
+ * Стресс (проверка корректности):
+ *   1. Случайные allocate / add_root / remove_root / add_ref / remove_ref
+ *      из нескольких потоков над общим небольшим пулом ID (ссылки только
+ *      от меньшего ID к большему, чтобы циклы не забивали пул). После остановки
+ *      проверяется, что у каждого живого объекта ref_count равен числу
+ *      входящих ссылок от живых объектов плюс корень, что все ссылки ведут
+ *      в живые объекты и что число allocate минус delete равно размеру кучи.
+ *   2. Два потока одновременно снимают два корня, которые делят один
+ *      подграф-решётку: после каскадов куча должна быть пуста, и каждый
+ *      объект должен быть удалён ровно один раз.
+ *   3. Объект, удерживаемый только ссылкой: один поток в цикле добавляет
+ *      его в корни, другой снимает. remove_root не должен снять корень,
+ *      увеличение которого ещё не попало в счётчик, — иначе объект
+ *      освобождается при живой ссылке. Тот же порядок воспроизводится
+ *      детерминированно: remove_root вызывается из set_root_claim_hook(),
+ *      когда add_root уже захватил корень, но не увеличил счётчик.
+ *      В режиме Biased — ещё и с объектом, созданным потоком add_root:
+ *      его корни считаются локально, а снятия другого потока — атомарно.
+ * Проверки выполняются в режимах CountMode::Atomic и CountMode::Biased.
+ *
+ * Пропускная способность: каждый поток строит и отпускает цепочки в своём
+ * диапазоне ID (без общих объектов), затем все потоки добавляют и снимают
+ * ссылки на один общий объект (конкуренция за счётчик). Число потоков
+ * перебирается от 1 до max_threads.
+ *
+ * Сборка (из каталога cpp/):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target bench_concurrent_heap
+ * Запуск:
+ *   build/bench_concurrent_heap [max_threads] [ops_per_thread]
+ * Проверки зарегистрированы в ctest; под ThreadSanitizer (из каталога cpp/):
+ *   cmake -S . -B build-tsan -DRC_SANITIZER=thread && cmake --build build-tsan && ctest --test-dir build-tsan
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "concurrent_rc_heap.h"
+#include "event_logger.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * Считает события allocate и delete; допускает вызовы из многих потоков
+     */
+    class CountingSink : public LogSink
+    {
+    public:
+        std::atomic<uint64_t> allocates{0};
+        std::atomic<uint64_t> deletes{0};
+
+        void write(const LogRecord &record) override
+        {
+            if (record.type == EventType::Allocate)
+            {
+                allocates.fetch_add(1, std::memory_order_relaxed);
+            }
+            else if (record.type == EventType::Delete)
+            {
+                deletes.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        void sync() override {}
+        bool is_open() const override { return true; }
+    };
+
+    template <typename Fn>
+    void run_threads(unsigned threads, Fn &&body)
+    {
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < threads; ++t)
+        {
+            workers.emplace_back(body, t);
+        }
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    bool check_invariants(ConcurrentRCHeap &heap, const CountingSink &sink, const char *name)
+    {
+        heap.settle();
+        std::unordered_map<int, int> in_degree;
+        size_t live = 0;
+        bool ok = true;
+        heap.for_each([&](const ConcurrentObject &obj)
+                      {
+                          live++;
+                          for (int child : obj.references)
+                          {
+                              in_degree[child]++;
+                          } });
+        heap.for_each([&](const ConcurrentObject &obj)
+                      {
+                          int expected = in_degree[obj.id] + (obj.is_root() ? 1 : 0);
+                          int actual = obj.count.total();
+                          if (actual != expected)
+                          {
+                              std::printf("  object %d: ref_count=%d, expected %d\n", obj.id, actual, expected);
+                              ok = false;
+                          }
+                          for (int child : obj.references)
+                          {
+                              if (!heap.object_exists(child))
+                              {
+                                  std::printf("  object %d references missing %d\n", obj.id, child);
+                                  ok = false;
+                              }
+                          } });
+
+        uint64_t balance = sink.allocates.load() - sink.deletes.load();
+        if (balance != live || live != heap.get_heap_size())
+        {
+            std::printf("  allocate-delete=%llu, live=%zu, heap size=%zu\n",
+                        static_cast<unsigned long long>(balance), live, heap.get_heap_size());
+            ok = false;
+        }
+        std::printf("stress %-14s | live %6zu | deletes %9llu | %s\n", name, live,
+                    static_cast<unsigned long long>(sink.deletes.load()), ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    bool stress_random(unsigned threads, int ops_per_thread, CountMode mode)
+    {
+        CountingSink *sink = new CountingSink();
+        EventLogger logger{std::unique_ptr<LogSink>(sink)};
+        ConcurrentRCHeap heap(logger, 16, mode);
+        const int pool = 64;
+
+        run_threads(threads, [&](unsigned t)
+                    {
+                        std::mt19937 rng(1000 + t);
+                        std::uniform_int_distribution<int> id(0, pool - 1);
+                        std::uniform_int_distribution<int> op(0, 99);
+                        for (int i = 0; i < ops_per_thread; ++i)
+                        {
+                            int kind = op(rng);
+                            if (kind < 20)
+                            {
+                                // Новый объект сразу получает владельца, иначе он жил бы вечно
+                                int obj = id(rng);
+                                if (heap.allocate(obj) && !heap.add_ref(id(rng) % (obj + 1), obj))
+                                {
+                                    heap.add_root(obj);
+                                }
+                            }
+                            else if (kind < 25)
+                            {
+                                heap.add_root(id(rng));
+                            }
+                            else if (kind < 40)
+                            {
+                                heap.remove_root(id(rng));
+                            }
+                            else if (kind < 60)
+                            {
+                                // Ссылки только от меньшего ID к большему: граф без циклов,
+                                // и любой объект рано или поздно может умереть
+                                int a = id(rng), b = id(rng);
+                                heap.add_ref(std::min(a, b), std::max(a, b));
+                            }
+                            else
+                            {
+                                int a = id(rng), b = id(rng);
+                                heap.remove_ref(std::min(a, b), std::max(a, b));
+                            }
+                        } });
+        return check_invariants(heap, *sink, mode == CountMode::Biased ? "random biased" : "random ops");
+    }
+
+    bool stress_shared_subgraph(int rounds, int side, CountMode mode)
+    {
+        CountingSink *sink = new CountingSink();
+        EventLogger logger{std::unique_ptr<LogSink>(sink)};
+        ConcurrentRCHeap heap(logger, 16, mode);
+        const char *name = mode == CountMode::Biased ? "shared biased" : "shared subgraph";
+
+        for (int round = 0; round < rounds; ++round)
+        {
+            // Корни 0 и 1 ссылаются на вершину решётки side x side; каждый узел
+            // решётки ссылается на правого и нижнего соседа (много общих путей)
+            const int base = 2;
+            auto node = [&](int r, int c)
+            { return base + r * side + c; };
+            heap.allocate(0);
+            heap.allocate(1);
+            heap.add_root(0);
+            heap.add_root(1);
+            for (int r = 0; r < side; ++r)
+            {
+                for (int c = 0; c < side; ++c)
+                {
+                    heap.allocate(node(r, c));
+                }
+            }
+            for (int r = 0; r < side; ++r)
+            {
+                for (int c = 0; c < side; ++c)
+                {
+                    if (c + 1 < side)
+                    {
+                        heap.add_ref(node(r, c), node(r, c + 1));
+                    }
+                    if (r + 1 < side)
+                    {
+                        heap.add_ref(node(r, c), node(r + 1, c));
+                    }
+                }
+            }
+            heap.add_ref(0, node(0, 0));
+            heap.add_ref(1, node(0, 0));
+            // Второй вход в подграф, чтобы оба каскада заходили глубоко
+            heap.add_ref(1, node(side / 2, side / 2));
+
+            std::atomic<int> ready{0};
+            run_threads(2, [&](unsigned t)
+                        {
+                            ready.fetch_add(1);
+                            while (ready.load() < 2)
+                            {
+                            }
+                            heap.remove_root(static_cast<int>(t)); });
+            // В режиме Biased объекты создал главный поток: досливаем его очередь
+            heap.merge_pending();
+
+            if (heap.get_heap_size() != 0)
+            {
+                std::printf("  round %d: %zu objects survived\n", round, heap.get_heap_size());
+                return check_invariants(heap, *sink, name);
+            }
+        }
+        return check_invariants(heap, *sink, name);
+    }
+
+    /**
+     * Объект 2 удерживает только ссылка 1 -> 2; remove_root(2) вызывается
+     * внутри add_root(2) — после захвата корня, до увеличения счётчика
+     */
+    bool check_root_claim(CountMode mode)
+    {
+        EventLogger logger{std::unique_ptr<LogSink>(new NullLogSink())};
+        ConcurrentRCHeap heap(logger, 16, mode);
+        heap.allocate(1);
+        heap.add_root(1);
+        heap.allocate(2);
+        heap.add_ref(1, 2);
+
+        bool removed_early = false;
+        heap.set_root_claim_hook([&](int obj_id)
+                                 { removed_early = heap.remove_root(obj_id); });
+        const bool added = heap.add_root(2);
+        heap.set_root_claim_hook(nullptr);
+
+        bool ok = added && !removed_early && heap.object_exists(2) && heap.get_ref_count(2) == 2;
+        ok = ok && heap.remove_root(2) && heap.get_ref_count(2) == 1;
+        ok = ok && heap.remove_ref(1, 2) && !heap.object_exists(2) && heap.get_heap_size() == 1;
+        std::printf("stress %-14s | %s\n", mode == CountMode::Biased ? "claim biased" : "root claim", ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    /**
+     * @param owner_flips Объект 2 создаёт поток, добавляющий корень: в режиме
+     *                    Biased его add_root идут по локальной части счётчика,
+     *                    а remove_root другого потока — по общей
+     */
+    bool stress_root_flip(int iterations, CountMode mode, bool owner_flips)
+    {
+        CountingSink *sink = new CountingSink();
+        EventLogger logger{std::unique_ptr<LogSink>(sink)};
+        ConcurrentRCHeap heap(logger, 16, mode);
+        heap.allocate(1);
+        heap.add_root(1);
+        if (!owner_flips)
+        {
+            heap.allocate(2);
+            heap.add_ref(1, 2);
+        }
+
+        std::atomic<bool> ready{!owner_flips};
+        run_threads(2, [&](unsigned t)
+                    {
+                        if (t == 0 && owner_flips)
+                        {
+                            heap.allocate(2);
+                            heap.add_ref(1, 2);
+                            ready.store(true);
+                        }
+                        while (!ready.load())
+                        {
+                        }
+                        for (int i = 0; i < iterations; ++i)
+                        {
+                            if (t == 0)
+                            {
+                                heap.add_root(2);
+                            }
+                            else
+                            {
+                                heap.remove_root(2);
+                            }
+                        }
+                        heap.merge_pending(); });
+        heap.merge_pending();
+        bool ok = heap.object_exists(2);
+        if (!ok)
+        {
+            std::printf("  object 2 freed while 1 -> 2 exists\n");
+        }
+        const char *name = owner_flips ? "flip by owner" : mode == CountMode::Biased ? "flip biased" : "root flip";
+        return check_invariants(heap, *sink, name) && ok;
+    }
+
+    double throughput_private(unsigned threads, int ops_per_thread)
+    {
+        EventLogger logger{std::unique_ptr<LogSink>(new NullLogSink())};
+        ConcurrentRCHeap heap(logger);
+        const int chain = 32;
+
+        auto start = Clock::now();
+        run_threads(threads, [&](unsigned t)
+                    {
+                        // Собственный диапазон ID потока; 3 операции на объект
+                        int base = static_cast<int>(t) * (chain + 1);
+                        int step = static_cast<int>(threads) * (chain + 1);
+                        for (int done = 0; done < ops_per_thread; done += 3 * chain + 2)
+                        {
+                            heap.allocate(base);
+                            heap.add_root(base);
+                            for (int k = 1; k <= chain; ++k)
+                            {
+                                heap.allocate(base + k);
+                                heap.add_ref(base + k - 1, base + k);
+                            }
+                            heap.remove_root(base); // каскад удаляет всю цепочку
+                            base += step;
+                        } });
+        double sec = std::chrono::duration<double>(Clock::now() - start).count();
+        return static_cast<double>(threads) * ops_per_thread / sec / 1e6;
+    }
+
+    double throughput_shared(unsigned threads, int ops_per_thread)
+    {
+        EventLogger logger{std::unique_ptr<LogSink>(new NullLogSink())};
+        ConcurrentRCHeap heap(logger);
+        heap.allocate(0);
+        heap.add_root(0);
+        for (unsigned t = 0; t < threads; ++t)
+        {
+            heap.allocate(static_cast<int>(t) + 1);
+            heap.add_root(static_cast<int>(t) + 1);
+        }
+
+        auto start = Clock::now();
+        run_threads(threads, [&](unsigned t)
+                    {
+                        int self = static_cast<int>(t) + 1;
+                        for (int i = 0; i < ops_per_thread; i += 2)
+                        {
+                            heap.add_ref(self, 0);
+                            heap.remove_ref(self, 0);
+                        } });
+        double sec = std::chrono::duration<double>(Clock::now() - start).count();
+        return static_cast<double>(threads) * ops_per_thread / sec / 1e6;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned max_threads = argc > 1 ? static_cast<unsigned>(std::atoi(argv[1]))
+                                    : std::thread::hardware_concurrency();
+    int ops = argc > 2 ? std::atoi(argv[2]) : 1000000;
+    if (max_threads == 0)
+    {
+        max_threads = 1;
+    }
+    unsigned stress_threads = max_threads < 4 ? 4 : max_threads;
+
+    bool ok = true;
+    for (CountMode mode : {CountMode::Atomic, CountMode::Biased})
+    {
+        ok = stress_random(stress_threads, ops / 4, mode) && ok;
+        ok = stress_shared_subgraph(200, 24, mode) && ok;
+        ok = check_root_claim(mode) && ok;
+        ok = stress_root_flip(ops / 4, mode, false) && ok;
+    }
+    ok = stress_root_flip(ops / 4, CountMode::Biased, true) && ok;
+
+    std::printf("\n%7s | %18s | %18s\n", "threads", "private M ops/s", "shared M ops/s");
+    for (unsigned threads = 1; threads <= max_threads; ++threads)
+    {
+        double private_mops = throughput_private(threads, ops);
+        double shared_mops = throughput_shared(threads, ops);
+        std::printf("%7u | %18.2f | %18.2f\n", threads, private_mops, shared_mops);
+    }
+    return ok ? 0 : 1;
+}
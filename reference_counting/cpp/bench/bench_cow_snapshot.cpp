@@ -0,0 +1,298 @@
+/**
+ * Бенчмарк срезов кучи с копированием при записи (RCHeap::snapshot).
+ *
+ * Строит кучу из графа со степенным распределением (objects вершин,
+ * 3 ссылки на вершину) и objects/1000 недостижимых пар-циклов (утечки).
+ * Мутатор: allocate + add_ref от случайного объекта графа, remove_ref
+ * самого старого из 1024 временных объектов (удаление каскадом),
+ * переключение корня каждые 500 операций. Измеряется:
+ *   - мутатор без среза;
+ *   - время snapshot() и первой записи после него (копия таблицы кусков);
+ *   - мутатор, пока срез жив: замедление, сколько памяти срез удерживает
+ *     сверх кучи (старые версии скопированных кусков);
+ *   - анализ (find_leaks, has_cycle) в отдельном потоке на срезе,
+ *     параллельно с мутатором, против паузы stop-the-world на той же работе.
+ * Проверяет, что срез после мутаций видит ровно состояние на момент
+ * снимка (контрольная сумма объектов и утечки), а свежий срез — новое,
+ * и что срез, последнюю ссылку на который отпускает поток анализа,
+ * возвращает списки ссылок в пул мутатора.
+ *
+ * Сборка (из каталога cpp/):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target bench_cow_snapshot
+ * Запуск:
+ *   build/bench_cow_snapshot [objects] [ops]   (по умолчанию 2000000 и 500000)
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "event_logger.h"
+#include "graph_generators.h"
+#include "heap_view.h"
+#include "pool_allocator.h"
+#include "rc_heap.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double seconds_since(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    class Mutator
+    {
+    public:
+        Mutator(RCHeap &heap_, int graph_size_, int first_free_id)
+            : heap(heap_), graph_size(graph_size_), next_id(first_free_id + 2), rng(7)
+        {
+            // Объект pinned удерживается holder'ом, поэтому корень на нём можно снимать
+            holder = first_free_id;
+            pinned = first_free_id + 1;
+            heap.allocate(holder);
+            heap.allocate(pinned);
+            heap.add_root(holder);
+            heap.add_ref(holder, pinned);
+        }
+
+        void step()
+        {
+            int owner = 1 + static_cast<int>(rng() % graph_size);
+            int temp = next_id++;
+            heap.allocate(temp);
+            heap.add_ref(owner, temp);
+            temps.emplace_back(owner, temp);
+            if (temps.size() > 1024)
+            {
+                heap.remove_ref(temps.front().first, temps.front().second);
+                temps.pop_front();
+            }
+            if (++count % 500 == 0)
+            {
+                if (pinned_root)
+                {
+                    heap.remove_root(pinned);
+                }
+                else
+                {
+                    heap.add_root(pinned);
+                }
+                pinned_root = !pinned_root;
+            }
+        }
+
+        double run(size_t ops)
+        {
+            auto start = Clock::now();
+            for (size_t i = 0; i < ops; ++i)
+            {
+                step();
+            }
+            return seconds_since(start);
+        }
+
+    private:
+        RCHeap &heap;
+        int graph_size;
+        int next_id;
+        int holder;
+        int pinned;
+        bool pinned_root = false;
+        size_t count = 0;
+        std::mt19937 rng;
+        std::deque<std::pair<int, int>> temps;
+    };
+
+    uint64_t checksum(const ObjectStore &store)
+    {
+        uint64_t hash = 1469598103934665603ull;
+        auto mix = [&hash](uint64_t value) { hash = (hash ^ value) * 1099511628211ull; };
+        store.for_each_in_id_order([&](const RCObject &obj)
+        {
+            mix(static_cast<uint32_t>(obj.id));
+            mix(static_cast<uint32_t>(obj.ref_count));
+            for (int child_id : obj.references)
+            {
+                mix(static_cast<uint32_t>(child_id));
+            }
+        });
+        return hash;
+    }
+
+    /**
+     * Работа анализа: поиск утечек и has_cycle для sample случайных объектов
+     */
+    size_t analyze(const HeapView &view, int objects, int sample, std::vector<int> &leaks)
+    {
+        leaks = view.find_leaks();
+        std::mt19937 rng(11);
+        size_t cycles = 0;
+        for (int i = 0; i < sample; ++i)
+        {
+            cycles += view.has_cycle(1 + static_cast<int>(rng() % (objects + objects / 500)));
+        }
+        return cycles;
+    }
+
+    /**
+     * Поток анализа держит последнюю ссылку на срез: старые версии
+     * скопированных кусков и их списки ссылок освобождаются в нём,
+     * а блоки возвращаются в пул мутатора
+     */
+    bool release_in_analyst(EventLogger &logger)
+    {
+        SizeClassPool &pool = SizeClassPool::local();
+        const size_t live_before = pool.get_live_blocks();
+        bool ok = true;
+        {
+            RCHeap heap(logger);
+            heap.allocate(1);
+            heap.add_root(1);
+            for (int i = 2; i <= 200; ++i)
+            {
+                heap.allocate(i);
+                heap.add_ref(1, i);
+            }
+            std::shared_ptr<const HeapView> view = heap.snapshot();
+            heap.allocate(201);
+            heap.add_ref(1, 201); // кусок с объектом 1 копируется, старая версия остаётся срезу
+
+            bool reachable = true;
+            std::thread analyst([view = std::move(view), &reachable]() mutable {
+                for (int i = 2; i <= 200; ++i)
+                {
+                    reachable = reachable && view->is_reachable(i);
+                }
+                reachable = reachable && !view->is_reachable(201);
+                view.reset();
+            });
+            analyst.join();
+            ok = reachable;
+
+            // Мутатор продолжает работу и забирает блоки, освобождённые анализом
+            for (int i = 202; i <= 400; ++i)
+            {
+                heap.allocate(i);
+                heap.add_ref(1, i);
+            }
+            heap.remove_root(1);
+            ok = ok && heap.get_heap_size() == 0;
+        }
+        pool.release_memory();
+        return ok && pool.get_live_blocks() == live_before;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int objects = argc > 1 ? std::atoi(argv[1]) : 2000000;
+    size_t ops = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 500000;
+    const int sample = 1000;
+
+    EventLogger logger{std::unique_ptr<LogSink>(new NullLogSink())};
+    RCHeap heap(logger);
+    heap.reserve(static_cast<size_t>(objects) + objects / 500 + 4096);
+    make_power_law(objects, 3, objects / 100, 42).load_into(heap);
+    for (int k = 0; k < objects / 1000; ++k)
+    {
+        int a = objects + 1 + 2 * k;
+        heap.allocate(a);
+        heap.allocate(a + 1);
+        heap.add_ref(a, a + 1);
+        heap.add_ref(a + 1, a);
+    }
+    Mutator mutator(heap, objects, objects + objects / 500 + 1);
+    std::printf("heap: %zu objects, %zu roots, chunk %zu objects\n", heap.get_heap_size(), heap.get_roots_count(),
+                ObjectStore::kSlotChunkSize);
+
+    // 1. Мутатор без среза
+    double plain_sec = mutator.run(ops);
+    std::printf("mutator, no snapshot     | %8.1f ms | %7.2f M ops/s\n", plain_sec * 1e3, ops / plain_sec / 1e6);
+
+    // 2. Стоимость snapshot() и первой записи после него
+    const int calls = 1000;
+    auto start = Clock::now();
+    for (int i = 0; i < calls; ++i)
+    {
+        heap.snapshot();
+    }
+    double snap_sec = seconds_since(start) / calls;
+
+    std::shared_ptr<const HeapView> view = heap.snapshot();
+    start = Clock::now();
+    mutator.step();
+    double first_write_sec = seconds_since(start);
+    view.reset();
+    std::printf("snapshot()               | %8.2f us | first write after it %.1f us\n", snap_sec * 1e6,
+                first_write_sec * 1e6);
+
+    // 3. Мутатор, пока срез жив
+    view = heap.snapshot();
+    const ObjectStore &frozen = view->get_objects();
+    uint64_t sum_before = checksum(frozen);
+    std::vector<int> leaks_before;
+    analyze(*view, objects, 0, leaks_before);
+    double cow_sec = mutator.run(ops);
+    size_t retained = frozen.unshared_memory_usage();
+    std::printf("mutator, snapshot held   | %8.1f ms | %7.2f M ops/s | x%.2f slower\n", cow_sec * 1e3,
+                ops / cow_sec / 1e6, cow_sec / plain_sec);
+    std::printf("snapshot overhead        | %8.1f MB retained by snapshot of %.1f MB heap (%.1f%%)\n",
+                retained / 1e6, frozen.memory_usage() / 1e6, 100.0 * retained / frozen.memory_usage());
+
+    bool ok = checksum(frozen) == sum_before;
+    std::vector<int> leaks_after;
+    analyze(*view, objects, 0, leaks_after);
+    ok = ok && leaks_after == leaks_before && leaks_before.size() == static_cast<size_t>(objects / 1000 * 2);
+    {
+        std::shared_ptr<const HeapView> fresh = heap.snapshot();
+        ok = ok && checksum(fresh->get_objects()) != sum_before && fresh->size() == heap.get_heap_size();
+    }
+    view.reset();
+
+    // 4. Анализ на срезе параллельно с мутатором против паузы на той же работе
+    std::vector<int> leaks;
+    start = Clock::now();
+    std::shared_ptr<const HeapView> paused = heap.snapshot();
+    size_t cycles = analyze(*paused, objects, sample, leaks);
+    paused.reset();
+    double pause_sec = seconds_since(start);
+    std::printf("stop-the-world analysis  | %8.1f ms mutator pause | %zu leaks, %zu of %d sampled reach a cycle\n",
+                pause_sec * 1e3, leaks.size(), cycles, sample);
+
+    view = heap.snapshot();
+    double analysis_sec = 0;
+    size_t concurrent_cycles = 0;
+    std::vector<int> concurrent_leaks;
+    std::thread analyst([&] {
+        auto analysis_start = Clock::now();
+        concurrent_cycles = analyze(*view, objects, sample, concurrent_leaks);
+        analysis_sec = seconds_since(analysis_start);
+    });
+    double concurrent_sec = mutator.run(ops);
+    analyst.join();
+    view.reset();
+    std::printf("concurrent analysis      | %8.1f ms | mutator %7.2f M ops/s alongside (x%.2f slower), %u hw threads\n",
+                analysis_sec * 1e3, ops / concurrent_sec / 1e6, concurrent_sec / plain_sec,
+                std::thread::hardware_concurrency());
+    ok = ok && concurrent_leaks.size() == leaks.size() && concurrent_cycles == cycles;
+
+    const bool released = release_in_analyst(logger);
+    std::printf("snapshot released by the analysis thread: %s\n", released ? "ok" : "MISMATCH");
+    ok = ok && released;
+
+    if (!ok)
+    {
+        std::printf("MISMATCH: snapshot does not show the state at snapshot time\n");
+        return 1;
+    }
+    std::printf("snapshot contents verified\n");
+    return 0;
+}
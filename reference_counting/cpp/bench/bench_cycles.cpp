@@ -0,0 +1,87 @@
+/**
+ * Бенчмарк сборщика циклов: время collect_cycles() от числа мусорных циклов
+ * и от размера живой части кучи.
+ *
+ * Живая часть — дерево из live объектов, удерживаемое корнем. Мусор —
+ * cycles маленьких циклов a -> b -> c -> a, каждый из которых сначала
+ * удерживался корнем, а затем корень отпущен (как scenario C).
+ * Время должно расти с числом циклов и не зависеть от размера живой кучи.
+ *
+ * Сборка (из каталога cpp/):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target bench_cycles
+ * Запуск:
+ *   build/bench_cycles [max_live] [max_cycles]
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "rc_heap.h"
+#include "event_logger.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    void run(EventLogger &logger, int live, int cycles)
+    {
+        RCHeap heap(logger);
+        heap.reserve(static_cast<size_t>(live) + 3 * static_cast<size_t>(cycles) + 1);
+
+        // Живое двоичное дерево под корнем 0
+        heap.allocate(0);
+        heap.add_root(0);
+        for (int id = 1; id <= live; ++id)
+        {
+            heap.allocate(id);
+            heap.add_ref((id - 1) / 2, id);
+        }
+
+        // Мусорные циклы длины 3
+        int next_id = live + 1;
+        for (int c = 0; c < cycles; ++c)
+        {
+            int a = next_id++;
+            int b = next_id++;
+            int d = next_id++;
+            heap.allocate(a);
+            heap.allocate(b);
+            heap.allocate(d);
+            heap.add_root(a);
+            heap.add_ref(a, b);
+            heap.add_ref(b, d);
+            heap.add_ref(d, a);
+            heap.remove_root(a);
+        }
+
+        size_t candidates = heap.get_cycle_candidate_count();
+        auto start = Clock::now();
+        size_t freed = heap.collect_cycles();
+        double sec = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::printf("live %9d | cycles %8d | candidates %8zu | freed %9zu | %9.3f ms | %6.1f ns/freed object\n",
+                    live, cycles, candidates, freed, sec * 1e3,
+                    freed > 0 ? sec * 1e9 / static_cast<double>(freed) : 0.0);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int max_live = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    int max_cycles = argc > 2 ? std::atoi(argv[2]) : 100000;
+
+    EventLogger logger("/dev/null");
+
+    std::printf("-- fixed number of cycles, growing live heap\n");
+    for (int live = 1000; live <= max_live; live *= 10)
+    {
+        run(logger, live, 1000);
+    }
+
+    std::printf("-- fixed live heap, growing number of cycles\n");
+    for (int cycles = 100; cycles <= max_cycles; cycles *= 10)
+    {
+        run(logger, max_live, cycles);
+    }
+    return 0;
+}
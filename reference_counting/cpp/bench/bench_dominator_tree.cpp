@@ -0,0 +1,202 @@
+/**
+ * Бенчмарк дерева доминаторов (DominatorTree): удерживаемые размеры
+ * всех объектов кучи.
+ *
+ * Графы из graph_generators.h, загруженные прямо в ObjectStore:
+ *   - power_law — Барабаши–Альберт, m = 3 (популярные объекты, на которые
+ *     ссылаются многие: удерживают мало, доминаторы — немногие хабы);
+ *   - erdos_renyi — случайный граф со средней степенью 4;
+ *   - chain — цепочка: глубина DFS равна числу объектов (проверка, что
+ *     рекурсии нет), каждый объект удерживает весь хвост;
+ *   - binary_tree+cross — двоичное дерево и n/20 случайных ссылок поверх:
+ *     глубокое дерево доминаторов, местами «срезанное» лишними путями.
+ * Измеряет захват образа, построение дерева и выбор top-10, в нс на
+ * объект. На маленьких графах сверяет удерживаемые размеры с перебором:
+ * размер объекта v — сколько объектов перестают быть достижимы, если
+ * убрать v.
+ *
+ * Сборка (из каталога cpp/):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target bench_dominator_tree
+ * Запуск:
+ *   build/bench_dominator_tree [max_objects]   (по умолчанию 10000000)
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "dominator_tree.h"
+#include "graph_generators.h"
+#include "heap_image.h"
+#include "object_store.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double seconds_since(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    const int kBruteForceLimit = 3000;
+
+    void load(const Graph &graph, ObjectStore &store, std::unordered_set<int> &roots)
+    {
+        store.reserve(graph.node_count);
+        for (int id = 1; id <= graph.node_count; ++id)
+        {
+            store.emplace(id);
+        }
+        for (const auto &edge : graph.edges)
+        {
+            if (store.find(edge.first)->add_outgoing_ref(edge.second))
+            {
+                store.find(edge.second)->ref_count++;
+            }
+        }
+        for (int root : graph.roots)
+        {
+            roots.insert(root);
+            store.find(root)->ref_count++;
+        }
+    }
+
+    /**
+     * Достижимые из корней и объектов с ref_count == 0, не проходя через skip
+     */
+    size_t count_reachable(const HeapImage &image, uint32_t skip, std::vector<uint8_t> &seen)
+    {
+        seen.assign(image.size(), 0);
+        std::vector<uint32_t> stack(image.get_root_indices());
+        image.zero_indices(stack);
+        size_t count = 0;
+        while (!stack.empty())
+        {
+            uint32_t index = stack.back();
+            stack.pop_back();
+            if (index == skip || seen[index])
+            {
+                continue;
+            }
+            seen[index] = 1;
+            count++;
+            for (const uint32_t *edge = image.edges_begin(index); edge != image.edges_end(index); ++edge)
+            {
+                stack.push_back(*edge);
+            }
+        }
+        return count;
+    }
+
+    bool brute_force_check(const HeapImage &image, const DominatorTree &tree)
+    {
+        std::vector<uint8_t> seen;
+        const size_t total = count_reachable(image, HeapImage::kNoIndex, seen);
+        bool ok = total == tree.size();
+        for (uint32_t index = 0; index < image.size() && ok; ++index)
+        {
+            if (!tree.is_reachable(index))
+            {
+                continue;
+            }
+            ok = total - count_reachable(image, index, seen) == tree.retained_objects(index);
+        }
+        return ok;
+    }
+
+    /**
+     * Двоичное дерево с cross случайными ссылками поверх: глубокое дерево
+     * доминаторов, которое дополнительные ссылки местами «срезают»
+     */
+    Graph make_tree_with_cross(int n, int cross, uint64_t seed)
+    {
+        Graph graph = make_binary_tree(n);
+        graph.name += "+cross=" + std::to_string(cross);
+        std::mt19937_64 rng(seed);
+        for (int i = 0; i < cross; ++i)
+        {
+            int from = 1 + static_cast<int>(rng() % n);
+            int to = 1 + static_cast<int>(rng() % n);
+            if (from != to)
+            {
+                graph.edges.emplace_back(from, to);
+            }
+        }
+        return graph;
+    }
+
+    bool run(const Graph &graph)
+    {
+        ObjectStore store;
+        std::unordered_set<int> roots;
+        load(graph, store, roots);
+
+        auto start = Clock::now();
+        HeapImage image(store, roots);
+        double capture_sec = seconds_since(start);
+
+        start = Clock::now();
+        DominatorTree tree(image);
+        double build_sec = seconds_since(start);
+
+        start = Clock::now();
+        std::vector<DominatorTree::Entry> top = tree.top(10);
+        double top_sec = seconds_since(start);
+
+        bool ok = !top.empty() && tree.retained_objects(top.front().index) >= tree.retained_objects(top.back().index);
+        const bool brute_force = graph.node_count <= kBruteForceLimit;
+        if (brute_force)
+        {
+            ok = brute_force_check(image, tree) && ok;
+        }
+
+        const size_t n = image.size();
+        std::printf("%-36s %9zu objects %9zu edges | capture %8.1f ms | dominators %8.1f ms (%5.1f ns/object)"
+                    " | top-10 %6.1f ms | largest %llu%s\n",
+                    graph.name.c_str(), n, image.edge_count(), capture_sec * 1e3, build_sec * 1e3,
+                    build_sec * 1e9 / n, top_sec * 1e3,
+                    static_cast<unsigned long long>(top.empty() ? 0 : top.front().retained_objects),
+                    brute_force ? " | checked against brute force" : "");
+        return ok;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int max_objects = argc > 1 ? std::atoi(argv[1]) : 10000000;
+
+    bool ok = true;
+    ok = run(make_power_law(kBruteForceLimit, 3, 3, 1)) && ok;
+    ok = run(make_erdos_renyi(kBruteForceLimit, 2.0 / kBruteForceLimit, 3, 1)) && ok;
+    ok = run(make_chain(kBruteForceLimit)) && ok;
+    ok = run(make_tree_with_cross(kBruteForceLimit, kBruteForceLimit / 20, 1)) && ok;
+    for (int n = 100000; n <= max_objects; n *= 10)
+    {
+        ok = run(make_power_law(n, 3, 16, 1)) && ok;
+        ok = run(make_erdos_renyi(n, 4.0 / n, 16, 1)) && ok;
+        ok = run(make_chain(n)) && ok;
+        ok = run(make_tree_with_cross(n, n / 20, 1)) && ok;
+    }
+
+    if (!ok)
+    {
+        std::printf("MISMATCH: dominator tree disagrees with brute force\n");
+        return 1;
+    }
+    std::printf("dominator tree verified\n");
+
+    // Пример отчёта на маленьком графе
+    Graph graph = make_tree_with_cross(kBruteForceLimit, kBruteForceLimit / 20, 1);
+    ObjectStore store;
+    std::unordered_set<int> roots;
+    load(graph, store, roots);
+    HeapImage image(store, roots);
+    DominatorTree(image).dump(std::cout, 5);
+    return 0;
+}
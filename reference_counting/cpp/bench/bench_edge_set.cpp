@@ -0,0 +1,143 @@
+/**
+ * Микробенчмарк множества исходящих ссылок при большой степени ветвления.
+ *
+ * Для степеней 1, 4, 16, ... до max_fan_out строит один объект с fan_out ссылками через
+ * RCObject::add_outgoing_ref, проверяет каждую через has_reference_to и удаляет
+ * все через remove_outgoing_ref (в случайном порядке). Для сравнения тот же
+ * сценарий гоняется на прежней реализации (std::vector + std::find) — она
+ * квадратична, поэтому ограничена степенью vector_limit.
+ *
+ * Сборка (из каталога cpp/):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target bench_edge_set
+ * Запуск:
+ *   build/bench_edge_set [max_fan_out] [vector_limit]   (по умолчанию 1000000 и 65536)
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "rc_object.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * Прежнее представление ссылок: линейный поиск по вектору
+     */
+    struct VectorEdges
+    {
+        std::vector<int> references;
+
+        bool has_reference_to(int target_id) const
+        {
+            return std::find(references.begin(), references.end(), target_id) != references.end();
+        }
+
+        bool add_outgoing_ref(int target_id)
+        {
+            if (!has_reference_to(target_id))
+            {
+                references.push_back(target_id);
+                return true;
+            }
+            return false;
+        }
+
+        bool remove_outgoing_ref(int target_id)
+        {
+            auto it = std::find(references.begin(), references.end(), target_id);
+            if (it != references.end())
+            {
+                references.erase(it);
+                return true;
+            }
+            return false;
+        }
+    };
+
+    struct Timing
+    {
+        double add_ns = 0;
+        double find_ns = 0;
+        double remove_ns = 0;
+        bool ok = true;
+    };
+
+    double ns_per_op(Clock::time_point start, size_t ops)
+    {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ops;
+    }
+
+    template <typename Edges>
+    Timing run(const std::vector<int> &targets, const std::vector<int> &removal_order)
+    {
+        Timing t;
+        Edges obj;
+        size_t n = targets.size();
+
+        auto start = Clock::now();
+        for (int target : targets)
+        {
+            t.ok = obj.add_outgoing_ref(target) && t.ok;
+        }
+        t.add_ns = ns_per_op(start, n);
+
+        start = Clock::now();
+        size_t found = 0;
+        for (int target : removal_order)
+        {
+            found += obj.has_reference_to(target);
+        }
+        t.find_ns = ns_per_op(start, n);
+        t.ok = t.ok && found == n;
+
+        start = Clock::now();
+        for (int target : removal_order)
+        {
+            t.ok = obj.remove_outgoing_ref(target) && t.ok;
+        }
+        t.remove_ns = ns_per_op(start, n);
+        t.ok = t.ok && obj.references.size() == 0;
+        return t;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t max_fan_out = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    size_t vector_limit = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 65536;
+
+    std::printf("sizeof(RCObject)=%zu sizeof(EdgeSet)=%zu\n", sizeof(RCObject), sizeof(EdgeSet));
+    std::printf("%9s | %-9s | %9s | %9s | %9s\n", "fan-out", "impl", "add ns", "find ns", "remove ns");
+
+    std::mt19937 rng(42);
+    bool ok = true;
+    for (size_t n = 1; n <= max_fan_out; n = (n < max_fan_out && n * 4 > max_fan_out) ? max_fan_out : n * 4)
+    {
+        // Разреженные ID целей, чтобы хеш не получал последовательные ключи
+        std::vector<int> targets(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            targets[i] = static_cast<int>(i * 7919 + 1);
+        }
+        std::vector<int> removal_order = targets;
+        std::shuffle(removal_order.begin(), removal_order.end(), rng);
+
+        Timing edge_set = run<RCObject>(targets, removal_order);
+        ok = ok && edge_set.ok;
+        std::printf("%9zu | %-9s | %9.1f | %9.1f | %9.1f%s\n", n, "EdgeSet",
+                    edge_set.add_ns, edge_set.find_ns, edge_set.remove_ns, edge_set.ok ? "" : "  MISMATCH");
+
+        if (n <= vector_limit)
+        {
+            Timing vec = run<VectorEdges>(targets, removal_order);
+            std::printf("%9zu | %-9s | %9.1f | %9.1f | %9.1f\n", n, "vector",
+                        vec.add_ns, vec.find_ns, vec.remove_ns);
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,199 @@
+/**
+ * Бенчмарк проходов по всей куче: AoS-слоты ObjectStore против HeapImage (SoA).
+ *
+ * Строит кучу из objects объектов: двоичное дерево под корнем, в котором
+ * каждый 16-й объект не имеет родителя (ref_count == 0), плюс objects/1000
+ * недостижимых пар-циклов (утечки). Затем сравнивает:
+ *   - подсчёт объектов с ref_count == 0: проход по слотам RCObject
+ *     (как в Tracer::mark) и по массиву ref_counts образа, скалярно и AVX2;
+ *   - сбор индексов таких объектов (movemask);
+ *   - поиск утечек: Tracer::mark + log_unmarked против
+ *     HeapImage::unreachable_ids (с захватом образа и без).
+ * Печатает лучшее из runs время, объекты/с и ГБ/с прочитанных данных
+ * (для скана — только поля, которые надо прочитать).
+ *
+ * Сборка (из каталога cpp/):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target bench_heap_image
+ * Запуск:
+ *   build/bench_heap_image [objects] [runs]   (по умолчанию 10000000 и 5)
+ * На 100M объектов нужно ~7 ГБ: куча ~5 ГБ и образ ~2 ГБ.
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include "event_logger.h"
+#include "heap_image.h"
+#include "object_store.h"
+#include "tracer.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    void link(ObjectStore &store, int from, int to)
+    {
+        if (store.find(from)->add_outgoing_ref(to))
+        {
+            store.find(to)->ref_count++;
+        }
+    }
+
+    /**
+     * @return Количество объектов в циклах-утечках
+     */
+    size_t build(ObjectStore &store, std::unordered_set<int> &roots, int objects)
+    {
+        store.reserve(static_cast<size_t>(objects) + objects / 500 + 2);
+        for (int id = 1; id <= objects; ++id)
+        {
+            store.emplace(id);
+        }
+        roots.insert(1);
+        store.find(1)->ref_count = 1;
+        for (int id = 2; id <= objects; ++id)
+        {
+            if (id % 16 != 0)
+            {
+                link(store, id / 2, id);
+            }
+        }
+
+        size_t leaked = 0;
+        for (int k = 0; k < objects / 1000; ++k)
+        {
+            int a = objects + 1 + 2 * k;
+            store.emplace(a);
+            store.emplace(a + 1);
+            link(store, a, a + 1);
+            link(store, a + 1, a);
+            leaked += 2;
+        }
+        return leaked;
+    }
+
+    template <typename Fn>
+    double best_seconds(int runs, Fn &&fn)
+    {
+        double best = 0;
+        for (int run = 0; run < runs; ++run)
+        {
+            auto start = Clock::now();
+            fn();
+            double sec = std::chrono::duration<double>(Clock::now() - start).count();
+            if (best == 0 || sec < best)
+            {
+                best = sec;
+            }
+        }
+        return best;
+    }
+
+    void report(const char *name, double sec, size_t objects, size_t bytes, size_t result)
+    {
+        std::printf("%-30s | %9.2f ms | %8.1f Mobj/s | ", name, sec * 1e3, objects / sec / 1e6);
+        if (bytes != 0)
+        {
+            std::printf("%6.2f GB/s | result %zu\n", bytes / sec / 1e9, result);
+        }
+        else
+        {
+            std::printf("%6s GB/s | result %zu\n", "-", result);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int objects = argc > 1 ? std::atoi(argv[1]) : 10000000;
+    int runs = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    ObjectStore store;
+    std::unordered_set<int> roots;
+    auto start = Clock::now();
+    size_t leaked = build(store, roots, objects);
+    std::printf("heap: %zu objects, %zu leaked, built in %.2f s, sizeof(RCObject)=%zu, AVX2 %s\n", store.size(),
+                leaked, std::chrono::duration<double>(Clock::now() - start).count(), sizeof(RCObject),
+                HeapImage::avx2_available() ? "yes" : "no");
+
+    start = Clock::now();
+    HeapImage image(store, roots);
+    std::printf("image: captured in %.2f s, %zu edges, %.1f MB (store %.1f MB)\n",
+                std::chrono::duration<double>(Clock::now() - start).count(), image.edge_count(),
+                image.memory_usage() / 1e6, store.memory_usage() / 1e6);
+
+    const size_t n = image.size();
+    const size_t slots = store.slot_count();
+    bool ok = true;
+    size_t result = 0;
+
+    // Подсчёт нулевых счётчиков
+    double sec = best_seconds(runs, [&] {
+        size_t zero = 0;
+        for (uint32_t slot = 0; slot < slots; ++slot)
+        {
+            zero += store.is_live_slot(slot) && store.at_slot(slot).ref_count == 0;
+        }
+        result = zero;
+    });
+    // Читается id и ref_count, но каждая кэш-линия слота приходит целиком
+    report("count_zero AoS slots", sec, n, slots * sizeof(RCObject), result);
+    const size_t expected_zero = result;
+
+    sec = best_seconds(runs, [&] { result = image.count_zero(ScanKernel::Scalar); });
+    report("count_zero SoA scalar", sec, n, n * sizeof(int32_t), result);
+    ok = ok && result == expected_zero;
+    if (HeapImage::avx2_available())
+    {
+        sec = best_seconds(runs, [&] { result = image.count_zero(ScanKernel::Avx2); });
+        report("count_zero SoA AVX2", sec, n, n * sizeof(int32_t), result);
+        ok = ok && result == expected_zero;
+    }
+
+    // Сбор индексов нулевых счётчиков
+    std::vector<uint32_t> zero_scalar, zero_avx2;
+    zero_scalar.reserve(expected_zero);
+    zero_avx2.reserve(expected_zero);
+    sec = best_seconds(runs, [&] {
+        zero_scalar.clear();
+        image.zero_indices(zero_scalar, ScanKernel::Scalar);
+    });
+    report("zero_indices SoA scalar", sec, n, n * sizeof(int32_t), zero_scalar.size());
+    if (HeapImage::avx2_available())
+    {
+        sec = best_seconds(runs, [&] {
+            zero_avx2.clear();
+            image.zero_indices(zero_avx2, ScanKernel::Avx2);
+        });
+        report("zero_indices SoA AVX2", sec, n, n * sizeof(int32_t), zero_avx2.size());
+        ok = ok && zero_avx2 == zero_scalar;
+    }
+
+    // Поиск утечек
+    EventLogger logger{std::unique_ptr<LogSink>(new NullLogSink())};
+    Tracer tracer(store, logger);
+    sec = best_seconds(runs, [&] {
+        tracer.mark(roots);
+        result = tracer.log_unmarked();
+    });
+    report("leaks Tracer (AoS)", sec, n, 0, result);
+    ok = ok && result == leaked;
+
+    sec = best_seconds(runs, [&] { result = image.unreachable_ids().size(); });
+    report("leaks HeapImage", sec, n, 0, result);
+    ok = ok && result == leaked;
+
+    sec = best_seconds(runs, [&] { result = HeapImage(store, roots).unreachable_ids().size(); });
+    report("leaks HeapImage + capture", sec, n, 0, result);
+    ok = ok && result == leaked;
+
+    if (!ok)
+    {
+        std::printf("MISMATCH between AoS and SoA results\n");
+        return 1;
+    }
+    return 0;
+}
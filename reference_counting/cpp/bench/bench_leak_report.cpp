@@ -0,0 +1,304 @@
+/**
+ * Бенчмарк отчёта об утечках (LeakReport): группировка по циклам
+ * и удерживаемые размеры за O(V + E).
+ *
+ * Куча из двух половин по числу ссылок:
+ *   - живая: дерево под корнем с дополнительными ссылками вниз по дереву;
+ *   - утечки: кластеры «цикл-источник (2..65 объектов) + дерево под ним»
+ *     с тяжёлым хвостом размеров (до 4096 объектов), вложенными циклами
+ *     из двух объектов, дополнительными ссылками внутри кластера, ссылками
+ *     из утечек в живую кучу и (у каждого восьмого кластера) ссылкой
+ *     в дерево предыдущего кластера — эти объекты становятся общими.
+ *
+ * Измеряет захват образа, HeapImage::unreachable_ids (плоский список
+ * утечек — нижняя граница) и LeakReport::analyze, в нс на ссылку.
+ * Проверяет, что утечек столько же, сколько у unreachable_ids, что
+ * удерживаемые и общие объекты и ссылки складываются в итог, групп
+ * столько, сколько кластеров, а на самой маленькой куче — удерживаемые
+ * размеры против перебора (обход от каждого источника).
+ *
+ * Сборка (из каталога cpp/):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target bench_leak_report
+ * Запуск:
+ *   build/bench_leak_report [max_edges]   (по умолчанию 10000000)
+ * На 50M ссылок (16M объектов) пиковая память ~1.6 ГБ.
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+#include "heap_image.h"
+#include "leak_report.h"
+#include "mark_bitmap.h"
+#include "object_store.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double seconds_since(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    const int kLiveDegree = 3;
+    const int kLeakDegree = 3;
+
+    struct Heap
+    {
+        ObjectStore store;
+        std::unordered_set<int> roots;
+        int next_id = 1;
+        size_t edges = 0;
+        size_t clusters = 0;
+    };
+
+    int make(Heap &heap)
+    {
+        heap.store.emplace(heap.next_id);
+        return heap.next_id++;
+    }
+
+    void link(Heap &heap, int from, int to)
+    {
+        if (heap.store.find(from)->add_outgoing_ref(to))
+        {
+            heap.store.find(to)->ref_count++;
+            heap.edges++;
+        }
+    }
+
+    void build(Heap &heap, size_t target_edges, uint64_t seed)
+    {
+        std::mt19937_64 rng(seed);
+
+        // Живая половина
+        const int root = make(heap);
+        heap.roots.insert(root);
+        heap.store.find(root)->ref_count = 1;
+        std::vector<int> live(1, root);
+        while (heap.edges < target_edges / 2)
+        {
+            int id = make(heap);
+            int parent = live[rng() % live.size()];
+            link(heap, parent, id);
+            for (int k = 1; k < kLiveDegree; ++k)
+            {
+                link(heap, live[rng() % live.size()], id);
+            }
+            live.push_back(id);
+        }
+
+        // Утечки: кластеры
+        std::vector<int> previous_tree;
+        std::vector<int> cluster;
+        std::vector<int> tree;
+        while (heap.edges < target_edges)
+        {
+            const int cycle = 2 + static_cast<int>(rng() % (uint64_t(1) << (rng() % 7)));
+            const int tree_size = static_cast<int>(rng() % (uint64_t(1) << (rng() % 13)));
+            cluster.clear();
+            tree.clear();
+            for (int i = 0; i < cycle; ++i)
+            {
+                cluster.push_back(make(heap));
+            }
+            for (int i = 0; i < cycle; ++i)
+            {
+                link(heap, cluster[i], cluster[(i + 1) % cycle]);
+            }
+            for (int i = 0; i < tree_size; ++i)
+            {
+                const size_t parent_index = rng() % cluster.size();
+                const int parent = cluster[parent_index];
+                const int id = make(heap);
+                link(heap, parent, id);
+                if (parent_index >= static_cast<size_t>(cycle) && rng() % 32 == 0)
+                {
+                    link(heap, id, parent); // вложенный цикл
+                }
+                cluster.push_back(id);
+                tree.push_back(id);
+            }
+            // Дополнительные ссылки вглубь дерева кластера и в живую кучу
+            for (size_t i = 0; i + 1 < cluster.size(); ++i)
+            {
+                for (int k = 1; k < kLeakDegree; ++k)
+                {
+                    const size_t to = i + 1 + rng() % (cluster.size() - i - 1);
+                    if (to >= static_cast<size_t>(cycle))
+                    {
+                        link(heap, cluster[i], cluster[to]);
+                    }
+                }
+                if (rng() % 16 == 0)
+                {
+                    link(heap, cluster[i], live[rng() % live.size()]);
+                }
+            }
+            if (!previous_tree.empty() && rng() % 8 == 0)
+            {
+                link(heap, cluster[rng() % cluster.size()], previous_tree[rng() % previous_tree.size()]);
+            }
+            previous_tree.swap(tree);
+            heap.clusters++;
+        }
+    }
+
+    /**
+     * Удерживаемые размеры перебором: обход утечек от цикла каждой группы;
+     * объект удерживается группой, если его достигает только она
+     */
+    bool brute_force_check(const HeapImage &image, const LeakReport &report)
+    {
+        MarkBitmap marks;
+        image.mark(marks);
+        std::vector<int> index_of;
+        for (uint32_t i = 0; i < image.size(); ++i)
+        {
+            if (static_cast<size_t>(image.id(i)) >= index_of.size())
+            {
+                index_of.resize(image.id(i) + 1, -1);
+            }
+            index_of[image.id(i)] = static_cast<int>(i);
+        }
+
+        std::vector<uint32_t> hits(image.size(), 0);
+        std::vector<uint32_t> last(image.size(), UINT32_MAX);
+        std::vector<uint32_t> stack;
+        for (uint32_t g = 0; g < report.groups.size(); ++g)
+        {
+            for (int id : report.groups[g].cycle)
+            {
+                uint32_t index = static_cast<uint32_t>(index_of[id]);
+                if (last[index] != g)
+                {
+                    last[index] = g;
+                    hits[index]++;
+                    stack.push_back(index);
+                }
+            }
+            while (!stack.empty())
+            {
+                uint32_t index = stack.back();
+                stack.pop_back();
+                for (const uint32_t *edge = image.edges_begin(index); edge != image.edges_end(index); ++edge)
+                {
+                    if (!marks.test(*edge) && last[*edge] != g)
+                    {
+                        last[*edge] = g;
+                        hits[*edge]++;
+                        stack.push_back(*edge);
+                    }
+                }
+            }
+        }
+
+        std::vector<uint64_t> retained(report.groups.size(), 0);
+        std::vector<uint64_t> retained_edges(report.groups.size(), 0);
+        uint64_t shared = 0;
+        for (uint32_t i = 0; i < image.size(); ++i)
+        {
+            if (marks.test(i))
+            {
+                continue;
+            }
+            if (hits[i] == 1)
+            {
+                retained[last[i]]++;
+                retained_edges[last[i]] += image.edges_end(i) - image.edges_begin(i);
+            }
+            else if (hits[i] > 1)
+            {
+                shared++;
+            }
+            else
+            {
+                return false; // утечка, не достижимая ни из одного источника
+            }
+        }
+        bool ok = shared == report.shared_objects;
+        for (size_t g = 0; g < report.groups.size(); ++g)
+        {
+            ok = ok && retained[g] == report.groups[g].retained_objects &&
+                 retained_edges[g] == report.groups[g].retained_edges;
+        }
+        return ok;
+    }
+
+    bool run(size_t target_edges, bool brute_force)
+    {
+        Heap heap;
+        auto start = Clock::now();
+        build(heap, target_edges, 42);
+        double build_sec = seconds_since(start);
+
+        start = Clock::now();
+        HeapImage image(heap.store, heap.roots);
+        double capture_sec = seconds_since(start);
+
+        start = Clock::now();
+        size_t flat = image.unreachable_ids().size();
+        double flat_sec = seconds_since(start);
+
+        start = Clock::now();
+        LeakReport report = LeakReport::analyze(image);
+        double report_sec = seconds_since(start);
+
+        uint64_t objects = report.shared_objects;
+        uint64_t edges = report.shared_edges;
+        bool sorted = true;
+        for (size_t g = 0; g < report.groups.size(); ++g)
+        {
+            objects += report.groups[g].retained_objects;
+            edges += report.groups[g].retained_edges;
+            sorted = sorted && (g == 0 || report.groups[g - 1].retained_objects >= report.groups[g].retained_objects);
+        }
+        bool ok = report.leaked_objects == flat && objects == report.leaked_objects &&
+                  edges == report.leaked_edges && report.groups.size() == heap.clusters && sorted;
+        if (brute_force)
+        {
+            ok = brute_force_check(image, report) && ok;
+        }
+
+        const size_t e = image.edge_count();
+        std::printf("%9zu objects %10zu edges (built %.1f s) | capture %8.1f ms | unreachable_ids %8.1f ms (%5.1f ns/edge)"
+                    " | LeakReport %8.1f ms (%5.1f ns/edge)\n",
+                    image.size(), e, build_sec, capture_sec * 1e3, flat_sec * 1e3, flat_sec * 1e9 / e,
+                    report_sec * 1e3, report_sec * 1e9 / e);
+        std::printf("          %zu leaked, %llu leaked edges, %zu groups, %llu cycles, shared %llu objects%s\n", flat,
+                    static_cast<unsigned long long>(report.leaked_edges), report.groups.size(),
+                    static_cast<unsigned long long>(report.cycles),
+                    static_cast<unsigned long long>(report.shared_objects),
+                    brute_force ? ", checked against brute force" : "");
+        if (brute_force)
+        {
+            report.dump(std::cout, 5);
+        }
+        return ok;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t max_edges = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+
+    bool ok = true;
+    for (size_t edges = 100000; edges < max_edges; edges *= 10)
+    {
+        ok = run(edges, edges == 100000) && ok;
+    }
+    ok = run(max_edges, max_edges <= 100000) && ok;
+    if (!ok)
+    {
+        std::printf("MISMATCH: leak report disagrees with the heap\n");
+        return 1;
+    }
+    std::printf("leak report verified\n");
+    return 0;
+}
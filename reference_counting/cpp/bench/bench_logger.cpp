@@ -0,0 +1,94 @@
+/**
+ * Бенчмарк стоимости записи события в лог.
+ *
+ * Пишет N событий (чередуя allocate / add_ref / remove_ref / delete) через
+ * EventLogger в форматах JsonLines и Binary и печатает время на событие.
+ * Затем проверяет, что бинарный лог, переведённый обратно в JSON-строки,
+ * совпадает с текстовым побайтно.
+ *
+ * Сборка (из каталога cpp/):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target bench_logger
+ * Запуск:
+ *   build/bench_logger [events] [dir]   (по умолчанию 1000000 и /tmp)
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "event_logger.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    void emit(EventLogger &logger, int i)
+    {
+        switch (i & 3)
+        {
+        case 0:
+            logger.log_allocate(i);
+            break;
+        case 1:
+            logger.log_add_ref(i - 1, i, i & 7);
+            break;
+        case 2:
+            logger.log_remove_ref(i - 2, i, i & 3);
+            break;
+        default:
+            logger.log_delete(i);
+            break;
+        }
+    }
+
+    double run(const std::string &path, LogFormat format, int events)
+    {
+        auto start = Clock::now();
+        {
+            EventLogger logger(path, format);
+            for (int i = 0; i < events; ++i)
+            {
+                emit(logger, i);
+            }
+        } // деструктор сбрасывает буфер
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / events;
+    }
+
+    std::string slurp(const std::string &path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        return ss.str();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int events = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    std::string dir = argc > 2 ? argv[2] : "/tmp";
+    std::string json_path = dir + "/bench_logger.log";
+    std::string bin_path = dir + "/bench_logger.bin";
+
+    double json_ns = run(json_path, LogFormat::JsonLines, events);
+    std::printf("json-lines | %10d events | %8.1f ns/event\n", events, json_ns);
+    double bin_ns = run(bin_path, LogFormat::Binary, events);
+    std::printf("binary     | %10d events | %8.1f ns/event | x%.1f\n", events, bin_ns, json_ns / bin_ns);
+
+    // Обратное преобразование должно дать тот же текст, что и JSON-лог
+    std::string converted;
+    BinaryLogReader reader(bin_path);
+    LogRecord record;
+    char line[kJsonRecordMax];
+    while (reader.next(record))
+    {
+        size_t len = format_json_record(record, line);
+        converted.append(line, len);
+        converted.push_back('\n');
+    }
+    bool same = converted == slurp(json_path);
+    std::printf("binary -> json round trip: %s\n", same ? "identical" : "MISMATCH");
+    return same ? 0 : 1;
+}
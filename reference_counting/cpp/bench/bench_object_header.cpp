@@ -0,0 +1,280 @@
+/**
+ * Бенчмарк размера объекта: обычный заголовок RCObject (40 байт, счётчик
+ * int) против компактного (-DRC_COMPACT_HEADER: 32 байта, 16-битный
+ * залипающий счётчик, sticky_ref_count.h).
+ *
+ * Графы с разными распределениями степеней:
+ *   - power_law — Барабаши–Альберт, m = 3: входящие степени со степенным
+ *     хвостом (немногие «популярные» объекты), исходящая — 3;
+ *   - erdos_renyi — случайный граф со средней степенью 4;
+ *   - binary_tree — у каждого объекта одна входящая и до двух исходящих;
+ *   - object_graph — как в кучах управляемых языков: у трети объектов нет
+ *     ссылок, у большинства остальных одна-две, редкие массивы держат
+ *     до 64; цели выбираются наполовину случайно, наполовину
+ *     пропорционально популярности.
+ * Для каждого графа печатаются байты на объект в ObjectStore (заголовки
+ * плюс вынесенные из объекта списки ссылок, поколения и индекс ID),
+ * доля объектов со ссылками во встроенном буфере и со счётчиком не больше 7,
+ * и скорость операций RCHeap: построение (allocate, add_ref, add_root),
+ * текучесть ссылок (пары add_ref/remove_ref) и трассировка всей кучи
+ * (collect_garbage, с восстановлением залипших счётчиков). Лог пишется
+ * в бинарном формате в /dev/null.
+ *
+ * Проверяется, что счётчики равны числу входящих ссылок (залипшие — не
+ * меньше максимума), и — на объекте-«хабе» с числом ссылок больше
+ * StickyRefCount::kSticky — что в компактном режиме залипший объект не
+ * освобождается подсчётом ссылок, а collect_garbage() восстанавливает
+ * точный счётчик живому и освобождает мёртвый.
+ *
+ * Режимы сравниваются двумя сборками (из каталога cpp/):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target bench_object_header
+ *   cmake -S . -B build-compact -DCMAKE_BUILD_TYPE=Release -DRC_COMPACT_HEADER=ON && \
+ *       cmake --build build-compact --target bench_object_header
+ * Запуск:
+ *   build/bench_object_header [objects]   (по умолчанию 1000000)
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "event_logger.h"
+#include "graph_generators.h"
+#include "object_store.h"
+#include "rc_heap.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double seconds_since(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    const int kHubReferrers = StickyRefCount::kSticky + 1000;
+
+    uint64_t edge_key(int from, int to)
+    {
+        return static_cast<uint64_t>(static_cast<uint32_t>(from)) << 32 | static_cast<uint32_t>(to);
+    }
+
+    /**
+     * Граф, похожий на кучу управляемого языка: тяжёлый хвост исходящих
+     * степеней и популярные цели
+     */
+    Graph make_object_graph(int n, uint64_t seed)
+    {
+        Graph graph;
+        graph.name = "object_graph/n=" + std::to_string(n);
+        graph.node_count = n;
+        std::mt19937_64 rng(seed);
+        std::vector<int> targets;
+        for (int id = 2; id <= n; ++id)
+        {
+            const uint64_t r = rng() % 100;
+            const int degree = r < 35 ? 0 : r < 65 ? 1 : r < 80 ? 2 : r < 88 ? 3 : r < 93 ? 4
+                               : r < 98 ? 5 + static_cast<int>(rng() % 4) : 9 + static_cast<int>(rng() % 56);
+            targets.clear();
+            for (int k = 0; k < degree; ++k)
+            {
+                const bool popular = rng() % 2 == 0 && !graph.edges.empty();
+                const int to = popular ? graph.edges[rng() % graph.edges.size()].second
+                                       : 1 + static_cast<int>(rng() % (id - 1));
+                if (std::find(targets.begin(), targets.end(), to) == targets.end())
+                {
+                    targets.push_back(to);
+                    graph.edges.emplace_back(id, to);
+                }
+            }
+        }
+        for (int i = 0; i < 16; ++i)
+        {
+            const int root = 1 + static_cast<int>(rng() % n);
+            if (std::find(graph.roots.begin(), graph.roots.end(), root) == graph.roots.end())
+            {
+                graph.roots.push_back(root);
+            }
+        }
+        return graph;
+    }
+
+    /**
+     * Память и распределение счётчиков: граф загружается прямо в ObjectStore
+     */
+    bool report_memory(const Graph &graph)
+    {
+        ObjectStore store;
+        store.reserve(graph.node_count);
+        std::vector<int> in_degree(static_cast<size_t>(graph.node_count) + 1, 0);
+        for (int id = 1; id <= graph.node_count; ++id)
+        {
+            store.emplace(id);
+        }
+        for (const auto &edge : graph.edges)
+        {
+            if (store.find(edge.first)->add_outgoing_ref(edge.second))
+            {
+                store.find(edge.second)->ref_count++;
+                in_degree[edge.second]++;
+            }
+        }
+        for (int root : graph.roots)
+        {
+            store.find(root)->ref_count++;
+            in_degree[root]++;
+        }
+
+        const ObjectStore &view = store;
+        size_t inline_edges = 0;
+        size_t small_counts = 0;
+        size_t sticky = 0;
+        size_t spilled_bytes = 0;
+        int max_count = 0;
+        bool ok = true;
+        for (int id = 1; id <= graph.node_count; ++id)
+        {
+            const RCObject &obj = view.at_slot(view.slot_of(id));
+            inline_edges += obj.references.memory_usage() == 0;
+            spilled_bytes += obj.references.memory_usage();
+            small_counts += in_degree[id] <= 7;
+            sticky += obj.has_sticky_count();
+            max_count = std::max(max_count, in_degree[id]);
+            ok = ok && (obj.has_sticky_count() ? in_degree[id] >= StickyRefCount::kSticky : obj.ref_count == in_degree[id]);
+        }
+
+        const double n = graph.node_count;
+        std::printf("%-34s %8zu edges | %5.1f bytes/object (header %zu, edge lists %5.1f) | inline edges %5.1f%%"
+                    " | ref_count <= 7 %5.1f%% | max ref_count %6d | sticky %zu\n",
+                    graph.name.c_str(), graph.edges.size(), store.unshared_memory_usage() / n, sizeof(RCObject),
+                    spilled_bytes / n, 100.0 * inline_edges / n, 100.0 * small_counts / n, max_count, sticky);
+        return ok;
+    }
+
+    /**
+     * Скорость операций RCHeap на том же графе
+     */
+    void report_throughput(const Graph &graph, EventLogger &logger)
+    {
+        RCHeap heap(logger);
+        auto start = Clock::now();
+        graph.load_into(heap);
+        const double build_sec = seconds_since(start);
+        const size_t build_ops = graph.node_count + graph.edges.size() + graph.roots.size();
+
+        // Текучесть: ссылка переезжает на другую цель того же распределения
+        std::vector<std::pair<int, int>> edges(graph.edges);
+        std::unordered_set<uint64_t> present;
+        for (const auto &edge : edges)
+        {
+            present.insert(edge_key(edge.first, edge.second));
+        }
+        std::mt19937_64 rng(7);
+        size_t churn_ops = 0;
+        start = Clock::now();
+        for (size_t i = 0; i < edges.size() && !edges.empty(); ++i)
+        {
+            std::pair<int, int> &edge = edges[rng() % edges.size()];
+            const int to = edges[rng() % edges.size()].second;
+            if (to == edge.first || present.count(edge_key(edge.first, to)) || !heap.object_exists(edge.first) ||
+                !heap.object_exists(to))
+            {
+                continue;
+            }
+            churn_ops += heap.add_ref(edge.first, to);
+            churn_ops += heap.remove_ref(edge.first, edge.second);
+            present.erase(edge_key(edge.first, edge.second));
+            present.insert(edge_key(edge.first, to));
+            edge.second = to;
+        }
+        const double churn_sec = seconds_since(start);
+
+        const size_t live = heap.get_heap_size();
+        start = Clock::now();
+        const size_t freed = heap.collect_garbage();
+        const double trace_sec = seconds_since(start);
+
+        std::printf("%-34s build %6.1f ns/op | churn %6.1f ns/op | collect_garbage %6.1f ns/object (%zu freed)\n",
+                    "", build_sec * 1e9 / build_ops, churn_ops > 0 ? churn_sec * 1e9 / churn_ops : 0.0,
+                    trace_sec * 1e9 / live, freed);
+    }
+
+    /**
+     * Объект, на который ссылается больше kSticky объектов
+     * @param rooted Остаётся ли хаб в корнях после снятия ссылок
+     */
+    bool check_hub(EventLogger &logger, bool rooted)
+    {
+        RCHeap heap(logger);
+        const int hub = 0;
+        heap.reserve(kHubReferrers + 1);
+        heap.allocate(hub);
+        heap.add_root(hub);
+        for (int id = 1; id <= kHubReferrers; ++id)
+        {
+            heap.allocate(id);
+            heap.add_ref(id, hub);
+        }
+        bool ok = heap.get_ref_count(hub) == (kCompactHeader ? StickyRefCount::kSticky : kHubReferrers + 1);
+
+        // Все ссылки на хаб, кроме корня, сняты (ссылавшиеся объекты живы: у них ref_count == 0)
+        for (int id = 1; id <= kHubReferrers; ++id)
+        {
+            heap.remove_ref(id, hub);
+        }
+        if (!rooted)
+        {
+            heap.remove_root(hub);
+        }
+        // Залипший хаб подсчёт ссылок не освобождает
+        ok = ok && heap.object_exists(hub) == (kCompactHeader || rooted);
+
+        heap.collect_garbage();
+        ok = ok && heap.object_exists(hub) == rooted && heap.get_heap_size() == kHubReferrers + (rooted ? 1 : 0);
+        if (rooted)
+        {
+            ok = ok && heap.get_ref_count(hub) == 1; // счётчик снова точный
+            heap.remove_root(hub);
+            ok = ok && !heap.object_exists(hub);
+        }
+        return ok;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int objects = argc > 1 ? std::atoi(argv[1]) : 1000000;
+
+    std::printf("-- %s header: sizeof(RCObject) = %zu, %u edges inline, reference count %s\n",
+                kCompactHeader ? "compact" : "default", sizeof(RCObject), ObjectEdgeSet::kInlineCapacity,
+                kCompactHeader ? "16-bit sticky" : "int");
+    const std::vector<Graph> graphs = {
+        make_power_law(objects, 3, 16, 1),
+        make_erdos_renyi(objects, 4.0 / objects, 16, 1),
+        make_binary_tree(objects),
+        make_object_graph(objects, 1),
+    };
+
+    EventLogger logger("/dev/null", LogFormat::Binary);
+    bool ok = true;
+    for (const Graph &graph : graphs)
+    {
+        ok = report_memory(graph) && ok;
+        report_throughput(graph, logger);
+    }
+    ok = check_hub(logger, true) && ok;
+    ok = check_hub(logger, false) && ok;
+
+    if (!ok)
+    {
+        std::printf("MISMATCH: reference counts disagree with the graph\n");
+        return 1;
+    }
+    std::printf("object header verified\n");
+    return 0;
+}
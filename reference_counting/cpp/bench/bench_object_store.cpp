@@ -0,0 +1,175 @@
+/**
+ * Бенчмарк хранилища объектов: std::unordered_map<int, RCObject> против ObjectStore.
+ *
+ * Измеряет время заполнения, случайного поиска по ID и объём выделенной памяти
+ * (через подсчёт operator new) на куче из N объектов (по умолчанию 1M).
+ *
+ * Сборка (из каталога cpp/):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target bench_object_store
+ * Запуск:
+ *   build/bench_object_store [objects] [lookups]
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "object_store.h"
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+namespace
+{
+    size_t g_live_bytes = 0;
+    size_t g_alloc_calls = 0;
+}
+
+// Подсчёт выделенной памяти: размер блока хранится перед ним
+void *operator new(size_t size)
+{
+    void *raw = std::malloc(size + sizeof(max_align_t));
+    if (raw == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    *static_cast<size_t *>(raw) = size;
+    g_live_bytes += size;
+    g_alloc_calls++;
+    return static_cast<char *>(raw) + sizeof(max_align_t);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    if (ptr == nullptr)
+    {
+        return;
+    }
+    void *raw = static_cast<char *>(ptr) - sizeof(max_align_t);
+    g_live_bytes -= *static_cast<size_t *>(raw);
+    std::free(raw);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double seconds_since(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    struct Result
+    {
+        double build_sec;
+        double lookup_sec;
+        size_t bytes;
+        size_t allocs;
+        long long checksum;
+    };
+
+    Result bench_map(const std::vector<int> &ids, const std::vector<int> &queries)
+    {
+        Result r{};
+        size_t bytes_before = g_live_bytes;
+        size_t allocs_before = g_alloc_calls;
+
+        auto start = Clock::now();
+        std::unordered_map<int, RCObject> heap;
+        for (int id : ids)
+        {
+            heap.emplace(id, RCObject(id));
+        }
+        r.build_sec = seconds_since(start);
+        r.bytes = g_live_bytes - bytes_before;
+        r.allocs = g_alloc_calls - allocs_before;
+
+        start = Clock::now();
+        for (int id : queries)
+        {
+            auto it = heap.find(id);
+            if (it != heap.end())
+            {
+                it->second.ref_count++;
+                r.checksum += it->second.ref_count;
+            }
+        }
+        r.lookup_sec = seconds_since(start);
+        return r;
+    }
+
+    Result bench_store(const std::vector<int> &ids, const std::vector<int> &queries)
+    {
+        Result r{};
+        size_t bytes_before = g_live_bytes;
+        size_t allocs_before = g_alloc_calls;
+
+        auto start = Clock::now();
+        ObjectStore heap;
+        for (int id : ids)
+        {
+            heap.emplace(id);
+        }
+        r.build_sec = seconds_since(start);
+        r.bytes = g_live_bytes - bytes_before;
+        r.allocs = g_alloc_calls - allocs_before;
+
+        start = Clock::now();
+        for (int id : queries)
+        {
+            RCObject *obj = heap.find(id);
+            if (obj != nullptr)
+            {
+                obj->ref_count++;
+                r.checksum += obj->ref_count;
+            }
+        }
+        r.lookup_sec = seconds_since(start);
+        return r;
+    }
+
+    void print(const char *name, const Result &r, size_t objects, size_t lookups)
+    {
+        std::printf("%-22s build %8.3f s | lookup %7.2f ns/op | %8.2f MiB (%5.1f B/object) | %9zu allocs | checksum %lld\n",
+                    name, r.build_sec, r.lookup_sec * 1e9 / static_cast<double>(lookups),
+                    static_cast<double>(r.bytes) / (1024.0 * 1024.0),
+                    static_cast<double>(r.bytes) / static_cast<double>(objects),
+                    r.allocs, r.checksum);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t objects = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    size_t lookups = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10000000;
+
+    std::vector<int> ids(objects);
+    for (size_t i = 0; i < objects; ++i)
+    {
+        ids[i] = static_cast<int>(i + 1);
+    }
+    std::mt19937 rng(42);
+    std::shuffle(ids.begin(), ids.end(), rng);
+
+    std::vector<int> queries(lookups);
+    std::uniform_int_distribution<int> pick(1, static_cast<int>(objects));
+    for (int &q : queries)
+    {
+        q = pick(rng);
+    }
+
+    std::printf("objects=%zu lookups=%zu sizeof(RCObject)=%zu\n", objects, lookups, sizeof(RCObject));
+    print("unordered_map<int,RC>", bench_map(ids, queries), objects, lookups);
+    print("ObjectStore", bench_store(ids, queries), objects, lookups);
+    return 0;
+}
@@ -0,0 +1,145 @@
+/**
+ * Бенчмарк масштабирования параллельной фазы пометки.
+ *
+ * Для трёх форм графа — случайный (как в bench_tracer), длинная цепочка
+ * и широкий веер (корень ссылается на все объекты, каждый из которых
+ * ссылается на пару соседей) — запускает ParallelMarker на 1..N потоках
+ * и сверяет битовую карту с последовательным Tracer::mark.
+ *
+ * Сборка (из каталога cpp/):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target bench_parallel_mark
+ * Запуск:
+ *   build/bench_parallel_mark [objects] [max_threads]
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <unordered_set>
+
+#include "object_store.h"
+#include "tracer.h"
+#include "parallel_marker.h"
+#include "event_logger.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct GraphBuilder
+    {
+        ObjectStore &heap;
+        size_t edges = 0;
+
+        void create(int objects)
+        {
+            heap.reserve(static_cast<size_t>(objects));
+            for (int id = 0; id < objects; ++id)
+            {
+                heap.emplace(id);
+            }
+            heap.find(0)->ref_count = 1; // корень
+        }
+
+        void link(int from, int to)
+        {
+            if (from != to && heap.find(from)->add_outgoing_ref(to))
+            {
+                heap.find(to)->ref_count++;
+                edges++;
+            }
+        }
+    };
+
+    size_t build_random(ObjectStore &heap, int objects)
+    {
+        GraphBuilder g{heap};
+        g.create(objects);
+        std::mt19937 rng(1234);
+        std::uniform_int_distribution<int> any(0, objects - 1);
+        for (int id = 1; id < objects; ++id)
+        {
+            std::uniform_int_distribution<int> parent(0, id - 1);
+            g.link(parent(rng), id);
+            g.link(id, any(rng));
+        }
+        return g.edges;
+    }
+
+    size_t build_chain(ObjectStore &heap, int objects)
+    {
+        GraphBuilder g{heap};
+        g.create(objects);
+        for (int id = 1; id < objects; ++id)
+        {
+            g.link(id - 1, id);
+        }
+        return g.edges;
+    }
+
+    size_t build_fan_out(ObjectStore &heap, int objects)
+    {
+        GraphBuilder g{heap};
+        g.create(objects);
+        for (int id = 1; id < objects; ++id)
+        {
+            g.link(0, id);
+        }
+        for (int id = 1; id < objects; ++id)
+        {
+            g.link(id, 1 + id % (objects - 1));
+            g.link(id, 1 + (id * 7) % (objects - 1));
+        }
+        return g.edges;
+    }
+
+    bool run_graph(const char *name, size_t (*build)(ObjectStore &, int), int objects, unsigned max_threads)
+    {
+        ObjectStore heap;
+        size_t edges = build(heap, objects);
+        std::printf("\n%s: objects=%d edges=%zu\n", name, objects, edges);
+
+        EventLogger logger("/dev/null");
+        Tracer tracer(heap, logger);
+        std::unordered_set<int> roots{0};
+
+        auto start = Clock::now();
+        size_t expected = tracer.mark(roots);
+        double serial_sec = std::chrono::duration<double>(Clock::now() - start).count();
+        std::printf("  serial   | marked %10zu | %7.3f s\n", expected, serial_sec);
+
+        bool ok = true;
+        ParallelMarker marker(heap);
+        MarkBitmap marks;
+        for (unsigned threads = 1; threads <= max_threads; ++threads)
+        {
+            marker.set_thread_count(threads);
+            start = Clock::now();
+            size_t marked = marker.mark(roots, marks);
+            double sec = std::chrono::duration<double>(Clock::now() - start).count();
+            bool same = marked == expected && marks.words() == tracer.get_marks().words();
+            ok = ok && same;
+            std::printf("  %2u thr   | marked %10zu | %7.3f s | x%5.2f vs serial | %s\n",
+                        threads, marked, sec, serial_sec / sec, same ? "ok" : "MISMATCH");
+        }
+        return ok;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int objects = argc > 1 ? std::atoi(argv[1]) : 2000000;
+    unsigned max_threads = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2]))
+                                    : std::thread::hardware_concurrency();
+    if (max_threads == 0)
+    {
+        max_threads = 1;
+    }
+
+    bool ok = true;
+    ok = run_graph("random", build_random, objects, max_threads) && ok;
+    ok = run_graph("chain", build_chain, objects, max_threads) && ok;
+    ok = run_graph("fan-out", build_fan_out, objects, max_threads) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,141 @@
+/**
+ * Бенчмарк пауз: немедленный каскад против отложенного режима с ZCT.
+ *
+ * Нагрузка: объект-владелец 0 держит "окно" из нескольких деревьев случайного
+ * размера (степенное распределение до max_tree объектов). Мутатор строит новые
+ * деревья и отпускает самые старые, так что иногда одной операцией
+ * умирает большой подграф. Для каждой операции мутатора измеряется её
+ * длительность; в отложенном режиме к операции добавляется collect(budget).
+ *
+ * Сборка (из каталога cpp/):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target bench_pause
+ * Запуск:
+ *   build/bench_pause [total_objects] [max_tree] [budget_objects]
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "rc_heap.h"
+#include "event_logger.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct PauseStats
+    {
+        std::vector<double> pauses_ns;
+        double total_sec = 0.0;
+    };
+
+    double percentile(std::vector<double> &sorted, double p)
+    {
+        size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1));
+        return sorted[index];
+    }
+
+    PauseStats run(bool deferred, int total_objects, int max_tree, const CollectBudget &budget)
+    {
+        EventLogger logger("/dev/null");
+        RCHeap heap(logger);
+        heap.set_deferred(deferred);
+        // Заранее выделить слоты, чтобы рост массива не попадал в паузы
+        heap.reserve(static_cast<size_t>(total_objects));
+
+        PauseStats stats;
+        stats.pauses_ns.reserve(static_cast<size_t>(total_objects) * 3);
+
+        std::mt19937 rng(7);
+        // Степенное распределение размеров деревьев: size = max_tree^u, u ~ U(0,1)
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+        auto timed = [&](auto &&op)
+        {
+            auto start = Clock::now();
+            op();
+            if (deferred)
+            {
+                heap.collect(budget);
+            }
+            stats.pauses_ns.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+        };
+
+        auto bench_start = Clock::now();
+        heap.allocate(0);
+        heap.add_root(0);
+
+        std::deque<int> live_trees;
+        int next_id = 1;
+        while (next_id < total_objects)
+        {
+            int size = std::max(1, static_cast<int>(std::pow(static_cast<double>(max_tree), unit(rng))));
+            size = std::min(size, total_objects - next_id);
+
+            // Построить дерево: каждый узел ссылается на случайного предыдущего
+            int tree_root = next_id;
+            for (int i = 0; i < size; ++i)
+            {
+                int id = next_id++;
+                timed([&]
+                      { heap.allocate(id); });
+                if (i == 0)
+                {
+                    timed([&]
+                          { heap.add_ref(0, id); });
+                }
+                else
+                {
+                    std::uniform_int_distribution<int> parent(tree_root, id - 1);
+                    int p = parent(rng);
+                    timed([&]
+                          { heap.add_ref(p, id); });
+                }
+            }
+            live_trees.push_back(tree_root);
+
+            // Держать в живых не больше 8 деревьев: отпустить самое старое
+            if (live_trees.size() > 8)
+            {
+                int victim = live_trees.front();
+                live_trees.pop_front();
+                timed([&]
+                      { heap.remove_ref(0, victim); });
+            }
+        }
+
+        // Досчитать остаток ZCT, чтобы сравнение было честным по объёму работы
+        heap.collect();
+        stats.total_sec = std::chrono::duration<double>(Clock::now() - bench_start).count();
+        return stats;
+    }
+
+    void report(const char *name, PauseStats stats)
+    {
+        std::sort(stats.pauses_ns.begin(), stats.pauses_ns.end());
+        std::printf("%-22s ops %9zu | p50 %8.0f ns | p99 %8.0f ns | p99.9 %10.0f ns | max %12.0f ns | total %6.2f s\n",
+                    name, stats.pauses_ns.size(),
+                    percentile(stats.pauses_ns, 0.50), percentile(stats.pauses_ns, 0.99),
+                    percentile(stats.pauses_ns, 0.999), stats.pauses_ns.back(), stats.total_sec);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int total_objects = argc > 1 ? std::atoi(argv[1]) : 2000000;
+    int max_tree = argc > 2 ? std::atoi(argv[2]) : 200000;
+    size_t budget = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 64;
+
+    std::printf("objects=%d max_tree=%d deferred budget=%zu objects/op or 20 us/op\n",
+                total_objects, max_tree, budget);
+    report("eager cascade", run(false, total_objects, max_tree, CollectBudget()));
+    report("deferred, objects", run(true, total_objects, max_tree, CollectBudget::objects(budget)));
+    report("deferred, time slice", run(true, total_objects, max_tree,
+                                       CollectBudget::time(std::chrono::microseconds(20))));
+    return 0;
+}
@@ -0,0 +1,312 @@
+/**
+ * Бенчмарк пула памяти для списков ссылок (pool_allocator.h).
+ *
+ * Текучесть кучи: раунды по round_size объектов строят под временным
+ * корнем дерево с разным ветвлением (от 1 до 48 детей — и встроенные
+ * списки, и внешние массивы, и массивы с хеш-индексом), затем корень
+ * снимается и каскад удаляет весь раунд. ID переиспользуются, так что
+ * размер хранилища объектов не растёт. Всего создаётся objects объектов.
+ *
+ * Для каждой фазы печатаются время, число вызовов operator new (глобальный
+ * operator new этого бенчмарка подменён счётчиком) и RSS. Затем тот же
+ * рисунок выделений гоняется прямо на EdgeSet и BasicEdgeSet<PoolAllocator>.
+ *
+ * В сборке с пулом подграфы по 65536 объектов строятся и умирают, пока жив
+ * постоянный корень со своим списком ссылок. Проверяется, что куски
+ * умерших подграфов освобождаются целиком (get_chunk_release_count) и что
+ * release_memory() возвращает системе пустые куски при живых блоках корня.
+ *
+ * Куча сравнивается двумя сборками (из каталога cpp/):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target bench_pool_alloc
+ *   cmake -S . -B build-nopool -DCMAKE_BUILD_TYPE=Release -DRC_POOL_ALLOCATOR=OFF && \
+ *       cmake --build build-nopool --target bench_pool_alloc
+ * Запуск:
+ *   build/bench_pool_alloc [objects] [round_size]   (по умолчанию 10000000 и 4096)
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include "edge_set.h"
+#include "event_logger.h"
+#include "pool_allocator.h"
+#include "rc_heap.h"
+
+namespace
+{
+    std::atomic<uint64_t> g_new_calls{0};
+}
+
+void *operator new(size_t size)
+{
+    g_new_calls.fetch_add(1, std::memory_order_relaxed);
+    void *pointer = std::malloc(size == 0 ? 1 : size);
+    if (pointer == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void *operator new(size_t size, std::align_val_t align)
+{
+    g_new_calls.fetch_add(1, std::memory_order_relaxed);
+    const size_t alignment = static_cast<size_t>(align);
+    void *pointer = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    if (pointer == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *pointer) noexcept { std::free(pointer); }
+void operator delete[](void *pointer) noexcept { std::free(pointer); }
+void operator delete(void *pointer, size_t) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, size_t) noexcept { std::free(pointer); }
+void operator delete(void *pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete(void *pointer, size_t, std::align_val_t) noexcept { std::free(pointer); }
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Ветвление родителей по кругу: среднее ~10 детей на внутренний узел
+    const int kFanOuts[] = {1, 2, 3, 4, 6, 12, 24, 48};
+    const int kFanOutCount = sizeof(kFanOuts) / sizeof(kFanOuts[0]);
+
+    /**
+     * @brief Текущий RSS процесса в КиБ (0, если неизвестен)
+     */
+    long rss_kib()
+    {
+#if defined(__linux__)
+        long pages = 0, resident = 0;
+        std::FILE *statm = std::fopen("/proc/self/statm", "r");
+        if (statm != nullptr)
+        {
+            if (std::fscanf(statm, "%ld %ld", &pages, &resident) != 2)
+            {
+                resident = 0;
+            }
+            std::fclose(statm);
+        }
+        return resident * (sysconf(_SC_PAGESIZE) / 1024);
+#else
+        return 0;
+#endif
+    }
+
+    /**
+     * @brief Пиковый RSS процесса в КиБ (0, если неизвестен)
+     */
+    long peak_rss_kib()
+    {
+#if defined(__linux__)
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+#else
+        return 0;
+#endif
+    }
+
+    /**
+     * @brief Рёбра дерева раунда: пары (родитель, ребёнок) в порядке построения
+     */
+    std::vector<std::pair<int, int>> round_edges(int round_size)
+    {
+        std::vector<std::pair<int, int>> edges;
+        int parent = 1;
+        int next = 2;
+        while (next <= round_size)
+        {
+            int fan_out = kFanOuts[parent % kFanOutCount];
+            for (int k = 0; k < fan_out && next <= round_size; ++k)
+            {
+                edges.emplace_back(parent, next++);
+            }
+            parent++;
+        }
+        return edges;
+    }
+
+    struct Phase
+    {
+        const char *name;
+        uint64_t start_calls;
+        long start_rss;
+        Clock::time_point start;
+
+        explicit Phase(const char *name_)
+            : name(name_), start_calls(g_new_calls.load()), start_rss(rss_kib()), start(Clock::now()) {}
+
+        void report(size_t objects) const
+        {
+            double sec = std::chrono::duration<double>(Clock::now() - start).count();
+            uint64_t calls = g_new_calls.load() - start_calls;
+            std::printf("%-26s | %8.3f s | %10.0f obj/s | %10llu new | %7.3f new/obj | rss %+8ld KiB\n", name,
+                        sec, objects / sec, static_cast<unsigned long long>(calls),
+                        static_cast<double>(calls) / objects, rss_kib() - start_rss);
+        }
+    };
+
+    size_t heap_churn(size_t objects, int round_size)
+    {
+        const std::vector<std::pair<int, int>> edges = round_edges(round_size);
+        EventLogger logger{std::unique_ptr<LogSink>(new NullLogSink())};
+        RCHeap heap(logger);
+
+        size_t created = 0;
+        while (created < objects)
+        {
+            for (int id = 1; id <= round_size; ++id)
+            {
+                heap.allocate(id);
+            }
+            heap.add_root(1);
+            for (const auto &edge : edges)
+            {
+                heap.add_ref(edge.first, edge.second);
+            }
+            heap.remove_root(1);
+            created += round_size;
+        }
+        if (heap.get_heap_size() != 0)
+        {
+            std::printf("MISMATCH: %zu objects survived the churn\n", heap.get_heap_size());
+        }
+        return created;
+    }
+
+    /**
+     * Подграфы под временным корнем, пока жив постоянный корень со своим
+     * списком ссылок: куски умершего подграфа должны освобождаться целиком,
+     * хотя выданные блоки в пуле остаются
+     */
+    bool subgraph_release(int rounds, int round_size)
+    {
+        const std::vector<std::pair<int, int>> edges = round_edges(round_size);
+        EventLogger logger{std::unique_ptr<LogSink>(new NullLogSink())};
+        RCHeap heap(logger);
+        SizeClassPool &pool = SizeClassPool::local();
+
+        const int anchor = 0;
+        const int base = 1000;
+        heap.allocate(anchor);
+        heap.add_root(anchor);
+        for (int id = 1; id <= 100; ++id)
+        {
+            heap.allocate(id);
+            heap.add_ref(anchor, id);
+        }
+        const size_t anchor_blocks = pool.get_live_blocks();
+        const size_t releases_before = pool.get_chunk_release_count();
+        size_t peak_chunks = 0;
+
+        bool ok = anchor_blocks > 0;
+        for (int round = 0; round < rounds; ++round)
+        {
+            for (int id = 1; id <= round_size; ++id)
+            {
+                heap.allocate(base + id);
+            }
+            heap.add_root(base + 1);
+            for (const auto &edge : edges)
+            {
+                heap.add_ref(base + edge.first, base + edge.second);
+            }
+            peak_chunks = std::max(peak_chunks, pool.get_chunk_count());
+            heap.remove_root(base + 1);
+            ok = ok && heap.get_heap_size() == 101 && pool.get_live_blocks() == anchor_blocks;
+        }
+        const size_t releases = pool.get_chunk_release_count() - releases_before;
+        const size_t empty = pool.get_empty_chunk_count();
+        const size_t chunks_before = pool.get_chunk_count();
+        const bool released_all = pool.release_memory();
+        std::printf("subgraphs under a live root | %d rounds of %d | %zu whole-chunk releases | peak %zu chunks,"
+                    " %zu empty after the last round | release_memory: %zu -> %zu chunks (%s)\n",
+                    rounds, round_size, releases, peak_chunks, empty, chunks_before, pool.get_chunk_count(),
+                    released_all ? "pool empty" : "root blocks live");
+        ok = ok && releases >= static_cast<size_t>(rounds) && !released_all &&
+             pool.get_chunk_count() < chunks_before && pool.get_live_blocks() == anchor_blocks;
+        if (!ok)
+        {
+            std::printf("MISMATCH: subgraph chunks were not released while the root lived\n");
+        }
+        return ok;
+    }
+
+    template <typename Set>
+    size_t set_churn(size_t objects, int round_size)
+    {
+        const std::vector<std::pair<int, int>> edges = round_edges(round_size);
+        std::vector<Set> sets(round_size + 1);
+
+        size_t created = 0;
+        while (created < objects)
+        {
+            for (const auto &edge : edges)
+            {
+                sets[edge.first].insert(edge.second);
+            }
+            for (Set &set : sets)
+            {
+                set.clear();
+            }
+            created += round_size;
+        }
+        return created;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t objects = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+    int round_size = argc > 2 ? std::atoi(argv[2]) : 4096;
+    if (round_size < 2)
+    {
+        round_size = 2;
+    }
+
+    std::printf("pool allocator %s | %zu objects, rounds of %d\n", kPoolAllocatorEnabled ? "on " : "off", objects,
+                round_size);
+
+    {
+        Phase phase(kPoolAllocatorEnabled ? "RCHeap churn (pool)" : "RCHeap churn (std)");
+        size_t created = heap_churn(objects, round_size);
+        phase.report(created);
+    }
+    {
+        Phase phase("EdgeSet churn (std)");
+        size_t created = set_churn<EdgeSet>(objects, round_size);
+        phase.report(created);
+    }
+    {
+        Phase phase("EdgeSet churn (pool)");
+        size_t created = set_churn<BasicEdgeSet<PoolAllocator<int>>>(objects, round_size);
+        phase.report(created);
+    }
+
+    bool ok = !kPoolAllocatorEnabled || subgraph_release(20, 65536);
+
+    SizeClassPool &pool = SizeClassPool::local();
+    std::printf("pool: %zu chunks (%zu KiB) reserved, %zu live blocks\n", pool.get_chunk_count(),
+                pool.get_reserved_bytes() / 1024, pool.get_live_blocks());
+    long before = rss_kib();
+    bool released = pool.release_memory();
+    std::printf("release_memory: %s, rss %ld -> %ld KiB, peak %ld KiB\n", released ? "ok" : "blocks still live",
+                before, rss_kib(), peak_rss_kib());
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,244 @@
+/**
+ * Бенчмарк инкрементального индекса циклов (SccIndex).
+ *
+ * Растущая куча: объекты выделяются по одному, каждый новый объект
+ * удерживается более старым (ссылки дерева, по порядку), и
+ * с вероятностью cross добавляется ссылка между двумя живыми объектами
+ * (может идти против порядка и замыкать циклы). Время от времени одна из
+ * таких ссылок удаляется (компонента становится «грязной»). Все объекты
+ * удерживаются деревом от корня, поэтому удаления ничего не освобождают.
+ *
+ * Два распределения дополнительных ссылок:
+ *   - local   — владелец и дополнительные ссылки среди объектов с близкими
+ *     ID (окно kLocalWindow): обратные указатели, списки, маленькие циклы,
+ *     как в реальных кучах;
+ *   - uniform — между любыми объектами: быстро образуется гигантская
+ *     компонента, и каждое слияние с ней стоит O(её размера). Худший случай,
+ *     поэтому прогоняется только до kUniformLimit объектов.
+ *
+ * Измеряется:
+ *   - стоимость мутатора с индексом и без (нс на операцию), счётчики
+ *     перестановок, слияний и разбиений — амортизированная стоимость;
+ *   - in_cycle() против итеративного DFS «вернётся ли обход в объект»;
+ *   - построение индекса с нуля (attach) по готовой куче.
+ * Проверяет инварианты индекса и совпадение in_cycle() с DFS.
+ *
+ * Сборка (из каталога cpp/):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target bench_scc_index
+ * Запуск:
+ *   build/bench_scc_index [max_objects] [cross]   (по умолчанию 1000000 и 0.3)
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "event_logger.h"
+#include "rc_heap.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double seconds_since(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    const int kLocalWindow = 256;
+    const int kUniformLimit = 100000;
+
+    /**
+     * Вырастить кучу из objects объектов; возвращает количество операций
+     * @param window Окно ID для дополнительных ссылок; 0 — любые объекты
+     */
+    size_t grow(RCHeap &heap, int objects, double cross, int window, uint64_t seed)
+    {
+        std::mt19937_64 rng(seed);
+        std::uniform_real_distribution<double> coin(0.0, 1.0);
+        std::vector<std::pair<int, int>> extra;
+        std::unordered_set<uint64_t> edges;
+        auto key = [](int from, int to) { return static_cast<uint64_t>(from) << 32 | static_cast<uint32_t>(to); };
+        size_t ops = 0;
+
+        heap.allocate(0);
+        heap.add_root(0);
+        for (int id = 1; id < objects; ++id)
+        {
+            heap.allocate(id);
+            int parent = window == 0 || window > id ? static_cast<int>(rng() % id) : id - 1 - static_cast<int>(rng() % window);
+            heap.add_ref(parent, id);
+            edges.insert(key(parent, id));
+            ops += 2;
+            if (coin(rng) < cross)
+            {
+                int span = window == 0 || window > id ? id + 1 : window;
+                int from = id - static_cast<int>(rng() % span);
+                int to = id - static_cast<int>(rng() % span);
+                if (from != to && edges.insert(key(from, to)).second)
+                {
+                    heap.add_ref(from, to);
+                    extra.emplace_back(from, to);
+                    ops++;
+                }
+            }
+            if (!extra.empty() && coin(rng) < cross / 4)
+            {
+                size_t pick = rng() % extra.size();
+                heap.remove_ref(extra[pick].first, extra[pick].second);
+                edges.erase(key(extra[pick].first, extra[pick].second));
+                extra[pick] = extra.back();
+                extra.pop_back();
+                ops++;
+            }
+        }
+        return ops;
+    }
+
+    /**
+     * Лежит ли объект на цикле: вернётся ли в него обход из его ссылок
+     */
+    bool on_cycle_dfs(const ObjectStore &store, int obj_id, std::vector<uint8_t> &seen, std::vector<uint32_t> &touched)
+    {
+        const uint32_t target = store.slot_of(obj_id);
+        std::vector<uint32_t> stack(1, target);
+        bool found = false;
+        while (!stack.empty() && !found)
+        {
+            uint32_t slot = stack.back();
+            stack.pop_back();
+            for (int child_id : store.at_slot(slot).references)
+            {
+                uint32_t child = store.slot_of(child_id);
+                if (child == target)
+                {
+                    found = true;
+                    break;
+                }
+                if (child != ObjectStore::kInvalidSlot && seen[child] == 0)
+                {
+                    seen[child] = 1;
+                    touched.push_back(child);
+                    stack.push_back(child);
+                }
+            }
+        }
+        for (uint32_t slot : touched)
+        {
+            seen[slot] = 0;
+        }
+        touched.clear();
+        return found;
+    }
+
+    bool run(int objects, double cross, int window)
+    {
+        EventLogger logger{std::unique_ptr<LogSink>(new NullLogSink())};
+
+        // Мутатор без индекса
+        RCHeap plain(logger);
+        plain.reserve(objects);
+        auto start = Clock::now();
+        size_t ops = grow(plain, objects, cross, window, 42);
+        double plain_sec = seconds_since(start);
+
+        // Тот же мутатор с индексом
+        RCHeap heap(logger);
+        heap.reserve(objects);
+        heap.set_scc_tracking(true);
+        start = Clock::now();
+        grow(heap, objects, cross, window, 42);
+        double tracked_sec = seconds_since(start);
+        SccIndex &index = heap.get_scc_index();
+        const SccIndexStats stats = index.get_stats();
+
+        std::printf("%-7s %9d objects %9zu ops | plain %7.1f ns/op | indexed %7.1f ns/op (x%.2f)\n", window ? "local" : "uniform", objects, ops,
+                    plain_sec * 1e9 / ops, tracked_sec * 1e9 / ops, tracked_sec / plain_sec);
+        std::printf("                  edges +%zu -%zu | reorders %zu (%.2f%% of adds), %.1f components visited per reorder"
+                    " | merges %zu | splits %zu | relabels %zu\n",
+                    static_cast<size_t>(stats.edges_added), static_cast<size_t>(stats.edges_removed),
+                    static_cast<size_t>(stats.reorders), 100.0 * stats.reorders / stats.edges_added,
+                    stats.reorders ? static_cast<double>(stats.components_visited) / stats.reorders : 0.0,
+                    static_cast<size_t>(stats.merges), static_cast<size_t>(stats.splits),
+                    static_cast<size_t>(stats.relabels));
+
+        // Запросы: in_cycle для всех объектов (первый проход доразбивает грязные компоненты)
+        start = Clock::now();
+        size_t cyclic = 0;
+        for (int id = 0; id < objects; ++id)
+        {
+            cyclic += heap.in_cycle(id);
+        }
+        double first_sec = seconds_since(start);
+        start = Clock::now();
+        size_t again = 0;
+        for (int id = 0; id < objects; ++id)
+        {
+            again += heap.in_cycle(id);
+        }
+        double query_sec = seconds_since(start);
+        bool ok = again == cyclic && index.verify();
+
+        // Тот же вопрос обходом графа (на выборке: каждый обход до O(V+E))
+        std::shared_ptr<const HeapView> view = heap.snapshot();
+        const ObjectStore &store = view->get_objects();
+        std::vector<uint8_t> seen(store.slot_count(), 0);
+        std::vector<uint32_t> touched;
+        std::mt19937 rng(7);
+        const int sample = 200;
+        start = Clock::now();
+        for (int i = 0; i < sample; ++i)
+        {
+            int id = static_cast<int>(rng() % objects);
+            ok = ok && on_cycle_dfs(store, id, seen, touched) == heap.in_cycle(id);
+        }
+        double dfs_sec = seconds_since(start) / sample;
+
+        std::printf("                  %zu objects on cycles in %zu components | in_cycle %.1f ns (first pass %.1f ns)"
+                    " | DFS %.1f us\n",
+                    cyclic, index.component_count(), query_sec * 1e9 / objects, first_sec * 1e9 / objects,
+                    dfs_sec * 1e6);
+
+        // Построение с нуля по готовой куче
+        heap.set_scc_tracking(false);
+        start = Clock::now();
+        heap.set_scc_tracking(true);
+        double attach_sec = seconds_since(start);
+        size_t rebuilt = 0;
+        for (int id = 0; id < objects; ++id)
+        {
+            rebuilt += heap.in_cycle(id);
+        }
+        ok = ok && rebuilt == cyclic && index.verify();
+        std::printf("                  attach (Tarjan over whole heap) %.1f ms\n", attach_sec * 1e3);
+        return ok;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int max_objects = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    double cross = argc > 2 ? std::atof(argv[2]) : 0.3;
+
+    bool ok = true;
+    for (int objects = 10000; objects <= max_objects; objects *= 10)
+    {
+        ok = run(objects, cross, kLocalWindow) && ok;
+        if (objects <= kUniformLimit)
+        {
+            ok = run(objects, cross, 0) && ok;
+        }
+    }
+    if (!ok)
+    {
+        std::printf("MISMATCH: index disagrees with the heap\n");
+        return 1;
+    }
+    std::printf("index verified\n");
+    return 0;
+}
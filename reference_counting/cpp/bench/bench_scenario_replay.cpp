@@ -0,0 +1,155 @@
+/**
+ * Бенчмарк потокового чтения и выполнения сценариев.
+ *
+ * Генерирует JSON-сценарий из N операций (цепочки по 16 объектов: корень,
+ * ссылки, снятие корня с каскадом) и измеряет:
+ *   1. только разбор ScenarioReader (ops/s и MB/s);
+ *   2. RCHeap::replay без вывода состояния;
+ *   3. RCHeap::replay с dump_state() после каждой операции (на префиксе,
+ *      вывод уходит в пустой буфер) — стоимость прежнего режима.
+ *
+ * Сборка (из каталога cpp/):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target bench_scenario_replay
+ * Запуск:
+ *   build/bench_scenario_replay [ops] [dir]   (по умолчанию 2000000 и /tmp)
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <streambuf>
+#include <string>
+
+#include "event_logger.h"
+#include "rc_heap.h"
+#include "scenario_reader.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const int kChain = 16;
+
+    /**
+     * @return Фактическое число операций (кратно длине блока)
+     */
+    size_t generate(const std::string &path, size_t ops)
+    {
+        std::FILE *out = std::fopen(path.c_str(), "w");
+        if (out == nullptr)
+        {
+            std::perror(path.c_str());
+            std::exit(1);
+        }
+        std::fputs("[\n", out);
+        size_t written = 0;
+        bool first = true;
+        auto emit = [&](const char *op, int a, int b)
+        {
+            std::fputs(first ? "  " : ",\n  ", out);
+            first = false;
+            if (b < 0)
+            {
+                std::fprintf(out, "{\"op\": \"%s\", \"id\": %d}", op, a);
+            }
+            else
+            {
+                std::fprintf(out, "{\"op\": \"%s\", \"from\": %d, \"to\": %d}", op, a, b);
+            }
+            written++;
+        };
+        // Блок: allocate+add_root корня, allocate+add_ref на звено, remove_root
+        while (written + 2 * kChain + 1 <= ops)
+        {
+            emit("allocate", 1, -1);
+            emit("add_root", 1, -1);
+            for (int k = 2; k <= kChain; ++k)
+            {
+                emit("allocate", k, -1);
+                emit("add_ref", k - 1, k);
+            }
+            emit("remove_root", 1, -1); // каскад удаляет всю цепочку
+        }
+        std::fputs("\n]\n", out);
+        std::fclose(out);
+        return written;
+    }
+
+    class NullBuffer : public std::streambuf
+    {
+    protected:
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char *, std::streamsize n) override { return n; }
+    };
+
+    double seconds_since(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t ops = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+    std::string dir = argc > 2 ? argv[2] : "/tmp";
+    std::string path = dir + "/bench_scenario.json";
+
+    size_t generated = generate(path, ops);
+
+    // 1. Только разбор
+    size_t parsed = 0;
+    double mb = 0;
+    auto start = Clock::now();
+    {
+        ScenarioReader reader(path);
+        ScenarioOp op;
+        while (reader.next(op))
+        {
+            parsed++;
+        }
+        mb = reader.bytes_read() / 1e6;
+    }
+    double parse_sec = seconds_since(start);
+    std::printf("parse only     | %9zu ops | %7.1f MB | %12.0f ops/s | %7.1f MB/s\n", parsed, mb,
+                parsed / parse_sec, mb / parse_sec);
+
+    EventLogger logger{std::unique_ptr<LogSink>(new NullLogSink())};
+
+    // 2. Выполнение без вывода состояния
+    start = Clock::now();
+    size_t replayed;
+    {
+        RCHeap heap(logger);
+        ScenarioReader reader(path);
+        replayed = heap.replay(reader, false);
+    }
+    double replay_sec = seconds_since(start);
+    std::printf("replay         | %9zu ops |            | %12.0f ops/s\n", replayed, replayed / replay_sec);
+
+    // 3. С dump_state() после каждой операции — на префиксе сценария
+    size_t prefix = std::min<size_t>(generated, 20000);
+    NullBuffer null_buffer;
+    std::streambuf *saved = std::cout.rdbuf(&null_buffer);
+    start = Clock::now();
+    {
+        RCHeap heap(logger);
+        ScenarioReader reader(path);
+        ScenarioOp op;
+        for (size_t i = 0; i < prefix && reader.next(op); ++i)
+        {
+            heap.apply(op);
+            heap.dump_state();
+        }
+    }
+    double dump_sec = seconds_since(start);
+    std::cout.rdbuf(saved);
+    std::printf("replay + dump  | %9zu ops |            | %12.0f ops/s | x%.1f slower\n", prefix,
+                prefix / dump_sec, (replayed / replay_sec) / (prefix / dump_sec));
+
+    bool ok = parsed == generated && replayed == generated;
+    std::printf("ops parsed and replayed: %s\n", ok ? "ok" : "MISMATCH");
+    std::remove(path.c_str());
+    return ok ? 0 : 1;
+}
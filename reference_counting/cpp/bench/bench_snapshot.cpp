@@ -0,0 +1,243 @@
+/**
+ * Бенчмарк снимков кучи: dump_state() против полных и diff-кадров
+ * HeapSnapshotWriter.
+ *
+ * Строит кучу из графа со степенным распределением (objects вершин,
+ * 3 ссылки на вершину), затем сравнивает:
+ *   - текстовый dump_state() всей кучи;
+ *   - полный бинарный кадр;
+ *   - мутации (allocate + add_ref, remove_ref с каскадом, переключение
+ *     корня) с diff-кадром после каждых every операций — и сколько стоили
+ *     бы полные кадры с той же частотой;
+ *   - полный кадр по квантам времени slice_us, между которыми выполняется
+ *     по 64 мутации: максимальная пауза мутатора и длительность кадра.
+ * В конце читает файл HeapSnapshotReader'ом и сверяет восстановленное
+ * состояние с dump_state() кучи.
+ *
+ * Сборка (из каталога cpp/):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target bench_snapshot
+ * Запуск:
+ *   build/bench_snapshot [objects] [ops] [every] [slice_us] [dir]
+ *   (по умолчанию 1000000, 200000, 1000, 1000 и /tmp)
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "event_logger.h"
+#include "graph_generators.h"
+#include "heap_snapshot.h"
+#include "rc_heap.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double seconds_since(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    /**
+     * Мутатор с ограниченным числом временных объектов: каждая операция
+     * создаёт объект, на который ссылается случайный объект графа, и
+     * снимает ссылку с самого старого временного (он удаляется каскадом).
+     * Каждая 500-я операция добавляет или снимает корень.
+     */
+    class Mutator
+    {
+    public:
+        Mutator(RCHeap &heap_, int objects) : heap(heap_), graph_size(objects), next_id(objects + 3), rng(7)
+        {
+            // Объект pinned удерживается holder'ом, поэтому корень на нём можно снимать
+            holder = objects + 1;
+            pinned = objects + 2;
+            heap.allocate(holder);
+            heap.allocate(pinned);
+            heap.add_root(holder);
+            heap.add_ref(holder, pinned);
+        }
+
+        void step()
+        {
+            int owner = 1 + static_cast<int>(rng() % graph_size);
+            int temp = next_id++;
+            heap.allocate(temp);
+            heap.add_ref(owner, temp);
+            temps.emplace_back(owner, temp);
+            if (temps.size() > 1024)
+            {
+                heap.remove_ref(temps.front().first, temps.front().second);
+                temps.pop_front();
+            }
+            if (++count % 500 == 0)
+            {
+                if (pinned_root)
+                {
+                    heap.remove_root(pinned);
+                }
+                else
+                {
+                    heap.add_root(pinned);
+                }
+                pinned_root = !pinned_root;
+            }
+        }
+
+    private:
+        RCHeap &heap;
+        int graph_size;
+        int next_id;
+        int holder;
+        int pinned;
+        bool pinned_root = false;
+        size_t count = 0;
+        std::mt19937 rng;
+        std::deque<std::pair<int, int>> temps;
+    };
+
+    /**
+     * Состояние как текст dump_state(); корни отсортированы, т.к. порядок
+     * обхода unordered_set зависит от истории вставок
+     */
+    std::string normalize(const std::string &text)
+    {
+        size_t roots_begin = text.find("ROOTS: ");
+        size_t roots_end = text.find('\n', roots_begin);
+        std::istringstream roots_line(text.substr(roots_begin + 7, roots_end - roots_begin - 7));
+        std::vector<int> roots;
+        int root;
+        while (roots_line >> root)
+        {
+            roots.push_back(root);
+        }
+        std::sort(roots.begin(), roots.end());
+        std::string sorted;
+        for (int id : roots)
+        {
+            sorted += std::to_string(id) + " ";
+        }
+        return text.substr(0, roots_begin + 7) + sorted + text.substr(roots_end);
+    }
+
+    std::string capture_dump(const RCHeap &heap)
+    {
+        std::ostringstream captured;
+        std::streambuf *saved = std::cout.rdbuf(captured.rdbuf());
+        heap.dump_state();
+        std::cout.rdbuf(saved);
+        return captured.str();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int objects = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    size_t ops = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 200000;
+    size_t every = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1000;
+    long slice_us = argc > 4 ? std::atol(argv[4]) : 1000;
+    std::string dir = argc > 5 ? argv[5] : "/tmp";
+    const std::string path = dir + "/bench_snapshot.rcsn";
+
+    EventLogger logger{std::unique_ptr<LogSink>(new NullLogSink())};
+    RCHeap heap(logger);
+    heap.reserve(static_cast<size_t>(objects) + 2048);
+    make_power_law(objects, 3, objects / 100, 42).load_into(heap);
+    Mutator mutator(heap, objects);
+    std::printf("heap: %zu objects, %zu roots\n", heap.get_heap_size(), heap.get_roots_count());
+
+    // 1. Текстовый вывод всей кучи
+    auto start = Clock::now();
+    size_t text_bytes = capture_dump(heap).size();
+    double text_sec = seconds_since(start);
+    std::printf("dump_state text         | %9.2f ms | %8.1f MB\n", text_sec * 1e3, text_bytes / 1e6);
+
+    HeapSnapshotWriter writer(path);
+
+    // 2. Полный кадр
+    start = Clock::now();
+    heap.write_snapshot(writer, SnapshotMode::Full);
+    double full_sec = seconds_since(start);
+    uint64_t full_bytes = writer.get_bytes_written();
+    std::printf("full frame              | %9.2f ms | %8.1f MB\n", full_sec * 1e3, full_bytes / 1e6);
+
+    // 3. Мутации с diff-кадром после каждых every операций
+    double mutate_sec = 0;
+    double diff_sec = 0;
+    size_t diff_frames = 0;
+    uint64_t before = writer.get_bytes_written();
+    for (size_t done = 0; done < ops;)
+    {
+        start = Clock::now();
+        for (size_t i = 0; i < every && done < ops; ++i, ++done)
+        {
+            mutator.step();
+        }
+        mutate_sec += seconds_since(start);
+        start = Clock::now();
+        heap.write_snapshot(writer, SnapshotMode::Diff);
+        diff_sec += seconds_since(start);
+        diff_frames++;
+    }
+    uint64_t diff_bytes = writer.get_bytes_written() - before;
+    std::printf("mutator                 | %9.2f ms | %zu ops\n", mutate_sec * 1e3, ops);
+    std::printf("diff frames             | %9.2f ms | %8.1f MB | %zu frames, %.1f us and %.1f KB per frame\n",
+                diff_sec * 1e3, diff_bytes / 1e6, diff_frames, diff_sec / diff_frames * 1e6,
+                diff_bytes / 1e3 / diff_frames);
+    std::printf("  same with full frames | %9.2f ms | %8.1f MB | x%.0f time, x%.0f bytes\n",
+                full_sec * diff_frames * 1e3, full_bytes * diff_frames / 1e6,
+                full_sec * diff_frames / diff_sec, static_cast<double>(full_bytes) * diff_frames / diff_bytes);
+
+    // 4. Полный кадр по квантам времени, мутатор работает между шагами
+    const std::chrono::microseconds slice(slice_us);
+    double max_pause = 0;
+    size_t steps = 0;
+    start = Clock::now();
+    for (bool done = false; !done;)
+    {
+        auto step_start = Clock::now();
+        done = heap.write_snapshot(writer, SnapshotMode::Full, slice);
+        max_pause = std::max(max_pause, seconds_since(step_start));
+        steps++;
+        for (int i = 0; i < 64; ++i)
+        {
+            mutator.step();
+        }
+    }
+    double sliced_sec = seconds_since(start);
+    std::printf("sliced full frame       | %9.2f ms | %zu steps of %ld us, max pause %.2f ms\n", sliced_sec * 1e3,
+                steps, slice_us, max_pause * 1e3);
+
+    // Изменения во время нечёткого кадра догоняет следующий diff-кадр
+    heap.write_snapshot(writer, SnapshotMode::Diff);
+    writer.close();
+    std::printf("file: %llu frames, %.1f MB -> %s\n", static_cast<unsigned long long>(writer.get_frame_count()),
+                writer.get_bytes_written() / 1e6, path.c_str());
+
+    start = Clock::now();
+    HeapSnapshotReader reader(path);
+    size_t frames = 0;
+    while (reader.next_frame())
+    {
+        frames++;
+    }
+    std::ostringstream restored;
+    reader.dump(restored);
+    std::printf("read and apply          | %9.2f ms | %zu frames\n", seconds_since(start) * 1e3, frames);
+
+    if (frames != writer.get_frame_count() || normalize(restored.str()) != normalize(capture_dump(heap)))
+    {
+        std::printf("MISMATCH between restored snapshot and heap\n");
+        return 1;
+    }
+    std::printf("restored state matches heap\n");
+    return 0;
+}
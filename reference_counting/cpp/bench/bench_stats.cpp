@@ -0,0 +1,117 @@
+/**
+ * Бенчмарк стоимости статистики RCHeap (rc_stats.h).
+ *
+ * Выполняет смешанную трассу: цепочки и деревья, снимаемые каскадом,
+ * и текучесть ссылок между долгоживущими объектами. Печатает лучшую
+ * из нескольких прогонок скорость в ops/s, а при сборке с
+ * -DRC_ENABLE_STATS — ещё и dump_stats() и JSON-снимок.
+ *
+ * Стоимость статистики — разница между двумя сборками (из каталога cpp/):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target bench_stats
+ *   cmake -S . -B build-stats -DCMAKE_BUILD_TYPE=Release -DRC_ENABLE_STATS=ON && \
+ *       cmake --build build-stats --target bench_stats
+ * Запуск:
+ *   build/bench_stats [ops] [runs]   (по умолчанию 2000000 и 5)
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "event_logger.h"
+#include "rc_heap.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const int kLongLived = 1024;
+
+    std::vector<ScenarioOp> generate(size_t ops)
+    {
+        std::mt19937 rng(7);
+        std::vector<ScenarioOp> trace;
+        trace.reserve(ops + 256);
+        for (int id = 1; id <= kLongLived; ++id)
+        {
+            trace.emplace_back(OpCode::Allocate, id);
+            trace.emplace_back(OpCode::AddRoot, id);
+        }
+
+        int next = kLongLived + 1;
+        while (trace.size() < ops)
+        {
+            if (rng() % 2 == 0)
+            {
+                // Дерево с ветвлением до 4 и размером до 64 объектов под временным корнем
+                int size = 1 + static_cast<int>(rng() % 64);
+                int root = next;
+                for (int k = 0; k < size; ++k)
+                {
+                    trace.emplace_back(OpCode::Allocate, next + k);
+                    if (k == 0)
+                    {
+                        trace.emplace_back(OpCode::AddRoot, root);
+                    }
+                    else
+                    {
+                        trace.emplace_back(OpCode::AddRef, -1, next + (k - 1) / 4, next + k);
+                    }
+                }
+                trace.emplace_back(OpCode::RemoveRoot, root);
+                next += size;
+            }
+            else
+            {
+                // Ссылка между долгоживущими объектами, сразу снятая
+                int from = 1 + static_cast<int>(rng() % kLongLived);
+                int to = 1 + static_cast<int>(rng() % kLongLived);
+                if (from != to)
+                {
+                    trace.emplace_back(OpCode::AddRef, -1, from, to);
+                    trace.emplace_back(OpCode::RemoveRef, -1, from, to);
+                }
+            }
+        }
+        return trace;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t ops = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+    int runs = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    std::vector<ScenarioOp> trace = generate(ops);
+    EventLogger logger{std::unique_ptr<LogSink>(new NullLogSink())};
+
+    double best = 0;
+    std::unique_ptr<RCHeap> last;
+    for (int run = 0; run < runs; ++run)
+    {
+        std::unique_ptr<RCHeap> heap(new RCHeap(logger));
+        auto start = Clock::now();
+        for (const ScenarioOp &op : trace)
+        {
+            heap->apply(op);
+        }
+        double sec = std::chrono::duration<double>(Clock::now() - start).count();
+        if (best == 0 || sec < best)
+        {
+            best = sec;
+        }
+        last = std::move(heap);
+    }
+
+    std::printf("stats %s | %zu ops | %12.0f ops/s (best of %d)\n", kStatsEnabled ? "on " : "off", trace.size(),
+                trace.size() / best, runs);
+    if (kStatsEnabled)
+    {
+        last->dump_stats();
+        std::cout << last->stats_json().substr(0, 400) << "...\n";
+    }
+    return 0;
+}
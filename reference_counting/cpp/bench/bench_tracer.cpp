@@ -0,0 +1,113 @@
+/**
+ * Бенчмарк пропускной способности фазы пометки резервного трассировщика.
+ *
+ * Строит случайный граф из N объектов (по умолчанию 10M): каждый объект i > 0
+ * получает ссылку от случайного предшественника (всё достижимо из корня 0)
+ * и ещё в среднем extra_degree случайных ссылок. Сравнивает Tracer::mark
+ * (битовая карта по слотам) с пометкой через std::unordered_set<int>.
+ *
+ * Сборка (из каталога cpp/):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target bench_tracer
+ * Запуск:
+ *   build/bench_tracer [objects] [extra_degree]
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+#include "object_store.h"
+#include "tracer.h"
+#include "event_logger.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    size_t build_graph(ObjectStore &heap, int objects, int extra_degree)
+    {
+        std::mt19937 rng(1234);
+        heap.reserve(static_cast<size_t>(objects));
+        for (int id = 0; id < objects; ++id)
+        {
+            heap.emplace(id);
+        }
+        heap.find(0)->ref_count = 1; // корень
+
+        size_t edges = 0;
+        auto link = [&](int from, int to)
+        {
+            if (from != to && heap.find(from)->add_outgoing_ref(to))
+            {
+                heap.find(to)->ref_count++;
+                edges++;
+            }
+        };
+
+        std::uniform_int_distribution<int> any(0, objects - 1);
+        for (int id = 1; id < objects; ++id)
+        {
+            std::uniform_int_distribution<int> parent(0, id - 1);
+            link(parent(rng), id);
+            for (int k = 0; k < extra_degree; ++k)
+            {
+                link(id, any(rng));
+            }
+        }
+        return edges;
+    }
+
+    size_t mark_with_hash_set(const ObjectStore &heap, int root)
+    {
+        std::unordered_set<int> visited;
+        std::vector<int> stack{root};
+        visited.insert(root);
+        while (!stack.empty())
+        {
+            int id = stack.back();
+            stack.pop_back();
+            for (int child : heap.find(id)->references)
+            {
+                if (visited.insert(child).second)
+                {
+                    stack.push_back(child);
+                }
+            }
+        }
+        return visited.size();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int objects = argc > 1 ? std::atoi(argv[1]) : 10000000;
+    int extra_degree = argc > 2 ? std::atoi(argv[2]) : 1;
+
+    ObjectStore heap;
+    auto start = Clock::now();
+    size_t edges = build_graph(heap, objects, extra_degree);
+    double build_sec = std::chrono::duration<double>(Clock::now() - start).count();
+    std::printf("objects=%d edges=%zu build %.2f s\n", objects, edges, build_sec);
+
+    EventLogger logger("/dev/null");
+    Tracer tracer(heap, logger);
+    std::unordered_set<int> roots{0};
+
+    for (int run = 0; run < 3; ++run)
+    {
+        start = Clock::now();
+        size_t marked = tracer.mark(roots);
+        double sec = std::chrono::duration<double>(Clock::now() - start).count();
+        std::printf("bitmap mark   | marked %10zu | %7.3f s | %7.2f M objects/s | %7.2f M edges/s\n",
+                    marked, sec, marked / sec / 1e6, edges / sec / 1e6);
+    }
+
+    start = Clock::now();
+    size_t marked = mark_with_hash_set(heap, 0);
+    double sec = std::chrono::duration<double>(Clock::now() - start).count();
+    std::printf("hash-set mark | marked %10zu | %7.3f s | %7.2f M objects/s | %7.2f M edges/s\n",
+                marked, sec, marked / sec / 1e6, edges / sec / 1e6);
+    return 0;
+}
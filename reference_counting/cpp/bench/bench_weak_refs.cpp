@@ -0,0 +1,194 @@
+/**
+ * Бенчмарк слабых ссылок (WeakRefTable) на двусвязных списках.
+ *
+ * Каждый раунд строит список из length узлов под корнем: ссылка next
+ * сильная, обратная ссылка prev — сильная или слабая. Затем из середины
+ * списка вынимается каждый восьмой узел (перешивка next/prev соседей)
+ * и корень отпускается; после раунда вызывается collect_cycles().
+ * ID узлов в каждом раунде одни и те же, так что слоты и ID переиспользуются.
+ *
+ * С сильными prev каждая пара соседей — цикл: вынутый узел освобождается,
+ * но оставляет соседей кандидатами в корни циклов, а список без корня —
+ * мусорный цикл, который освобождает только сборщик. Со слабыми prev список
+ * освобождается каскадом, как только отпущен корень: кандидаты, оставшиеся
+ * от перешивки, к сборке уже удалены, и сборщику нечего просматривать.
+ *
+ * Наблюдатель (отдельный корень) держит слабые ссылки на голову и узлы
+ * списка. Проверяется: после раунда куча пуста, со слабыми prev сборщик
+ * не сделал работы, ссылки наблюдателя недействительны сразу после
+ * освобождения целей и не «оживают», когда их ID занимают узлы следующего
+ * раунда, а устаревшие ссылки удаляются remove_weak_ref().
+ *
+ * Лог пишется в бинарном формате: в JSON форматирование событий стоит
+ * дороже самих операций, а со слабыми prev событий больше (weak_expire
+ * на каждый узел), чем при сборке цикла сборщиком (только delete).
+ *
+ * Сборка (из каталога cpp/):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target bench_weak_refs
+ * Запуск:
+ *   build/bench_weak_refs [total_nodes] [length]   (по умолчанию 2000000 и 1000)
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "event_logger.h"
+#include "rc_heap.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const int kObserver = 0;
+    const int kUnlinkEvery = 8;
+    const int kWatchEvery = 64;
+
+    struct Result
+    {
+        double seconds = 0;
+        double collect_seconds = 0;
+        size_t candidates = 0;
+        size_t freed_by_collector = 0;
+        uint64_t traced = 0;
+        bool ok = true;
+    };
+
+    void link_prev(RCHeap &heap, bool weak, int node, int prev)
+    {
+        if (weak)
+        {
+            heap.add_weak_ref(node, prev);
+        }
+        else
+        {
+            heap.add_ref(node, prev);
+        }
+    }
+
+    void unlink_prev(RCHeap &heap, bool weak, int node, int prev)
+    {
+        if (weak)
+        {
+            heap.remove_weak_ref(node, prev);
+        }
+        else
+        {
+            heap.remove_ref(node, prev);
+        }
+    }
+
+    /**
+     * Узлы списка — ID 1..length; head = 1 удерживается корнем
+     */
+    bool run_round(RCHeap &heap, bool weak, int length, bool first, Result &result)
+    {
+        bool ok = true;
+        // Слабые ссылки наблюдателя прошлого раунда устарели, хотя ID снова заняты
+        for (int id = 1; id <= length; id += kWatchEvery)
+        {
+            ok = ok && !heap.is_weak_ref_valid(kObserver, id);
+        }
+
+        heap.allocate(1);
+        heap.add_root(1);
+        for (int id = 2; id <= length; ++id)
+        {
+            heap.allocate(id);
+            heap.add_ref(id - 1, id);
+            link_prev(heap, weak, id, id - 1);
+        }
+        for (int id = 1; id <= length; id += kWatchEvery)
+        {
+            if (!first)
+            {
+                ok = ok && heap.remove_weak_ref(kObserver, id); // устаревшая ссылка прошлого раунда
+            }
+            ok = ok && heap.add_weak_ref(kObserver, id);
+        }
+        ok = ok && heap.get_weak_count(1) == (weak ? 1 : 0) + 1;
+
+        // Вынуть узлы из середины: prev <-> id <-> next превращается в prev <-> next
+        for (int id = 2; id + 1 <= length; id += kUnlinkEvery)
+        {
+            const int prev = id - 1;
+            const int next = id + 1;
+            heap.add_ref(prev, next);
+            link_prev(heap, weak, next, prev);
+            unlink_prev(heap, weak, next, id);
+            heap.remove_ref(prev, id);
+            ok = ok && !heap.object_exists(id);
+        }
+
+        heap.remove_root(1);
+        if (weak)
+        {
+            ok = ok && heap.get_heap_size() == 1 && heap.get_weak_ref_count() == 0;
+        }
+        result.candidates += heap.get_cycle_candidate_count();
+        auto start = Clock::now();
+        result.freed_by_collector += heap.collect_cycles();
+        result.collect_seconds += std::chrono::duration<double>(Clock::now() - start).count();
+        ok = ok && heap.get_heap_size() == 1 && heap.get_weak_ref_count() == 0;
+        for (int id = 1; id <= length; id += kWatchEvery)
+        {
+            ok = ok && !heap.is_weak_ref_valid(kObserver, id);
+        }
+        return ok;
+    }
+
+    Result run(EventLogger &logger, bool weak, int total_nodes, int length)
+    {
+        RCHeap heap(logger);
+        heap.reserve(static_cast<size_t>(length) + 1);
+        heap.allocate(kObserver);
+        heap.add_root(kObserver);
+
+        Result result;
+        const int rounds = total_nodes / length;
+        auto start = Clock::now();
+        for (int round = 0; round < rounds; ++round)
+        {
+            result.ok = run_round(heap, weak, length, round == 0, result) && result.ok;
+        }
+        result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        result.traced = heap.get_cycle_traced_count();
+
+        const double nodes = static_cast<double>(rounds) * length;
+        std::printf("%-12s | %9.0f nodes | %8.1f ms | %6.1f ns/node | collect_cycles %7.1f ms | candidates %8zu"
+                    " | traced %9llu | freed by collector %9zu\n",
+                    weak ? "weak prev" : "strong prev", nodes, result.seconds * 1e3, result.seconds * 1e9 / nodes,
+                    result.collect_seconds * 1e3, result.candidates, static_cast<unsigned long long>(result.traced),
+                    result.freed_by_collector);
+        return result;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int total_nodes = argc > 1 ? std::atoi(argv[1]) : 2000000;
+    int length = argc > 2 ? std::atoi(argv[2]) : 1000;
+    if (length < 2 || total_nodes < length)
+    {
+        std::fprintf(stderr, "Usage: bench_weak_refs [total_nodes] [length >= 2]\n");
+        return 1;
+    }
+
+    EventLogger logger("/dev/null", LogFormat::Binary);
+    std::printf("-- doubly-linked lists of %d nodes, every %dth node unlinked, then dropped\n", length, kUnlinkEvery);
+    Result strong = run(logger, false, total_nodes, length);
+    Result weak = run(logger, true, total_nodes, length);
+
+    const bool ok = strong.ok && weak.ok && weak.traced == 0 &&
+                    weak.freed_by_collector == 0 && strong.freed_by_collector > 0;
+    if (!ok)
+    {
+        std::printf("MISMATCH: weak references disagree with the expected heap\n");
+        return 1;
+    }
+    std::printf("weak back-edges removed %llu traced objects and %.1f ms of collect_cycles(); total time %+.1f%%\n",
+                static_cast<unsigned long long>(strong.traced), (strong.collect_seconds - weak.collect_seconds) * 1e3,
+                100.0 * (weak.seconds / strong.seconds - 1.0));
+    std::printf("weak references verified\n");
+    return 0;
+}
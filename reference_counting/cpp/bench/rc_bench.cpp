@@ -0,0 +1,231 @@
+/**
+ * Набор бенчмарков RCHeap на Google Benchmark.
+ *
+ * Покрывает:
+ *   - allocate;
+ *   - add_ref/remove_ref при разном числе исходящих ссылок (fan-out);
+ *   - каскадное удаление цепочек и двоичных деревьев;
+ *   - поиск утечек на случайных графах (Эрдёш–Реньи и степенной);
+ *   - стоимость лога: без лога, JSON-строки, бинарный, асинхронный.
+ * Графы строятся генераторами graph_generators.h с фиксированным seed,
+ * поэтому результаты разных версий сравнимы между собой.
+ *
+ * Сборка (из каталога cpp/, нужен пакет Google Benchmark):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target rc_bench
+ * Запуск:
+ *   build/rc_bench [--benchmark_filter=Cascade] --benchmark_out=rc_bench.json --benchmark_out_format=json
+ * или cmake --build build --target rc_bench_json (результат — build/rc_bench.json).
+ */
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+#include "async_log_sink.h"
+#include "event_logger.h"
+#include "graph_generators.h"
+#include "log_sink.h"
+#include "rc_heap.h"
+
+namespace
+{
+    const uint64_t kSeed = 20240101;
+
+    EventLogger &null_logger()
+    {
+        static EventLogger logger{std::unique_ptr<LogSink>(new NullLogSink())};
+        return logger;
+    }
+
+    std::string temp_log_path(const char *name)
+    {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    /**
+     * @brief Выполнить операции графа без учёта времени
+     */
+    std::unique_ptr<RCHeap> build_heap(const Graph &graph, EventLogger &logger)
+    {
+        std::unique_ptr<RCHeap> heap(new RCHeap(logger));
+        graph.load_into(*heap);
+        return heap;
+    }
+
+    void BM_Allocate(benchmark::State &state)
+    {
+        const int n = static_cast<int>(state.range(0));
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            std::unique_ptr<RCHeap> heap(new RCHeap(null_logger()));
+            state.ResumeTiming();
+
+            for (int id = 1; id <= n; ++id)
+            {
+                heap->allocate(id);
+            }
+
+            state.PauseTiming();
+            heap.reset();
+            state.ResumeTiming();
+        }
+        state.SetItemsProcessed(state.iterations() * n);
+    }
+
+    /**
+     * Один источник добавляет и снимает ссылки на fan_out корней:
+     * цели не умирают, измеряется сам add_ref/remove_ref и множество рёбер
+     */
+    void BM_AddRemoveRef(benchmark::State &state)
+    {
+        const int fan_out = static_cast<int>(state.range(0));
+        RCHeap heap(null_logger());
+        for (int id = 1; id <= fan_out + 1; ++id)
+        {
+            heap.allocate(id);
+            heap.add_root(id);
+        }
+
+        for (auto _ : state)
+        {
+            for (int target = 2; target <= fan_out + 1; ++target)
+            {
+                heap.add_ref(1, target);
+            }
+            for (int target = 2; target <= fan_out + 1; ++target)
+            {
+                heap.remove_ref(1, target);
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * 2 * fan_out);
+    }
+
+    /**
+     * Снятие единственного корня графа: каскад удаляет все n объектов
+     */
+    void cascade(benchmark::State &state, const Graph &graph)
+    {
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            std::unique_ptr<RCHeap> heap = build_heap(graph, null_logger());
+            state.ResumeTiming();
+
+            heap->remove_root(graph.roots.front());
+
+            state.PauseTiming();
+            heap.reset();
+            state.ResumeTiming();
+        }
+        state.SetItemsProcessed(state.iterations() * graph.node_count);
+    }
+
+    void BM_CascadeChain(benchmark::State &state)
+    {
+        cascade(state, make_chain(static_cast<int>(state.range(0))));
+    }
+
+    void BM_CascadeTree(benchmark::State &state)
+    {
+        cascade(state, make_binary_tree(static_cast<int>(state.range(0))));
+    }
+
+    /**
+     * Поиск утечек: пометка от корней и объектов с нулевым счётчиком,
+     * затем перебор непомеченных; куча не меняется, граф строится один раз
+     */
+    void leak_detection(benchmark::State &state, const Graph &graph)
+    {
+        std::unique_ptr<RCHeap> heap = build_heap(graph, null_logger());
+        for (auto _ : state)
+        {
+            heap->detect_and_log_leaks();
+        }
+        state.SetItemsProcessed(state.iterations() * graph.node_count);
+        state.counters["edges"] = static_cast<double>(graph.edges.size());
+    }
+
+    void BM_LeakDetectionErdosRenyi(benchmark::State &state)
+    {
+        const int n = static_cast<int>(state.range(0));
+        // Средняя степень 2: есть и недостижимые компоненты, и циклы
+        leak_detection(state, make_erdos_renyi(n, 2.0 / n, n / 100 + 1, kSeed));
+    }
+
+    void BM_LeakDetectionPowerLaw(benchmark::State &state)
+    {
+        const int n = static_cast<int>(state.range(0));
+        leak_detection(state, make_power_law(n, 2, n / 100 + 1, kSeed));
+    }
+
+    enum SinkKind
+    {
+        kNoLog,
+        kJsonLines,
+        kBinary,
+        kAsyncBinary
+    };
+
+    std::unique_ptr<LogSink> make_sink(SinkKind kind, const std::string &path)
+    {
+        switch (kind)
+        {
+        case kJsonLines:
+            return std::unique_ptr<LogSink>(new JsonLinesSink(path));
+        case kBinary:
+            return std::unique_ptr<LogSink>(new BinaryLogSink(path));
+        case kAsyncBinary:
+            return std::unique_ptr<LogSink>(new AsyncLogSink(std::unique_ptr<LogSink>(new BinaryLogSink(path))));
+        default:
+            return std::unique_ptr<LogSink>(new NullLogSink());
+        }
+    }
+
+    /**
+     * Цепочка из 64 объектов под корнем, затем снятие корня:
+     * ~200 событий лога на итерацию
+     */
+    void BM_Logging(benchmark::State &state)
+    {
+        static const char *const kNames[] = {"no_log", "json_lines", "binary", "async_binary"};
+        const SinkKind kind = static_cast<SinkKind>(state.range(0));
+        const int chain = 64;
+        const std::string path = temp_log_path("rc_bench_events.log");
+        state.SetLabel(kNames[kind]);
+        {
+            EventLogger logger{make_sink(kind, path)};
+            RCHeap heap(logger);
+            for (auto _ : state)
+            {
+                for (int id = 1; id <= chain; ++id)
+                {
+                    heap.allocate(id);
+                    if (id == 1)
+                    {
+                        heap.add_root(id);
+                    }
+                    else
+                    {
+                        heap.add_ref(id - 1, id);
+                    }
+                }
+                heap.remove_root(1);
+            }
+            state.SetItemsProcessed(state.iterations() * (2 * chain + 1));
+        }
+        std::remove(path.c_str());
+    }
+}
+
+BENCHMARK(BM_Allocate)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_AddRemoveRef)->RangeMultiplier(8)->Range(1, 4096)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_CascadeChain)->RangeMultiplier(10)->Range(1000, 100000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_CascadeTree)->RangeMultiplier(10)->Range(1000, 100000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_LeakDetectionErdosRenyi)->RangeMultiplier(10)->Range(1000, 100000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_LeakDetectionPowerLaw)->RangeMultiplier(10)->Range(1000, 100000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Logging)->DenseRange(kNoLog, kAsyncBinary)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
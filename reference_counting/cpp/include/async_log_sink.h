@@ -0,0 +1,117 @@
+#ifndef ASYNC_LOG_SINK_H
+#define ASYNC_LOG_SINK_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "log_sink.h"
+
+/**
+ * @enum OverflowPolicy
+ * @brief Что делать с событием, когда кольцевой буфер заполнен
+ */
+enum class OverflowPolicy
+{
+    Block, ///< Ждать, пока фоновый поток освободит место
+    Drop,  ///< Отбросить событие и увеличить счётчик потерь
+    Grow   ///< Сложить событие в дополнительный список под мьютексом
+};
+
+/**
+ * @class AsyncLogSink
+ * @brief Асинхронный приёмник: события пишет фоновый поток
+ *
+ * Потоки-мутаторы кладут события в ограниченное кольцо без блокировок
+ * (очередь Вьюкова: у каждой ячейки свой номер поколения, производители
+ * захватывают позицию одним CAS). Единственный фоновый поток вычерпывает
+ * кольцо пачками и передаёт события вложенному приёмнику, который поэтому
+ * используется только из одного потока. sync() ждёт, пока всё записанное
+ * до вызова дойдёт до вложенного приёмника и будет сброшено; деструктор
+ * дописывает всё и останавливает поток.
+ */
+class AsyncLogSink : public LogSink
+{
+public:
+    /**
+     * @param inner Приёмник, в который пишет фоновый поток
+     * @param capacity Ёмкость кольца в событиях (округляется вверх до степени двойки)
+     * @param policy Поведение при заполненном кольце
+     */
+    AsyncLogSink(std::unique_ptr<LogSink> inner, size_t capacity = 1 << 16,
+                 OverflowPolicy policy = OverflowPolicy::Block);
+    ~AsyncLogSink() override;
+
+    AsyncLogSink(const AsyncLogSink &) = delete;
+    AsyncLogSink &operator=(const AsyncLogSink &) = delete;
+
+    void write(const LogRecord &record) override;
+    void sync() override;
+    bool is_open() const override { return inner->is_open(); }
+
+    /**
+     * @brief Количество событий, отброшенных политикой Drop
+     */
+    uint64_t get_dropped() const { return dropped.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Количество событий, прошедших через дополнительный список (Grow)
+     */
+    uint64_t get_overflowed() const { return overflowed.load(std::memory_order_relaxed); }
+
+private:
+    struct Cell
+    {
+        std::atomic<uint64_t> sequence;
+        LogRecord record;
+    };
+
+    std::unique_ptr<LogSink> inner;
+    OverflowPolicy policy;
+    std::unique_ptr<Cell[]> cells;
+    uint64_t mask;
+
+    alignas(64) std::atomic<uint64_t> enqueue_pos{0};
+    alignas(64) uint64_t dequeue_pos = 0; ///< Меняет только фоновый поток
+
+    alignas(64) std::atomic<uint64_t> produced{0}; ///< Принято событий (кольцо + список)
+    std::atomic<uint64_t> consumed{0};             ///< Передано вложенному приёмнику
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> overflowed{0};
+
+    // Дополнительный список для Grow: пока он не пуст, новые события идут
+    // туда же, чтобы не обогнать уже отложенные
+    std::atomic<bool> overflow_active{false};
+    std::vector<LogRecord> overflow;
+
+    std::mutex mutex; ///< Защищает overflow и ожидание на cv
+    std::condition_variable writer_cv;
+    std::condition_variable sync_cv;
+    uint64_t sync_target = 0; ///< Позиция produced, до которой запрошен сброс
+    uint64_t synced = 0;      ///< Позиция, до которой сброс выполнен
+    bool stopping = false;
+
+    std::thread writer;
+
+    bool try_push(const LogRecord &record);
+    bool try_pop(LogRecord &record);
+    void push_overflow(const LogRecord &record);
+
+    /**
+     * @brief Тело фонового потока
+     */
+    void run();
+
+    /**
+     * @brief Вычерпать кольцо и дополнительный список
+     * @return Количество переданных событий
+     */
+    size_t drain();
+};
+
+#endif // ASYNC_LOG_SINK_H
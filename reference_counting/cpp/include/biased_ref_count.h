@@ -0,0 +1,183 @@
+#ifndef BIASED_REF_COUNT_H
+#define BIASED_REF_COUNT_H
+
+#include <atomic>
+#include <cstdint>
+#include <climits>
+
+/**
+ * @class BiasedRefCount
+ * @brief Счётчик ссылок, смещённый в пользу потока-владельца (biased RC)
+ *
+ * Счётчик состоит из двух частей. Локальную (biased) меняет только поток,
+ * создавший объект, — обычными загрузками и записями без атомарных RMW.
+ * Остальные потоки меняют общую часть атомарно. Полный счётчик равен
+ * сумме частей, поэтому общая часть может временно быть отрицательной.
+ *
+ * Общее слово хранит count * 2 + merged. Слияние (merge) одним fetch_add
+ * переносит локальную часть в общую и ставит бит merged; после этого
+ * объект считается только общей частью, как обычный атомарный счётчик.
+ * Слияние выполняет владелец: когда его локальная часть падает до 0, либо
+ * явно, когда чужой поток довёл общую часть несмёрженного объекта до <= 0
+ * и поставил объект в очередь владельца (decrement вернул Queue).
+ * Объект можно удалять только после слияния, когда общий счётчик равен 0:
+ * удаляет тот, кто выиграл CAS 0 -> kDead.
+ *
+ * Без смещения (biased = false в init) объект сразу считается слитым,
+ * и все операции — обычные атомарные RMW.
+ */
+class BiasedRefCount
+{
+public:
+    /// Объект захвачен для удаления. Бит merged установлен, поэтому владелец
+    /// не пойдёт по локальному пути и увидит kDead в общем счётчике
+    static constexpr int64_t kDead = INT64_MIN + 1;
+
+    /**
+     * @brief Результат уменьшения счётчика
+     */
+    enum class Release
+    {
+        Alive, ///< Объект жив (или его судьбу решит другой поток)
+        Zero,  ///< Счётчик слит и стал 0: вызывающий захватил объект и должен его удалить
+        Queue  ///< Объект не слит, а общая часть <= 0: поставить в очередь владельца
+    };
+
+    /**
+     * @param owner Номер потока-владельца
+     * @param biased false — обычный атомарный счётчик без локальной части
+     */
+    void init(uint32_t owner, bool biased)
+    {
+        owner_thread = owner;
+        local.store(0, std::memory_order_relaxed);
+        shared.store(biased ? 0 : 1, std::memory_order_relaxed);
+        queued.store(false, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Увеличить счётчик
+     * @param self Номер вызывающего потока
+     * @param count_after Новое значение счётчика (для лога; приблизительно при гонках)
+     * @return false, если объект уже захвачен для удаления
+     */
+    bool increment(uint32_t self, int &count_after)
+    {
+        int64_t word = shared.load(std::memory_order_relaxed);
+        if (self == owner_thread && (word & 1) == 0)
+        {
+            int32_t value = local.load(std::memory_order_relaxed) + 1;
+            local.store(value, std::memory_order_relaxed);
+            count_after = value + static_cast<int>(decode(word));
+            return true;
+        }
+
+        do
+        {
+            if (word == kDead)
+            {
+                return false;
+            }
+        } while (!shared.compare_exchange_weak(word, word + 2, std::memory_order_acq_rel,
+                                               std::memory_order_relaxed));
+        word += 2;
+        count_after = static_cast<int>(decode(word)) + ((word & 1) ? 0 : local.load(std::memory_order_relaxed));
+        return true;
+    }
+
+    /**
+     * @brief Уменьшить счётчик
+     * @param self Номер вызывающего потока
+     * @param count_after Новое значение счётчика (для лога; приблизительно при гонках)
+     */
+    Release decrement(uint32_t self, int &count_after)
+    {
+        if (self == owner_thread && (shared.load(std::memory_order_relaxed) & 1) == 0)
+        {
+            int32_t value = local.load(std::memory_order_relaxed) - 1;
+            local.store(value, std::memory_order_relaxed);
+            if (value > 0)
+            {
+                count_after = value + static_cast<int>(decode(shared.load(std::memory_order_relaxed)));
+                return Release::Alive;
+            }
+            // Локальная часть исчерпана (или ушла в минус, если ссылки добавляли
+            // чужие потоки): слить её, дальше объект живёт на общем счётчике
+            local.store(0, std::memory_order_relaxed);
+            int64_t delta = int64_t(value) * 2 + 1;
+            int64_t word = shared.fetch_add(delta, std::memory_order_acq_rel) + delta;
+            count_after = static_cast<int>(decode(word));
+            return settle(word);
+        }
+
+        int64_t word = shared.fetch_sub(2, std::memory_order_acq_rel) - 2;
+        if (word & 1)
+        {
+            count_after = static_cast<int>(decode(word));
+            return settle(word);
+        }
+        count_after = static_cast<int>(decode(word)) + local.load(std::memory_order_relaxed);
+        if (decode(word) <= 0 && !queued.exchange(true, std::memory_order_acq_rel))
+        {
+            return Release::Queue;
+        }
+        return Release::Alive;
+    }
+
+    /**
+     * @brief Явное слияние (вызывает владелец для объектов из своей очереди)
+     */
+    Release merge()
+    {
+        int64_t word = shared.load(std::memory_order_relaxed);
+        if (word & 1)
+        {
+            return Release::Alive; // Уже слит: судьбу решают обычные декременты
+        }
+        int32_t value = local.load(std::memory_order_relaxed);
+        local.store(0, std::memory_order_relaxed);
+        word = shared.fetch_add(int64_t(value) * 2 + 1, std::memory_order_acq_rel) + int64_t(value) * 2 + 1;
+        return settle(word);
+    }
+
+    bool is_dead() const { return shared.load(std::memory_order_acquire) == kDead; }
+
+    /**
+     * @brief Полное значение счётчика (точное, только когда потоки не меняют его)
+     */
+    int total() const
+    {
+        int64_t word = shared.load(std::memory_order_acquire);
+        if (word == kDead)
+        {
+            return 0;
+        }
+        return static_cast<int>(decode(word)) + ((word & 1) ? 0 : local.load(std::memory_order_relaxed));
+    }
+
+    uint32_t owner() const { return owner_thread; }
+
+private:
+    uint32_t owner_thread = 0;
+    std::atomic<int32_t> local{0};  ///< Пишет только владелец (relaxed, без RMW)
+    std::atomic<int64_t> shared{1}; ///< count * 2 + merged, либо kDead
+    std::atomic<bool> queued{false};
+
+    static int64_t decode(int64_t word) { return (word - (word & 1)) / 2; }
+
+    /**
+     * @brief Слитый счётчик стал 0 — попытаться захватить объект для удаления
+     */
+    Release settle(int64_t word)
+    {
+        int64_t expected = 1; // count == 0, merged
+        if (word == expected &&
+            shared.compare_exchange_strong(expected, kDead, std::memory_order_acq_rel))
+        {
+            return Release::Zero;
+        }
+        return Release::Alive;
+    }
+};
+
+#endif // BIASED_REF_COUNT_H
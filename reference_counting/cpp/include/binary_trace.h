@@ -0,0 +1,242 @@
+#ifndef BINARY_TRACE_H
+#define BINARY_TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "scenario_op.h"
+
+/**
+ * Бинарный формат сценария (трассы операций).
+ *
+ * Заголовок kTraceHeaderSize байт: магия "RCTR", версия (u16), флаги (u16),
+ * количество операций (u64); всё в little-endian. Дальше идут операции:
+ *   - обычный режим: упакованные записи {op: u8, a: u32, b: u32} по
+ *     kTraceRecordSize байт; для allocate/add_root/remove_root a = id, b = 0,
+ *     для add_ref/remove_ref a = from, b = to;
+ *   - режим kTraceVarint: байт op, затем ID как zigzag-varint разности:
+ *     id (или from) — относительно предыдущей операции, to — относительно from.
+ *     Соседние операции трассы обычно трогают близкие ID, и запись
+ *     занимает 2–4 байта вместо 9.
+ */
+const char kTraceMagic[4] = {'R', 'C', 'T', 'R'};
+const uint16_t kTraceVersion = 1;
+const uint16_t kTraceVarint = 1; ///< Флаг: записи закодированы varint-разностями
+const size_t kTraceHeaderSize = 16;
+const size_t kTraceRecordSize = 9;
+
+/**
+ * @class BinaryTraceWriter
+ * @brief Запись сценария в бинарном формате через буфер в памяти
+ */
+class BinaryTraceWriter
+{
+public:
+    /**
+     * @param filename Путь к файлу трассы
+     * @param varint Кодировать записи varint-разностями
+     * @throw std::runtime_error если файл не открывается
+     */
+    BinaryTraceWriter(const std::string &filename, bool varint = false);
+
+    /**
+     * @brief Дописать буфер и количество операций в заголовок, закрыть файл
+     */
+    ~BinaryTraceWriter();
+
+    BinaryTraceWriter(const BinaryTraceWriter &) = delete;
+    BinaryTraceWriter &operator=(const BinaryTraceWriter &) = delete;
+
+    /**
+     * @brief Записать операцию (OpCode::Unknown пропускается)
+     */
+    void write(const ScenarioOp &op);
+
+    /**
+     * @brief Дописать буфер и количество операций, закрыть файл
+     * @throw std::runtime_error при ошибке записи
+     */
+    void close();
+
+    uint64_t get_op_count() const { return op_count; }
+
+private:
+    std::FILE *file;
+    bool varint;
+    std::vector<unsigned char> buffer;
+    size_t used;
+    uint64_t op_count;
+    int32_t previous; ///< ID предыдущей операции (режим varint)
+
+    void flush();
+    void put_varint(int64_t delta);
+};
+
+/**
+ * @class BinaryTraceReader
+ * @brief Чтение бинарной трассы без копирования: файл отображается в память
+ *
+ * На POSIX файл отображается через mmap, операции декодируются прямо из
+ * отображения, без выделений памяти на операцию. Где mmap нет (Windows),
+ * файл целиком читается в буфер.
+ */
+class BinaryTraceReader
+{
+public:
+    /**
+     * @throw std::runtime_error если файл не открывается или заголовок неверен
+     */
+    explicit BinaryTraceReader(const std::string &filename);
+    ~BinaryTraceReader();
+
+    BinaryTraceReader(const BinaryTraceReader &) = delete;
+    BinaryTraceReader &operator=(const BinaryTraceReader &) = delete;
+
+    /**
+     * @brief Прочитать следующую операцию
+     * @return false в конце трассы
+     * @throw std::runtime_error при повреждённой записи или если данные
+     *        кончились раньше, чем прочитано op_count операций заголовка
+     */
+    bool next(ScenarioOp &op)
+    {
+        if (cursor == end)
+        {
+            // op_count == 0: писатель не закрыл трассу, сверять не с чем
+            if (op_count != 0 && read_count < op_count)
+            {
+                corrupt();
+            }
+            return false;
+        }
+        read_count++;
+        uint8_t code = *cursor;
+        if (code >= static_cast<uint8_t>(OpCode::Unknown))
+        {
+            corrupt();
+        }
+        op.op = static_cast<OpCode>(code);
+        return varint ? next_varint(op) : next_fixed(op);
+    }
+
+    /**
+     * @brief Вернуться к первой операции
+     */
+    void rewind()
+    {
+        cursor = begin;
+        previous = 0;
+        read_count = 0;
+    }
+
+    /**
+     * @brief Количество операций по заголовку
+     */
+    uint64_t get_op_count() const { return op_count; }
+
+    bool is_varint() const { return varint; }
+
+    /**
+     * @brief Размер файла в байтах
+     */
+    size_t size_bytes() const { return mapped_size; }
+
+    /**
+     * @brief Начинается ли файл с заголовка бинарной трассы
+     */
+    static bool is_binary_trace(const std::string &filename);
+
+private:
+    const unsigned char *data;  ///< Начало файла (отображение или буфер)
+    size_t mapped_size;
+    bool mapped;                ///< data получен через mmap
+    std::vector<unsigned char> fallback;
+    const unsigned char *begin; ///< Первая запись
+    const unsigned char *cursor;
+    const unsigned char *end;
+    bool varint;
+    uint64_t op_count;
+    uint64_t read_count; ///< Операций прочитано с начала трассы
+    int32_t previous;
+
+    void release();
+
+    static uint32_t get32(const unsigned char *in)
+    {
+        return static_cast<uint32_t>(in[0]) | static_cast<uint32_t>(in[1]) << 8 |
+               static_cast<uint32_t>(in[2]) << 16 | static_cast<uint32_t>(in[3]) << 24;
+    }
+
+    bool next_fixed(ScenarioOp &op)
+    {
+        if (static_cast<size_t>(end - cursor) < kTraceRecordSize)
+        {
+            corrupt();
+        }
+        int32_t a = static_cast<int32_t>(get32(cursor + 1));
+        int32_t b = static_cast<int32_t>(get32(cursor + 5));
+        cursor += kTraceRecordSize;
+        assign(op, a, b);
+        return true;
+    }
+
+    bool next_varint(ScenarioOp &op)
+    {
+        cursor++;
+        int32_t a = previous + static_cast<int32_t>(get_varint());
+        int32_t b = 0;
+        if (op.op == OpCode::AddRef || op.op == OpCode::RemoveRef)
+        {
+            b = a + static_cast<int32_t>(get_varint());
+        }
+        previous = a;
+        assign(op, a, b);
+        return true;
+    }
+
+    int64_t get_varint()
+    {
+        uint64_t value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7)
+        {
+            if (cursor == end)
+            {
+                corrupt();
+            }
+            uint8_t byte = *cursor++;
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1); // zigzag
+            }
+        }
+        corrupt();
+    }
+
+    static void assign(ScenarioOp &op, int32_t a, int32_t b)
+    {
+        if (op.op == OpCode::AddRef || op.op == OpCode::RemoveRef)
+        {
+            op.id = -1;
+            op.from = a;
+            op.to = b;
+        }
+        else
+        {
+            op.id = a;
+            op.from = -1;
+            op.to = -1;
+        }
+    }
+
+    [[noreturn]] void corrupt() const
+    {
+        throw std::runtime_error("Corrupt binary trace at offset " + std::to_string(cursor - data));
+    }
+};
+
+#endif // BINARY_TRACE_H
@@ -0,0 +1,250 @@
+#ifndef CONCURRENT_RC_HEAP_H
+#define CONCURRENT_RC_HEAP_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "edge_set.h"
+#include "biased_ref_count.h"
+#include "event_logger.h"
+
+/**
+ * @class SpinLock
+ * @brief Короткая блокировка для списка ссылок одного объекта
+ */
+class SpinLock
+{
+public:
+    void lock()
+    {
+        while (flag.test_and_set(std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    void unlock() { flag.clear(std::memory_order_release); }
+
+private:
+    std::atomic_flag flag = ATOMIC_FLAG_INIT;
+};
+
+/**
+ * @enum CountMode
+ * @brief Способ подсчёта ссылок в ConcurrentRCHeap
+ */
+enum class CountMode
+{
+    Atomic, ///< Каждое изменение счётчика — атомарный RMW
+    Biased  ///< Поток, создавший объект, считает локально без RMW (BiasedRefCount)
+};
+
+/**
+ * @enum RootState
+ * @brief Состояние корня объекта ConcurrentRCHeap
+ *
+ * add_root захватывает корень (None -> Adding) до увеличения счётчика и
+ * публикует его (Adding -> Rooted) только после. remove_root снимает лишь
+ * опубликованный корень (Rooted -> None), поэтому никогда не уменьшает
+ * счётчик раньше, чем увеличение корня в него попало.
+ */
+enum class RootState : unsigned char
+{
+    None,   ///< Не корень
+    Adding, ///< add_root захватил корень, но ещё не увеличил счётчик
+    Rooted  ///< Корень учтён в счётчике
+};
+
+/**
+ * @struct ConcurrentObject
+ * @brief Объект многопоточной кучи
+ *
+ * Счётчик, захваченный для удаления (kDead), больше не увеличивается.
+ * Список исходящих ссылок защищён edges_lock.
+ */
+struct ConcurrentObject
+{
+    int id;
+    BiasedRefCount count;
+    std::atomic<RootState> root;
+    SpinLock edges_lock;
+    EdgeSet references;
+
+    ConcurrentObject(int id_, uint32_t owner, bool biased) : id(id_), root(RootState::None)
+    {
+        count.init(owner, biased);
+    }
+
+    bool is_dead() const { return count.is_dead(); }
+
+    bool is_root() const { return root.load(std::memory_order_acquire) == RootState::Rooted; }
+};
+
+/**
+ * @class ConcurrentRCHeap
+ * @brief Куча с подсчётом ссылок, допускающая вызовы из многих потоков
+ *
+ * Таблица объектов разбита на шарды с собственным мьютексом; поиск отдаёт
+ * shared_ptr, поэтому объект, который удаляет другой поток, остаётся
+ * в памяти до конца текущей операции. Счётчики меняются атомарно.
+ *
+ * Удаление: поток, уменьшивший счётчик до 0, пытается перевести его
+ * CAS-ом 0 -> kDead (в режиме Biased — после слияния локальной части). Удаляет объект ровно тот поток, чей CAS прошёл;
+ * если раньше успел add_ref (объект снова нужен мутатору), удаления нет.
+ * Удаляющий поток убирает объект из таблицы, под edges_lock забирает его
+ * ссылки и уменьшает счётчики детей тем же протоколом, итеративно.
+ * Поэтому два потока, одновременно снявшие последние ссылки на общий
+ * подграф, удаляют каждый его объект ровно один раз.
+ *
+ * Операции над отсутствующими или уже удаляемыми объектами возвращают
+ * false без вывода в консоль: при многопоточной нагрузке такие гонки
+ * ожидаемы. Логгер должен допускать вызовы из нескольких потоков
+ * (AsyncLogSink или NullLogSink).
+ *
+ * В режиме Biased объект, чей счётчик чужой поток опустил до нуля, ждёт
+ * в очереди владельца: владелец сливает очередь в начале каждой своей
+ * операции или в merge_pending(). Поток, который больше не будет работать
+ * с кучей, должен вызвать merge_pending(); settle() сливает все очереди,
+ * когда с кучей не работает ни один поток.
+ */
+class ConcurrentRCHeap
+{
+public:
+    /**
+     * @param logger Логгер событий
+     * @param shard_count Количество шардов таблицы (округляется вверх до степени двойки)
+     * @param mode Способ подсчёта ссылок
+     */
+    explicit ConcurrentRCHeap(EventLogger &logger, size_t shard_count = 64,
+                              CountMode mode = CountMode::Atomic);
+
+    bool allocate(int obj_id);
+    bool add_root(int obj_id);
+    bool remove_root(int obj_id);
+    bool add_ref(int from, int to);
+    bool remove_ref(int from, int to);
+
+    /**
+     * @brief Количество живых объектов
+     */
+    size_t get_heap_size() const { return live_count.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Получить ref_count объекта
+     * @return ref_count, или -1 если объекта нет
+     */
+    int get_ref_count(int obj_id) const;
+
+    bool object_exists(int obj_id) const { return find(obj_id) != nullptr; }
+
+    CountMode get_mode() const { return mode; }
+
+    /**
+     * @brief Задать функцию, которую add_root вызывает между захватом корня и увеличением счётчика
+     *
+     * Нужна проверкам, чтобы детерминированно воспроизвести гонку add_root
+     * с remove_root того же объекта. Задаётся до начала работы потоков.
+     *
+     * @param hook Получает ID объекта; пустая функция отключает вызов
+     */
+    void set_root_claim_hook(std::function<void(int)> hook) { root_claim_hook = std::move(hook); }
+
+    /**
+     * @brief Слить объекты из очереди вызывающего потока (режим Biased)
+     * @return Количество слитых объектов
+     */
+    size_t merge_pending();
+
+    /**
+     * @brief Слить очереди всех потоков (только когда другие потоки не работают с кучей)
+     * @return Количество слитых объектов
+     */
+    size_t settle();
+
+    /**
+     * @brief Обойти все живые объекты (только когда другие потоки не работают с кучей)
+     */
+    template <typename Fn>
+    void for_each(Fn &&fn) const
+    {
+        for (const Shard &shard : shards)
+        {
+            for (const auto &entry : shard.objects)
+            {
+                fn(*entry.second);
+            }
+        }
+    }
+
+private:
+    struct alignas(64) Shard
+    {
+        mutable std::mutex lock;
+        std::unordered_map<int, std::shared_ptr<ConcurrentObject>> objects;
+    };
+
+    /**
+     * @brief Очередь объектов, ждущих слияния у потока-владельца
+     */
+    struct OwnerQueue
+    {
+        std::mutex lock;
+        std::vector<std::shared_ptr<ConcurrentObject>> objects;
+        std::atomic<bool> pending{false};
+    };
+
+    EventLogger &logger;
+    std::vector<Shard> shards;
+    size_t shard_mask;
+    std::atomic<size_t> live_count{0};
+    CountMode mode;
+    uint64_t instance; ///< Уникальный номер кучи (ключ кеша очереди в потоке)
+    std::function<void(int)> root_claim_hook; ///< set_root_claim_hook()
+
+    std::mutex queues_lock;
+    std::unordered_map<uint32_t, std::unique_ptr<OwnerQueue>> queues; ///< По номеру потока
+
+    /**
+     * @brief Номер вызывающего потока (уникален в пределах процесса)
+     */
+    static uint32_t current_thread();
+
+    OwnerQueue &queue_for(uint32_t owner);
+
+    /**
+     * @brief Слить очередь вызывающего потока, если в ней что-то есть
+     */
+    void merge_if_pending()
+    {
+        if (mode == CountMode::Biased)
+        {
+            merge_pending();
+        }
+    }
+
+    /**
+     * @brief Обработать результат уменьшения счётчика: удалить или поставить в очередь владельца
+     */
+    void on_release(std::shared_ptr<ConcurrentObject> obj, BiasedRefCount::Release result);
+
+    Shard &shard_for(int obj_id) { return shards[static_cast<size_t>(obj_id) & shard_mask]; }
+    const Shard &shard_for(int obj_id) const { return shards[static_cast<size_t>(obj_id) & shard_mask]; }
+
+    std::shared_ptr<ConcurrentObject> find(int obj_id) const;
+
+
+    /**
+     * @brief Удалить захваченный объект и итеративно всех, кто освободился вслед за ним
+     */
+    void cascade(std::shared_ptr<ConcurrentObject> obj);
+};
+
+#endif // CONCURRENT_RC_HEAP_H
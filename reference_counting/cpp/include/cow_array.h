@@ -0,0 +1,192 @@
+#ifndef COW_ARRAY_H
+#define COW_ARRAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/**
+ * @class CowArray
+ * @brief Массив из кусков по 2^ChunkShift элементов с копированием при записи
+ *
+ * Таблица указателей на куски и сами куски разделяются через shared_ptr.
+ * share() возвращает срез за O(1): он разделяет таблицу с массивом.
+ * Первая запись после share() копирует таблицу (только указатели на куски),
+ * а первая запись в каждый кусок — сам кусок, если им владеет ещё кто-то.
+ * Нетронутые куски остаются общими.
+ *
+ * Флаги owned в таблице отмечают куски, которые уже принадлежат только
+ * этой таблице, поэтому запись в своё обходится двумя проверками без
+ * атомарных операций. use_count() читается только на медленном пути:
+ * другой поток может лишь уменьшить его, освободив срез, и тогда копия
+ * просто окажется лишней.
+ *
+ * Запись — только из одного потока. Срезы читаются из любых потоков.
+ * Ссылки на элементы стабильны: куски не перемещаются при росте массива.
+ */
+template <typename T, unsigned ChunkShift>
+class CowArray
+{
+public:
+    static constexpr size_t kChunkSize = size_t(1) << ChunkShift;
+    static constexpr size_t kChunkMask = kChunkSize - 1;
+
+    CowArray()
+        : table(std::make_shared<Table>()), count(0), table_owned(true), chunk_ptrs(nullptr), owned_flags(nullptr)
+    {
+    }
+
+    // Копирование только через share(): обычная копия считала бы таблицу своей
+    CowArray(const CowArray &) = delete;
+    CowArray &operator=(const CowArray &) = delete;
+    CowArray(CowArray &&) = default;
+    CowArray &operator=(CowArray &&) = default;
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    const T &operator[](size_t index) const { return chunk_ptrs[index >> ChunkShift]->items[index & kChunkMask]; }
+
+    /**
+     * @brief Элемент для записи: кусок копируется, если он разделён со срезом
+     */
+    T &operator[](size_t index)
+    {
+        size_t chunk = index >> ChunkShift;
+        if (!table_owned || !owned_flags[chunk])
+        {
+            own_chunk(chunk);
+        }
+        return chunk_ptrs[chunk]->items[index & kChunkMask];
+    }
+
+    void push_back(T value)
+    {
+        if ((count & kChunkMask) == 0 && (count >> ChunkShift) == table->chunks.size())
+        {
+            add_chunk();
+        }
+        (*this)[count++] = std::move(value);
+    }
+
+    /**
+     * @brief Увеличить размер, заполнив новые элементы значением fill (уменьшение не поддерживается)
+     */
+    void grow(size_t new_count, const T &fill)
+    {
+        while (count < new_count)
+        {
+            push_back(fill);
+        }
+    }
+
+    /**
+     * @brief Зарезервировать таблицу под заданное число элементов (куски выделяются по мере роста)
+     */
+    void reserve(size_t capacity)
+    {
+        own_table();
+        size_t chunks = (capacity + kChunkMask) >> ChunkShift;
+        table->chunks.reserve(chunks);
+        table->owned.reserve(chunks);
+        cache();
+    }
+
+    /**
+     * @brief Срез за O(1): неизменяемая копия, разделяющая куски с этим массивом
+     */
+    CowArray share()
+    {
+        table_owned = false;
+        CowArray view;
+        view.table = table;
+        view.count = count;
+        view.table_owned = false;
+        view.cache();
+        return view;
+    }
+
+    size_t chunk_count() const { return table->chunks.size(); }
+
+    /**
+     * @brief Разделён ли кусок с другим массивом или срезом
+     */
+    bool is_chunk_shared(size_t chunk) const { return table->chunks[chunk].use_count() > 1; }
+
+    /**
+     * @brief Байт, занятых таблицей и кусками (разделённые куски учитываются полностью)
+     */
+    size_t memory_usage() const
+    {
+        return table->chunks.capacity() * (sizeof(std::shared_ptr<Chunk>) + 1) +
+               table->chunks.size() * sizeof(Chunk);
+    }
+
+private:
+    struct Chunk
+    {
+        T items[kChunkSize];
+    };
+
+    struct Table
+    {
+        std::vector<std::shared_ptr<Chunk>> chunks;
+        std::vector<uint8_t> owned; ///< Кусок принадлежит только этой таблице
+    };
+
+    std::shared_ptr<Table> table;
+    size_t count;
+    bool table_owned;                     ///< Таблица не разделена со срезом
+    std::shared_ptr<Chunk> *chunk_ptrs;   ///< table->chunks.data(): на одну косвенность меньше
+    uint8_t *owned_flags;                 ///< table->owned.data()
+
+    void cache()
+    {
+        chunk_ptrs = table->chunks.data();
+        owned_flags = table->owned.data();
+    }
+
+    void own_table()
+    {
+        if (table_owned)
+        {
+            return;
+        }
+        if (table.use_count() > 1)
+        {
+            // Новая таблица разделяет все куски со старой
+            std::shared_ptr<Table> copy = std::make_shared<Table>();
+            copy->chunks = table->chunks;
+            copy->owned.assign(copy->chunks.size(), 0);
+            table = std::move(copy);
+            cache();
+        }
+        table_owned = true;
+    }
+
+    void own_chunk(size_t chunk)
+    {
+        own_table();
+        if (table->owned[chunk])
+        {
+            return;
+        }
+        if (table->chunks[chunk].use_count() > 1)
+        {
+            table->chunks[chunk] = std::make_shared<Chunk>(*table->chunks[chunk]);
+        }
+        table->owned[chunk] = 1;
+    }
+
+    void add_chunk()
+    {
+        own_table();
+        table->chunks.push_back(std::make_shared<Chunk>());
+        table->owned.push_back(1);
+        cache();
+    }
+};
+
+#endif // COW_ARRAY_H
@@ -0,0 +1,87 @@
+#ifndef CYCLE_COLLECTOR_H
+#define CYCLE_COLLECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "rc_object.h"
+#include "object_store.h"
+#include "event_logger.h"
+
+/**
+ * @class CycleCollector
+ * @brief Синхронный сборщик циклов методом пробного удаления (Bacon–Rajan)
+ *
+ * Когда декремент оставляет ref_count > 0, объект может оказаться корнем
+ * мусорного цикла: он окрашивается в Purple и попадает в буфер кандидатов.
+ * collect_cycles() выполняет три фазы над подграфом, достижимым из кандидатов:
+ * - MarkGray: пробно вычесть внутренние ссылки подграфа
+ * - Scan: объекты с оставшимся ref_count > 0 достижимы извне (Black),
+ *   их счётчики восстанавливаются; остальные — мусор (White)
+ * - CollectWhite: освободить белые объекты
+ *
+ * Работа пропорциональна размеру подграфа кандидатов, а не всей кучи.
+ * Все обходы итеративные и используют переиспользуемые стеки.
+ */
+class CycleCollector
+{
+public:
+    /**
+     * @brief Конструктор
+     * @param heap Ссылка на хранилище объектов
+     * @param logger Ссылка на логгер событий
+     */
+    CycleCollector(ObjectStore &heap, EventLogger &logger);
+
+    /**
+     * @brief Зарегистрировать возможный корень цикла
+     *
+     * Вызывается после декремента, оставившего ref_count > 0.
+     *
+     * @param obj Объект, чей счётчик уменьшился
+     */
+    void possible_root(RCObject &obj);
+
+    /**
+     * @brief Найти и освободить мусорные циклы среди кандидатов
+     * @return Количество освобождённых объектов
+     */
+    size_t collect_cycles();
+
+    /**
+     * @brief Количество записей в буфере кандидатов
+     */
+    size_t candidate_count() const { return candidates.size(); }
+
+    /**
+     * @brief Сколько объектов прошла фаза MarkGray за всё время (мера работы сборщика)
+     */
+    uint64_t traced_count() const { return traced; }
+
+private:
+    ObjectStore &heap;
+    EventLogger &logger;
+
+    std::vector<ObjectHandle> candidates; ///< Буфер кандидатов в корни циклов
+    std::vector<int> stack;               ///< Рабочий стек MarkGray/Scan/CollectWhite
+    std::vector<int> black_stack;         ///< Рабочий стек ScanBlack (вызывается изнутри Scan)
+    std::vector<int> garbage;             ///< Белые объекты, собранные для освобождения
+    uint64_t traced;                      ///< Объекты, окрашенные в Gray
+
+    /**
+     * @brief Удалить из буфера устаревшие дескрипторы освобождённых объектов
+     */
+    void compact_candidates();
+
+    void mark_roots();
+    void scan_roots();
+    size_t collect_roots();
+
+    void mark_gray(RCObject &obj);
+    void scan(RCObject &obj);
+    void scan_black(RCObject &obj);
+    void collect_white(RCObject &obj);
+};
+
+#endif // CYCLE_COLLECTOR_H
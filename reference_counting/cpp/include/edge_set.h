@@ -0,0 +1,359 @@
+#ifndef EDGE_SET_H
+#define EDGE_SET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @class BasicEdgeSet
+ * @brief Множество исходящих ссылок объекта (ID целей)
+ *
+ * До kInlineCapacity ссылок хранятся прямо в объекте, без выделений памяти.
+ * Дальше ссылки лежат в отдельном плотном массиве; пока их не больше
+ * kHashThreshold, поиск — линейный проход. Выше порога к массиву добавляется
+ * хеш-индекс с открытой адресацией (ID -> позиция в массиве), и проверка,
+ * вставка и удаление становятся O(1) амортизированно.
+ *
+ * Обход идёт по плотному массиву в порядке вставки. Без хеш-индекса удаление
+ * этот порядок сохраняет; с индексом удалённый элемент замещается последним.
+ *
+ * Внешний массив и хеш-индекс выделяются через Alloc (для индекса — его
+ * rebind на uint32_t). Аллокатор должен быть без состояния
+ * (is_always_equal): он не хранится в объекте и не меняет его размер.
+ */
+template <typename Alloc>
+class BasicEdgeSet : private Alloc
+{
+    static_assert(std::allocator_traits<Alloc>::is_always_equal::value,
+                  "BasicEdgeSet requires a stateless allocator");
+
+public:
+    using const_iterator = const int *;
+    using const_reverse_iterator = std::reverse_iterator<const int *>;
+
+    static constexpr uint32_t kInlineCapacity = 4; ///< Ссылок без выделения памяти
+    static constexpr uint32_t kHashThreshold = 16; ///< Наибольшая ёмкость без хеш-индекса
+
+    BasicEdgeSet() : count(0), capacity(0), storage{} {}
+
+    BasicEdgeSet(const BasicEdgeSet &other) : Alloc(), count(0), capacity(0), storage{}
+    {
+        copy_from(other);
+    }
+
+    BasicEdgeSet(BasicEdgeSet &&other) noexcept : count(other.count), capacity(other.capacity), storage(other.storage)
+    {
+        other.count = 0;
+        other.capacity = 0;
+    }
+
+    BasicEdgeSet &operator=(const BasicEdgeSet &other)
+    {
+        if (this != &other)
+        {
+            release();
+            copy_from(other);
+        }
+        return *this;
+    }
+
+    BasicEdgeSet &operator=(BasicEdgeSet &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            count = other.count;
+            capacity = other.capacity;
+            storage = other.storage;
+            other.count = 0;
+            other.capacity = 0;
+        }
+        return *this;
+    }
+
+    ~BasicEdgeSet() { release(); }
+
+    const_iterator begin() const { return values(); }
+    const_iterator end() const { return values() + count; }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    /**
+     * @brief Есть ли ссылка на объект
+     */
+    bool contains(int target_id) const
+    {
+        if (has_index())
+        {
+            return storage.heap.index[probe(target_id)] != 0;
+        }
+        return linear_find(target_id) != count;
+    }
+
+    /**
+     * @brief Добавить ссылку
+     * @return true, если ссылки не было
+     */
+    bool insert(int target_id)
+    {
+        if (contains(target_id))
+        {
+            return false;
+        }
+        if (count == effective_capacity())
+        {
+            grow();
+        }
+
+        int *data = values();
+        data[count] = target_id;
+        count++;
+        if (has_index())
+        {
+            storage.heap.index[probe(target_id)] = count; // позиция + 1
+        }
+        return true;
+    }
+
+    /**
+     * @brief Удалить ссылку
+     * @return true, если ссылка была
+     */
+    bool erase(int target_id)
+    {
+        int *data = values();
+        if (!has_index())
+        {
+            uint32_t pos = linear_find(target_id);
+            if (pos == count)
+            {
+                return false;
+            }
+            std::memmove(data + pos, data + pos + 1, (count - pos - 1) * sizeof(int));
+            count--;
+            return true;
+        }
+
+        uint32_t bucket = probe(target_id);
+        uint32_t entry = storage.heap.index[bucket];
+        if (entry == 0)
+        {
+            return false;
+        }
+        remove_bucket(bucket);
+
+        // Последний элемент переезжает на место удалённого
+        uint32_t pos = entry - 1;
+        uint32_t last = count - 1;
+        if (pos != last)
+        {
+            data[pos] = data[last];
+            storage.heap.index[probe(data[pos])] = pos + 1;
+        }
+        count--;
+        return true;
+    }
+
+    /**
+     * @brief Удалить все ссылки и освободить память
+     */
+    void clear()
+    {
+        release();
+        count = 0;
+        capacity = 0;
+    }
+
+    /**
+     * @brief Память, выделенная вне объекта (массив и хеш-индекс), в байтах
+     */
+    size_t memory_usage() const
+    {
+        if (capacity == 0)
+        {
+            return 0;
+        }
+        size_t bytes = capacity * sizeof(int);
+        if (has_index())
+        {
+            bytes += index_size() * sizeof(uint32_t);
+        }
+        return bytes;
+    }
+
+private:
+    using ValueTraits = std::allocator_traits<Alloc>;
+    using IndexAlloc = typename ValueTraits::template rebind_alloc<uint32_t>;
+    using IndexTraits = std::allocator_traits<IndexAlloc>;
+
+    uint32_t count;    ///< Количество ссылок
+    uint32_t capacity; ///< Ёмкость внешнего массива; 0 — ссылки хранятся во встроенном буфере
+
+    union Storage
+    {
+        int inline_refs[kInlineCapacity];
+        struct
+        {
+            int *data;       ///< Плотный массив ссылок
+            uint32_t *index; ///< Хеш-индекс: позиция + 1, 0 — пустая ячейка (nullptr до порога)
+        } heap;
+    } storage;
+
+    int *values() { return capacity == 0 ? storage.inline_refs : storage.heap.data; }
+    const int *values() const { return capacity == 0 ? storage.inline_refs : storage.heap.data; }
+
+    uint32_t effective_capacity() const { return capacity == 0 ? kInlineCapacity : capacity; }
+    bool has_index() const { return capacity > kHashThreshold; }
+
+    /**
+     * @brief Размер хеш-индекса: вдвое больше ёмкости, загрузка не выше 1/2
+     */
+    uint32_t index_size() const { return capacity * 2; }
+
+    static uint32_t hash(int value)
+    {
+        return static_cast<uint32_t>((static_cast<uint64_t>(static_cast<uint32_t>(value)) *
+                                      0x9E3779B97F4A7C15ull) >> 32);
+    }
+
+    uint32_t linear_find(int target_id) const
+    {
+        const int *data = values();
+        uint32_t pos = 0;
+        while (pos < count && data[pos] != target_id)
+        {
+            pos++;
+        }
+        return pos;
+    }
+
+    /**
+     * @brief Ячейка хеш-индекса с данным ID или первая пустая ячейка на его пути
+     */
+    uint32_t probe(int target_id) const
+    {
+        const uint32_t mask = index_size() - 1;
+        const int *data = storage.heap.data;
+        const uint32_t *index = storage.heap.index;
+        uint32_t bucket = hash(target_id) & mask;
+        while (index[bucket] != 0 && data[index[bucket] - 1] != target_id)
+        {
+            bucket = (bucket + 1) & mask;
+        }
+        return bucket;
+    }
+
+    /**
+     * @brief Освободить ячейку, сдвинув назад следующие за ней записи цепочки
+     *
+     * Линейное зондирование без надгробий: записи, которые больше не
+     * достижимы от своей домашней ячейки, переносятся в освободившуюся.
+     */
+    void remove_bucket(uint32_t hole)
+    {
+        const uint32_t mask = index_size() - 1;
+        uint32_t *index = storage.heap.index;
+        const int *data = storage.heap.data;
+        uint32_t bucket = hole;
+        for (;;)
+        {
+            bucket = (bucket + 1) & mask;
+            if (index[bucket] == 0)
+            {
+                break;
+            }
+            uint32_t home = hash(data[index[bucket] - 1]) & mask;
+            // Запись остаётся на месте, если её домашняя ячейка лежит в (hole, bucket]
+            bool stays = hole <= bucket ? (hole < home && home <= bucket)
+                                        : (hole < home || home <= bucket);
+            if (!stays)
+            {
+                index[hole] = index[bucket];
+                hole = bucket;
+            }
+        }
+        index[hole] = 0;
+    }
+
+    void grow()
+    {
+        uint32_t new_capacity = capacity == 0 ? kInlineCapacity * 2 : capacity * 2;
+        int *data = allocate_values(new_capacity);
+        std::memcpy(data, values(), count * sizeof(int));
+        release();
+        capacity = new_capacity;
+        storage.heap.data = data;
+        storage.heap.index = nullptr;
+        if (has_index())
+        {
+            rebuild_index();
+        }
+    }
+
+    void rebuild_index()
+    {
+        storage.heap.index = allocate_index(index_size());
+        std::memset(storage.heap.index, 0, index_size() * sizeof(uint32_t));
+        for (uint32_t pos = 0; pos < count; ++pos)
+        {
+            storage.heap.index[probe(storage.heap.data[pos])] = pos + 1;
+        }
+    }
+
+    void copy_from(const BasicEdgeSet &other)
+    {
+        count = other.count;
+        capacity = other.capacity;
+        if (capacity == 0)
+        {
+            storage = other.storage;
+            return;
+        }
+        storage.heap.data = allocate_values(capacity);
+        std::memcpy(storage.heap.data, other.storage.heap.data, count * sizeof(int));
+        storage.heap.index = nullptr;
+        if (has_index())
+        {
+            storage.heap.index = allocate_index(index_size());
+            std::memcpy(storage.heap.index, other.storage.heap.index, index_size() * sizeof(uint32_t));
+        }
+    }
+
+    void release()
+    {
+        if (capacity != 0)
+        {
+            ValueTraits::deallocate(values_allocator(), storage.heap.data, capacity);
+            if (storage.heap.index != nullptr)
+            {
+                IndexAlloc index_allocator(values_allocator());
+                IndexTraits::deallocate(index_allocator, storage.heap.index, index_size());
+            }
+        }
+    }
+
+    Alloc &values_allocator() { return *this; }
+
+    int *allocate_values(uint32_t n) { return ValueTraits::allocate(values_allocator(), n); }
+
+    uint32_t *allocate_index(uint32_t n)
+    {
+        IndexAlloc index_allocator(values_allocator());
+        return IndexTraits::allocate(index_allocator, n);
+    }
+};
+
+/**
+ * @brief Множество ссылок на стандартном аллокаторе
+ */
+using EdgeSet = BasicEdgeSet<std::allocator<int>>;
+
+#endif // EDGE_SET_H
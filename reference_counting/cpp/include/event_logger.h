@@ -1,17 +1,34 @@
 #ifndef EVENT_LOGGER_H
 #define EVENT_LOGGER_H
 
+#include <atomic>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <iostream>
 #include <ctime>
 
+#include "log_sink.h"
+
+/**
+ * @enum LogFormat
+ * @brief Формат файла логов
+ */
+enum class LogFormat
+{
+    JsonLines, ///< Текст, JSON-строка на событие (читает Python-аниматор)
+    Binary     ///< Записи фиксированного размера, буферизованная запись
+};
+
 /**
  * @class EventLogger
  * @brief Логирует все события изменения памяти в JSON формате
  *
  * Создаёт файл логов при инициализации и записывает каждое событие
- * в формате JSON для последующего анализа и визуализации.
+ * для последующего анализа и визуализации. Способ хранения задаётся
+ * приёмником (LogSink): JSON-строки по умолчанию или бинарные записи.
+ * Вызывать log_* из нескольких потоков можно, только если приёмник это
+ * допускает (AsyncLogSink).
  */
 class EventLogger
 {
@@ -19,9 +36,17 @@ public:
     /**
      * @brief Конструктор с указанием пути к файлу логов
      * @param filename Путь к файлу для логов
+     * @param format Формат файла логов
      * @throw std::runtime_error если файл не удаётся открыть
      */
-    explicit EventLogger(const std::string &filename);
+    explicit EventLogger(const std::string &filename, LogFormat format = LogFormat::JsonLines);
+
+    /**
+     * @brief Конструктор с готовым приёмником событий
+     * @param sink Приёмник событий
+     * @throw std::runtime_error если приёмник не открыт
+     */
+    explicit EventLogger(std::unique_ptr<LogSink> sink);
 
     /**
      * @brief Деструктор, закрывает файл логов
@@ -62,14 +87,48 @@ public:
      */
     void log_leak(int obj_id);
 
+    /**
+     * @brief Логировать добавление слабой ссылки
+     * @param from ID объекта-держателя
+     * @param to ID объекта-цели
+     * @param new_weak_count Новое количество слабых ссылок на цель
+     */
+    void log_add_weak_ref(int from, int to, int new_weak_count);
+
+    /**
+     * @brief Логировать удаление слабой ссылки
+     * @param from ID объекта-держателя
+     * @param to ID объекта-цели
+     * @param new_weak_count Новое количество слабых ссылок на цель (0, если цель уже удалена)
+     */
+    void log_remove_weak_ref(int from, int to, int new_weak_count);
+
+    /**
+     * @brief Логировать удаление объекта, на который остались слабые ссылки
+     * @param obj_id ID удаляемого объекта
+     * @param weak_count Сколько слабых ссылок стали недействительными
+     */
+    void log_weak_expire(int obj_id, int weak_count);
+
+    /**
+     * @brief Сбросить буферизованные события в файл
+     */
+    void sync() { sink->sync(); }
+
     /**
      * @brief Проверить, успешно ли открыт файл логов
      * @return true, если файл открыт
      */
-    bool is_open() const { return file.is_open(); }
+    bool is_open() const { return sink->is_open(); }
+
+    /**
+     * @brief Количество событий, записанных с момента открытия
+     */
+    uint64_t get_event_count() const { return seq.load(std::memory_order_relaxed); }
 
 private:
-    std::ofstream file;
+    std::unique_ptr<LogSink> sink;
+    std::atomic<uint64_t> seq; ///< Номер следующего события (общий для всех потоков)
 
     /**
      * @brief Получить текущее время в ISO формате
@@ -78,10 +137,12 @@ private:
     std::string get_timestamp() const;
 
     /**
-     * @brief Записать строку JSON в файл логов
-     * @param json JSON строка для записи
+     * @brief Передать событие приёмнику
      */
-    void write(const std::string &json);
+    void write(EventType type, int from, int to, int ref_count)
+    {
+        sink->write(LogRecord{type, from, to, ref_count, seq.fetch_add(1, std::memory_order_relaxed)});
+    }
 
     /**
      * @brief Создать директорию логов если её не существует
@@ -0,0 +1,79 @@
+#ifndef GRAPH_GENERATORS_H
+#define GRAPH_GENERATORS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "scenario_op.h"
+
+class RCHeap;
+
+/**
+ * @struct Graph
+ * @brief Граф объектов для бенчмарков и сценариев
+ *
+ * Вершины — объекты с ID от 1 до node_count (0 в логе означает корень),
+ * рёбра — ссылки from -> to без петель и повторов. Генераторы
+ * детерминированы: одинаковые параметры и seed дают один и тот же граф
+ * на любой платформе (распределения std:: здесь не используются).
+ */
+struct Graph
+{
+    std::string name;                       ///< Вид и параметры, например "erdos_renyi/n=1000/p=0.002"
+    int node_count = 0;
+    std::vector<std::pair<int, int>> edges; ///< Ссылки (from, to) в порядке добавления
+    std::vector<int> roots;                 ///< Корни
+
+    /**
+     * @brief Операции сценария, строящие граф: allocate всех вершин, add_ref, add_root
+     */
+    std::vector<ScenarioOp> to_scenario() const;
+
+    /**
+     * @brief Построить граф в куче (ID объектов кучи должны быть свободны)
+     */
+    void load_into(RCHeap &heap) const;
+
+    /**
+     * @brief Записать граф как JSON-сценарий (формат каталога scenarios/)
+     * @throw std::runtime_error если файл не открывается
+     */
+    void write_scenario_json(const std::string &filename) const;
+};
+
+/**
+ * @brief Цепочка 1 -> 2 -> ... -> n с корнем 1
+ */
+Graph make_chain(int n);
+
+/**
+ * @brief Полное двоичное дерево из n вершин (дети i — 2i и 2i+1) с корнем 1
+ */
+Graph make_binary_tree(int n);
+
+/**
+ * @brief Случайный ориентированный граф Эрдёша–Реньи G(n, p)
+ *
+ * Каждая из n(n-1) упорядоченных пар становится ссылкой с вероятностью p.
+ * Пропуски между рёбрами выбираются геометрически (Batagelj–Brandes),
+ * поэтому время — O(n + m), а не O(n^2).
+ *
+ * @param root_count Сколько случайных вершин сделать корнями
+ */
+Graph make_erdos_renyi(int n, double p, int root_count, uint64_t seed);
+
+/**
+ * @brief Граф со степенным распределением входящих ссылок (Барабаши–Альберт)
+ *
+ * Каждая новая вершина ссылается на m уже существующих, выбранных
+ * пропорционально их степени: на немногие «популярные» объекты
+ * ссылаются очень многие.
+ *
+ * @param root_count Сколько случайных вершин сделать корнями
+ */
+Graph make_power_law(int n, int m, int root_count, uint64_t seed);
+
+#endif // GRAPH_GENERATORS_H
@@ -0,0 +1,148 @@
+#ifndef HEAP_IMAGE_H
+#define HEAP_IMAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+#include "mark_bitmap.h"
+#include "object_store.h"
+
+/**
+ * @enum ScanKernel
+ * @brief Реализация сканирования массива счётчиков
+ */
+enum class ScanKernel
+{
+    Auto,   ///< AVX2, если процессор его поддерживает, иначе Scalar
+    Scalar, ///< Переносимый цикл
+    Avx2    ///< Сравнение 8 счётчиков за инструкцию + movemask (только x86 с GCC/Clang)
+};
+
+/**
+ * @class HeapImage
+ * @brief Снимок кучи в виде структуры массивов (SoA) для проходов по всей куче
+ *
+ * Живые объекты нумеруются подряд в порядке слотов ObjectStore. Для
+ * индекса i хранятся ids[i], generations[i] и ref_counts[i] в отдельных
+ * плотных массивах, а исходящие ссылки — в формате CSR: индексы целей
+ * edge_targets[edge_offsets[i] .. edge_offsets[i + 1]). Ссылки переведены
+ * из ID в индексы образа при захвате, поэтому обход графа не обращается
+ * к таблице ID -> слот.
+ *
+ * Сканирование счётчиков идёт по одному массиву int32 подряд и на x86
+ * векторизуется AVX2 (выбор реализации — во время выполнения).
+ *
+ * Образ не следит за кучей: после изменений его нужно захватить заново.
+ */
+class HeapImage
+{
+public:
+    static constexpr uint32_t kNoIndex = UINT32_MAX;
+
+    HeapImage() {}
+
+    /**
+     * @brief Захватить образ кучи
+     * @param store Хранилище объектов
+     * @param roots Множество явных корней
+     * @throw std::length_error, если ссылок больше, чем помещается в uint32
+     */
+    HeapImage(const ObjectStore &store, const std::unordered_set<int> &roots);
+
+    /**
+     * @brief Собрать образ из готовых массивов (ссылки и корни уже в индексах образа)
+     *
+     * Для состояний кучи не из ObjectStore (HeapSnapshotReader); поколения
+     * слотов нулевые.
+     *
+     * @param edge_offsets_ ids_.size() + 1 значений
+     */
+    HeapImage(std::vector<int32_t> ids_, std::vector<int32_t> ref_counts_, std::vector<uint32_t> edge_offsets_,
+              std::vector<uint32_t> edge_targets_, std::vector<uint32_t> root_indices_);
+
+    /**
+     * @brief Количество объектов в образе
+     */
+    size_t size() const { return ids.size(); }
+
+    /**
+     * @brief Количество ссылок в образе
+     */
+    size_t edge_count() const { return edge_targets.size(); }
+
+    int id(uint32_t index) const { return ids[index]; }
+    uint32_t generation(uint32_t index) const { return generations[index]; }
+    int ref_count(uint32_t index) const { return ref_counts[index]; }
+
+    /**
+     * @brief Индексы целей исходящих ссылок объекта
+     */
+    const uint32_t *edges_begin(uint32_t index) const { return edge_targets.data() + edge_offsets[index]; }
+    const uint32_t *edges_end(uint32_t index) const { return edge_targets.data() + edge_offsets[index + 1]; }
+
+    /**
+     * @brief Подсказать процессору загрузить границы ссылок объекта заранее
+     *
+     * Для обходов, где следующий объект известен задолго до того, как
+     * понадобятся его ссылки (DFS: цели ссылок только что открытого объекта).
+     */
+    void prefetch_edges(uint32_t index) const
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(edge_offsets.data() + index);
+#else
+        (void)index;
+#endif
+    }
+
+    /**
+     * @brief Индексы явных корней
+     */
+    const std::vector<uint32_t> &get_root_indices() const { return root_indices; }
+
+    /**
+     * @brief Количество объектов с ref_count == 0
+     */
+    size_t count_zero(ScanKernel kernel = ScanKernel::Auto) const;
+
+    /**
+     * @brief Дописать в out индексы объектов с ref_count == 0 (по возрастанию)
+     */
+    void zero_indices(std::vector<uint32_t> &out, ScanKernel kernel = ScanKernel::Auto) const;
+
+    /**
+     * @brief Пометить объекты, достижимые из корней и из объектов с ref_count == 0
+     *
+     * Те же правила, что у Tracer::mark(); бит i карты — индекс образа.
+     *
+     * @return Количество помеченных объектов
+     */
+    size_t mark(MarkBitmap &marks, ScanKernel kernel = ScanKernel::Auto) const;
+
+    /**
+     * @brief ID объектов, не достижимых ни из корней, ни из объектов с ref_count == 0 (утечки RC)
+     */
+    std::vector<int> unreachable_ids(ScanKernel kernel = ScanKernel::Auto) const;
+
+    /**
+     * @brief Поддерживает ли процессор (и сборка) реализацию AVX2
+     */
+    static bool avx2_available();
+
+    /**
+     * @brief Память массивов образа в байтах
+     */
+    size_t memory_usage() const;
+
+private:
+    std::vector<int32_t> ids;           ///< ID объекта
+    std::vector<uint32_t> generations;  ///< Поколение слота объекта
+    std::vector<int32_t> ref_counts;    ///< Счётчик ссылок
+    std::vector<uint32_t> edge_offsets; ///< Начало ссылок объекта в edge_targets (size() + 1 значений)
+    std::vector<uint32_t> edge_targets; ///< Индексы целей ссылок
+    std::vector<uint32_t> root_indices; ///< Индексы явных корней
+};
+
+#endif // HEAP_IMAGE_H
@@ -0,0 +1,239 @@
+#ifndef HEAP_SNAPSHOT_H
+#define HEAP_SNAPSHOT_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <ostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "heap_image.h"
+#include "object_store.h"
+
+/**
+ * Бинарный формат снимков кучи.
+ *
+ * Заголовок kSnapshotHeaderSize байт: магия "RCSN", версия (u16), флаги (u16),
+ * количество завершённых кадров (u64); всё в little-endian. Дальше идут
+ * кадры, каждый — последовательность записей с байтом-тегом:
+ *   - kSnapshotFrameBegin: режим (u8: 0 — полный, 1 — diff), номер кадра (u64);
+ *   - kSnapshotRemove: ID (i32) — объект удалён;
+ *   - kSnapshotObject: ID (i32), ref_count (i32), число ссылок (u32), ID целей (i32 каждая);
+ *   - kSnapshotRoots: число корней (u32), их ID (i32 каждый);
+ *   - kSnapshotFrameEnd: размер кучи на момент завершения кадра (u64).
+ * Полный кадр заменяет состояние целиком, diff-кадр сначала удаляет, затем
+ * записывает объекты поверх. Кадр без kSnapshotFrameEnd (запись прервана)
+ * читатель пропускает.
+ */
+const char kSnapshotMagic[4] = {'R', 'C', 'S', 'N'};
+const uint16_t kSnapshotVersion = 1;
+const size_t kSnapshotHeaderSize = 16;
+
+const uint8_t kSnapshotFrameBegin = 1;
+const uint8_t kSnapshotRemove = 2;
+const uint8_t kSnapshotObject = 3;
+const uint8_t kSnapshotRoots = 4;
+const uint8_t kSnapshotFrameEnd = 5;
+
+/**
+ * @enum SnapshotMode
+ * @brief Вид кадра снимка
+ */
+enum class SnapshotMode
+{
+    Full, ///< Все живые объекты
+    Diff  ///< Только объекты, изменённые или удалённые после предыдущего кадра
+};
+
+/**
+ * @class HeapSnapshotWriter
+ * @brief Пошаговая запись снимков кучи с ограничением времени на шаг
+ *
+ * Кадр пишется за один или несколько вызовов step(), между которыми
+ * мутатор продолжает работу. Для diff-кадров хранилище ведёт учёт
+ * изменённых объектов (ObjectStore::set_dirty_tracking включается первым
+ * кадром), так что стоимость diff-кадра пропорциональна числу изменений,
+ * а не размеру кучи.
+ *
+ * Кадр, растянутый на несколько шагов, не мгновенный срез: объект,
+ * изменённый после того, как writer его прошёл, попадёт в следующий
+ * diff-кадр (как при нечётких контрольных точках СУБД). Поэтому
+ * последовательность кадров, применённая по порядку, даёт состояние кучи
+ * на момент конца последнего кадра, если после его начала куча не менялась.
+ *
+ * На одно хранилище — один writer: учёт изменений общий.
+ */
+class HeapSnapshotWriter
+{
+public:
+    /**
+     * @throw std::runtime_error если файл не открывается
+     */
+    explicit HeapSnapshotWriter(const std::string &filename);
+
+    /**
+     * @brief Дописать буфер и число кадров в заголовок, закрыть файл
+     */
+    ~HeapSnapshotWriter();
+
+    HeapSnapshotWriter(const HeapSnapshotWriter &) = delete;
+    HeapSnapshotWriter &operator=(const HeapSnapshotWriter &) = delete;
+
+    /**
+     * @brief Начать кадр (если он не начат) и записать его часть
+     *
+     * diff-кадр до первого полного кадра этого writer'а пишется как полный.
+     * Если кадр уже начат, mode не учитывается.
+     *
+     * @param store Хранилище объектов
+     * @param roots Множество корней
+     * @param roots_version Номер версии множества корней: diff-кадр пишет
+     *        корни, только если номер изменился с прошлого кадра
+     * @param mode Вид нового кадра
+     * @param time_slice Ограничение длительности шага; 0 — дописать кадр целиком
+     * @return true, если кадр завершён
+     */
+    bool step(ObjectStore &store, const std::unordered_set<int> &roots, uint64_t roots_version, SnapshotMode mode,
+              std::chrono::nanoseconds time_slice);
+
+    /**
+     * @brief Начат ли и не завершён ли кадр
+     */
+    bool in_progress() const { return active; }
+
+    /**
+     * @brief Дописать буфер и число кадров, закрыть файл (незавершённый кадр остаётся неполным)
+     * @throw std::runtime_error при ошибке записи
+     */
+    void close();
+
+    uint64_t get_frame_count() const { return frame_count; }
+    uint64_t get_bytes_written() const { return bytes_written + used; }
+
+private:
+    std::FILE *file;
+    std::vector<unsigned char> buffer;
+    size_t used;
+    uint64_t bytes_written;
+    uint64_t frame_count;            ///< Завершённые кадры
+    bool active;                     ///< Кадр начат
+    SnapshotMode frame_mode;         ///< Вид текущего кадра
+    const ObjectStore *source;       ///< Хранилище, с которого писался последний кадр
+    uint32_t cursor;                 ///< Следующий слот (полный кадр) или позиция в pending (diff)
+    std::vector<uint32_t> pending;   ///< Слоты для записи в текущем diff-кадре
+    std::vector<int> removed;        ///< Удалённые ID для текущего diff-кадра
+    uint64_t written_roots_version;  ///< Версия корней в последнем записанном кадре
+
+    void begin_frame(ObjectStore &store, SnapshotMode mode);
+    void write_object(const RCObject &obj);
+    void write_roots(const std::unordered_set<int> &roots);
+    void end_frame(const ObjectStore &store);
+
+    unsigned char *reserve(size_t bytes);
+    void put_u8(uint8_t value) { *reserve(1) = value; }
+    void put_u32(uint32_t value);
+    void put_u64(uint64_t value);
+    void flush();
+};
+
+/**
+ * @struct SnapshotObject
+ * @brief Объект в состоянии, восстановленном из снимка
+ */
+struct SnapshotObject
+{
+    int ref_count = 0;
+    std::vector<int> references;
+};
+
+/**
+ * @struct SnapshotFrame
+ * @brief Сводка последнего прочитанного кадра
+ */
+struct SnapshotFrame
+{
+    uint64_t number = 0;
+    SnapshotMode mode = SnapshotMode::Full;
+    std::vector<int> removed;  ///< Удалённые ID
+    std::vector<int> written;  ///< ID записанных объектов
+    bool roots_written = false;
+    uint64_t heap_size = 0;    ///< Размер кучи по записи kSnapshotFrameEnd
+};
+
+/**
+ * @class HeapSnapshotReader
+ * @brief Чтение файла снимков и восстановление состояния кучи по кадрам
+ *
+ * Объекты хранятся упорядоченными по ID, поэтому вывод состояния идёт
+ * в порядке ID без сортировки.
+ */
+class HeapSnapshotReader
+{
+public:
+    /**
+     * @throw std::runtime_error если файл не открывается или заголовок неверен
+     */
+    explicit HeapSnapshotReader(const std::string &filename);
+
+    /**
+     * @brief Применить следующий кадр к состоянию
+     * @return false в конце файла (неполный последний кадр пропускается)
+     * @throw std::runtime_error при повреждённой записи
+     */
+    bool next_frame();
+
+    /**
+     * @brief Сводка последнего применённого кадра
+     */
+    const SnapshotFrame &get_frame() const { return frame; }
+
+    /**
+     * @brief Количество завершённых кадров по заголовку
+     */
+    uint64_t get_frame_count() const { return frame_count; }
+
+    const std::map<int, SnapshotObject> &get_objects() const { return objects; }
+    const std::vector<int> &get_roots() const { return roots; }
+
+    /**
+     * @brief Вывести состояние в формате RCHeap::dump_state()
+     */
+    void dump(std::ostream &out) const;
+
+    /**
+     * @brief SoA-образ восстановленного состояния (индексы образа — в порядке ID)
+     *
+     * Ссылки на отсутствующие объекты отбрасываются, как в HeapImage(store, roots).
+     */
+    HeapImage capture_image() const;
+
+    /**
+     * @brief Начинается ли файл с заголовка снимка
+     */
+    static bool is_snapshot(const std::string &filename);
+
+private:
+    std::vector<unsigned char> data;
+    size_t cursor;
+    uint64_t frame_count;
+    std::map<int, SnapshotObject> objects;
+    std::vector<int> roots;
+    SnapshotFrame frame;
+
+    /**
+     * @brief Дописан ли кадр, начинающийся с cursor, до kSnapshotFrameEnd
+     * @throw std::runtime_error при неизвестном теге
+     */
+    bool frame_complete() const;
+
+    uint8_t get_u8() { return data[cursor++]; }
+    uint32_t get_u32();
+    uint64_t get_u64();
+    [[noreturn]] void corrupt() const;
+};
+
+#endif // HEAP_SNAPSHOT_H
@@ -0,0 +1,75 @@
+#ifndef HEAP_VIEW_H
+#define HEAP_VIEW_H
+
+#include <cstddef>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include "heap_image.h"
+#include "leak_report.h"
+#include "object_store.h"
+
+/**
+ * @class HeapView
+ * @brief Неизменяемый срез кучи для анализа параллельно с мутатором
+ *
+ * Создаётся RCHeap::snapshot(): объекты и множество корней разделяются
+ * с кучей через копирование при записи (ObjectStore::snapshot).
+ * Все методы константные и не трогают счётчики статистики, поэтому срез
+ * можно читать из нескольких потоков одновременно, пока мутатор меняет
+ * кучу. Освобождать срез можно в любом потоке (см. ObjectStore::snapshot).
+ */
+class HeapView
+{
+public:
+    HeapView(ObjectStore objects_, std::shared_ptr<const std::unordered_set<int>> roots_);
+
+    const ObjectStore &get_objects() const { return objects; }
+    const std::unordered_set<int> &get_roots() const { return *roots; }
+
+    /**
+     * @brief Количество объектов в срезе
+     */
+    size_t size() const { return objects.size(); }
+
+    bool object_exists(int obj_id) const { return objects.slot_of(obj_id) != ObjectStore::kInvalidSlot; }
+
+    /**
+     * @return ref_count, или -1 если объекта нет в срезе
+     */
+    int get_ref_count(int obj_id) const;
+
+    /**
+     * @brief Достижим ли объект из явных корней
+     */
+    bool is_reachable(int obj_id) const;
+
+    /**
+     * @brief Достижим ли из объекта цикл ссылок
+     *
+     * Итеративный DFS: глубина графа не ограничена стеком вызовов.
+     */
+    bool has_cycle(int start_id) const;
+
+    /**
+     * @brief ID утечек: объектов, недостижимых ни из корней, ни из объектов с ref_count == 0
+     */
+    std::vector<int> find_leaks() const { return capture_image().unreachable_ids(); }
+
+    /**
+     * @brief Утечки, сгруппированные по циклам, с удерживаемыми размерами (см. LeakReport)
+     */
+    LeakReport analyze_leaks() const { return LeakReport::analyze(capture_image()); }
+
+    /**
+     * @brief SoA-образ среза для проходов по всей куче
+     */
+    HeapImage capture_image() const { return HeapImage(objects, *roots); }
+
+private:
+    ObjectStore objects;
+    std::shared_ptr<const std::unordered_set<int>> roots;
+};
+
+#endif // HEAP_VIEW_H
@@ -0,0 +1,68 @@
+#ifndef LEAK_REPORT_H
+#define LEAK_REPORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "heap_image.h"
+
+/**
+ * @struct LeakGroup
+ * @brief Цикл-источник утечки и всё, что удерживает только он
+ *
+ * Источник — компонента сильной связности утечек, в которую не ведут
+ * ссылки из других утечек (у утечек ref_count > 0, поэтому источник —
+ * цикл). Объекты, достижимые по утечкам только из этого источника,
+ * освободятся, если разорвать его цикл: это удерживаемый размер группы.
+ */
+struct LeakGroup
+{
+    std::vector<int> cycle;        ///< ID объектов цикла-источника по возрастанию
+    uint64_t cycle_edges = 0;      ///< Ссылки между объектами цикла
+    uint64_t retained_objects = 0; ///< Объекты, удерживаемые только этим циклом (вместе с ним)
+    uint64_t retained_edges = 0;   ///< Исходящие ссылки этих объектов
+    uint64_t nested_cycles = 0;    ///< Другие циклы среди удерживаемых объектов
+};
+
+/**
+ * @struct LeakReport
+ * @brief Утечки, сгруппированные по циклам, с удерживаемыми размерами
+ *
+ * Строится по HeapImage за O(V + E): пометка достижимого (HeapImage::mark),
+ * итеративный Тарьян по непомеченным объектам и один проход по компонентам
+ * в топологическом порядке, который назначает каждой компоненте
+ * единственный источник, из которого она достижима, или помечает её общей
+ * (достижима из нескольких источников). Рекурсии нет, рабочая память —
+ * несколько массивов uint32 по числу объектов образа.
+ */
+struct LeakReport
+{
+    static constexpr size_t kSampleIds = 16; ///< Сколько ID цикла выводят to_json() и dump()
+
+    uint64_t leaked_objects = 0; ///< Все утечки (= HeapImage::unreachable_ids().size())
+    uint64_t leaked_edges = 0;   ///< Исходящие ссылки утечек
+    uint64_t cycles = 0;         ///< Компоненты утечек из нескольких объектов
+    uint64_t shared_objects = 0; ///< Утечки, достижимые из нескольких источников
+    uint64_t shared_edges = 0;   ///< Исходящие ссылки общих утечек
+    std::vector<LeakGroup> groups; ///< По убыванию retained_objects, затем retained_edges
+
+    /**
+     * @brief Построить отчёт по образу кучи
+     */
+    static LeakReport analyze(const HeapImage &image);
+
+    /**
+     * @brief Отчёт в JSON (одна строка); у циклов выводятся первые kSampleIds ID
+     */
+    std::string to_json() const;
+
+    /**
+     * @brief Таблица первых limit групп для человека
+     */
+    void dump(std::ostream &out, size_t limit = 10) const;
+};
+
+#endif // LEAK_REPORT_H
@@ -0,0 +1,209 @@
+#ifndef LOG_SINK_H
+#define LOG_SINK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * @enum EventType
+ * @brief Тип события изменения памяти (значения записываются в бинарный лог)
+ */
+enum class EventType : uint32_t
+{
+    Allocate = 0,
+    AddRef = 1,
+    RemoveRef = 2,
+    Delete = 3,
+    Leak = 4,
+    AddWeakRef = 5,
+    RemoveWeakRef = 6,
+    WeakExpire = 7
+};
+
+/**
+ * @struct LogRecord
+ * @brief Одно событие лога
+ *
+ * Для событий над одним объектом (allocate, delete, leak) ID объекта лежит
+ * в from, а to и ref_count равны -1. У событий слабых ссылок в ref_count
+ * лежит счётчик слабых ссылок цели; у weak_expire to равен -1.
+ */
+struct LogRecord
+{
+    EventType type;
+    int32_t from;
+    int32_t to;
+    int32_t ref_count;
+    uint64_t seq; ///< Порядковый номер события с момента открытия лога
+};
+
+/**
+ * @brief Отформатировать событие как строку JSON (без перевода строки)
+ * @param record Событие
+ * @param out Буфер не короче kJsonRecordMax байт
+ * @return Длина строки
+ */
+size_t format_json_record(const LogRecord &record, char *out);
+
+constexpr size_t kJsonRecordMax = 96; ///< Максимальная длина JSON-строки события
+
+/**
+ * @class LogSink
+ * @brief Приёмник событий лога (способ хранения)
+ */
+class LogSink
+{
+public:
+    virtual ~LogSink() = default;
+
+    /**
+     * @brief Записать событие
+     */
+    virtual void write(const LogRecord &record) = 0;
+
+    /**
+     * @brief Сбросить буферизованные события в файл
+     */
+    virtual void sync() = 0;
+
+    /**
+     * @brief Открыт ли файл
+     */
+    virtual bool is_open() const = 0;
+};
+
+/**
+ * @class NullLogSink
+ * @brief Приёмник, отбрасывающий все события (логирование выключено)
+ */
+class NullLogSink : public LogSink
+{
+public:
+    void write(const LogRecord &) override {}
+    void sync() override {}
+    bool is_open() const override { return true; }
+};
+
+/**
+ * @class JsonLinesSink
+ * @brief Текстовый лог: одна JSON-строка на событие, сброс после каждого события
+ *
+ * Формат, который читает Python-аниматор.
+ */
+class JsonLinesSink : public LogSink
+{
+public:
+    explicit JsonLinesSink(const std::string &filename);
+
+    void write(const LogRecord &record) override;
+    void sync() override;
+    bool is_open() const override { return file.is_open(); }
+
+private:
+    std::ofstream file;
+};
+
+/**
+ * @class BinaryLogSink
+ * @brief Бинарный лог из записей фиксированного размера
+ *
+ * Файл начинается с заголовка (магия "RCEV", версия, размер записи), за ним
+ * идут записи по kRecordSize байт: type, from, to, ref_count (u32/i32)
+ * и seq (u64), всё в little-endian. Записи копятся в буфере в памяти и
+ * уходят в файл одним вызовом, когда буфер заполнен, по sync() или при
+ * закрытии.
+ */
+class BinaryLogSink : public LogSink
+{
+public:
+    /**
+     * @param filename Путь к файлу лога
+     * @param buffer_bytes Размер буфера в памяти
+     */
+    explicit BinaryLogSink(const std::string &filename, size_t buffer_bytes = 1 << 20);
+    ~BinaryLogSink() override;
+
+    BinaryLogSink(const BinaryLogSink &) = delete;
+    BinaryLogSink &operator=(const BinaryLogSink &) = delete;
+
+    void write(const LogRecord &record) override
+    {
+        if (used + kRecordSize > buffer.size())
+        {
+            sync();
+        }
+        encode(record, &buffer[used]);
+        used += kRecordSize;
+    }
+
+    void sync() override;
+    bool is_open() const override { return file != nullptr; }
+
+    static constexpr size_t kRecordSize = 24;
+
+    /**
+     * @brief Закодировать событие в kRecordSize байт little-endian
+     */
+    static void encode(const LogRecord &record, unsigned char *out)
+    {
+        put32(out, static_cast<uint32_t>(record.type));
+        put32(out + 4, static_cast<uint32_t>(record.from));
+        put32(out + 8, static_cast<uint32_t>(record.to));
+        put32(out + 12, static_cast<uint32_t>(record.ref_count));
+        put32(out + 16, static_cast<uint32_t>(record.seq));
+        put32(out + 20, static_cast<uint32_t>(record.seq >> 32));
+    }
+
+    /**
+     * @brief Раскодировать событие из kRecordSize байт little-endian
+     */
+    static LogRecord decode(const unsigned char *in);
+
+private:
+    std::FILE *file;
+    std::vector<unsigned char> buffer;
+    size_t used;
+
+    static void put32(unsigned char *out, uint32_t value)
+    {
+        out[0] = static_cast<unsigned char>(value);
+        out[1] = static_cast<unsigned char>(value >> 8);
+        out[2] = static_cast<unsigned char>(value >> 16);
+        out[3] = static_cast<unsigned char>(value >> 24);
+    }
+};
+
+/**
+ * @class BinaryLogReader
+ * @brief Последовательное чтение бинарного лога, записанного BinaryLogSink
+ */
+class BinaryLogReader
+{
+public:
+    /**
+     * @throw std::runtime_error если файл не открывается или заголовок неверен
+     */
+    explicit BinaryLogReader(const std::string &filename);
+    ~BinaryLogReader();
+
+    BinaryLogReader(const BinaryLogReader &) = delete;
+    BinaryLogReader &operator=(const BinaryLogReader &) = delete;
+
+    /**
+     * @brief Прочитать следующее событие
+     * @return false в конце файла
+     */
+    bool next(LogRecord &record);
+
+private:
+    std::FILE *file;
+    std::vector<unsigned char> buffer;
+    size_t pos;
+    size_t filled;
+};
+
+#endif // LOG_SINK_H
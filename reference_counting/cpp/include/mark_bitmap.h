@@ -0,0 +1,155 @@
+#ifndef MARK_BITMAP_H
+#define MARK_BITMAP_H
+
+#include <atomic>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @class AtomicMarkBitmap
+ * @brief Битовая карта пометок для параллельной пометки
+ *
+ * Установка бита — атомарный fetch_or: ровно один поток узнаёт,
+ * что пометил слот первым, и только он кладёт слот в свою очередь.
+ */
+class AtomicMarkBitmap
+{
+public:
+    /**
+     * @brief Подготовить карту на заданное число слотов и снять все пометки
+     */
+    void reset(size_t slot_count)
+    {
+        size_t word_count = (slot_count + 63) / 64;
+        if (word_count != words)
+        {
+            bits.reset(new std::atomic<uint64_t>[word_count]);
+            words = word_count;
+        }
+        for (size_t i = 0; i < words; ++i)
+        {
+            bits[i].store(0, std::memory_order_relaxed);
+        }
+        size = slot_count;
+    }
+
+    /**
+     * @brief Атомарно пометить слот (test-and-set)
+     * @return true, если слот не был помечен ранее
+     */
+    bool set(uint32_t slot)
+    {
+        uint64_t mask = uint64_t(1) << (slot & 63);
+        std::atomic<uint64_t> &word = bits[slot >> 6];
+        // Дешёвая проверка без записи: большинство повторных попаданий отсекается здесь
+        if (word.load(std::memory_order_relaxed) & mask)
+        {
+            return false;
+        }
+        return (word.fetch_or(mask, std::memory_order_relaxed) & mask) == 0;
+    }
+
+    bool test(uint32_t slot) const
+    {
+        return (bits[slot >> 6].load(std::memory_order_relaxed) >> (slot & 63)) & 1u;
+    }
+
+    size_t slot_count() const { return size; }
+    size_t word_count() const { return words; }
+    uint64_t word(size_t index) const { return bits[index].load(std::memory_order_relaxed); }
+
+private:
+    std::unique_ptr<std::atomic<uint64_t>[]> bits;
+    size_t words = 0;
+    size_t size = 0;
+};
+
+/**
+ * @class MarkBitmap
+ * @brief Битовая карта пометок, индексируемая номером слота ObjectStore
+ *
+ * Один бит на слот вместо хеш-множества посещённых ID: сброс — memset,
+ * проверка и установка — одна операция над словом.
+ */
+class MarkBitmap
+{
+public:
+    /**
+     * @brief Подготовить карту на заданное число слотов и снять все пометки
+     * @param slot_count Количество слотов
+     */
+    void reset(size_t slot_count)
+    {
+        bits.assign((slot_count + 63) / 64, 0);
+        size = slot_count;
+    }
+
+    /**
+     * @brief Помечен ли слот
+     */
+    bool test(uint32_t slot) const
+    {
+        return (bits[slot >> 6] >> (slot & 63)) & 1u;
+    }
+
+    /**
+     * @brief Пометить слот
+     * @return true, если слот не был помечен ранее
+     */
+    bool set(uint32_t slot)
+    {
+        uint64_t mask = uint64_t(1) << (slot & 63);
+        uint64_t &word = bits[slot >> 6];
+        if (word & mask)
+        {
+            return false;
+        }
+        word |= mask;
+        return true;
+    }
+
+    /**
+     * @brief Скопировать пометки из атомарной карты (после завершения параллельной пометки)
+     */
+    void copy_from(const AtomicMarkBitmap &other)
+    {
+        size = other.slot_count();
+        bits.resize(other.word_count());
+        for (size_t i = 0; i < bits.size(); ++i)
+        {
+            bits[i] = other.word(i);
+        }
+    }
+
+    /**
+     * @brief Количество слотов, которое покрывает карта
+     */
+    size_t slot_count() const { return size; }
+
+    /**
+     * @brief Количество помеченных слотов
+     */
+    size_t count() const
+    {
+        size_t total = 0;
+        for (uint64_t word : bits)
+        {
+            total += std::bitset<64>(word).count();
+        }
+        return total;
+    }
+
+    /**
+     * @brief Сырые слова карты (для сравнения результатов разных маркеров)
+     */
+    const std::vector<uint64_t> &words() const { return bits; }
+
+private:
+    std::vector<uint64_t> bits;
+    size_t size = 0;
+};
+
+#endif // MARK_BITMAP_H
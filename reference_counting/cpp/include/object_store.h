@@ -0,0 +1,439 @@
+#ifndef OBJECT_STORE_H
+#define OBJECT_STORE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "cow_array.h"
+#include "rc_object.h"
+#include "rc_stats.h"
+
+/**
+ * @struct ObjectHandle
+ * @brief Стабильный дескриптор объекта: номер слота + поколение
+ *
+ * Поколение увеличивается при каждом освобождении слота, поэтому
+ * дескриптор удалённого объекта никогда не указывает на новый объект,
+ * занявший тот же слот.
+ */
+struct ObjectHandle
+{
+    uint32_t slot;       ///< Индекс слота в плотном массиве
+    uint32_t generation; ///< Поколение слота на момент выдачи дескриптора
+
+    ObjectHandle() : slot(UINT32_MAX), generation(0) {}
+    ObjectHandle(uint32_t slot_, uint32_t generation_) : slot(slot_), generation(generation_) {}
+
+    bool operator==(const ObjectHandle &other) const
+    {
+        return slot == other.slot && generation == other.generation;
+    }
+    bool operator!=(const ObjectHandle &other) const { return !(*this == other); }
+};
+
+/**
+ * @class ObjectStoreListener
+ * @brief Наблюдатель за созданием и удалением объектов в ObjectStore
+ *
+ * Нужен вторичным индексам по слотам (SccIndex, WeakRefTable), которые
+ * должны узнавать о каждом объекте независимо от того, какой путь мутатора
+ * или сборщика его создал или удалил.
+ */
+class ObjectStoreListener
+{
+public:
+    virtual ~ObjectStoreListener() {}
+
+    /**
+     * @brief Объект создан в слоте slot (уже доступен через slot_of)
+     */
+    virtual void on_emplace(uint32_t slot) = 0;
+
+    /**
+     * @brief Объект obj в слоте slot сейчас будет удалён (ещё доступен через slot_of)
+     */
+    virtual void on_erase(uint32_t slot, const RCObject &obj) = 0;
+};
+
+/**
+ * @class ObjectStore
+ * @brief Плотный массив слотов с поколениями и списком свободных слотов
+ *
+ * Заменяет std::unordered_map<int, RCObject>: объекты лежат подряд в кусках
+ * по kSlotChunkSize слотов, освобождённые слоты переиспользуются через
+ * free list, а отображение ID -> слот хранится в плотной таблице (для
+ * компактных ID) с запасным хеш-индексом для разреженных ID.
+ *
+ * Слоты, поколения и индексы хранятся с копированием при записи (CowArray),
+ * поэтому snapshot() возвращает неизменяемую копию хранилища за O(1).
+ * Неконстантные методы доступа (find, at_slot, get, for_each) копируют
+ * кусок, если он разделён со срезом, — для чтения используйте константную
+ * ссылку на хранилище.
+ */
+class ObjectStore
+{
+public:
+    static constexpr uint32_t kInvalidSlot = UINT32_MAX;
+    static constexpr unsigned kSlotChunkShift = 10;
+    static constexpr size_t kSlotChunkSize = size_t(1) << kSlotChunkShift;
+
+    ObjectStore()
+        : sparse_index(std::make_shared<SparseIndex>()), live_count(0), lookup_count(0), hash_lookup_count(0),
+          dirty_tracking(false)
+    {
+    }
+
+    ObjectStore(ObjectStore &&) = default;
+    ObjectStore &operator=(ObjectStore &&) = default;
+
+    /**
+     * @brief Неизменяемая копия хранилища за O(1)
+     *
+     * Срез разделяет куски со хранилищем; хранилище копирует кусок при
+     * первой записи в него после снимка, так что срез видит состояние на
+     * момент вызова. Срез можно читать из других потоков параллельно с
+     * записью в хранилище и освобождать в любом потоке: списки ссылок
+     * возвращаются в пул потока хранилища (PoolAllocator) через его список
+     * удалённых освобождений.
+     * В срезе нет списка свободных слотов, учёта изменений и наблюдателей.
+     */
+    ObjectStore snapshot();
+
+    /**
+     * @brief Память кусков, которыми владеет только это хранилище (или срез)
+     *
+     * Для среза — сколько памяти он удерживает сверх хранилища: старые
+     * версии кусков, скопированных хранилищем после снимка.
+     *
+     * @return Количество байт (куски слотов со списками ссылок, поколения, индекс)
+     */
+    size_t unshared_memory_usage() const;
+
+    /**
+     * @brief Создать объект с указанным ID
+     * @param id ID нового объекта (>= 0)
+     * @return Указатель на созданный объект, или nullptr если ID занят или невалиден
+     */
+    RCObject *emplace(int id);
+
+    /**
+     * @brief Удалить объект и освободить его слот
+     * @param id ID удаляемого объекта
+     * @return true, если объект существовал
+     */
+    bool erase(int id);
+
+    /**
+     * @brief Найти объект по ID
+     * @param id ID объекта
+     * @return Указатель на объект, или nullptr
+     */
+    RCObject *find(int id)
+    {
+        uint32_t slot = lookup(id);
+        return slot == kInvalidSlot ? nullptr : &slots[slot];
+    }
+
+    /**
+     * @brief Найти объект по ID (константная версия)
+     */
+    const RCObject *find(int id) const
+    {
+        uint32_t slot = lookup(id);
+        return slot == kInvalidSlot ? nullptr : &slots[slot];
+    }
+
+    /**
+     * @brief Проверить, существует ли объект
+     */
+    bool contains(int id) const { return lookup(id) != kInvalidSlot; }
+
+    /**
+     * @brief Получить слот объекта по ID для кода мутатора
+     *
+     * То же, что slot_of(), но при сборке с RC_ENABLE_STATS учитывается
+     * в счётчиках поиска. Через lookup() идут find(), contains() и handle_of().
+     */
+    uint32_t lookup(int id) const
+    {
+        RC_STAT(lookup_count++;
+                if (!(id >= 0 && static_cast<size_t>(id) < dense_index.size()) && !sparse_index->empty())
+                {
+                    hash_lookup_count++;
+                })
+        return slot_of(id);
+    }
+
+    /**
+     * @brief Получить слот объекта по ID
+     *
+     * Не учитывается в статистике: безопасно вызывать из потоков пометки.
+     *
+     * @return Номер слота, или kInvalidSlot если объекта нет
+     */
+    uint32_t slot_of(int id) const
+    {
+        if (id >= 0 && static_cast<size_t>(id) < dense_index.size())
+        {
+            return dense_index[id];
+        }
+        if (sparse_index->empty())
+        {
+            return kInvalidSlot;
+        }
+        auto it = sparse_index->find(id);
+        return it == sparse_index->end() ? kInvalidSlot : it->second;
+    }
+
+    /**
+     * @brief Получить стабильный дескриптор объекта
+     * @return Дескриптор, или дескриптор с kInvalidSlot если объекта нет
+     */
+    ObjectHandle handle_of(int id) const
+    {
+        uint32_t slot = lookup(id);
+        return slot == kInvalidSlot ? ObjectHandle() : ObjectHandle(slot, generations[slot]);
+    }
+
+    /**
+     * @brief Проверить, жив ли объект, на который указывает дескриптор
+     */
+    bool is_valid(ObjectHandle handle) const
+    {
+        return handle.slot < slots.size() &&
+               generations[handle.slot] == handle.generation &&
+               slots[handle.slot].id >= 0;
+    }
+
+    /**
+     * @brief Разыменовать дескриптор
+     * @return Указатель на объект, или nullptr если дескриптор устарел
+     */
+    RCObject *get(ObjectHandle handle) { return is_valid(handle) ? &slots[handle.slot] : nullptr; }
+    const RCObject *get(ObjectHandle handle) const { return is_valid(handle) ? &slots[handle.slot] : nullptr; }
+
+    /**
+     * @brief Прямой доступ к слоту (без проверок)
+     */
+    RCObject &at_slot(uint32_t slot) { return slots[slot]; }
+    const RCObject &at_slot(uint32_t slot) const { return slots[slot]; }
+
+    /**
+     * @brief Текущее поколение слота
+     */
+    uint32_t generation_at(uint32_t slot) const { return generations[slot]; }
+
+    /**
+     * @brief Занят ли слот живым объектом
+     */
+    bool is_live_slot(uint32_t slot) const { return slots[slot].id >= 0; }
+
+    /**
+     * @brief Количество слотов (живых и свободных) — граница для индексации по слотам
+     */
+    uint32_t slot_count() const { return static_cast<uint32_t>(slots.size()); }
+
+    /**
+     * @brief Количество живых объектов
+     */
+    size_t size() const { return live_count; }
+    bool empty() const { return live_count == 0; }
+
+    /**
+     * @brief Зарезервировать место под заданное количество объектов
+     */
+    void reserve(size_t count);
+
+    /**
+     * @brief Оценка занимаемой памяти (слоты, индексы, списки ссылок)
+     * @return Количество байт
+     */
+    size_t memory_usage() const;
+
+    /**
+     * @brief Количество поисков через lookup() и из них через хеш-индекс
+     *
+     * Без RC_ENABLE_STATS всегда 0.
+     */
+    uint64_t get_lookup_count() const { return lookup_count; }
+    uint64_t get_hash_lookup_count() const { return hash_lookup_count; }
+    void reset_lookup_counts() { lookup_count = hash_lookup_count = 0; }
+
+    /**
+     * @brief Включить или выключить учёт изменённых объектов (для снимков в режиме diff)
+     *
+     * При включённом учёте emplace() и touch() запоминают слот, а erase() —
+     * ID удалённого объекта. Выключение очищает накопленное.
+     */
+    void set_dirty_tracking(bool enabled)
+    {
+        dirty_tracking = enabled;
+        clear_dirty();
+    }
+
+    bool is_dirty_tracking() const { return dirty_tracking; }
+
+    /**
+     * @brief Отметить, что у объекта изменился счётчик или список ссылок
+     *
+     * Вызывается всеми путями мутатора и сборщиков; без учёта — одна проверка флага.
+     */
+    void touch(const RCObject &obj)
+    {
+        if (dirty_tracking)
+        {
+            mark_dirty(slot_of(obj.id));
+        }
+    }
+
+    /**
+     * @brief Подписать наблюдателя на emplace()/erase()
+     *
+     * Наблюдатели вызываются в порядке подписки.
+     */
+    void add_listener(ObjectStoreListener *listener);
+
+    /**
+     * @brief Отписать наблюдателя (если он не подписан — ничего не делает)
+     */
+    void remove_listener(ObjectStoreListener *listener);
+
+    /**
+     * @brief Забрать накопленные изменения и начать учёт заново
+     * @param dirty Слоты, затронутые с прошлого вызова (каждый один раз; слот мог освободиться)
+     * @param removed ID объектов, удалённых с прошлого вызова
+     */
+    void take_dirty(std::vector<uint32_t> &dirty, std::vector<int> &removed);
+
+    /**
+     * @brief Забыть накопленные изменения
+     */
+    void clear_dirty();
+
+    /**
+     * @brief Количество слотов, изменённых с прошлого take_dirty()/clear_dirty()
+     */
+    size_t dirty_count() const { return dirty_slots.size(); }
+
+    /**
+     * @brief Обойти все живые объекты в порядке возрастания ID
+     *
+     * Компактные ID перечисляются по плотной таблице без сортировки;
+     * сортируются только ID из хеш-индекса (они все больше компактных).
+     *
+     * @param fn Функция вида fn(const RCObject &)
+     */
+    template <typename Fn>
+    void for_each_in_id_order(Fn &&fn) const
+    {
+        for (size_t id = 0; id < dense_index.size(); ++id)
+        {
+            uint32_t slot = dense_index[id];
+            if (slot != kInvalidSlot)
+            {
+                fn(slots[slot]);
+            }
+        }
+        if (!sparse_index->empty())
+        {
+            std::vector<int> ids;
+            ids.reserve(sparse_index->size());
+            for (const auto &entry : *sparse_index)
+            {
+                ids.push_back(entry.first);
+            }
+            std::sort(ids.begin(), ids.end());
+            for (int id : ids)
+            {
+                fn(slots[sparse_index->find(id)->second]);
+            }
+        }
+    }
+
+    /**
+     * @brief Обойти все живые объекты в порядке слотов
+     * @param fn Функция вида fn(RCObject &)
+     */
+    template <typename Fn>
+    void for_each(Fn &&fn)
+    {
+        for (size_t slot = 0; slot < slots.size(); ++slot)
+        {
+            if (is_live_slot(static_cast<uint32_t>(slot)))
+            {
+                fn(slots[slot]);
+            }
+        }
+    }
+
+    template <typename Fn>
+    void for_each(Fn &&fn) const
+    {
+        for (size_t slot = 0; slot < slots.size(); ++slot)
+        {
+            const RCObject &obj = slots[slot];
+            if (obj.id >= 0)
+            {
+                fn(obj);
+            }
+        }
+    }
+
+private:
+    using SparseIndex = std::unordered_map<int, uint32_t>;
+
+    CowArray<RCObject, kSlotChunkShift> slots;    ///< Объекты по слотам
+    CowArray<uint32_t, 12> generations;           ///< Поколение каждого слота
+    std::vector<uint32_t> free_slots;             ///< Стек свободных слотов
+    CowArray<uint32_t, 12> dense_index;           ///< ID -> слот для компактных ID
+    std::shared_ptr<SparseIndex> sparse_index;    ///< ID -> слот для разреженных ID (копируется при записи после снимка)
+    size_t live_count;                            ///< Количество живых объектов
+    mutable uint64_t lookup_count;                ///< Поиски через lookup() (RC_ENABLE_STATS)
+    mutable uint64_t hash_lookup_count;           ///< Из них через sparse_index
+    bool dirty_tracking;                          ///< Учитывать изменённые объекты
+    std::vector<uint8_t> dirty_flags;             ///< Слот уже есть в dirty_slots
+    std::vector<uint32_t> dirty_slots;            ///< Слоты, изменённые с прошлого take_dirty()
+    std::vector<int> removed_ids;                 ///< ID, удалённые с прошлого take_dirty()
+    std::vector<ObjectStoreListener *> listeners; ///< Наблюдатели за созданием и удалением объектов
+
+    /**
+     * @brief Хеш-индекс для записи (копируется, если разделён со срезом)
+     */
+    SparseIndex &sparse_for_write()
+    {
+        if (sparse_index.use_count() > 1)
+        {
+            sparse_index = std::make_shared<SparseIndex>(*sparse_index);
+        }
+        return *sparse_index;
+    }
+
+    void mark_dirty(uint32_t slot)
+    {
+        if (slot >= dirty_flags.size())
+        {
+            dirty_flags.resize(slots.size(), 0);
+        }
+        if (dirty_flags[slot] == 0)
+        {
+            dirty_flags[slot] = 1;
+            dirty_slots.push_back(slot);
+        }
+    }
+
+    /**
+     * @brief Записать отображение ID -> слот (с ростом плотной таблицы при необходимости)
+     */
+    void set_index(int id, uint32_t slot);
+
+    /**
+     * @brief Удалить отображение ID -> слот
+     */
+    void clear_index(int id);
+};
+
+#endif // OBJECT_STORE_H
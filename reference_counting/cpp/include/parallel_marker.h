@@ -0,0 +1,93 @@
+#ifndef PARALLEL_MARKER_H
+#define PARALLEL_MARKER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include "object_store.h"
+#include "mark_bitmap.h"
+#include "work_stealing_deque.h"
+
+/**
+ * @class ParallelMarker
+ * @brief Параллельная фаза пометки с кражей работы
+ *
+ * У каждого потока приватный стек и дек слотов: поток обходит граф через
+ * стек, выкладывая половину стека в дек, когда тот пуст, а опустевший
+ * поток крадёт из чужих деков. Пометка — атомарный
+ * test-and-set в общей битовой карте, поэтому каждый слот обходится
+ * ровно один раз. Корни те же, что у Tracer: явные корни и живые объекты
+ * с ref_count == 0. Результат совпадает с последовательной пометкой.
+ *
+ * Граф во время пометки не должен меняться.
+ */
+class ParallelMarker
+{
+public:
+    /**
+     * @brief Конструктор
+     * @param heap Хранилище объектов (только чтение)
+     * @param threads Количество потоков пометки (0 — по числу ядер)
+     */
+    ParallelMarker(const ObjectStore &heap, unsigned threads = 0);
+
+    /**
+     * @brief Задать количество потоков пометки (0 — по числу ядер)
+     */
+    void set_thread_count(unsigned threads);
+
+    /**
+     * @brief Текущее количество потоков пометки
+     */
+    unsigned get_thread_count() const { return thread_count; }
+
+    /**
+     * @brief Пометить все достижимые объекты
+     * @param roots Множество явных корней
+     * @param out Карта пометок, индексированная слотом
+     * @return Количество помеченных объектов
+     */
+    size_t mark(const std::unordered_set<int> &roots, MarkBitmap &out);
+
+private:
+    const ObjectStore &heap;
+    unsigned thread_count;
+    AtomicMarkBitmap marks;
+    std::vector<std::unique_ptr<WorkStealingDeque>> deques; ///< По деку на поток
+    std::atomic<unsigned> idle{0};                          ///< Потоки, не нашедшие работы
+
+    /**
+     * @brief Тело потока пометки
+     * @param index Номер потока
+     * @param roots Явные корни (засевает поток 0)
+     * @return Количество слотов, помеченных этим потоком
+     */
+    size_t run_worker(unsigned index, const std::unordered_set<int> &roots);
+
+    /**
+     * @brief Пометить слот и положить его в стек потока, если он ещё не помечен
+     */
+    void push(std::vector<uint32_t> &local, uint32_t slot)
+    {
+        if (marks.set(slot))
+        {
+            local.push_back(slot);
+        }
+    }
+
+    /**
+     * @brief Переложить половину приватного стека в дек, доступный ворам
+     */
+    static void share(std::vector<uint32_t> &local, WorkStealingDeque &own);
+
+    /**
+     * @brief Украсть слот у любого другого потока
+     */
+    bool steal(unsigned index, uint32_t &slot);
+};
+
+#endif // PARALLEL_MARKER_H
@@ -0,0 +1,294 @@
+#ifndef POOL_ALLOCATOR_H
+#define POOL_ALLOCATOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @class SizeClassPool
+ * @brief Пул блоков по классам размеров (степени двойки от kMinBlock до kMaxBlock)
+ *
+ * Память берётся крупными кусками (kChunkSize), и каждый кусок обслуживает
+ * один класс: блоки нарезаются из него сдвигом указателя, освобождённые
+ * попадают в список свободных своего куска и выдаются повторно без
+ * обращения к malloc. Блоки больше kMaxBlock идут напрямую в operator new.
+ *
+ * Кусок считает свои выданные блоки. Когда освобождён последний из них
+ * (каскад удалил подграф, списки ссылок которого лежали в этом куске),
+ * кусок освобождается целиком, за O(1): его список свободных отбрасывается,
+ * и кусок годится под любой класс. Это происходит независимо от остальных
+ * кусков, то есть и пока в куче живы корни и другие объекты. Подграф,
+ * построенный подряд, занимает одни и те же куски и при смерти возвращает
+ * их пулу. Пустые куски остаются за пулом; вернуть их системе можно
+ * release_memory().
+ *
+ * Пул выделяет память только в своём потоке: local() отдаёт пул текущего
+ * потока. Освобождать блок можно в любом потоке. Куски выровнены по
+ * kChunkSize и начинаются с заголовка с указателем на пул-владелец, так что
+ * владелец блока находится маской адреса. Блок чужого пула кладётся
+ * в его lock-free список удалённых освобождений, и владелец забирает
+ * список при следующем выделении или освобождении.
+ * Пул потока, завершившегося с выданными блоками, не удаляется: блоки,
+ * освобождённые позже, остаются за ним.
+ */
+class SizeClassPool
+{
+public:
+    static constexpr size_t kMinBlock = 16;           ///< Наименьший класс, байт
+    static constexpr size_t kMaxBlock = 64 * 1024;    ///< Наибольший класс, байт
+    static constexpr size_t kChunkSize = 1024 * 1024; ///< Размер куска, байт (и его выравнивание)
+    static constexpr size_t kChunkHeader = 64;        ///< Заголовок в начале куска, байт
+    static constexpr uint32_t kClassCount = 13;       ///< 16, 32, ..., 64 КиБ
+
+    SizeClassPool();
+    ~SizeClassPool();
+
+    SizeClassPool(const SizeClassPool &) = delete;
+    SizeClassPool &operator=(const SizeClassPool &) = delete;
+
+    /**
+     * @brief Пул текущего потока
+     */
+    static SizeClassPool &local()
+    {
+        SizeClassPool *pool = t_local;
+        return pool != nullptr ? *pool : attach_thread();
+    }
+
+    void *allocate(size_t bytes)
+    {
+        if (bytes > kMaxBlock)
+        {
+            return ::operator new(bytes);
+        }
+        drain_remote();
+        const uint32_t cls = size_class(bytes);
+        Chunk *chunk = current[cls];
+        if (chunk == nullptr ||
+            (chunk->free == nullptr && static_cast<size_t>(chunk->end() - chunk->bump) < (kMinBlock << cls)))
+        {
+            chunk = next_chunk(cls);
+        }
+        chunk->live++;
+        live_blocks++;
+        FreeBlock *block = chunk->free;
+        if (block != nullptr)
+        {
+            chunk->free = block->next;
+            return block;
+        }
+        void *carved = chunk->bump;
+        chunk->bump += kMinBlock << cls;
+        return carved;
+    }
+
+    /**
+     * @brief Освободить блок, выделенный любым пулом, в любом потоке
+     */
+    static void release(void *pointer, size_t bytes) noexcept
+    {
+        if (bytes > kMaxBlock)
+        {
+            ::operator delete(pointer);
+            return;
+        }
+        Chunk *chunk = chunk_of(pointer);
+        if (chunk->owner == t_local)
+        {
+            chunk->owner->free_local(chunk, pointer);
+        }
+        else
+        {
+            chunk->owner->free_remote(pointer);
+        }
+    }
+
+    /**
+     * @brief Освободить блок (блок чужого пула уходит владельцу)
+     */
+    void deallocate(void *pointer, size_t bytes) noexcept { release(pointer, bytes); }
+
+    /**
+     * @brief Вернуть системе пустые куски (в которых нет выданных блоков)
+     * @return true, если выданных блоков нет и пул не держит памяти
+     */
+    bool release_memory();
+
+    /**
+     * @brief Количество выданных и ещё не освобождённых блоков
+     *
+     * Блоки, освобождённые в других потоках, вычитаются, когда пул заберёт
+     * список удалённых освобождений.
+     */
+    size_t get_live_blocks() const { return live_blocks; }
+
+    /**
+     * @brief Количество кусков (обращений к operator new за памятью)
+     */
+    size_t get_chunk_count() const { return chunks.size(); }
+
+    /**
+     * @brief Память, занятая кусками, в байтах
+     */
+    size_t get_reserved_bytes() const { return chunks.size() * kChunkSize; }
+
+    /**
+     * @brief Сколько раз кусок освобождался целиком (умер последний его блок)
+     */
+    size_t get_chunk_release_count() const { return chunk_releases; }
+
+    /**
+     * @brief Количество пустых кусков, ждущих нового класса или release_memory()
+     */
+    size_t get_empty_chunk_count() const { return empty_count; }
+
+private:
+    struct FreeBlock
+    {
+        FreeBlock *next;
+    };
+
+    /**
+     * @brief Заголовок куска; меняет его только поток пула-владельца, кроме чтения owner
+     */
+    struct Chunk
+    {
+        SizeClassPool *owner; ///< Не меняется, пока кусок не возвращён системе
+        uint32_t cls;         ///< Класс, который обслуживает кусок
+        uint32_t live;        ///< Выданные блоки куска
+        FreeBlock *free;      ///< Освобождённые блоки куска
+        char *bump;           ///< Начало ненарезанной части
+        Chunk *prev;          ///< Соседи в списке partial[cls] или empty
+        Chunk *next;
+        bool listed; ///< Кусок в partial[cls] или empty
+
+        char *start() { return reinterpret_cast<char *>(this) + kChunkHeader; }
+        char *end() { return reinterpret_cast<char *>(this) + kChunkSize; }
+    };
+    static_assert(sizeof(Chunk) <= kChunkHeader, "chunk header must fit before the first block");
+
+    inline static thread_local SizeClassPool *t_local = nullptr; ///< Пул текущего потока (после local())
+
+    Chunk *current[kClassCount];        ///< Кусок, из которого выдаются блоки класса
+    Chunk *partial[kClassCount];        ///< Прочие куски класса со свободными блоками
+    Chunk *empty;                       ///< Куски без выданных блоков и без класса
+    std::vector<char *> chunks;         ///< Все куски пула
+    size_t live_blocks;                 ///< Выданные блоки
+    size_t empty_count;                 ///< Длина списка empty
+    size_t chunk_releases;              ///< get_chunk_release_count()
+    std::atomic<FreeBlock *> remote;    ///< Блоки, освобождённые в других потоках
+
+    static uint32_t size_class(size_t bytes)
+    {
+        uint32_t cls = 0;
+        while ((kMinBlock << cls) < bytes)
+        {
+            cls++;
+        }
+        return cls;
+    }
+
+    static Chunk *chunk_of(void *pointer)
+    {
+        return reinterpret_cast<Chunk *>(reinterpret_cast<uintptr_t>(pointer) &
+                                         ~static_cast<uintptr_t>(kChunkSize - 1));
+    }
+
+    void free_local(Chunk *chunk, void *pointer)
+    {
+        FreeBlock *block = static_cast<FreeBlock *>(pointer);
+        block->next = chunk->free;
+        chunk->free = block;
+        live_blocks--;
+        if (--chunk->live == 0)
+        {
+            release_chunk(chunk);
+        }
+        else if (chunk != current[chunk->cls] && !chunk->listed)
+        {
+            link(partial[chunk->cls], chunk);
+        }
+    }
+
+    void free_remote(void *pointer)
+    {
+        FreeBlock *block = static_cast<FreeBlock *>(pointer);
+        block->next = remote.load(std::memory_order_relaxed);
+        while (!remote.compare_exchange_weak(block->next, block, std::memory_order_release,
+                                             std::memory_order_relaxed))
+        {
+        }
+    }
+
+    /**
+     * @brief Забрать блоки, освобождённые другими потоками
+     */
+    void drain_remote()
+    {
+        if (remote.load(std::memory_order_relaxed) != nullptr)
+        {
+            drain_remote_slow();
+        }
+    }
+
+    void drain_remote_slow();
+
+    /**
+     * @brief Сделать текущим для класса кусок со свободным местом
+     */
+    Chunk *next_chunk(uint32_t cls);
+
+    /**
+     * @brief Последний блок куска освобождён: кусок пустеет целиком
+     */
+    void release_chunk(Chunk *chunk);
+
+    static void link(Chunk *&head, Chunk *chunk);
+    static void unlink(Chunk *&head, Chunk *chunk);
+
+    /**
+     * @brief Создать пул текущего потока; он удаляется при выходе из потока
+     */
+    static SizeClassPool &attach_thread();
+
+    /**
+     * @brief Поток пула завершается: вернуть память или оставить пул живым блокам
+     */
+    void retire();
+};
+
+/**
+ * @class PoolAllocator
+ * @brief Аллокатор без состояния поверх SizeClassPool::local()
+ *
+ * Все экземпляры взаимозаменяемы (is_always_equal), поэтому контейнер с
+ * таким аллокатором не хранит его и не увеличивается в размере.
+ */
+template <typename T>
+class PoolAllocator
+{
+public:
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    PoolAllocator() noexcept {}
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U> &) noexcept {}
+
+    T *allocate(size_t n) { return static_cast<T *>(SizeClassPool::local().allocate(n * sizeof(T))); }
+
+    void deallocate(T *pointer, size_t n) noexcept { SizeClassPool::release(pointer, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U> &) const noexcept { return true; }
+
+    template <typename U>
+    bool operator!=(const PoolAllocator<U> &) const noexcept { return false; }
+};
+
+#endif // POOL_ALLOCATOR_H
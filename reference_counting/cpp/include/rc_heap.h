@@ -1,30 +1,31 @@
 #ifndef RC_HEAP_H
 #define RC_HEAP_H
 
-#include <unordered_map>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
 #include <unordered_set>
 #include <vector>
 #include <string>
 
 #include "rc_object.h"
+#include "object_store.h"
 #include "reference_counter.h"
+#include "cycle_collector.h"
+#include "tracer.h"
 #include "event_logger.h"
+#include "scenario_op.h"
+#include "rc_stats.h"
+#include "heap_image.h"
+#include "heap_snapshot.h"
+#include "heap_view.h"
+#include "leak_report.h"
+#include "scc_index.h"
+#include "weak_ref_table.h"
 
-/**
- * @struct ScenarioOp
- * @brief Представляет одну операцию в сценарии тестирования
- */
-struct ScenarioOp
-{
-    std::string op; // "allocate", "add_ref", "remove_ref", "delete_root"
-    int id;         // Для allocate
-    int from;       // Для add_ref и remove_ref
-    int to;         // Для add_ref и remove_ref
-
-    ScenarioOp() : op(""), id(-1), from(-1), to(-1) {}
-    ScenarioOp(const std::string &op_, int id_, int from_ = -1, int to_ = -1)
-        : op(op_), id(id_), from(from_), to(to_) {}
-};
+class ScenarioReader;
+class BinaryTraceReader;
 
 /**
  * @class RCHeap
@@ -81,17 +82,116 @@ public:
      */
     bool remove_ref(int from, int to);
 
+    /**
+     * @brief Добавить слабую ссылку (см. WeakRefTable)
+     *
+     * Слабая ссылка не увеличивает ref_count цели и не удерживает её:
+     * когда цель освобождается, ссылка становится недействительной за O(1)
+     * (событие weak_expire), не затрагивая держателей. Сборщики циклов
+     * и трассировщик слабые ссылки не видят, поэтому обратная слабая
+     * ссылка не образует мусорного цикла.
+     *
+     * @param from ID объекта-держателя
+     * @param to ID объекта-цели
+     * @return true, если ссылка добавлена
+     */
+    bool add_weak_ref(int from, int to);
+
+    /**
+     * @brief Удалить слабую ссылку (цель может быть уже освобождена)
+     * @param from ID объекта-держателя
+     * @param to ID объекта-цели
+     * @return true, если ссылка удалена
+     */
+    bool remove_weak_ref(int from, int to);
+
+    /**
+     * @brief Есть ли у объекта слабая ссылка на to, и жива ли цель
+     */
+    bool is_weak_ref_valid(int from, int to) const { return weak.is_valid(from, to); }
+
+    /**
+     * @brief Количество действительных слабых ссылок на объект
+     * @return Количество, или -1 если объект не существует
+     */
+    int get_weak_count(int obj_id) const
+    {
+        return object_exists(obj_id) ? static_cast<int>(weak.weak_count(obj_id)) : -1;
+    }
+
+    /**
+     * @brief Количество действительных слабых ссылок во всей куче
+     */
+    size_t get_weak_ref_count() const { return weak.size(); }
+
     /**
      * @brief Вывести текущее состояние кучи в консоль
      */
     void dump_state() const;
 
+    /**
+     * @brief Выполнить одну операцию сценария
+     * @param op Операция
+     * @return Результат соответствующего метода; false для неизвестной операции
+     */
+    bool apply(const ScenarioOp &op);
+
+    /**
+     * @brief Выполнить пачку операций с объединением изменений счётчиков
+     *
+     * Итоговое состояние кучи (объекты, ссылки, счётчики, корни) такое же,
+     * как при последовательном вызове apply() для каждой операции, и каждая
+     * операция проверяется так же. Но счётчики целей меняются на итоговую
+     * разность за пачку: парные add_ref/remove_ref одной ссылки взаимно
+     * гасятся и не попадают в лог. Освобождение объектов, чей счётчик
+     * дошёл до 0, выполняется одним проходом в конце пачки.
+     *
+     * Объект, чей счётчик дошёл до 0 посреди пачки, для следующих операций
+     * считается удалённым (как при последовательном выполнении), вместе
+     * с теми, кого он удерживал. Лог содержит итоговые изменения ссылок
+     * в порядке первого обращения, затем удаления.
+     *
+     * @param ops Массив операций
+     * @param count Количество операций
+     * @return Количество успешно выполненных операций
+     */
+    size_t apply_batch(const ScenarioOp *ops, size_t count);
+
     /**
      * @brief Выполнить последовательность операций из сценария
      * @param ops Массив операций сценария
      * @param size Размер массива операций
+     * @param dump_each Выводить состояние кучи после каждой операции
+     */
+    void run_scenario(const ScenarioOp ops[], int size, bool dump_each = true);
+
+    /**
+     * @brief Выполнить сценарий, читая операции из потока по одной
+     *
+     * Сценарий не загружается в память целиком, поэтому размер файла
+     * не ограничен памятью.
+     *
+     * @param reader Источник операций
+     * @param dump_each Выводить состояние кучи после каждой операции
+     * @return Количество выполненных операций
+     * @throw std::runtime_error при синтаксической ошибке в сценарии
+     */
+    size_t replay(ScenarioReader &reader, bool dump_each = false);
+
+    /**
+     * @brief Выполнить бинарную трассу (см. binary_trace.h)
+     * @param reader Трасса, отображённая в память
+     * @param dump_each Выводить состояние кучи после каждой операции
+     * @return Количество выполненных операций
+     * @throw std::runtime_error при повреждённой записи
+     */
+    size_t replay(BinaryTraceReader &reader, bool dump_each = false);
+
+    /**
+     * @brief Заранее выделить место под заданное количество объектов
+     * @param count Ожидаемое количество объектов
      */
-    void run_scenario(const ScenarioOp ops[], int size);
+    void reserve(size_t count) { objects.reserve(count); }
 
     /**
      * @brief Получить количество объектов в куче
@@ -104,7 +204,7 @@ public:
      * @param obj_id ID проверяемого объекта
      * @return true, если объект существует
      */
-    bool object_exists(int obj_id) const { return objects.count(obj_id) > 0; }
+    bool object_exists(int obj_id) const { return objects.contains(obj_id); }
 
     /**
      * @brief Получить ref_count объекта
@@ -116,22 +216,310 @@ public:
     /**
      * @brief Обнаружить и зарегистрировать утечки памяти
      *
-     * Проверяет все объекты в куче с ref_count > 0 (которые не удалены)
-     * Это объекты, участвующие в циклических ссылках!
+     * Помечает объекты, достижимые из корней (и из объектов с ref_count == 0,
+     * которые удерживает мутатор), и логирует как leak все непомеченные.
+     * Это объекты с ref_count > 0, которые держат только циклические ссылки!
+     * Достижимые объекты утечками больше не считаются.
      */
     void detect_and_log_leaks();
 
+    /**
+     * @brief Захватить SoA-образ кучи для проходов по всей куче (см. HeapImage)
+     */
+    HeapImage capture_image() const { return HeapImage(objects, *roots); }
+
+    /**
+     * @brief Утечки, сгруппированные по циклам, с удерживаемыми размерами (см. LeakReport)
+     *
+     * Те же объекты, что логирует detect_and_log_leaks(), но за O(V + E)
+     * по образу кучи и без записи в лог.
+     */
+    LeakReport analyze_leaks() const { return LeakReport::analyze(capture_image()); }
+
+    /**
+     * @brief Неизменяемый срез кучи для анализа в других потоках (см. HeapView)
+     *
+     * Объекты и корни не копируются: O(1). После вызова куча копирует кусок
+     * слотов (kSlotChunkSize объектов вместе со списками ссылок) при первой
+     * записи в него, а множество корней — при первом изменении, пока срез
+     * жив. Последнюю ссылку на срез можно отпустить в любом потоке.
+     */
+    std::shared_ptr<const HeapView> snapshot()
+    {
+        return std::make_shared<const HeapView>(objects.snapshot(), roots);
+    }
+
+    /**
+     * @brief Записать кадр снимка кучи (или его часть, см. HeapSnapshotWriter)
+     *
+     * Между вызовами с неполным кадром куча может меняться.
+     *
+     * @param writer Файл снимков
+     * @param mode Вид кадра, если новый кадр начинается
+     * @param time_slice Ограничение длительности вызова; 0 — дописать кадр целиком
+     * @return true, если кадр завершён
+     */
+    bool write_snapshot(HeapSnapshotWriter &writer, SnapshotMode mode = SnapshotMode::Diff,
+                        std::chrono::nanoseconds time_slice = std::chrono::nanoseconds(0));
+
+    /**
+     * @brief Писать diff-кадр после каждой операции run_scenario() и replay()
+     * @param writer Файл снимков, или nullptr чтобы выключить
+     */
+    void attach_snapshot(HeapSnapshotWriter *writer) { snapshot_writer = writer; }
+
+    /**
+     * @brief Включить или выключить инкрементальный индекс циклов (см. SccIndex)
+     *
+     * При включении индекс строится по текущему графу за O(V+E), затем
+     * обновляется каждой операцией над ссылками и объектами. Выключение
+     * освобождает индекс.
+     *
+     * @param enabled true — поддерживать индекс
+     */
+    void set_scc_tracking(bool enabled)
+    {
+        if (enabled)
+        {
+            scc.attach();
+        }
+        else
+        {
+            scc.detach();
+        }
+        rc.set_scc_index(enabled ? &scc : nullptr);
+    }
+
+    /**
+     * @brief Поддерживается ли индекс циклов
+     */
+    bool is_scc_tracking() const { return scc.is_attached(); }
+
+    /**
+     * @brief Лежит ли объект на цикле ссылок
+     *
+     * O(1) при включённом индексе (set_scc_tracking); без него — false.
+     *
+     * @param obj_id ID объекта
+     */
+    bool in_cycle(int obj_id) { return scc.in_cycle(obj_id); }
+
+    /**
+     * @brief Номер компоненты сильной связности объекта (для группировки, например утечек)
+     * @return Номер, или SccIndex::kNoComponent если объекта нет или индекс выключен
+     */
+    uint32_t cycle_of(int obj_id) { return scc.component_of(obj_id); }
+
+    /**
+     * @brief Индекс циклов (счётчики работы, размеры компонент)
+     */
+    SccIndex &get_scc_index() { return scc; }
+
+    /**
+     * @brief Выполнить резервную сборку mark-sweep
+     *
+     * Освобождает все объекты, недостижимые из корней, включая мусорные
+     * циклы, которые RC удалить не может. Каждый освобождённый объект
+     * логируется как leak, затем как delete.
+     *
+     * @return Количество освобождённых объектов
+     */
+    size_t collect_garbage();
+
+    /**
+     * @brief Запускать collect_garbage() автоматически при росте кучи
+     *
+     * Сборка запускается из allocate(), когда куча выросла на growth
+     * объектов с момента предыдущей трассировки.
+     *
+     * @param growth Прирост кучи в объектах; 0 выключает автозапуск
+     */
+    void set_trace_threshold(size_t growth) { trace_threshold = growth; }
+
+    /**
+     * @brief Задать количество потоков фазы пометки трассировщика
+     *
+     * Влияет на collect_garbage() и detect_and_log_leaks().
+     *
+     * @param threads 1 — последовательная пометка, 0 — по числу ядер
+     */
+    void set_mark_threads(unsigned threads) { tracer.set_threads(threads); }
+
     /**
      * @brief Получить количество корней
      * @return Размер множества корней
      */
-    size_t get_roots_count() const { return roots.size(); }
+    size_t get_roots_count() const { return roots->size(); }
+
+    /**
+     * @brief Включить или выключить отложенный режим освобождения
+     *
+     * В отложенном режиме объекты, чей ref_count стал 0, не удаляются
+     * сразу, а попадают в таблицу нулевых счётчиков (ZCT) и освобождаются
+     * вызовами collect(). Это позволяет распределить удаление большого
+     * подграфа по нескольким вызовам. При выключении ZCT опустошается.
+     *
+     * @param deferred true — отложенный режим, false — немедленный каскад
+     */
+    void set_deferred(bool deferred)
+    {
+        rc.set_mode(deferred ? DecrementMode::Deferred : DecrementMode::Eager);
+    }
+
+    /**
+     * @brief Включён ли отложенный режим освобождения
+     */
+    bool is_deferred() const { return rc.get_mode() == DecrementMode::Deferred; }
+
+    /**
+     * @brief Освободить объекты из таблицы нулевых счётчиков
+     * @param budget Ограничение по количеству объектов и/или времени
+     * @return Количество освобождённых объектов
+     */
+    size_t collect(const CollectBudget &budget = CollectBudget::unlimited()) { return rc.collect(budget); }
+
+    /**
+     * @brief Количество записей, ожидающих освобождения в ZCT
+     */
+    size_t get_pending_count() const { return rc.pending_count(); }
+
+    /**
+     * @brief Найти и освободить мусорные циклы (синхронный сборщик Bacon–Rajan)
+     *
+     * Проверяет подграф, достижимый из кандидатов — объектов, чей ref_count
+     * уменьшился, но не до 0. Каждый освобождённый объект логируется как delete.
+     *
+     * @return Количество освобождённых объектов
+     */
+    size_t collect_cycles()
+    {
+        RC_STAT(PauseTimer pause(rc.get_stats().collector_pause_ns);)
+        return cycles.collect_cycles();
+    }
+
+    /**
+     * @brief Количество кандидатов в корни циклов, ожидающих проверки
+     */
+    size_t get_cycle_candidate_count() const { return cycles.candidate_count(); }
+
+    /**
+     * @brief Сколько объектов просмотрел сборщик циклов за всё время (см. CycleCollector::traced_count)
+     */
+    uint64_t get_cycle_traced_count() const { return cycles.traced_count(); }
+
+    /**
+     * @brief Снимок статистики: счётчики операций, поисков, каскадов и пауз
+     *
+     * Собирается только при сборке с -DRC_ENABLE_STATS; без флага все поля
+     * нулевые, а горячий путь не содержит ни одной инструкции учёта.
+     */
+    RCStats get_stats() const;
+
+    /**
+     * @brief Снимок статистики в JSON (одна строка, см. RCStats::to_json)
+     */
+    std::string stats_json() const { return get_stats().to_json(); }
+
+    /**
+     * @brief Вывести статистику в читаемом виде
+     * @param out Поток вывода
+     */
+    void dump_stats(std::ostream &out = std::cout) const { get_stats().dump(out); }
+
+    /**
+     * @brief Обнулить статистику (пиковый размер кучи становится текущим)
+     */
+    void reset_stats();
 
 private:
-    std::unordered_map<int, RCObject> objects; ///< Куча объектов
-    std::unordered_set<int> roots;             ///< Корни (root объекты)
-    ReferenceCounter rc;                       ///< Управление ссылками
-    EventLogger &logger;                       ///< Логгер событий
+    using RootSet = std::unordered_set<int>;
+
+    ObjectStore objects;           ///< Куча объектов (плотный массив слотов)
+    std::shared_ptr<RootSet> roots; ///< Корни (root объекты); разделяются со срезами до изменения
+    SccIndex scc;                  ///< Индекс циклов (пуст, пока не включён set_scc_tracking)
+    WeakRefTable weak;             ///< Слабые ссылки (пуста до первой add_weak_ref)
+    CycleCollector cycles;         ///< Сборщик мусорных циклов
+    ReferenceCounter rc;           ///< Управление ссылками
+    Tracer tracer;                 ///< Резервный трассирующий сборщик
+    EventLogger &logger;           ///< Логгер событий
+    size_t trace_threshold;        ///< Прирост кучи для автозапуска трассировки (0 — выкл.)
+    size_t size_after_trace;       ///< Размер кучи после последней трассировки
+    uint64_t roots_version;        ///< Растёт при каждом изменении корней (для diff-кадров)
+    HeapSnapshotWriter *snapshot_writer; ///< Снимки после каждой операции (см. attach_snapshot)
+
+    /**
+     * @brief Действия после операции сценария: вывод состояния и diff-кадр
+     */
+    void after_op(bool dump_each);
+
+    /**
+     * @brief Множество корней для записи (копируется, если разделено со срезом)
+     */
+    RootSet &roots_for_write()
+    {
+        if (roots.use_count() > 1)
+        {
+            roots = std::make_shared<RootSet>(*roots);
+        }
+        return *roots;
+    }
+
+    /**
+     * @struct BatchTarget
+     * @brief Изменения счётчика объекта в текущей пачке apply_batch()
+     */
+    struct BatchTarget
+    {
+        uint32_t slot;                   ///< Слот объекта в ObjectStore
+        int delta = 0;                   ///< Итоговое изменение ref_count
+        bool dead = false;               ///< Счётчик дошёл до 0 (режим Eager): объект удалён
+        bool decremented_alive = false;  ///< Был декремент, после которого объект жив
+        bool last_increment = false;     ///< Последнее изменение счётчика — инкремент
+
+        explicit BatchTarget(uint32_t slot_) : slot(slot_) {}
+    };
+
+    /**
+     * @struct BatchEdge
+     * @brief Ссылка (from, to), изменённая в пачке, и итог её изменений
+     */
+    struct BatchEdge
+    {
+        uint64_t key;     ///< from << 32 | to
+        int net;          ///< +1 — ссылка добавлена, -1 — удалена, 0 — пара погашена
+        uint32_t bucket;  ///< Позиция в batch_edge_table
+    };
+
+    std::vector<BatchTarget> batch_targets;   ///< Затронутые пачкой объекты в порядке первого обращения
+    std::vector<uint32_t> batch_slot_index;   ///< Слот -> 1 + индекс в batch_targets (0 — не затронут)
+    std::vector<BatchEdge> batch_edges;       ///< Изменённые ссылки в порядке первого обращения
+    std::vector<uint32_t> batch_edge_table;   ///< Открытая адресация: 1 + индекс в batch_edges
+    std::vector<int> batch_freed;             ///< Освобождённые пачкой объекты по порядку
+    std::vector<uint32_t> batch_worklist;     ///< Стек каскада внутри пачки
+
+    /**
+     * @brief Слот живого с точки зрения пачки объекта (kInvalidSlot, если удалён в ней)
+     */
+    uint32_t batch_slot(int obj_id) const;
+
+    BatchTarget &batch_target(uint32_t slot);
+
+    void batch_increment(uint32_t slot);
+
+    /**
+     * @brief Уменьшить счётчик; в режиме Eager при нуле — удалить объект и его подграф
+     */
+    void batch_decrement(uint32_t slot);
+
+    /**
+     * @brief Учесть изменение ссылки (from == -1 — корень) для итогового лога
+     */
+    void batch_note_edge(int from, int to, int change);
+
+    /**
+     * @brief Применить накопленные изменения: счётчики, лог, удаление
+     */
+    void flush_batch();
 
     /**
      * @brief Получить объект по ID (внутренняя функция)
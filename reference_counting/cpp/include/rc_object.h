@@ -5,28 +5,86 @@
 #include <algorithm>
 #include <iostream>
 
+#include "edge_set.h"
+#include "pool_allocator.h"
+#include "sticky_ref_count.h"
+
+/**
+ * Списки ссылок RCObject по умолчанию берут память из пула классов
+ * размеров (pool_allocator.h); при сборке с -DRC_NO_POOL_ALLOCATOR —
+ * из стандартного аллокатора.
+ */
+#ifdef RC_NO_POOL_ALLOCATOR
+using ObjectEdgeSet = EdgeSet;
+constexpr bool kPoolAllocatorEnabled = false;
+#else
+using ObjectEdgeSet = BasicEdgeSet<PoolAllocator<int>>;
+constexpr bool kPoolAllocatorEnabled = true;
+#endif
+
+/**
+ * Счётчик ссылок RCObject. При сборке с -DRC_COMPACT_HEADER — 16-битный
+ * залипающий (sticky_ref_count.h), и объект занимает 32 байта вместо 40:
+ * два объекта на строку кэша.
+ */
+#ifdef RC_COMPACT_HEADER
+using ObjectRefCount = StickyRefCount;
+constexpr bool kCompactHeader = true;
+#else
+using ObjectRefCount = int;
+constexpr bool kCompactHeader = false;
+#endif
+
+/**
+ * @enum GcColor
+ * @brief Цвет объекта для синхронного сборщика циклов (Bacon–Rajan)
+ */
+enum class GcColor : unsigned char
+{
+    Black,  ///< Живой (или ещё не проверенный) объект
+    Gray,   ///< Возможный член цикла, счётчик уменьшен пробным удалением
+    White,  ///< Мусорный член цикла
+    Purple  ///< Кандидат в корни цикла (счётчик уменьшился, но не до 0)
+};
+
 /**
  * @struct RCObject
  * @brief Объект в управляемой памяти с подсчётом ссылок
  *
- * Содержит счётчик ссылок и список объектов, на которые данный объект ссылается.
+ * Содержит счётчик ссылок и множество объектов, на которые данный объект ссылается.
+ * Поля заголовка (id, счётчик, цвет, флаг) идут перед списком ссылок, чтобы
+ * в компактном режиме уложиться в 8 байт без выравнивания.
  */
 struct RCObject
 {
     int id;                      ///< Уникальный идентификатор объекта
-    int ref_count;               ///< Количество входящих ссылок
-    std::vector<int> references; ///< Список объектов, на которые ссылается данный объект
+    ObjectRefCount ref_count;    ///< Количество входящих ссылок
+    GcColor color;               ///< Цвет для сборщика циклов
+    bool buffered;               ///< Объект находится в буфере кандидатов сборщика циклов
+    ObjectEdgeSet references;    ///< Множество объектов, на которые ссылается данный объект
 
     /**
      * @brief Конструктор по умолчанию
      */
-    RCObject() : id(-1), ref_count(0) {}
+    RCObject() : id(-1), ref_count(0), color(GcColor::Black), buffered(false) {}
 
     /**
      * @brief Конструктор с инициализацией ID
      * @param id_ Идентификатор объекта
      */
-    explicit RCObject(int id_) : id(id_), ref_count(0) {}
+    explicit RCObject(int id_) : id(id_), ref_count(0), color(GcColor::Black), buffered(false) {}
+
+    /**
+     * @brief Залип ли счётчик (только RC_COMPACT_HEADER): значение неизвестно, не меньше максимума
+     */
+    bool has_sticky_count() const
+    {
+#ifdef RC_COMPACT_HEADER
+        return ref_count.is_sticky();
+#else
+        return false;
+#endif
+    }
 
     /**
      * @brief Проверить, ссылается ли этот объект на другой объект
@@ -35,7 +93,7 @@ struct RCObject
      */
     bool has_reference_to(int target_id) const
     {
-        return std::find(references.begin(), references.end(), target_id) != references.end();
+        return references.contains(target_id);
     }
 
     /**
@@ -45,12 +103,7 @@ struct RCObject
      */
     bool add_outgoing_ref(int target_id)
     {
-        if (!has_reference_to(target_id))
-        {
-            references.push_back(target_id);
-            return true;
-        }
-        return false;
+        return references.insert(target_id);
     }
 
     /**
@@ -60,18 +113,12 @@ struct RCObject
      */
     bool remove_outgoing_ref(int target_id)
     {
-        auto it = std::find(references.begin(), references.end(), target_id);
-        if (it != references.end())
-        {
-            references.erase(it);
-            return true;
-        }
-        return false;
+        return references.erase(target_id);
     }
 
     /**
      * @brief Получить количество исходящих ссылок
-     * @return Размер массива ссылок
+     * @return Количество исходящих ссылок
      */
     size_t get_outgoing_count() const
     {
@@ -79,4 +126,6 @@ struct RCObject
     }
 };
 
+static_assert(!kCompactHeader || sizeof(RCObject) == 32, "compact RCObject must fit in 32 bytes");
+
 #endif // RC_OBJECT_H
@@ -0,0 +1,236 @@
+#ifndef RC_STATS_H
+#define RC_STATS_H
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+/**
+ * Статистика горячего пути RCHeap и ReferenceCounter.
+ *
+ * Сбор включается при сборке флагом -DRC_ENABLE_STATS. Без него RC_STAT(...)
+ * раскрывается в ничто: ни счётчиков, ни обращений к часам в коде операций
+ * не остаётся. Сами структуры есть в обоих вариантах сборки (раскладка
+ * классов не зависит от флага), и без флага они просто остаются нулевыми.
+ */
+#ifdef RC_ENABLE_STATS
+#define RC_STAT(...) __VA_ARGS__
+const bool kStatsEnabled = true;
+#else
+#define RC_STAT(...)
+const bool kStatsEnabled = false;
+#endif
+
+/**
+ * @class LogHistogram
+ * @brief Гистограмма с логарифмическими корзинами (в духе HdrHistogram)
+ *
+ * Каждая степень двойки делится на 2^kSubBits равных корзин, поэтому
+ * относительная погрешность значения не больше 1/2^kSubBits (12.5%),
+ * а весь диапазон uint64_t умещается в kBuckets счётчиков. Запись —
+ * несколько битовых операций и инкремент, без выделений памяти.
+ */
+class LogHistogram
+{
+public:
+    static const int kSubBits = 3;
+    static const int kSubBuckets = 1 << kSubBits;
+    static const int kBuckets = (64 - kSubBits + 1) * kSubBuckets;
+
+    LogHistogram() { reset(); }
+
+    void record(uint64_t value)
+    {
+        counts[bucket_of(value)]++;
+        total++;
+        sum += value;
+        if (value < min_value)
+        {
+            min_value = value;
+        }
+        if (value > max_value)
+        {
+            max_value = value;
+        }
+    }
+
+    void reset();
+
+    uint64_t count() const { return total; }
+    uint64_t min() const { return total > 0 ? min_value : 0; }
+    uint64_t max() const { return max_value; }
+    double mean() const { return total > 0 ? static_cast<double>(sum) / total : 0.0; }
+
+    /**
+     * @brief Значение перцентиля (верхняя граница корзины, не больше max())
+     * @param fraction Доля от 0 до 1, например 0.99
+     */
+    uint64_t percentile(double fraction) const;
+
+    /**
+     * @brief {"count", "min", "max", "mean", "p50", "p90", "p99", "p999", "buckets": [[lo, hi, n], ...]}
+     *
+     * В buckets только непустые корзины.
+     */
+    std::string to_json() const;
+
+    /**
+     * @brief Номер корзины значения
+     */
+    static int bucket_of(uint64_t value)
+    {
+        if (value < static_cast<uint64_t>(kSubBuckets))
+        {
+            return static_cast<int>(value);
+        }
+        int shift = highest_bit(value) - kSubBits;
+        return (shift + 1) * kSubBuckets + static_cast<int>((value >> shift) & (kSubBuckets - 1));
+    }
+
+    /**
+     * @brief Наименьшее значение корзины
+     */
+    static uint64_t bucket_low(int bucket)
+    {
+        if (bucket < kSubBuckets)
+        {
+            return static_cast<uint64_t>(bucket);
+        }
+        int shift = bucket / kSubBuckets - 1;
+        return static_cast<uint64_t>(kSubBuckets + bucket % kSubBuckets) << shift;
+    }
+
+    /**
+     * @brief Наибольшее значение корзины
+     */
+    static uint64_t bucket_high(int bucket)
+    {
+        int shift = bucket < kSubBuckets ? 0 : bucket / kSubBuckets - 1;
+        return bucket_low(bucket) + ((uint64_t(1) << shift) - 1);
+    }
+
+private:
+    uint64_t counts[kBuckets];
+    uint64_t total;
+    uint64_t sum;
+    uint64_t min_value;
+    uint64_t max_value;
+
+    static int highest_bit(uint64_t value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return 63 - __builtin_clzll(value);
+#else
+        int bit = 0;
+        while (value >>= 1)
+        {
+            bit++;
+        }
+        return bit;
+#endif
+    }
+};
+
+/**
+ * @struct RCStats
+ * @brief Счётчики операций, каскадов и пауз кучи
+ */
+struct RCStats
+{
+    // Успешные операции мутатора
+    uint64_t allocations;
+    uint64_t add_roots;
+    uint64_t remove_roots;
+    uint64_t add_refs;
+    uint64_t remove_refs;
+
+    uint64_t lookups;      ///< Поиски объекта по ID (ObjectStore::find/contains/handle_of)
+    uint64_t hash_lookups; ///< Из них через хеш-индекс разреженных ID
+
+    uint64_t frees;             ///< Освобождённые подсчётом ссылок объекты
+    uint64_t cascades;          ///< Каскадные удаления (cascade_delete и пачки apply_batch)
+    uint64_t max_cascade_depth; ///< Наибольшая глубина каскада (0 — удалён один объект)
+    uint64_t max_fan_out;       ///< Наибольшее число исходящих ссылок объекта
+
+    uint64_t heap_size;      ///< Живые объекты на момент снимка
+    uint64_t peak_heap_size; ///< Наибольший размер кучи
+
+    LogHistogram cascade_length;     ///< Объектов за каскад
+    LogHistogram cascade_pause_ns;   ///< Длительность каскада или вызова collect() (ZCT)
+    LogHistogram collector_pause_ns; ///< Длительность collect_cycles() и collect_garbage()
+
+    RCStats() { reset(); }
+
+    void reset();
+
+    void record_cascade(uint64_t length, uint64_t depth)
+    {
+        cascades++;
+        cascade_length.record(length);
+        if (depth > max_cascade_depth)
+        {
+            max_cascade_depth = depth;
+        }
+    }
+
+    void note_heap_size(uint64_t size)
+    {
+        if (size > peak_heap_size)
+        {
+            peak_heap_size = size;
+        }
+    }
+
+    void note_fan_out(uint64_t fan_out)
+    {
+        if (fan_out > max_fan_out)
+        {
+            max_fan_out = fan_out;
+        }
+    }
+
+    /**
+     * @brief Снимок в JSON (одна строка); при сборке без RC_ENABLE_STATS — {"enabled": false}
+     */
+    std::string to_json() const;
+
+    /**
+     * @brief Таблица счётчиков и перцентилей для человека
+     */
+    void dump(std::ostream &out) const;
+};
+
+/**
+ * @brief Монотонное время в наносекундах для замеров пауз
+ */
+inline uint64_t stats_now_ns()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+}
+
+/**
+ * @class PauseTimer
+ * @brief Записывает длительность своей области видимости в гистограмму, нс
+ *
+ * Используется внутри RC_STAT(...), поэтому без RC_ENABLE_STATS часы
+ * не читаются вовсе.
+ */
+class PauseTimer
+{
+public:
+    explicit PauseTimer(LogHistogram &histogram_) : histogram(histogram_), start(stats_now_ns()) {}
+
+    ~PauseTimer() { histogram.record(stats_now_ns() - start); }
+
+    PauseTimer(const PauseTimer &) = delete;
+    PauseTimer &operator=(const PauseTimer &) = delete;
+
+private:
+    LogHistogram &histogram;
+    uint64_t start;
+};
+
+#endif // RC_STATS_H
@@ -1,12 +1,56 @@
 #ifndef REFERENCE_COUNTER_H
 #define REFERENCE_COUNTER_H
 
-#include <unordered_map>
-#include <unordered_set>
+#include <chrono>
+#include <cstddef>
 #include <vector>
 
 #include "rc_object.h"
+#include "object_store.h"
+#include "cycle_collector.h"
+#include "scc_index.h"
 #include "event_logger.h"
+#include "rc_stats.h"
+
+/**
+ * @enum DecrementMode
+ * @brief Когда освобождать объекты, чей ref_count стал 0
+ */
+enum class DecrementMode
+{
+    Eager,   ///< Сразу запускать каскадное удаление (поведение по умолчанию)
+    Deferred ///< Складывать объекты в таблицу нулевых счётчиков (ZCT) до вызова collect()
+};
+
+/**
+ * @struct CollectBudget
+ * @brief Ограничение работы одного вызова collect()
+ *
+ * Нулевое значение поля означает отсутствие ограничения по нему.
+ */
+struct CollectBudget
+{
+    size_t max_objects;                  ///< Максимум освобождаемых объектов
+    std::chrono::nanoseconds time_slice; ///< Максимальная длительность вызова
+
+    CollectBudget() : max_objects(0), time_slice(0) {}
+
+    static CollectBudget objects(size_t count)
+    {
+        CollectBudget budget;
+        budget.max_objects = count;
+        return budget;
+    }
+
+    static CollectBudget time(std::chrono::nanoseconds slice)
+    {
+        CollectBudget budget;
+        budget.time_slice = slice;
+        return budget;
+    }
+
+    static CollectBudget unlimited() { return CollectBudget(); }
+};
 
 /**
  * @class ReferenceCounter
@@ -15,7 +59,7 @@
  * Отвечает за:
  * - Добавление и удаление ссылок между объектами
  * - Каскадное удаление объектов когда ref_count достигает 0
- * - Обнаружение циклических ссылок (которые вызывают утечку памяти)
+ * - Сообщение об изменениях ссылок индексу циклов (SccIndex)
  * - Логирование всех операций
  *
  * **ВАЖНО: В этой версии НЕ удаляем автоматически в цикле!**
@@ -26,10 +70,11 @@ class ReferenceCounter
 public:
     /**
      * @brief Конструктор
-     * @param heap Ссылка на контейнер объектов в памяти
+     * @param heap Ссылка на хранилище объектов в памяти
      * @param logger Ссылка на логгер событий
+     * @param cycles Сборщик циклов, которому сообщаются декременты (может быть nullptr)
      */
-    ReferenceCounter(std::unordered_map<int, RCObject> &heap, EventLogger &logger);
+    ReferenceCounter(ObjectStore &heap, EventLogger &logger, CycleCollector *cycles = nullptr);
 
     /**
      * @brief Добавить ссылку от одного объекта к другому
@@ -50,35 +95,118 @@ public:
     /**
      * @brief Выполнить каскадное удаление объекта и его зависимостей
      *
-     * Удаляет объект только если ref_count == 0, затем рекурсивно
-     * удаляет объекты, на которые он ссылается (если их ref_count == 0)
+     * Удаляет объект только если ref_count == 0, затем удаляет объекты,
+     * на которые он ссылается (если их ref_count становится 0).
+     * Обход итеративный: вместо рекурсии используется явный стек,
+     * который переиспользуется между вызовами, поэтому длина цепочки
+     * не ограничена размером стека вызовов.
      *
      * @param obj_id ID объекта для удаления
-     * @param visited Множество уже посещённых объектов (для предотвращения циклов)
      */
-    void cascade_delete(int obj_id, std::unordered_set<int> &visited);
+    void cascade_delete(int obj_id);
+
+    /**
+     * @brief Освободить объект, чей ref_count стал 0, согласно режиму
+     *
+     * В режиме Eager запускает cascade_delete, в режиме Deferred
+     * добавляет объект в таблицу нулевых счётчиков.
+     *
+     * @param obj_id ID объекта
+     */
+    void release(int obj_id);
+
+    /**
+     * @brief Установить режим обработки нулевых счётчиков
+     *
+     * При переключении в Eager таблица нулевых счётчиков опустошается полностью.
+     */
+    void set_mode(DecrementMode new_mode);
+
+    /**
+     * @brief Текущий режим обработки нулевых счётчиков
+     */
+    DecrementMode get_mode() const { return mode; }
+
+    /**
+     * @brief Освободить объекты из таблицы нулевых счётчиков в пределах бюджета
+     *
+     * Дочерние объекты, чей счётчик стал 0, попадают обратно в таблицу
+     * и освобождаются этим же или следующими вызовами.
+     *
+     * @param budget Ограничение по количеству объектов и/или времени
+     * @return Количество освобождённых объектов
+     */
+    size_t collect(const CollectBudget &budget);
+
+    /**
+     * @brief Количество записей в таблице нулевых счётчиков
+     */
+    size_t pending_count() const { return zct.size(); }
+
+    /**
+     * @brief Сообщать индексу циклов о каждой добавленной и удалённой ссылке
+     * @param index Индекс, или nullptr чтобы выключить
+     */
+    void set_scc_index(SccIndex *index) { scc = index; }
+
+    /**
+     * @brief Статистика операций и каскадов (заполняется при сборке с RC_ENABLE_STATS)
+     */
+    RCStats &get_stats() { return stats; }
+    const RCStats &get_stats() const { return stats; }
 
 private:
-    std::unordered_map<int, RCObject> &heap;
+    ObjectStore &heap;
     EventLogger &logger;
+    CycleCollector *cycles;
+    SccIndex *scc; ///< Индекс циклов, которому сообщаются изменения ссылок (может быть nullptr)
+
+    /**
+     * @brief Стек отложенных декрементов каскада (ID дочерних объектов)
+     *
+     * Не очищается от памяти между вызовами: после прогрева каскад
+     * не выделяет память.
+     */
+    std::vector<int> worklist;
+
+    DecrementMode mode; ///< Режим обработки нулевых счётчиков
+
+    /**
+     * @brief Таблица нулевых счётчиков (ZCT) для режима Deferred
+     *
+     * Хранит дескрипторы, а не ID: если объект уже освобождён и его ID
+     * занят новым объектом, устаревшая запись будет просто пропущена.
+     */
+    std::vector<ObjectHandle> zct;
+
+    RCStats stats; ///< Заполняется только при сборке с RC_ENABLE_STATS
 
     /**
-     * @brief Проверить, находится ли цикл в графе ссылок
-     * @param start_id ID объекта для начала проверки
-     * @return true, если обнаружен цикл
+     * @brief Глубины записей worklist текущего каскада (только RC_ENABLE_STATS)
+     */
+    std::vector<uint32_t> cascade_depths;
+
+    /**
+     * @brief Освободить объект с ref_count == 0
+     *
+     * Переносит исходящие ссылки в worklist (в обратном порядке, чтобы
+     * порядок удаления совпадал с рекурсивным обходом), удаляет объект
+     * из хранилища и логирует удаление.
+     *
+     * @param obj Освобождаемый объект
      */
-    bool has_cycle(int start_id) const;
+    void free_object(RCObject &obj);
 
     /**
-     * @brief Вспомогательная функция для DFS поиска цикла
-     * @param current_id Текущий узел DFS
-     * @param visited Множество посещённых узлов
-     * @param rec_stack Стек рекурсии для обнаружения цикла
-     * @return true, если цикл найден
+     * @brief Сообщить сборщику циклов о декременте, оставившем ref_count > 0
      */
-    bool has_cycle_dfs(int current_id,
-                       std::unordered_set<int> &visited,
-                       std::unordered_set<int> &rec_stack) const;
+    void note_decrement(RCObject &obj)
+    {
+        if (cycles != nullptr)
+        {
+            cycles->possible_root(obj);
+        }
+    }
 };
 
 #endif // REFERENCE_COUNTER_H
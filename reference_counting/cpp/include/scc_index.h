@@ -0,0 +1,253 @@
+#ifndef SCC_INDEX_H
+#define SCC_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "edge_set.h"
+#include "object_store.h"
+
+/**
+ * @struct SccIndexStats
+ * @brief Счётчики работы SccIndex (для оценки амортизированной стоимости)
+ */
+struct SccIndexStats
+{
+    uint64_t edges_added = 0;        ///< Вызовы add_edge()
+    uint64_t edges_removed = 0;      ///< Вызовы remove_edge()
+    uint64_t reorders = 0;           ///< Рёбра против порядка, потребовавшие перестановки
+    uint64_t components_visited = 0; ///< Компоненты, пройденные поиском при перестановках
+    uint64_t merges = 0;             ///< Рёбра, замкнувшие новый цикл
+    uint64_t splits = 0;             ///< Пересчёты компонент после удалений (Тарьян)
+    uint64_t relabels = 0;           ///< Полные перенумерации порядка (не хватило меток)
+};
+
+/**
+ * @class SccIndex
+ * @brief Инкрементальный индекс компонент сильной связности графа ссылок
+ *
+ * Поддерживает разбиение живых объектов на компоненты сильной связности
+ * и топологический порядок компонент (по мотивам алгоритма Пирса–Келли):
+ * каждой компоненте выдана метка, и каждая ссылка между разными
+ * компонентами ведёт от меньшей метки к большей. Ссылка, согласованная
+ * с порядком, добавляется за O(1). Ссылка против порядка запускает
+ * поочерёдно прямой поиск от цели и обратный от источника, ограниченные
+ * метками концов. Метки разрежены, поэтому достаточно переставить одну
+ * сторону: первую исчерпанную — прямую сразу за источник, обратную сразу
+ * перед целью; работа пропорциональна меньшей стороне. Если один поиск
+ * дошёл до другого конца, ссылка замкнула цикл: обе стороны проходятся
+ * целиком, и компоненты на путях между концами сливаются в одну.
+ *
+ * Удаление ссылки внутри компоненты (или объекта из неё) только помечает
+ * компоненту как «грязную»: она по-прежнему объединение настоящих
+ * компонент и не нарушает порядок. Разбиение выполняется лениво —
+ * итеративным Тарьяном по членам компоненты — при первом запросе к ней
+ * или добавлении ссылки из/в неё. Новые компоненты получают метки
+ * в промежутке после метки старой (порядок хранится в std::map); если
+ * промежутка не хватает, все метки перенумеровываются заново. Ссылки
+ * объекта на себя индекс не считает циклами (RCHeap их запрещает).
+ *
+ * Исходящие ссылки берутся из ObjectStore, входящие (для обратного поиска)
+ * индекс хранит сам. Объекты индексируются по слотам; о создании и
+ * удалении объектов индекс узнаёт как ObjectStoreListener, о ссылках —
+ * через add_edge()/remove_edge() от кода мутатора.
+ */
+class SccIndex : public ObjectStoreListener
+{
+public:
+    static constexpr uint32_t kNoComponent = UINT32_MAX;
+    static constexpr uint64_t kLabelGap = uint64_t(1) << 32;
+    static constexpr uint64_t kLabelLimit = UINT64_MAX / 2; ///< Выше — перенумеровать перед новой меткой
+
+    explicit SccIndex(ObjectStore &store);
+    ~SccIndex() override;
+
+    SccIndex(const SccIndex &) = delete;
+    SccIndex &operator=(const SccIndex &) = delete;
+
+    /**
+     * @brief Построить индекс по текущему графу и начать следить за хранилищем
+     */
+    void attach();
+
+    /**
+     * @brief Перестать следить за хранилищем и освободить индекс
+     */
+    void detach();
+
+    bool is_attached() const { return attached; }
+
+    /**
+     * @brief Учесть новую ссылку from -> to (уже добавленную в хранилище)
+     * @return true, если ссылка лежит на цикле (замкнула новый или внутри существующего)
+     */
+    bool add_edge(int from, int to);
+
+    /**
+     * @brief Учесть удалённую ссылку from -> to (уже удалённую из хранилища)
+     */
+    void remove_edge(int from, int to);
+
+    /**
+     * @brief Лежит ли объект на цикле ссылок
+     *
+     * O(1), если компонента объекта не менялась удалениями; иначе сначала
+     * пересчитывается эта компонента (амортизируется по удалениям).
+     */
+    bool in_cycle(int obj_id);
+
+    /**
+     * @brief Номер компоненты объекта, или kNoComponent если объекта нет
+     *
+     * Номер стабилен, пока компонента не сливается и не разбивается;
+     * годится для группировки объектов (например, утечек) по циклам.
+     */
+    uint32_t component_of(int obj_id);
+
+    /**
+     * @brief Количество объектов в компоненте
+     */
+    size_t component_size(uint32_t component) const { return components[component].size; }
+
+    /**
+     * @brief Количество компонент (включая одиночные объекты)
+     */
+    size_t component_count() const { return labels.size(); }
+
+    const SccIndexStats &get_stats() const { return stats; }
+    void reset_stats() { stats = SccIndexStats(); }
+
+    /**
+     * @brief Проверить инварианты: порядок согласован со всеми ссылками,
+     *        списки членов и входящих ссылок соответствуют хранилищу
+     * @return true, если индекс корректен (для тестов и бенчмарков)
+     */
+    bool verify();
+
+    void on_emplace(uint32_t slot) override;
+    void on_erase(uint32_t slot, const RCObject &obj) override;
+
+private:
+    struct Component
+    {
+        uint64_t label = 0;     ///< Позиция в топологическом порядке
+        uint32_t head = 0;      ///< Первый член (кольцевой список по member_next)
+        uint32_t size = 0;      ///< 0 — компонента свободна
+        bool dirty = false;     ///< Могла распасться после удалений
+        uint32_t forward_visit = 0;  ///< Номер прямого поиска, который её посетил
+        uint32_t backward_visit = 0; ///< Номер обратного поиска, который её посетил
+    };
+
+    ObjectStore &heap;
+    bool attached;
+
+    std::vector<uint32_t> node_component; ///< Слот -> компонента
+    std::vector<uint32_t> member_next;    ///< Кольцевой двусвязный список членов компоненты
+    std::vector<uint32_t> member_prev;
+    std::vector<EdgeSet> in_edges;        ///< Слот -> слоты источников входящих ссылок
+
+    std::vector<Component> components;
+    std::vector<uint32_t> free_components;
+    std::map<uint64_t, uint32_t> labels;  ///< Метка -> компонента, в топологическом порядке
+    uint32_t visit_epoch;
+    SccIndexStats stats;
+
+    // Рабочие буферы поисков: найденные компоненты и позиция следующей непросмотренной
+    std::vector<uint32_t> forward;
+    std::vector<uint32_t> backward;
+    size_t forward_next;
+    size_t backward_next;
+    size_t forward_work;    ///< Просмотрено объектов и ссылок прямым поиском
+    size_t backward_work;   ///< То же обратным
+    std::vector<uint32_t> work;
+    std::vector<uint32_t> merge_buffer;
+
+    // Состояние Тарьяна по слотам; после каждого прохода сбрасывается только у пройденных
+    std::vector<uint32_t> tarjan_index;   ///< 0 — не посещён
+    std::vector<uint32_t> tarjan_low;
+    std::vector<uint8_t> tarjan_on_stack;
+    std::vector<std::pair<uint32_t, uint32_t>> tarjan_path; ///< Кадры обхода: слот и позиция следующей ссылки
+    std::vector<uint32_t> scc_nodes;      ///< Найденные компоненты подряд, стоки первыми
+    std::vector<uint32_t> scc_offsets;    ///< Границы компонент в scc_nodes
+
+    uint32_t new_component(uint64_t label);
+    void free_component(uint32_t component);
+    void link_member(uint32_t component, uint32_t slot);
+    void unlink_member(uint32_t slot);
+    void ensure_slots(uint32_t slot_count);
+    uint64_t next_label() const { return labels.empty() ? kLabelGap : labels.rbegin()->first + kLabelGap; }
+
+    /**
+     * @brief Итеративный Тарьян по nodes
+     *
+     * Переходит только по ссылкам в объекты компоненты within (или во все
+     * живые объекты, если within == kNoComponent). Результат — в scc_nodes
+     * и scc_offsets в порядке завершения: компонента идёт после всех,
+     * достижимых из неё.
+     */
+    void tarjan(const std::vector<uint32_t> &nodes, uint32_t within);
+
+    /**
+     * @brief Разбить грязную компоненту на настоящие компоненты (итеративный Тарьян)
+     */
+    void split(uint32_t component);
+
+    /**
+     * @brief Слить компоненты в самую большую из них (метки не трогает)
+     * @return Номер получившейся компоненты
+     */
+    uint32_t merge(const std::vector<uint32_t> &parts);
+
+    /**
+     * @brief Начать прямой поиск от forward_start и обратный от backward_start
+     */
+    void start_search(uint32_t forward_start, uint32_t backward_start);
+
+    /**
+     * @brief Просмотреть ссылки очередной компоненты прямого поиска
+     *
+     * Найденные компоненты с меткой не больше bound добавляются в forward.
+     * Поиск не должен быть исчерпан.
+     */
+    void advance_forward(uint64_t bound);
+
+    /**
+     * @brief Просмотреть входящие ссылки очередной компоненты обратного поиска
+     *
+     * Найденные компоненты с меткой не меньше bound добавляются в backward.
+     * Поиск не должен быть исчерпан.
+     */
+    void advance_backward(uint64_t bound);
+
+    /**
+     * @brief Найти компоненты исчерпанной стороны поиска, лежащие на цикле
+     *
+     * Результат — в merge_buffer; компоненты отмечены возвращённым номером
+     * (в backward_visit, если исчерпан прямой поиск, иначе в forward_visit).
+     *
+     * @param start cu, если исчерпан прямой поиск (forward_done), иначе cv
+     * @param epoch Номер завершённого поиска
+     */
+    uint32_t collect_cycle(uint32_t start, bool forward_done, uint32_t epoch);
+
+    /**
+     * @brief Выдать компонентам order (их метки уже убраны из labels) метки
+     *        по порядку в промежутке сразу после метки position
+     */
+    void relocate(const std::vector<uint32_t> &order, uint64_t position);
+
+    /**
+     * @brief Перенумеровать все компоненты с шагом spacing, сохраняя порядок
+     */
+    void relabel_all(uint64_t spacing);
+
+    /**
+     * @brief Чистая компонента объекта в слоте (грязная сначала разбивается)
+     */
+    uint32_t clean_component(uint32_t slot);
+};
+
+#endif // SCC_INDEX_H
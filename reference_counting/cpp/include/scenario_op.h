@@ -0,0 +1,98 @@
+#ifndef SCENARIO_OP_H
+#define SCENARIO_OP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @enum OpCode
+ * @brief Вид операции сценария
+ *
+ * Имя операции сопоставляется коду один раз при разборе сценария,
+ * а не при каждом выполнении.
+ */
+enum class OpCode : uint8_t
+{
+    Allocate,
+    AddRoot,
+    RemoveRoot,
+    AddRef,
+    RemoveRef,
+    Unknown
+};
+
+/**
+ * @brief Код операции по её имени в сценарии
+ * @return OpCode::Unknown для неизвестного имени
+ */
+inline OpCode parse_op_code(const char *name, size_t length)
+{
+    const std::string_view text(name, length);
+    if (text == "allocate")
+    {
+        return OpCode::Allocate;
+    }
+    if (text == "add_root")
+    {
+        return OpCode::AddRoot;
+    }
+    if (text == "remove_root")
+    {
+        return OpCode::RemoveRoot;
+    }
+    if (text == "add_ref")
+    {
+        return OpCode::AddRef;
+    }
+    if (text == "remove_ref")
+    {
+        return OpCode::RemoveRef;
+    }
+    return OpCode::Unknown;
+}
+
+inline OpCode parse_op_code(const std::string &name) { return parse_op_code(name.data(), name.size()); }
+
+/**
+ * @brief Имя операции в сценарии
+ */
+inline const char *op_code_name(OpCode code)
+{
+    switch (code)
+    {
+    case OpCode::Allocate:
+        return "allocate";
+    case OpCode::AddRoot:
+        return "add_root";
+    case OpCode::RemoveRoot:
+        return "remove_root";
+    case OpCode::AddRef:
+        return "add_ref";
+    case OpCode::RemoveRef:
+        return "remove_ref";
+    default:
+        return "unknown";
+    }
+}
+
+/**
+ * @struct ScenarioOp
+ * @brief Представляет одну операцию в сценарии тестирования
+ */
+struct ScenarioOp
+{
+    OpCode op; // allocate, add_root, remove_root, add_ref, remove_ref
+    int id;    // Для allocate, add_root и remove_root
+    int from;  // Для add_ref и remove_ref
+    int to;    // Для add_ref и remove_ref
+
+    ScenarioOp() : op(OpCode::Unknown), id(-1), from(-1), to(-1) {}
+    ScenarioOp(OpCode op_, int id_, int from_ = -1, int to_ = -1)
+        : op(op_), id(id_), from(from_), to(to_) {}
+    ScenarioOp(const std::string &op_, int id_, int from_ = -1, int to_ = -1)
+        : op(parse_op_code(op_)), id(id_), from(from_), to(to_) {}
+};
+
+#endif // SCENARIO_OP_H
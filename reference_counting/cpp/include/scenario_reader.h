@@ -0,0 +1,112 @@
+#ifndef SCENARIO_READER_H
+#define SCENARIO_READER_H
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "scenario_op.h"
+
+/**
+ * @class ScenarioReader
+ * @brief Потоковое чтение сценария из JSON-файла (каталог scenarios/)
+ *
+ * Формат — массив объектов операций:
+ *   [ {"op": "allocate", "id": 1}, {"op": "add_ref", "from": 1, "to": 2}, ... ]
+ * Допускается и поток объектов без внешнего массива (JSON Lines).
+ *
+ * Файл читается блоками фиксированного размера, операции разбираются по
+ * одной, поэтому память не зависит от размера сценария. Имя операции
+ * переводится в OpCode при разборе; операции с неизвестным именем
+ * пропускаются с предупреждением в std::cerr. Неизвестные поля объекта
+ * игнорируются.
+ */
+class ScenarioReader
+{
+public:
+    /**
+     * @throw std::runtime_error если файл не открывается
+     */
+    explicit ScenarioReader(const std::string &filename);
+    ~ScenarioReader();
+
+    ScenarioReader(const ScenarioReader &) = delete;
+    ScenarioReader &operator=(const ScenarioReader &) = delete;
+
+    /**
+     * @brief Прочитать следующую операцию
+     * @return false в конце сценария
+     * @throw std::runtime_error при синтаксической ошибке (с номером строки)
+     */
+    bool next(ScenarioOp &op);
+
+    /**
+     * @brief Прочитано байт файла
+     */
+    size_t bytes_read() const { return consumed + pos; }
+
+    /**
+     * @brief Пропущено операций с неизвестным именем
+     */
+    size_t skipped() const { return skipped_ops; }
+
+    const std::string &get_filename() const { return filename; }
+
+private:
+    std::string filename;
+    std::FILE *file;
+    std::vector<char> buffer;
+    size_t pos;         ///< Позиция в буфере
+    size_t filled;      ///< Заполнено байт буфера
+    size_t consumed;    ///< Байт файла до начала буфера
+    size_t line;        ///< Текущая строка (для сообщений об ошибках)
+    bool started;       ///< Начало файла уже разобрано
+    bool in_array;      ///< Операции лежат во внешнем массиве
+    bool finished;      ///< Сценарий закончился
+    size_t parsed;      ///< Разобрано объектов операций
+    size_t skipped_ops; ///< Пропущено операций с неизвестным именем
+    std::string token;  ///< Буфер строковых значений (переиспользуется)
+
+    /**
+     * @brief Следующий символ без извлечения; EOF в конце файла
+     */
+    int peek()
+    {
+        if (pos == filled && !refill())
+        {
+            return EOF;
+        }
+        return static_cast<unsigned char>(buffer[pos]);
+    }
+
+    int get()
+    {
+        int c = peek();
+        if (c != EOF)
+        {
+            pos++;
+            if (c == '\n')
+            {
+                line++;
+            }
+        }
+        return c;
+    }
+
+    bool refill();
+    void skip_whitespace();
+    void expect(char c);
+    [[noreturn]] void fail(const std::string &message) const;
+
+    /**
+     * @brief Разобрать объект операции
+     * @return false, если операция неизвестна и пропущена
+     */
+    bool parse_op(ScenarioOp &op);
+    void parse_string(std::string &out);
+    int parse_int();
+    void skip_value();
+};
+
+#endif // SCENARIO_READER_H
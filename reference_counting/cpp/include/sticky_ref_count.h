@@ -0,0 +1,92 @@
+#ifndef STICKY_REF_COUNT_H
+#define STICKY_REF_COUNT_H
+
+#include <cstdint>
+
+/**
+ * @class StickyRefCount
+ * @brief Узкий (16 бит) счётчик ссылок, залипающий при переполнении
+ *
+ * У подавляющего большинства объектов лишь несколько входящих ссылок, так
+ * что 32-битный счётчик почти всегда пуст. Этот счётчик занимает 2 байта
+ * и ведёт себя как int, пока значение меньше kSticky. Инкремент до kSticky
+ * «залипает» счётчик: дальше инкременты и декременты его не меняют,
+ * и подсчёт ссылок такой объект не освободит. Точное значение
+ * восстанавливает трассировщик (Tracer::restore_sticky_counts): живому
+ * объекту — по пометкам, мусорный освобождает sweep.
+ *
+ * Для сборщика циклов залипший объект всегда достижим извне (пробное
+ * удаление его не уменьшает) — консервативно и безопасно.
+ */
+class StickyRefCount
+{
+public:
+    static constexpr int kSticky = INT16_MAX;
+
+    StickyRefCount() : value(0) {}
+    explicit StickyRefCount(int count) : value(clamp(count)) {}
+
+    StickyRefCount &operator=(int count)
+    {
+        value = clamp(count);
+        return *this;
+    }
+
+    operator int() const { return value; }
+
+    bool is_sticky() const { return value == kSticky; }
+
+    StickyRefCount &operator++()
+    {
+        if (value != kSticky)
+        {
+            value++;
+        }
+        return *this;
+    }
+
+    StickyRefCount &operator--()
+    {
+        if (value != kSticky && value != INT16_MIN)
+        {
+            value--;
+        }
+        return *this;
+    }
+
+    int operator++(int)
+    {
+        int old = value;
+        ++*this;
+        return old;
+    }
+
+    int operator--(int)
+    {
+        int old = value;
+        --*this;
+        return old;
+    }
+
+    /**
+     * @brief Прибавить итоговую разность (apply_batch); залипший счётчик не меняется
+     */
+    StickyRefCount &operator+=(int delta)
+    {
+        if (value != kSticky)
+        {
+            value = clamp(value + delta);
+        }
+        return *this;
+    }
+
+private:
+    int16_t value;
+
+    static int16_t clamp(int count)
+    {
+        return static_cast<int16_t>(count >= kSticky ? kSticky : count < INT16_MIN ? INT16_MIN : count);
+    }
+};
+
+#endif // STICKY_REF_COUNT_H
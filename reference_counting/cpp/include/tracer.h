@@ -0,0 +1,116 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+#include "rc_object.h"
+#include "object_store.h"
+#include "mark_bitmap.h"
+#include "parallel_marker.h"
+#include "event_logger.h"
+
+/**
+ * @class Tracer
+ * @brief Резервный трассирующий сборщик (mark-sweep) поверх кучи с подсчётом ссылок
+ *
+ * Помечает объекты, достижимые из корней, и освобождает остальные.
+ * Помимо явных корней (add_root) корнями считаются объекты с ref_count == 0:
+ * на них никто не ссылается, значит их удерживает сам мутатор (например,
+ * только что выделенный объект), и RC ещё не решил их судьбу.
+ * Непомеченный объект поэтому всегда имеет ref_count > 0 и удерживается
+ * только другими недостижимыми объектами — это и есть утечка RC.
+ *
+ * При set_threads(n > 1) пометка выполняется ParallelMarker'ом.
+ */
+class Tracer
+{
+public:
+    /**
+     * @brief Конструктор
+     * @param heap Ссылка на хранилище объектов
+     * @param logger Ссылка на логгер событий
+     */
+    Tracer(ObjectStore &heap, EventLogger &logger);
+
+    /**
+     * @brief Пометить все достижимые объекты
+     * @param roots Множество явных корней
+     * @return Количество помеченных объектов
+     */
+    size_t mark(const std::unordered_set<int> &roots);
+
+    /**
+     * @brief Задать количество потоков фазы пометки
+     * @param threads 1 — последовательная пометка, 0 — по числу ядер
+     */
+    void set_threads(unsigned threads);
+
+    /**
+     * @brief Количество потоков фазы пометки
+     */
+    unsigned get_threads() const { return threads; }
+
+    /**
+     * @brief Освободить объекты, не помеченные последним вызовом mark()
+     *
+     * Каждый освобождённый объект логируется как leak, затем как delete.
+     * Ссылки из мусора на живые объекты снимаются с их ref_count.
+     *
+     * @return Количество освобождённых объектов
+     */
+    size_t sweep();
+
+    /**
+     * @brief Восстановить точные значения залипших счётчиков (RC_COMPACT_HEADER)
+     *
+     * Вызывается после sweep(): значение залипшего живого объекта — число
+     * ссылок на него из помеченных объектов и из корней. Если оно меньше
+     * максимума, счётчик снова точный. Без RC_COMPACT_HEADER ничего не делает.
+     *
+     * @param roots Множество явных корней, переданное в mark()
+     * @return Количество счётчиков, ставших снова точными
+     */
+    size_t restore_sticky_counts(const std::unordered_set<int> &roots);
+
+    /**
+     * @brief Залогировать (без освобождения) объекты, не помеченные последним mark()
+     * @return Количество найденных утечек
+     */
+    size_t log_unmarked();
+
+    /**
+     * @brief Помечен ли слот последним вызовом mark()
+     */
+    bool is_marked(uint32_t slot) const { return slot < marks.slot_count() && marks.test(slot); }
+
+    /**
+     * @brief Карта пометок последнего вызова mark()
+     */
+    const MarkBitmap &get_marks() const { return marks; }
+
+private:
+    ObjectStore &heap;
+    EventLogger &logger;
+    MarkBitmap marks;            ///< Пометки, индексированные слотом
+    ParallelMarker parallel;     ///< Параллельная пометка (при threads > 1)
+    unsigned threads;            ///< Количество потоков пометки
+    std::vector<uint32_t> stack; ///< Рабочий стек пометки (слоты)
+    std::vector<int> garbage;    ///< Непомеченные объекты, собранные в sweep()
+    std::vector<uint32_t> sticky; ///< Слоты живых объектов с залипшими счётчиками (restore_sticky_counts)
+
+    /**
+     * @brief Пометить слот и добавить его в стек, если он ещё не помечен
+     */
+    void push(uint32_t slot)
+    {
+        if (marks.set(slot))
+        {
+            stack.push_back(slot);
+        }
+    }
+};
+
+#endif // TRACER_H
@@ -0,0 +1,93 @@
+#ifndef WEAK_REF_TABLE_H
+#define WEAK_REF_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "event_logger.h"
+#include "object_store.h"
+
+/**
+ * @class WeakRefTable
+ * @brief Слабые ссылки между объектами: не удерживают цель и не входят в ref_count
+ *
+ * Слабая ссылка хранит дескриптор цели (слот и поколение). Блок управления
+ * цели — её поколение в ObjectStore: erase() увеличивает его, и все слабые
+ * ссылки на объект становятся недействительными за O(1), без обхода
+ * держателей. Дескриптор не «оживает», даже если ID или слот достанется
+ * новому объекту.
+ *
+ * Рядом, по слоту цели, хранится количество действительных слабых ссылок
+ * на неё: при удалении цели оно попадает в лог (weak_expire) и сбрасывается,
+ * тоже за O(1). Устаревшая ссылка остаётся у держателя до remove(),
+ * повторного add() той же цели или удаления держателя и счётчик уже
+ * не уменьшает.
+ *
+ * Сборщики (CycleCollector, Tracer, HeapImage) слабые ссылки не видят:
+ * объекты, связанные только ими, освобождаются обычным подсчётом ссылок,
+ * а обратная слабая ссылка не образует цикла.
+ *
+ * Об удалении объектов таблица узнаёт как ObjectStoreListener; подписывается
+ * при первой слабой ссылке, так что куча без слабых ссылок за неё не платит.
+ * Существование объектов проверяет вызывающий код (RCHeap).
+ */
+class WeakRefTable : public ObjectStoreListener
+{
+public:
+    WeakRefTable(ObjectStore &store, EventLogger &logger);
+    ~WeakRefTable() override;
+
+    WeakRefTable(const WeakRefTable &) = delete;
+    WeakRefTable &operator=(const WeakRefTable &) = delete;
+
+    /**
+     * @brief Добавить слабую ссылку from -> to (оба объекта должны существовать)
+     * @return false, если действительная слабая ссылка from -> to уже есть
+     */
+    bool add(int from, int to);
+
+    /**
+     * @brief Удалить слабую ссылку from -> to (действительную или устаревшую)
+     * @return false, если у from нет слабой ссылки на to
+     */
+    bool remove(int from, int to);
+
+    /**
+     * @brief Есть ли у from слабая ссылка на to, и жива ли цель
+     */
+    bool is_valid(int from, int to) const;
+
+    /**
+     * @brief Количество действительных слабых ссылок на объект
+     */
+    uint32_t weak_count(int id) const;
+
+    /**
+     * @brief Количество действительных слабых ссылок во всей куче
+     */
+    size_t size() const { return live_refs; }
+
+    void on_emplace(uint32_t slot) override { (void)slot; }
+    void on_erase(uint32_t slot, const RCObject &obj) override;
+
+private:
+    struct WeakRef
+    {
+        int target_id;       ///< ID цели на момент add() (для remove() после её удаления)
+        ObjectHandle target; ///< Цель; устаревает при её удалении
+    };
+
+    ObjectStore &store;
+    EventLogger &logger;
+    bool attached;
+    size_t live_refs;
+
+    // По слоту
+    std::vector<std::vector<WeakRef>> held; ///< Слабые ссылки держателя
+    std::vector<uint32_t> counts;           ///< Действительные слабые ссылки на текущий объект слота
+
+    void ensure_slots(uint32_t slot_count);
+};
+
+#endif // WEAK_REF_TABLE_H
@@ -0,0 +1,144 @@
+#ifndef WORK_STEALING_DEQUE_H
+#define WORK_STEALING_DEQUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @class WorkStealingDeque
+ * @brief Дек Чейза–Лева для номеров слотов
+ *
+ * Владелец кладёт и забирает элементы с нижнего конца без блокировок,
+ * остальные потоки крадут с верхнего конца одним CAS. Буфер растёт
+ * удвоением; старые буферы живут до разрушения дека, так как вор
+ * может ещё читать из них.
+ */
+class WorkStealingDeque
+{
+public:
+    explicit WorkStealingDeque(int64_t initial_capacity = 1024)
+        : top(0), bottom(0)
+    {
+        buffers.emplace_back(new Buffer(initial_capacity));
+        buffer.store(buffers.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque &) = delete;
+    WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+    /**
+     * @brief Положить элемент (только поток-владелец)
+     */
+    void push(uint32_t value)
+    {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        Buffer *buf = buffer.load(std::memory_order_relaxed);
+        if (b - t > buf->capacity - 1)
+        {
+            buf = grow(buf, b, t);
+        }
+        buf->put(b, value);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Забрать элемент с нижнего конца (только поток-владелец)
+     * @return false, если дек пуст
+     */
+    bool pop(uint32_t &value)
+    {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        Buffer *buf = buffer.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+
+        if (t > b)
+        {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        value = buf->get(b);
+        if (t == b)
+        {
+            // Последний элемент: соревнуемся с ворами
+            bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                   std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Украсть элемент с верхнего конца (любой поток)
+     * @return false, если дек пуст или кражу перехватил другой поток
+     */
+    bool steal(uint32_t &value)
+    {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b)
+        {
+            return false;
+        }
+
+        Buffer *buf = buffer.load(std::memory_order_acquire);
+        value = buf->get(t);
+        return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                           std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Приблизительная проверка на пустоту (для решения о краже)
+     */
+    bool looks_empty() const
+    {
+        return top.load(std::memory_order_relaxed) >= bottom.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Buffer
+    {
+        int64_t capacity;
+        std::unique_ptr<std::atomic<uint32_t>[]> data;
+
+        explicit Buffer(int64_t capacity_)
+            : capacity(capacity_), data(new std::atomic<uint32_t>[capacity_]) {}
+
+        uint32_t get(int64_t index) const
+        {
+            return data[index & (capacity - 1)].load(std::memory_order_relaxed);
+        }
+
+        void put(int64_t index, uint32_t value)
+        {
+            data[index & (capacity - 1)].store(value, std::memory_order_relaxed);
+        }
+    };
+
+    alignas(64) std::atomic<int64_t> top;
+    alignas(64) std::atomic<int64_t> bottom;
+    std::atomic<Buffer *> buffer;
+    std::vector<std::unique_ptr<Buffer>> buffers; ///< Все выделенные буферы (меняет только владелец)
+
+    Buffer *grow(Buffer *old, int64_t b, int64_t t)
+    {
+        buffers.emplace_back(new Buffer(old->capacity * 2));
+        Buffer *bigger = buffers.back().get();
+        for (int64_t i = t; i < b; ++i)
+        {
+            bigger->put(i, old->get(i));
+        }
+        buffer.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+};
+
+#endif // WORK_STEALING_DEQUE_H
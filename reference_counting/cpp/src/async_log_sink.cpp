@@ -0,0 +1,189 @@
+#include "async_log_sink.h"
+
+#include <chrono>
+
+AsyncLogSink::AsyncLogSink(std::unique_ptr<LogSink> inner_, size_t capacity, OverflowPolicy policy_)
+    : inner(std::move(inner_)), policy(policy_)
+{
+    size_t size = 2;
+    while (size < capacity)
+    {
+        size *= 2;
+    }
+    cells.reset(new Cell[size]);
+    for (size_t i = 0; i < size; ++i)
+    {
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    mask = size - 1;
+
+    writer = std::thread(&AsyncLogSink::run, this);
+}
+
+AsyncLogSink::~AsyncLogSink()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    writer_cv.notify_one();
+    writer.join();
+}
+
+bool AsyncLogSink::try_push(const LogRecord &record)
+{
+    uint64_t pos = enqueue_pos.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        Cell &cell = cells[pos & mask];
+        uint64_t seq = cell.sequence.load(std::memory_order_acquire);
+        int64_t diff = static_cast<int64_t>(seq - pos);
+        if (diff == 0)
+        {
+            if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                cell.record = record;
+                cell.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0)
+        {
+            return false; // Кольцо заполнено
+        }
+        else
+        {
+            pos = enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool AsyncLogSink::try_pop(LogRecord &record)
+{
+    Cell &cell = cells[dequeue_pos & mask];
+    uint64_t seq = cell.sequence.load(std::memory_order_acquire);
+    if (seq != dequeue_pos + 1)
+    {
+        return false;
+    }
+    record = cell.record;
+    cell.sequence.store(dequeue_pos + mask + 1, std::memory_order_release);
+    dequeue_pos++;
+    return true;
+}
+
+void AsyncLogSink::push_overflow(const LogRecord &record)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    overflow.push_back(record);
+    overflow_active.store(true, std::memory_order_release);
+    overflowed.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AsyncLogSink::write(const LogRecord &record)
+{
+    if (policy == OverflowPolicy::Grow && overflow_active.load(std::memory_order_acquire))
+    {
+        push_overflow(record);
+    }
+    else if (!try_push(record))
+    {
+        switch (policy)
+        {
+        case OverflowPolicy::Block:
+            writer_cv.notify_one();
+            while (!try_push(record))
+            {
+                std::this_thread::yield();
+            }
+            break;
+        case OverflowPolicy::Drop:
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        case OverflowPolicy::Grow:
+            push_overflow(record);
+            break;
+        }
+    }
+    produced.fetch_add(1, std::memory_order_release);
+}
+
+void AsyncLogSink::sync()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    uint64_t target = produced.load(std::memory_order_acquire);
+    if (target > sync_target)
+    {
+        sync_target = target;
+    }
+    writer_cv.notify_one();
+    sync_cv.wait(lock, [&]
+                 { return synced >= target; });
+}
+
+size_t AsyncLogSink::drain()
+{
+    size_t written = 0;
+    LogRecord record;
+    while (try_pop(record))
+    {
+        inner->write(record);
+        written++;
+    }
+
+    // Отложенные события новее всего, что было в кольце на момент их появления
+    if (overflow_active.load(std::memory_order_acquire))
+    {
+        std::vector<LogRecord> batch;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            batch.swap(overflow);
+            overflow_active.store(false, std::memory_order_release);
+        }
+        for (const LogRecord &item : batch)
+        {
+            inner->write(item);
+        }
+        written += batch.size();
+    }
+
+    if (written > 0)
+    {
+        consumed.fetch_add(written, std::memory_order_release);
+    }
+    return written;
+}
+
+void AsyncLogSink::run()
+{
+    for (;;)
+    {
+        size_t written = drain();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        uint64_t done = consumed.load(std::memory_order_acquire);
+        if (sync_target > synced && done >= sync_target)
+        {
+            lock.unlock();
+            inner->sync();
+            lock.lock();
+            synced = done;
+            sync_cv.notify_all();
+        }
+
+        if (stopping && written == 0 && done == produced.load(std::memory_order_acquire))
+        {
+            break;
+        }
+        if (written == 0)
+        {
+            // Производители не будят поток на каждом событии: он просыпается по таймауту
+            writer_cv.wait_for(lock, std::chrono::milliseconds(1));
+        }
+    }
+
+    inner->sync();
+    std::lock_guard<std::mutex> lock(mutex);
+    synced = consumed.load(std::memory_order_relaxed);
+    sync_cv.notify_all();
+}
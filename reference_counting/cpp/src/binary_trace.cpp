@@ -0,0 +1,256 @@
+#include "binary_trace.h"
+
+#include <cstring>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    void put16(unsigned char *out, uint16_t value)
+    {
+        out[0] = static_cast<unsigned char>(value);
+        out[1] = static_cast<unsigned char>(value >> 8);
+    }
+
+    void put32(unsigned char *out, uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            out[i] = static_cast<unsigned char>(value >> (8 * i));
+        }
+    }
+
+    void put64(unsigned char *out, uint64_t value)
+    {
+        for (int i = 0; i < 8; ++i)
+        {
+            out[i] = static_cast<unsigned char>(value >> (8 * i));
+        }
+    }
+
+    uint16_t get16(const unsigned char *in)
+    {
+        return static_cast<uint16_t>(in[0] | in[1] << 8);
+    }
+
+    uint64_t get64(const unsigned char *in)
+    {
+        uint64_t value = 0;
+        for (int i = 7; i >= 0; --i)
+        {
+            value = value << 8 | in[i];
+        }
+        return value;
+    }
+
+    void encode_header(unsigned char *header, bool varint, uint64_t op_count)
+    {
+        std::memcpy(header, kTraceMagic, sizeof(kTraceMagic));
+        put16(header + 4, kTraceVersion);
+        put16(header + 6, varint ? kTraceVarint : 0);
+        put64(header + 8, op_count);
+    }
+
+    bool is_ref_op(OpCode code)
+    {
+        return code == OpCode::AddRef || code == OpCode::RemoveRef;
+    }
+}
+
+BinaryTraceWriter::BinaryTraceWriter(const std::string &filename, bool varint_)
+    : file(std::fopen(filename.c_str(), "wb")), varint(varint_), buffer(1 << 20), used(0), op_count(0),
+      previous(0)
+{
+    if (file == nullptr)
+    {
+        throw std::runtime_error("Failed to open trace file: " + filename);
+    }
+    // Количество операций дописывается в заголовок при закрытии
+    unsigned char header[kTraceHeaderSize];
+    encode_header(header, varint, 0);
+    std::fwrite(header, 1, sizeof(header), file);
+}
+
+BinaryTraceWriter::~BinaryTraceWriter()
+{
+    try
+    {
+        close();
+    }
+    catch (const std::exception &)
+    {
+        // Деструктор не бросает; ошибку записи увидит тот, кто вызовет close()
+    }
+}
+
+void BinaryTraceWriter::write(const ScenarioOp &op)
+{
+    if (op.op == OpCode::Unknown)
+    {
+        return;
+    }
+    // Запас на самую длинную varint-запись: байт кода и два 10-байтовых числа
+    if (used + 21 > buffer.size())
+    {
+        flush();
+    }
+
+    const bool ref = is_ref_op(op.op);
+    const int32_t a = ref ? op.from : op.id;
+    const int32_t b = ref ? op.to : 0;
+    buffer[used++] = static_cast<unsigned char>(op.op);
+    if (varint)
+    {
+        put_varint(static_cast<int64_t>(a) - previous);
+        if (ref)
+        {
+            put_varint(static_cast<int64_t>(b) - a);
+        }
+        previous = a;
+    }
+    else
+    {
+        put32(&buffer[used], static_cast<uint32_t>(a));
+        put32(&buffer[used + 4], static_cast<uint32_t>(b));
+        used += 8;
+    }
+    op_count++;
+}
+
+void BinaryTraceWriter::put_varint(int64_t delta)
+{
+    // zigzag: малые по модулю разности любого знака дают короткий varint
+    uint64_t value = static_cast<uint64_t>(delta) << 1 ^ static_cast<uint64_t>(delta >> 63);
+    while (value >= 0x80)
+    {
+        buffer[used++] = static_cast<unsigned char>(value | 0x80);
+        value >>= 7;
+    }
+    buffer[used++] = static_cast<unsigned char>(value);
+}
+
+void BinaryTraceWriter::flush()
+{
+    if (used > 0 && std::fwrite(buffer.data(), 1, used, file) != used)
+    {
+        throw std::runtime_error("Failed to write binary trace");
+    }
+    used = 0;
+}
+
+void BinaryTraceWriter::close()
+{
+    if (file == nullptr)
+    {
+        return;
+    }
+    std::FILE *f = file;
+    file = nullptr;
+
+    bool ok = true;
+    if (used > 0)
+    {
+        ok = std::fwrite(buffer.data(), 1, used, f) == used;
+        used = 0;
+    }
+    unsigned char header[kTraceHeaderSize];
+    encode_header(header, varint, op_count);
+    ok = ok && std::fseek(f, 0, SEEK_SET) == 0 && std::fwrite(header, 1, sizeof(header), f) == sizeof(header);
+    ok = std::fclose(f) == 0 && ok;
+    if (!ok)
+    {
+        throw std::runtime_error("Failed to write binary trace");
+    }
+}
+
+BinaryTraceReader::BinaryTraceReader(const std::string &filename)
+    : data(nullptr), mapped_size(0), mapped(false), begin(nullptr), cursor(nullptr), end(nullptr), varint(false),
+      op_count(0), read_count(0), previous(0)
+{
+#if !defined(_WIN32)
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Failed to open trace file: " + filename);
+    }
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= kTraceHeaderSize)
+    {
+        void *address = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED)
+        {
+            data = static_cast<const unsigned char *>(address);
+            mapped_size = static_cast<size_t>(info.st_size);
+            mapped = true;
+            ::madvise(address, mapped_size, MADV_SEQUENTIAL);
+        }
+    }
+    ::close(fd);
+#endif
+
+    if (!mapped)
+    {
+        // Без mmap: прочитать файл целиком
+        std::FILE *file = std::fopen(filename.c_str(), "rb");
+        if (file == nullptr)
+        {
+            throw std::runtime_error("Failed to open trace file: " + filename);
+        }
+        unsigned char chunk[1 << 16];
+        size_t read;
+        while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+        {
+            fallback.insert(fallback.end(), chunk, chunk + read);
+        }
+        std::fclose(file);
+        data = fallback.data();
+        mapped_size = fallback.size();
+    }
+
+    if (mapped_size < kTraceHeaderSize || std::memcmp(data, kTraceMagic, sizeof(kTraceMagic)) != 0 ||
+        get16(data + 4) != kTraceVersion)
+    {
+        release();
+        throw std::runtime_error("Not a binary trace: " + filename);
+    }
+    varint = (get16(data + 6) & kTraceVarint) != 0;
+    op_count = get64(data + 8);
+    begin = data + kTraceHeaderSize;
+    cursor = begin;
+    end = data + mapped_size;
+}
+
+BinaryTraceReader::~BinaryTraceReader()
+{
+    release();
+}
+
+void BinaryTraceReader::release()
+{
+#if !defined(_WIN32)
+    if (mapped)
+    {
+        ::munmap(const_cast<unsigned char *>(data), mapped_size);
+        mapped = false;
+    }
+#endif
+}
+
+bool BinaryTraceReader::is_binary_trace(const std::string &filename)
+{
+    std::FILE *file = std::fopen(filename.c_str(), "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+    char magic[sizeof(kTraceMagic)];
+    bool match = std::fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                 std::memcmp(magic, kTraceMagic, sizeof(magic)) == 0;
+    std::fclose(file);
+    return match;
+}
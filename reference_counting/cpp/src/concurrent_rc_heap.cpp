@@ -0,0 +1,327 @@
+#include "concurrent_rc_heap.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+    std::atomic<uint32_t> g_next_thread{1};
+    std::atomic<uint64_t> g_next_instance{1};
+
+    /**
+     * Кеш очереди владельца текущего потока для последней использованной кучи
+     */
+    struct QueueCache
+    {
+        uint64_t instance = 0;
+        void *queue = nullptr;
+    };
+    thread_local QueueCache t_queue_cache;
+
+    /**
+     * Ссылка ведёт в удалённый объект: счётчики кучи уже разошлись с графом,
+     * и продолжать нельзя — любой следующий шаг освободит живой объект
+     */
+    [[noreturn]] void missing_target(int from, int to)
+    {
+        std::fprintf(stderr, "ConcurrentRCHeap: reference %d -> %d points to a deleted object\n", from, to);
+        std::abort();
+    }
+}
+
+ConcurrentRCHeap::ConcurrentRCHeap(EventLogger &logger_, size_t shard_count, CountMode mode_)
+    : logger(logger_), mode(mode_), instance(g_next_instance.fetch_add(1))
+{
+    size_t size = 1;
+    while (size < shard_count)
+    {
+        size *= 2;
+    }
+    shards = std::vector<Shard>(size);
+    shard_mask = size - 1;
+}
+
+std::shared_ptr<ConcurrentObject> ConcurrentRCHeap::find(int obj_id) const
+{
+    if (obj_id < 0)
+    {
+        return nullptr;
+    }
+    const Shard &shard = shard_for(obj_id);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    auto it = shard.objects.find(obj_id);
+    return it != shard.objects.end() ? it->second : nullptr;
+}
+
+uint32_t ConcurrentRCHeap::current_thread()
+{
+    thread_local uint32_t index = g_next_thread.fetch_add(1, std::memory_order_relaxed);
+    return index;
+}
+
+ConcurrentRCHeap::OwnerQueue &ConcurrentRCHeap::queue_for(uint32_t owner)
+{
+    std::lock_guard<std::mutex> guard(queues_lock);
+    std::unique_ptr<OwnerQueue> &queue = queues[owner];
+    if (!queue)
+    {
+        queue.reset(new OwnerQueue());
+    }
+    return *queue;
+}
+
+size_t ConcurrentRCHeap::merge_pending()
+{
+    QueueCache &cache = t_queue_cache;
+    if (cache.instance != instance)
+    {
+        cache.queue = &queue_for(current_thread());
+        cache.instance = instance;
+    }
+    OwnerQueue &queue = *static_cast<OwnerQueue *>(cache.queue);
+    if (!queue.pending.load(std::memory_order_acquire))
+    {
+        return 0;
+    }
+
+    std::vector<std::shared_ptr<ConcurrentObject>> batch;
+    {
+        std::lock_guard<std::mutex> guard(queue.lock);
+        batch.swap(queue.objects);
+        queue.pending.store(false, std::memory_order_relaxed);
+    }
+    for (std::shared_ptr<ConcurrentObject> &obj : batch)
+    {
+        BiasedRefCount::Release result = obj->count.merge();
+        on_release(std::move(obj), result);
+    }
+    return batch.size();
+}
+
+size_t ConcurrentRCHeap::settle()
+{
+    std::vector<std::shared_ptr<ConcurrentObject>> batch;
+    {
+        std::lock_guard<std::mutex> guard(queues_lock);
+        for (auto &entry : queues)
+        {
+            OwnerQueue &queue = *entry.second;
+            std::lock_guard<std::mutex> queue_guard(queue.lock);
+            batch.insert(batch.end(), queue.objects.begin(), queue.objects.end());
+            queue.objects.clear();
+            queue.pending.store(false, std::memory_order_relaxed);
+        }
+    }
+    for (std::shared_ptr<ConcurrentObject> &obj : batch)
+    {
+        BiasedRefCount::Release result = obj->count.merge();
+        on_release(std::move(obj), result);
+    }
+    return batch.size();
+}
+
+void ConcurrentRCHeap::on_release(std::shared_ptr<ConcurrentObject> obj, BiasedRefCount::Release result)
+{
+    if (result == BiasedRefCount::Release::Zero)
+    {
+        cascade(std::move(obj));
+    }
+    else if (result == BiasedRefCount::Release::Queue)
+    {
+        OwnerQueue &queue = queue_for(obj->count.owner());
+        std::lock_guard<std::mutex> guard(queue.lock);
+        queue.objects.push_back(std::move(obj));
+        queue.pending.store(true, std::memory_order_release);
+    }
+}
+
+bool ConcurrentRCHeap::allocate(int obj_id)
+{
+    if (obj_id < 0)
+    {
+        return false;
+    }
+
+    Shard &shard = shard_for(obj_id);
+    {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        auto inserted = shard.objects.emplace(obj_id, nullptr);
+        if (!inserted.second)
+        {
+            return false;
+        }
+        inserted.first->second = std::make_shared<ConcurrentObject>(obj_id, current_thread(),
+                                                                    mode == CountMode::Biased);
+    }
+    live_count.fetch_add(1, std::memory_order_relaxed);
+    logger.log_allocate(obj_id);
+    return true;
+}
+
+bool ConcurrentRCHeap::add_root(int obj_id)
+{
+    merge_if_pending();
+    std::shared_ptr<ConcurrentObject> obj = find(obj_id);
+    RootState expected = RootState::None;
+    if (obj == nullptr ||
+        !obj->root.compare_exchange_strong(expected, RootState::Adding, std::memory_order_acq_rel))
+    {
+        return false;
+    }
+    if (root_claim_hook)
+    {
+        root_claim_hook(obj_id);
+    }
+
+    int count;
+    if (!obj->count.increment(current_thread(), count))
+    {
+        obj->root.store(RootState::None, std::memory_order_release);
+        return false;
+    }
+    // Только теперь remove_root может снять корень: увеличение уже в счётчике,
+    // а событие корня в логе — раньше события его снятия
+    logger.log_add_ref(0, obj_id, count); // 0 = root
+    obj->root.store(RootState::Rooted, std::memory_order_release);
+    return true;
+}
+
+bool ConcurrentRCHeap::remove_root(int obj_id)
+{
+    merge_if_pending();
+    std::shared_ptr<ConcurrentObject> obj = find(obj_id);
+    // Корень, который ещё добавляется (Adding), не снимается: его увеличение могло не попасть в счётчик
+    RootState expected = RootState::Rooted;
+    if (obj == nullptr ||
+        !obj->root.compare_exchange_strong(expected, RootState::None, std::memory_order_acq_rel))
+    {
+        return false;
+    }
+
+    // Событие логируется до возможного каскада, как в RCHeap
+    int count;
+    BiasedRefCount::Release result = obj->count.decrement(current_thread(), count);
+    logger.log_remove_ref(0, obj_id, count); // 0 = root
+    on_release(std::move(obj), result);
+    return true;
+}
+
+bool ConcurrentRCHeap::add_ref(int from, int to)
+{
+    if (from == to)
+    {
+        return false;
+    }
+    merge_if_pending();
+    std::shared_ptr<ConcurrentObject> from_obj = find(from);
+    std::shared_ptr<ConcurrentObject> to_obj = find(to);
+    if (from_obj == nullptr || to_obj == nullptr)
+    {
+        return false;
+    }
+
+    int count;
+    {
+        std::lock_guard<SpinLock> guard(from_obj->edges_lock);
+        // Удаляемый источник уже отдал свои ссылки каскаду: новых ему не добавить
+        if (from_obj->is_dead() || from_obj->references.contains(to))
+        {
+            return false;
+        }
+        if (!to_obj->count.increment(current_thread(), count))
+        {
+            return false;
+        }
+        from_obj->references.insert(to);
+    }
+    logger.log_add_ref(from, to, count);
+    return true;
+}
+
+bool ConcurrentRCHeap::remove_ref(int from, int to)
+{
+    merge_if_pending();
+    std::shared_ptr<ConcurrentObject> from_obj = find(from);
+    if (from_obj == nullptr)
+    {
+        return false;
+    }
+
+    {
+        std::lock_guard<SpinLock> guard(from_obj->edges_lock);
+        if (from_obj->is_dead() || !from_obj->references.erase(to))
+        {
+            return false;
+        }
+    }
+
+    // Пока ссылка существовала, она удерживала цель: цель ещё в таблице
+    std::shared_ptr<ConcurrentObject> to_obj = find(to);
+    if (to_obj == nullptr)
+    {
+        missing_target(from, to);
+    }
+    int count;
+    BiasedRefCount::Release result = to_obj->count.decrement(current_thread(), count);
+    logger.log_remove_ref(from, to, count);
+    on_release(std::move(to_obj), result);
+    return true;
+}
+
+int ConcurrentRCHeap::get_ref_count(int obj_id) const
+{
+    std::shared_ptr<ConcurrentObject> obj = find(obj_id);
+    if (obj == nullptr)
+    {
+        return -1;
+    }
+    return obj->count.total();
+}
+
+void ConcurrentRCHeap::cascade(std::shared_ptr<ConcurrentObject> obj)
+{
+    // Стек на поток: каскад не выделяет память при каждом вызове
+    thread_local std::vector<std::shared_ptr<ConcurrentObject>> worklist;
+    const size_t base = worklist.size();
+    worklist.push_back(std::move(obj));
+
+    EdgeSet children;
+    while (worklist.size() > base)
+    {
+        std::shared_ptr<ConcurrentObject> current = std::move(worklist.back());
+        worklist.pop_back();
+
+        {
+            Shard &shard = shard_for(current->id);
+            std::lock_guard<std::mutex> guard(shard.lock);
+            shard.objects.erase(current->id);
+        }
+        live_count.fetch_sub(1, std::memory_order_relaxed);
+
+        {
+            std::lock_guard<SpinLock> guard(current->edges_lock);
+            children = std::move(current->references);
+        }
+        logger.log_delete(current->id);
+
+        const uint32_t self = current_thread();
+        for (auto it = children.rbegin(); it != children.rend(); ++it)
+        {
+            std::shared_ptr<ConcurrentObject> child = find(*it);
+            if (child == nullptr)
+            {
+                missing_target(current->id, *it);
+            }
+            int count;
+            BiasedRefCount::Release result = child->count.decrement(self, count);
+            if (result == BiasedRefCount::Release::Zero)
+            {
+                worklist.push_back(std::move(child));
+            }
+            else
+            {
+                on_release(std::move(child), result);
+            }
+        }
+    }
+}
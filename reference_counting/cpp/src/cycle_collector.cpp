@@ -0,0 +1,233 @@
+#include "cycle_collector.h"
+
+#include <algorithm>
+
+namespace
+{
+    // Буфер кандидатов чистится от устаревших записей, когда превышает
+    // max(kMinCompaction, 2 * живых объектов): живой объект попадает в буфер
+    // не больше одного раза, так что после чистки буфер не больше кучи.
+    constexpr size_t kMinCompaction = 1024;
+}
+
+CycleCollector::CycleCollector(ObjectStore &heap_, EventLogger &logger_)
+    : heap(heap_), logger(logger_), traced(0)
+{
+}
+
+void CycleCollector::possible_root(RCObject &obj)
+{
+    if (obj.color == GcColor::Purple)
+    {
+        return;
+    }
+
+    obj.color = GcColor::Purple;
+    if (!obj.buffered)
+    {
+        obj.buffered = true;
+        candidates.push_back(heap.handle_of(obj.id));
+
+        if (candidates.size() > std::max(kMinCompaction, 2 * heap.size()))
+        {
+            compact_candidates();
+        }
+    }
+}
+
+size_t CycleCollector::collect_cycles()
+{
+    mark_roots();
+    scan_roots();
+    return collect_roots();
+}
+
+void CycleCollector::compact_candidates()
+{
+    auto stale = [this](const ObjectHandle &handle)
+    {
+        return !heap.is_valid(handle);
+    };
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(), stale), candidates.end());
+}
+
+void CycleCollector::mark_roots()
+{
+    size_t kept = 0;
+    for (const ObjectHandle &handle : candidates)
+    {
+        RCObject *obj = heap.get(handle);
+        if (obj == nullptr)
+        {
+            continue; // Объект уже освобождён обычным каскадом
+        }
+
+        if (obj->color == GcColor::Purple && obj->ref_count > 0)
+        {
+            mark_gray(*obj);
+            candidates[kept++] = handle;
+        }
+        else
+        {
+            // Объект снова получил ссылку (Black) и не может быть корнем мусорного цикла
+            obj->buffered = false;
+        }
+    }
+    candidates.resize(kept);
+}
+
+void CycleCollector::scan_roots()
+{
+    for (const ObjectHandle &handle : candidates)
+    {
+        scan(*heap.get(handle));
+    }
+}
+
+size_t CycleCollector::collect_roots()
+{
+    garbage.clear();
+    for (const ObjectHandle &handle : candidates)
+    {
+        RCObject &obj = *heap.get(handle);
+        obj.buffered = false;
+        collect_white(obj);
+    }
+    candidates.clear();
+
+    // Ссылки из белых объектов на живые уже вычтены в MarkGray,
+    // поэтому освобождение не трогает счётчики выживших объектов
+    for (int obj_id : garbage)
+    {
+        heap.erase(obj_id);
+        logger.log_delete(obj_id);
+    }
+    return garbage.size();
+}
+
+void CycleCollector::mark_gray(RCObject &obj)
+{
+    if (obj.color == GcColor::Gray)
+    {
+        return;
+    }
+
+    obj.color = GcColor::Gray;
+    stack.push_back(obj.id);
+    traced++;
+
+    while (!stack.empty())
+    {
+        RCObject *current = heap.find(stack.back());
+        stack.pop_back();
+
+        for (int child_id : current->references)
+        {
+            RCObject *child = heap.find(child_id);
+            if (child == nullptr)
+            {
+                continue;
+            }
+
+            // Пробное удаление внутренней ссылки (у выживших восстанавливается в scan_black,
+            // кроме ссылок из белых объектов)
+            child->ref_count--;
+            heap.touch(*child);
+            if (child->color != GcColor::Gray)
+            {
+                child->color = GcColor::Gray;
+                stack.push_back(child_id);
+                traced++;
+            }
+        }
+    }
+}
+
+void CycleCollector::scan(RCObject &obj)
+{
+    stack.push_back(obj.id);
+
+    while (!stack.empty())
+    {
+        RCObject *current = heap.find(stack.back());
+        stack.pop_back();
+
+        if (current->color != GcColor::Gray)
+        {
+            continue;
+        }
+
+        if (current->ref_count > 0)
+        {
+            // Есть внешняя ссылка: объект и всё достижимое из него живо
+            scan_black(*current);
+            continue;
+        }
+
+        current->color = GcColor::White;
+        for (int child_id : current->references)
+        {
+            if (heap.contains(child_id))
+            {
+                stack.push_back(child_id);
+            }
+        }
+    }
+}
+
+void CycleCollector::scan_black(RCObject &obj)
+{
+    obj.color = GcColor::Black;
+    black_stack.push_back(obj.id);
+
+    while (!black_stack.empty())
+    {
+        RCObject *current = heap.find(black_stack.back());
+        black_stack.pop_back();
+
+        for (int child_id : current->references)
+        {
+            RCObject *child = heap.find(child_id);
+            if (child == nullptr)
+            {
+                continue;
+            }
+
+            // Восстановить ссылку, вычтенную в MarkGray
+            child->ref_count++;
+            if (child->color != GcColor::Black)
+            {
+                child->color = GcColor::Black;
+                black_stack.push_back(child_id);
+            }
+        }
+    }
+}
+
+void CycleCollector::collect_white(RCObject &obj)
+{
+    if (obj.color != GcColor::White || obj.buffered)
+    {
+        return;
+    }
+
+    obj.color = GcColor::Black;
+    stack.push_back(obj.id);
+
+    while (!stack.empty())
+    {
+        int current_id = stack.back();
+        stack.pop_back();
+        garbage.push_back(current_id);
+
+        for (int child_id : heap.find(current_id)->references)
+        {
+            RCObject *child = heap.find(child_id);
+            if (child != nullptr && child->color == GcColor::White && !child->buffered)
+            {
+                child->color = GcColor::Black;
+                stack.push_back(child_id);
+            }
+        }
+    }
+}
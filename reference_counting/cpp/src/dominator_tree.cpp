@@ -0,0 +1,347 @@
+#include "dominator_tree.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <ostream>
+#include <utility>
+
+namespace
+{
+    const uint32_t kPrefetchDistance = 16;
+
+    void prefetch(const void *address)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(address);
+#else
+        (void)address;
+#endif
+    }
+
+    void append_uint(std::string &out, const char *key, uint64_t value)
+    {
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), "\"%s\": %llu", key, static_cast<unsigned long long>(value));
+        out += buffer;
+    }
+}
+
+DominatorTree::DominatorTree(const HeapImage &image_) : image(image_), reachable(0), reachable_edges(0)
+{
+    build();
+}
+
+void DominatorTree::build()
+{
+    const uint32_t n = static_cast<uint32_t>(image.size());
+    dfs_number.assign(n, kNoIndex);
+    vertex.assign(1, kNoIndex);
+    vertex.reserve(static_cast<size_t>(n) + 1);
+    std::vector<uint32_t> parent(1, 0);
+    parent.reserve(static_cast<size_t>(n) + 1);
+
+    // 1. Итеративный DFS из виртуального корня: его ссылки — явные корни и объекты с ref_count == 0
+    std::vector<uint32_t> seeds(image.get_root_indices());
+    image.zero_indices(seeds);
+    std::vector<std::pair<uint32_t, const uint32_t *>> path; ///< Номер DFS и следующая ссылка
+    // Номер DFS цели каждой ссылки достижимых объектов (в порядке ссылок образа)
+    std::vector<uint32_t> edge_number(image.edge_count());
+    const uint32_t *edges_base = image.edge_count() == 0 ? nullptr : image.edges_begin(0);
+    for (uint32_t seed : seeds)
+    {
+        if (dfs_number[seed] != kNoIndex)
+        {
+            continue;
+        }
+        dfs_number[seed] = static_cast<uint32_t>(vertex.size());
+        vertex.push_back(seed);
+        parent.push_back(0);
+        path.emplace_back(dfs_number[seed], image.edges_begin(seed));
+        while (!path.empty())
+        {
+            const uint32_t number = path.back().first;
+            const uint32_t *&next = path.back().second;
+            if (next == image.edges_end(vertex[number]))
+            {
+                path.pop_back();
+                continue;
+            }
+            const uint32_t child = *next;
+            uint32_t &child_number = edge_number[next - edges_base];
+            ++next;
+            if (dfs_number[child] == kNoIndex)
+            {
+                dfs_number[child] = static_cast<uint32_t>(vertex.size());
+                vertex.push_back(child);
+                parent.push_back(number);
+                path.emplace_back(dfs_number[child], image.edges_begin(child));
+                // Цели ссылок открытого объекта проверяются следующими: запросить их из памяти заранее
+                for (const uint32_t *edge = image.edges_begin(child); edge != image.edges_end(child); ++edge)
+                {
+                    prefetch(&dfs_number[*edge]);
+                    image.prefetch_edges(*edge);
+                }
+            }
+            child_number = dfs_number[child];
+        }
+    }
+    const uint32_t count = static_cast<uint32_t>(vertex.size());
+    reachable = count - 1;
+
+    // 2. Обратные ссылки в номерах DFS (CSR); у явных корней и объектов с ref_count == 0 — ссылка из 0.
+    // Объекты и их ссылки читаются подряд в порядке образа, случайна только запись
+    std::vector<uint32_t> pred_offsets(static_cast<size_t>(count) + 1, 0);
+    for (uint32_t seed : seeds)
+    {
+        pred_offsets[dfs_number[seed] + 1]++;
+    }
+    for (uint32_t index = 0; index < n; ++index)
+    {
+        if (dfs_number[index] == kNoIndex)
+        {
+            continue;
+        }
+        const size_t begin = image.edges_begin(index) - edges_base;
+        const size_t end = image.edges_end(index) - edges_base;
+        reachable_edges += end - begin;
+        for (size_t e = begin; e < end; ++e)
+        {
+            pred_offsets[edge_number[e] + 1]++;
+        }
+    }
+    for (uint32_t w = 0; w < count; ++w)
+    {
+        pred_offsets[w + 1] += pred_offsets[w];
+    }
+    std::vector<uint32_t> preds(pred_offsets[count]);
+    {
+        std::vector<uint32_t> fill(pred_offsets.begin(), pred_offsets.end() - 1);
+        for (uint32_t seed : seeds)
+        {
+            preds[fill[dfs_number[seed]]++] = 0;
+        }
+        for (uint32_t index = 0; index < n; ++index)
+        {
+            const uint32_t w = dfs_number[index];
+            if (w == kNoIndex)
+            {
+                continue;
+            }
+            const size_t end = image.edges_end(index) - edges_base;
+            for (size_t e = image.edges_begin(index) - edges_base; e < end; ++e)
+            {
+                preds[fill[edge_number[e]]++] = w;
+            }
+        }
+    }
+    std::vector<uint32_t>().swap(edge_number);
+
+    // 3. Полудоминаторы и непосредственные доминаторы (Ленгауэр–Тарьян, сжатие путей без балансировки).
+    // Поля леса eval() лежат рядом, а вместе с меткой хранится её полудоминатор
+    // (он уже окончателен): сжатие пути читает по одной строке кэша на вершину
+    struct Link
+    {
+        uint32_t ancestor;
+        uint32_t label;      ///< Вершина с наименьшим полудоминатором на пути к корню леса
+        uint32_t label_semi; ///< semi[label]
+    };
+    std::vector<uint32_t> semi(count);
+    std::vector<Link> forest(count);
+    std::vector<uint32_t> bucket_head(count, kNoIndex);
+    std::vector<uint32_t> bucket_next(count, kNoIndex);
+    idom.assign(count, 0);
+    for (uint32_t w = 0; w < count; ++w)
+    {
+        semi[w] = w;
+        forest[w] = Link{kNoIndex, w, w};
+    }
+
+    // Сжать путь от v до корня его дерева в лесу; возвращает запись v
+    std::vector<uint32_t> chain;
+    auto eval = [&](uint32_t v) -> const Link & {
+        Link &link = forest[v];
+        if (link.ancestor == kNoIndex || forest[link.ancestor].ancestor == kNoIndex)
+        {
+            return link;
+        }
+        // Сначала верхние вершины пути, как в рекурсивной версии
+        for (uint32_t x = v; forest[forest[x].ancestor].ancestor != kNoIndex; x = forest[x].ancestor)
+        {
+            chain.push_back(x);
+        }
+        while (!chain.empty())
+        {
+            Link &x = forest[chain.back()];
+            chain.pop_back();
+            const Link &a = forest[x.ancestor];
+            if (a.label_semi < x.label_semi)
+            {
+                x.label = a.label;
+                x.label_semi = a.label_semi;
+            }
+            x.ancestor = a.ancestor;
+        }
+        return link;
+    };
+
+    for (uint32_t w = count; w-- > 1;)
+    {
+        uint32_t best = w;
+        for (uint32_t p = pred_offsets[w + 1]; p-- > pred_offsets[w];)
+        {
+            // preds читаются подряд с конца: запись леса для предшественника впереди запросить заранее
+            if (p >= kPrefetchDistance)
+            {
+                prefetch(&forest[preds[p - kPrefetchDistance]]);
+            }
+            // Предшественник раньше w в порядке DFS ещё не обработан: eval() вернул бы его самого
+            const uint32_t v = preds[p];
+            best = std::min(best, v < w ? v : eval(v).label_semi);
+        }
+        semi[w] = best;
+        forest[w].label_semi = best;
+        bucket_next[w] = bucket_head[best];
+        bucket_head[best] = w;
+
+        const uint32_t p = parent[w];
+        forest[w].ancestor = p;
+        for (uint32_t v = bucket_head[p]; v != kNoIndex; v = bucket_next[v])
+        {
+            const Link &u = eval(v);
+            idom[v] = u.label_semi < semi[v] ? u.label : p;
+        }
+        bucket_head[p] = kNoIndex;
+    }
+    for (uint32_t w = 1; w < count; ++w)
+    {
+        if (idom[w] != semi[w])
+        {
+            idom[w] = idom[idom[w]];
+        }
+    }
+
+    // 4. Размеры поддеревьев: доминатор раньше в порядке DFS, поэтому хватает одного обратного прохода
+    subtree_objects.assign(count, 1);
+    subtree_edges.assign(count, 0);
+    subtree_objects[0] = 0;
+    for (uint32_t w = count; w-- > 1;)
+    {
+        const uint32_t index = vertex[w];
+        subtree_edges[w] += image.edges_end(index) - image.edges_begin(index);
+        subtree_objects[idom[w]] += subtree_objects[w];
+        subtree_edges[idom[w]] += subtree_edges[w];
+    }
+}
+
+uint32_t DominatorTree::immediate_dominator(uint32_t index) const
+{
+    const uint32_t w = dfs_number[index];
+    if (w == kNoIndex || idom[w] == 0)
+    {
+        return kNoIndex;
+    }
+    return vertex[idom[w]];
+}
+
+uint64_t DominatorTree::retained_objects(uint32_t index) const
+{
+    const uint32_t w = dfs_number[index];
+    return w == kNoIndex ? 0 : subtree_objects[w];
+}
+
+uint64_t DominatorTree::retained_edges(uint32_t index) const
+{
+    const uint32_t w = dfs_number[index];
+    return w == kNoIndex ? 0 : subtree_edges[w];
+}
+
+std::vector<DominatorTree::Entry> DominatorTree::top(size_t k) const
+{
+    std::vector<uint32_t> numbers;
+    numbers.reserve(reachable);
+    for (uint32_t w = 1; w < vertex.size(); ++w)
+    {
+        numbers.push_back(w);
+    }
+    auto larger = [this](uint32_t a, uint32_t b) {
+        if (subtree_objects[a] != subtree_objects[b])
+        {
+            return subtree_objects[a] > subtree_objects[b];
+        }
+        if (subtree_edges[a] != subtree_edges[b])
+        {
+            return subtree_edges[a] > subtree_edges[b];
+        }
+        return vertex[a] < vertex[b];
+    };
+    k = std::min(k, numbers.size());
+    std::partial_sort(numbers.begin(), numbers.begin() + k, numbers.end(), larger);
+
+    std::vector<Entry> result;
+    result.reserve(k);
+    for (size_t i = 0; i < k; ++i)
+    {
+        const uint32_t w = numbers[i];
+        result.push_back(Entry{vertex[w], subtree_objects[w], subtree_edges[w]});
+    }
+    return result;
+}
+
+std::string DominatorTree::to_json(size_t k) const
+{
+    std::string out = "{";
+    append_uint(out, "reachable_objects", reachable);
+    out += ", ";
+    append_uint(out, "reachable_edges", reachable_edges);
+    out += ", ";
+    append_uint(out, "unreachable_objects", image.size() - reachable);
+    out += ", \"top\": [";
+    const std::vector<Entry> entries = top(k);
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        const Entry &entry = entries[i];
+        const uint32_t dominator = immediate_dominator(entry.index);
+        out += i == 0 ? "{\"id\": " : ", {\"id\": ";
+        out += std::to_string(image.id(entry.index));
+        out += ", ";
+        append_uint(out, "retained_objects", entry.retained_objects);
+        out += ", ";
+        append_uint(out, "retained_edges", entry.retained_edges);
+        out += ", \"dominator\": ";
+        out += dominator == kNoIndex ? "null" : std::to_string(image.id(dominator));
+        out += "}";
+    }
+    out += "]}";
+    return out;
+}
+
+void DominatorTree::dump(std::ostream &out, size_t k) const
+{
+    out << "=== RETAINED SIZE ===\n";
+    out << "dominator tree: " << reachable << " objects, " << reachable_edges << " edges";
+    if (image.size() > reachable)
+    {
+        out << "; " << image.size() - reachable << " unreachable (leaks)";
+    }
+    out << "\n";
+    const std::vector<Entry> entries = top(k);
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        const Entry &entry = entries[i];
+        const uint32_t dominator = immediate_dominator(entry.index);
+        char line[160];
+        std::snprintf(line, sizeof(line), "  #%-4zu id %-10d retained %-10llu (%5.1f%%) edges %-10llu dominator ", i + 1,
+                      image.id(entry.index), static_cast<unsigned long long>(entry.retained_objects),
+                      100.0 * entry.retained_objects / reachable, static_cast<unsigned long long>(entry.retained_edges));
+        out << line;
+        if (dominator == kNoIndex)
+        {
+            out << "root\n";
+        }
+        else
+        {
+            out << image.id(dominator) << "\n";
+        }
+    }
+    out << "=====================\n\n";
+}
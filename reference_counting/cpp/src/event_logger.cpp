@@ -12,7 +12,8 @@ namespace fs = std::filesystem;
 #endif
 #endif
 
-EventLogger::EventLogger(const std::string &filename)
+EventLogger::EventLogger(const std::string &filename, LogFormat format)
+    : seq(0)
 {
     // Извлечь директорию из пути к файлу
     size_t last_slash = filename.find_last_of("/\\");
@@ -39,22 +40,35 @@ EventLogger::EventLogger(const std::string &filename)
     }
 
     // Открыть файл логов в режиме перезаписи
-    file.open(filename, std::ios::out | std::ios::trunc);
+    if (format == LogFormat::Binary)
+    {
+        sink.reset(new BinaryLogSink(filename));
+    }
+    else
+    {
+        sink.reset(new JsonLinesSink(filename));
+    }
 
-    if (!file.is_open())
+    if (!sink->is_open())
     {
         throw std::runtime_error("Failed to open log file: " + filename);
     }
 }
 
-EventLogger::~EventLogger()
+EventLogger::EventLogger(std::unique_ptr<LogSink> sink_)
+    : sink(std::move(sink_)), seq(0)
 {
-    if (file.is_open())
+    if (!sink || !sink->is_open())
     {
-        file.close();
+        throw std::runtime_error("Log sink is not open");
     }
 }
 
+EventLogger::~EventLogger()
+{
+    // Приёмник сбрасывает буфер и закрывает файл в своём деструкторе
+}
+
 std::string EventLogger::get_timestamp() const
 {
     auto now = std::time(nullptr);
@@ -64,42 +78,44 @@ std::string EventLogger::get_timestamp() const
     return ss.str();
 }
 
-void EventLogger::write(const std::string &json)
-{
-    if (file.is_open())
-    {
-        file << json << "\n";
-        file.flush(); // Убедиться, что данные записаны немедленно
-    }
-}
-
 void EventLogger::log_allocate(int obj_id)
 {
-    write("{\"event\":\"allocate\",\"object\":" + std::to_string(obj_id) + "}");
+    write(EventType::Allocate, obj_id, -1, -1);
 }
 
 void EventLogger::log_add_ref(int from, int to, int new_ref_count)
 {
-    write("{\"event\":\"add_ref\",\"from\":" + std::to_string(from) +
-          ",\"to\":" + std::to_string(to) +
-          ",\"ref_count\":" + std::to_string(new_ref_count) + "}");
+    write(EventType::AddRef, from, to, new_ref_count);
 }
 
 void EventLogger::log_remove_ref(int from, int to, int new_ref_count)
 {
-    write("{\"event\":\"remove_ref\",\"from\":" + std::to_string(from) +
-          ",\"to\":" + std::to_string(to) +
-          ",\"ref_count\":" + std::to_string(new_ref_count) + "}");
+    write(EventType::RemoveRef, from, to, new_ref_count);
 }
 
 void EventLogger::log_delete(int obj_id)
 {
-    write("{\"event\":\"delete\",\"object\":" + std::to_string(obj_id) + "}");
+    write(EventType::Delete, obj_id, -1, -1);
 }
 
 void EventLogger::log_leak(int obj_id)
 {
-    write("{\"event\":\"leak\",\"object\":" + std::to_string(obj_id) + "}");
+    write(EventType::Leak, obj_id, -1, -1);
+}
+
+void EventLogger::log_add_weak_ref(int from, int to, int new_weak_count)
+{
+    write(EventType::AddWeakRef, from, to, new_weak_count);
+}
+
+void EventLogger::log_remove_weak_ref(int from, int to, int new_weak_count)
+{
+    write(EventType::RemoveWeakRef, from, to, new_weak_count);
+}
+
+void EventLogger::log_weak_expire(int obj_id, int weak_count)
+{
+    write(EventType::WeakExpire, obj_id, -1, weak_count);
 }
 
 bool EventLogger::ensure_directory_exists(const std::string &path)
@@ -0,0 +1,218 @@
+#include "graph_generators.h"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+
+#include "rc_heap.h"
+
+namespace
+{
+    /**
+     * @brief Равномерное число в [0, 1) из 53 старших бит генератора
+     */
+    double uniform01(std::mt19937_64 &rng)
+    {
+        return static_cast<double>(rng() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    /**
+     * @brief root_count различных случайных вершин (частичное перемешивание)
+     */
+    std::vector<int> pick_roots(int n, int root_count, std::mt19937_64 &rng)
+    {
+        std::vector<int> ids(n);
+        for (int i = 0; i < n; ++i)
+        {
+            ids[i] = i + 1;
+        }
+        int count = root_count < n ? root_count : n;
+        for (int i = 0; i < count; ++i)
+        {
+            int j = i + static_cast<int>(rng() % static_cast<uint64_t>(n - i));
+            std::swap(ids[i], ids[j]);
+        }
+        ids.resize(count > 0 ? count : 0);
+        return ids;
+    }
+}
+
+std::vector<ScenarioOp> Graph::to_scenario() const
+{
+    std::vector<ScenarioOp> ops;
+    ops.reserve(node_count + edges.size() + roots.size());
+    for (int id = 1; id <= node_count; ++id)
+    {
+        ops.emplace_back(OpCode::Allocate, id);
+    }
+    for (const auto &edge : edges)
+    {
+        ops.emplace_back(OpCode::AddRef, -1, edge.first, edge.second);
+    }
+    for (int root : roots)
+    {
+        ops.emplace_back(OpCode::AddRoot, root);
+    }
+    return ops;
+}
+
+void Graph::load_into(RCHeap &heap) const
+{
+    heap.reserve(heap.get_heap_size() + node_count);
+    for (const ScenarioOp &op : to_scenario())
+    {
+        heap.apply(op);
+    }
+}
+
+void Graph::write_scenario_json(const std::string &filename) const
+{
+    std::FILE *out = std::fopen(filename.c_str(), "w");
+    if (out == nullptr)
+    {
+        throw std::runtime_error("Failed to open scenario file: " + filename);
+    }
+    std::fputs("[", out);
+    bool first = true;
+    for (const ScenarioOp &op : to_scenario())
+    {
+        std::fputs(first ? "\n  " : ",\n  ", out);
+        first = false;
+        if (op.op == OpCode::AddRef)
+        {
+            std::fprintf(out, "{\"op\": \"add_ref\", \"from\": %d, \"to\": %d}", op.from, op.to);
+        }
+        else
+        {
+            std::fprintf(out, "{\"op\": \"%s\", \"id\": %d}", op_code_name(op.op), op.id);
+        }
+    }
+    std::fputs("\n]\n", out);
+    if (std::fclose(out) != 0)
+    {
+        throw std::runtime_error("Failed to write scenario file: " + filename);
+    }
+}
+
+Graph make_chain(int n)
+{
+    Graph graph;
+    graph.name = "chain/n=" + std::to_string(n);
+    graph.node_count = n;
+    graph.edges.reserve(n > 0 ? n - 1 : 0);
+    for (int id = 1; id < n; ++id)
+    {
+        graph.edges.emplace_back(id, id + 1);
+    }
+    if (n > 0)
+    {
+        graph.roots.push_back(1);
+    }
+    return graph;
+}
+
+Graph make_binary_tree(int n)
+{
+    Graph graph;
+    graph.name = "binary_tree/n=" + std::to_string(n);
+    graph.node_count = n;
+    graph.edges.reserve(n > 0 ? n - 1 : 0);
+    for (int id = 2; id <= n; ++id)
+    {
+        graph.edges.emplace_back(id / 2, id);
+    }
+    if (n > 0)
+    {
+        graph.roots.push_back(1);
+    }
+    return graph;
+}
+
+Graph make_erdos_renyi(int n, double p, int root_count, uint64_t seed)
+{
+    Graph graph;
+    char name[96];
+    std::snprintf(name, sizeof(name), "erdos_renyi/n=%d/p=%g", n, p);
+    graph.name = name;
+    graph.node_count = n;
+
+    std::mt19937_64 rng(seed);
+    if (n > 1 && p > 0)
+    {
+        const uint64_t pairs = static_cast<uint64_t>(n) * static_cast<uint64_t>(n - 1);
+        const double log_q = p < 1 ? std::log(1.0 - p) : 0;
+        graph.edges.reserve(static_cast<size_t>(pairs * (p < 1 ? p : 1.0)) + 16);
+        // Номер пары k: from = k / (n-1), to — k % (n-1) со сдвигом мимо from
+        uint64_t k = 0;
+        while (true)
+        {
+            if (p < 1)
+            {
+                double skip = std::floor(std::log(1.0 - uniform01(rng)) / log_q);
+                if (skip >= static_cast<double>(pairs - k))
+                {
+                    break;
+                }
+                k += static_cast<uint64_t>(skip);
+            }
+            if (k >= pairs)
+            {
+                break;
+            }
+            int from = static_cast<int>(k / (n - 1));
+            int to = static_cast<int>(k % (n - 1));
+            to += to >= from ? 1 : 0;
+            graph.edges.emplace_back(from + 1, to + 1);
+            k++;
+        }
+    }
+    graph.roots = pick_roots(n, root_count, rng);
+    return graph;
+}
+
+Graph make_power_law(int n, int m, int root_count, uint64_t seed)
+{
+    Graph graph;
+    graph.name = "power_law/n=" + std::to_string(n) + "/m=" + std::to_string(m);
+    graph.node_count = n;
+    graph.edges.reserve(static_cast<size_t>(n) * (m > 0 ? m : 0));
+
+    std::mt19937_64 rng(seed);
+    // Каждая вершина встречается здесь столько раз, какова её степень:
+    // равномерный выбор из списка — выбор пропорционально степени.
+    // С вероятностью 1/8 цель выбирается равномерно, иначе вершины без
+    // ссылок никогда бы их не получили
+    std::vector<int> endpoints;
+    endpoints.reserve(2 * graph.edges.capacity() + n);
+    std::vector<int> chosen;
+    for (int id = 1; id <= n; ++id)
+    {
+        int existing = id - 1;
+        int links = m < existing ? m : existing;
+        chosen.clear();
+        while (static_cast<int>(chosen.size()) < links)
+        {
+            int target = endpoints.empty() || rng() % 8 == 0
+                             ? 1 + static_cast<int>(rng() % static_cast<uint64_t>(existing))
+                             : endpoints[rng() % endpoints.size()];
+            bool duplicate = false;
+            for (int previous : chosen)
+            {
+                duplicate = duplicate || previous == target;
+            }
+            if (!duplicate)
+            {
+                chosen.push_back(target);
+            }
+        }
+        for (int target : chosen)
+        {
+            graph.edges.emplace_back(id, target);
+            endpoints.push_back(target);
+            endpoints.push_back(id);
+        }
+    }
+    graph.roots = pick_roots(n, root_count, rng);
+    return graph;
+}
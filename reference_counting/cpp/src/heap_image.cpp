@@ -0,0 +1,271 @@
+#include "heap_image.h"
+
+#include <stdexcept>
+#include <utility>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define RC_HEAP_IMAGE_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    size_t count_zero_scalar(const int32_t *counts, size_t n)
+    {
+        size_t total = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            total += counts[i] == 0;
+        }
+        return total;
+    }
+
+    void zero_indices_scalar(const int32_t *counts, size_t begin, size_t n, std::vector<uint32_t> &out)
+    {
+        for (size_t i = begin; i < n; ++i)
+        {
+            if (counts[i] == 0)
+            {
+                out.push_back(static_cast<uint32_t>(i));
+            }
+        }
+    }
+
+#ifdef RC_HEAP_IMAGE_AVX2
+    __attribute__((target("avx2"))) size_t count_zero_avx2(const int32_t *counts, size_t n)
+    {
+        // cmpeq даёт -1 в совпавших полосах: вычитание накапливает число нулей по полосам
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i acc = _mm256_setzero_si256();
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(counts + i));
+            acc = _mm256_sub_epi32(acc, _mm256_cmpeq_epi32(v, zero));
+        }
+        alignas(32) uint32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), acc);
+        size_t total = 0;
+        for (uint32_t lane : lanes)
+        {
+            total += lane;
+        }
+        return total + count_zero_scalar(counts + i, n - i);
+    }
+
+    __attribute__((target("avx2"))) void zero_indices_avx2(const int32_t *counts, size_t n,
+                                                           std::vector<uint32_t> &out)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(counts + i));
+            __m256i equal = _mm256_cmpeq_epi32(v, zero);
+            unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(equal)));
+            while (mask != 0)
+            {
+                out.push_back(static_cast<uint32_t>(i + __builtin_ctz(mask)));
+                mask &= mask - 1;
+            }
+        }
+        zero_indices_scalar(counts, i, n, out);
+    }
+#endif
+
+    unsigned lowest_bit(uint64_t word)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<unsigned>(__builtin_ctzll(word));
+#else
+        unsigned bit = 0;
+        while (((word >> bit) & 1u) == 0)
+        {
+            bit++;
+        }
+        return bit;
+#endif
+    }
+
+    bool use_avx2(ScanKernel kernel)
+    {
+        if (kernel == ScanKernel::Scalar)
+        {
+            return false;
+        }
+        if (kernel == ScanKernel::Avx2 && !HeapImage::avx2_available())
+        {
+            throw std::runtime_error("AVX2 scan kernel is not available on this CPU or build");
+        }
+        return HeapImage::avx2_available();
+    }
+}
+
+HeapImage::HeapImage(const ObjectStore &store, const std::unordered_set<int> &roots)
+{
+    const uint32_t slot_count = store.slot_count();
+    const size_t count = store.size();
+    ids.reserve(count);
+    generations.reserve(count);
+    ref_counts.reserve(count);
+    edge_offsets.reserve(count + 1);
+
+    // Слот -> индекс образа
+    std::vector<uint32_t> index_of(slot_count, kNoIndex);
+    size_t edges = 0;
+    for (uint32_t slot = 0; slot < slot_count; ++slot)
+    {
+        if (store.is_live_slot(slot))
+        {
+            const RCObject &obj = store.at_slot(slot);
+            index_of[slot] = static_cast<uint32_t>(ids.size());
+            ids.push_back(obj.id);
+            generations.push_back(store.generation_at(slot));
+            ref_counts.push_back(obj.ref_count);
+            edges += obj.references.size();
+        }
+    }
+    if (edges > UINT32_MAX)
+    {
+        throw std::length_error("HeapImage: too many references for 32-bit edge offsets");
+    }
+
+    edge_targets.reserve(edges);
+    edge_offsets.push_back(0);
+    for (uint32_t slot = 0; slot < slot_count; ++slot)
+    {
+        if (!store.is_live_slot(slot))
+        {
+            continue;
+        }
+        for (int child_id : store.at_slot(slot).references)
+        {
+            uint32_t child_slot = store.slot_of(child_id);
+            if (child_slot != ObjectStore::kInvalidSlot)
+            {
+                edge_targets.push_back(index_of[child_slot]);
+            }
+        }
+        edge_offsets.push_back(static_cast<uint32_t>(edge_targets.size()));
+    }
+
+    root_indices.reserve(roots.size());
+    for (int root_id : roots)
+    {
+        uint32_t slot = store.slot_of(root_id);
+        if (slot != ObjectStore::kInvalidSlot)
+        {
+            root_indices.push_back(index_of[slot]);
+        }
+    }
+}
+
+HeapImage::HeapImage(std::vector<int32_t> ids_, std::vector<int32_t> ref_counts_, std::vector<uint32_t> edge_offsets_,
+                     std::vector<uint32_t> edge_targets_, std::vector<uint32_t> root_indices_)
+    : ids(std::move(ids_)), generations(ids.size(), 0), ref_counts(std::move(ref_counts_)),
+      edge_offsets(std::move(edge_offsets_)), edge_targets(std::move(edge_targets_)),
+      root_indices(std::move(root_indices_))
+{
+}
+
+size_t HeapImage::count_zero(ScanKernel kernel) const
+{
+#ifdef RC_HEAP_IMAGE_AVX2
+    if (use_avx2(kernel))
+    {
+        return count_zero_avx2(ref_counts.data(), ref_counts.size());
+    }
+#else
+    use_avx2(kernel);
+#endif
+    return count_zero_scalar(ref_counts.data(), ref_counts.size());
+}
+
+void HeapImage::zero_indices(std::vector<uint32_t> &out, ScanKernel kernel) const
+{
+#ifdef RC_HEAP_IMAGE_AVX2
+    if (use_avx2(kernel))
+    {
+        zero_indices_avx2(ref_counts.data(), ref_counts.size(), out);
+        return;
+    }
+#else
+    use_avx2(kernel);
+#endif
+    zero_indices_scalar(ref_counts.data(), 0, ref_counts.size(), out);
+}
+
+size_t HeapImage::mark(MarkBitmap &marks, ScanKernel kernel) const
+{
+    marks.reset(size());
+    std::vector<uint32_t> seeds(root_indices);
+    zero_indices(seeds, kernel);
+
+    // Корень с ref_count == 0 попадает в seeds дважды: set() отсечёт повтор
+    std::vector<uint32_t> stack;
+    for (uint32_t index : seeds)
+    {
+        if (marks.set(index))
+        {
+            stack.push_back(index);
+        }
+    }
+
+    size_t marked = 0;
+    while (!stack.empty())
+    {
+        uint32_t index = stack.back();
+        stack.pop_back();
+        marked++;
+        for (const uint32_t *edge = edges_begin(index); edge != edges_end(index); ++edge)
+        {
+            if (marks.set(*edge))
+            {
+                stack.push_back(*edge);
+            }
+        }
+    }
+    return marked;
+}
+
+std::vector<int> HeapImage::unreachable_ids(ScanKernel kernel) const
+{
+    MarkBitmap marks;
+    mark(marks, kernel);
+
+    std::vector<int> result;
+    const std::vector<uint64_t> &words = marks.words();
+    for (size_t w = 0; w < words.size(); ++w)
+    {
+        // Полностью помеченные слова пропускаются целиком
+        uint64_t unmarked = ~words[w];
+        while (unmarked != 0)
+        {
+            size_t index = w * 64 + lowest_bit(unmarked);
+            if (index >= size())
+            {
+                break;
+            }
+            result.push_back(ids[index]);
+            unmarked &= unmarked - 1;
+        }
+    }
+    return result;
+}
+
+bool HeapImage::avx2_available()
+{
+#ifdef RC_HEAP_IMAGE_AVX2
+    static const bool available = __builtin_cpu_supports("avx2");
+    return available;
+#else
+    return false;
+#endif
+}
+
+size_t HeapImage::memory_usage() const
+{
+    return ids.capacity() * sizeof(int32_t) + generations.capacity() * sizeof(uint32_t) +
+           ref_counts.capacity() * sizeof(int32_t) + edge_offsets.capacity() * sizeof(uint32_t) +
+           edge_targets.capacity() * sizeof(uint32_t) + root_indices.capacity() * sizeof(uint32_t);
+}
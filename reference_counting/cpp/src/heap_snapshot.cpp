@@ -0,0 +1,512 @@
+#include "heap_snapshot.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const size_t kBufferSize = 1 << 20;
+
+    void put16(unsigned char *out, uint16_t value)
+    {
+        out[0] = static_cast<unsigned char>(value);
+        out[1] = static_cast<unsigned char>(value >> 8);
+    }
+
+    void put64(unsigned char *out, uint64_t value)
+    {
+        for (int i = 0; i < 8; ++i)
+        {
+            out[i] = static_cast<unsigned char>(value >> (8 * i));
+        }
+    }
+
+    uint16_t get16(const unsigned char *in)
+    {
+        return static_cast<uint16_t>(in[0] | in[1] << 8);
+    }
+
+    uint32_t get32(const unsigned char *in)
+    {
+        return static_cast<uint32_t>(in[0]) | static_cast<uint32_t>(in[1]) << 8 |
+               static_cast<uint32_t>(in[2]) << 16 | static_cast<uint32_t>(in[3]) << 24;
+    }
+
+    void encode_header(unsigned char *header, uint64_t frame_count)
+    {
+        std::memcpy(header, kSnapshotMagic, sizeof(kSnapshotMagic));
+        put16(header + 4, kSnapshotVersion);
+        put16(header + 6, 0);
+        put64(header + 8, frame_count);
+    }
+}
+
+HeapSnapshotWriter::HeapSnapshotWriter(const std::string &filename)
+    : file(std::fopen(filename.c_str(), "wb")), buffer(kBufferSize), used(0), bytes_written(0), frame_count(0),
+      active(false), frame_mode(SnapshotMode::Full), source(nullptr), cursor(0), written_roots_version(0)
+{
+    if (file == nullptr)
+    {
+        throw std::runtime_error("Failed to open snapshot file: " + filename);
+    }
+    // Количество кадров дописывается в заголовок при закрытии
+    unsigned char header[kSnapshotHeaderSize];
+    encode_header(header, 0);
+    std::fwrite(header, 1, sizeof(header), file);
+    bytes_written = sizeof(header);
+}
+
+HeapSnapshotWriter::~HeapSnapshotWriter()
+{
+    try
+    {
+        close();
+    }
+    catch (const std::exception &)
+    {
+        // Деструктор не бросает: ошибка записи видна только при явном close()
+    }
+}
+
+void HeapSnapshotWriter::close()
+{
+    if (file == nullptr)
+    {
+        return;
+    }
+    flush();
+    unsigned char header[kSnapshotHeaderSize];
+    encode_header(header, frame_count);
+    bool ok = std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(header, 1, sizeof(header), file) == sizeof(header);
+    ok = std::fclose(file) == 0 && ok;
+    file = nullptr;
+    if (!ok)
+    {
+        throw std::runtime_error("Failed to write snapshot file");
+    }
+}
+
+bool HeapSnapshotWriter::step(ObjectStore &store, const std::unordered_set<int> &roots, uint64_t roots_version,
+                              SnapshotMode mode, std::chrono::nanoseconds time_slice)
+{
+    if (file == nullptr)
+    {
+        throw std::runtime_error("Snapshot writer is closed");
+    }
+    if (!active)
+    {
+        begin_frame(store, mode);
+    }
+
+    const bool timed = time_slice.count() > 0;
+    const Clock::time_point deadline = timed ? Clock::now() + time_slice : Clock::time_point();
+    size_t visited = 0;
+
+    // Часы опрашиваются раз в 64 слота
+    if (frame_mode == SnapshotMode::Full)
+    {
+        // Слотов может стать больше, пока кадр пишется: граница читается на каждом шаге
+        while (cursor < store.slot_count())
+        {
+            if (timed && (++visited & 63) == 0 && Clock::now() >= deadline)
+            {
+                return false;
+            }
+            if (store.is_live_slot(cursor))
+            {
+                write_object(store.at_slot(cursor));
+            }
+            cursor++;
+        }
+    }
+    else
+    {
+        while (cursor < pending.size())
+        {
+            if (timed && (++visited & 63) == 0 && Clock::now() >= deadline)
+            {
+                return false;
+            }
+            // Слот мог освободиться: удаление уже записано или попадёт в следующий кадр
+            uint32_t slot = pending[cursor++];
+            if (slot < store.slot_count() && store.is_live_slot(slot))
+            {
+                write_object(store.at_slot(slot));
+            }
+        }
+    }
+
+    if (frame_mode == SnapshotMode::Full || roots_version != written_roots_version)
+    {
+        write_roots(roots);
+        written_roots_version = roots_version;
+    }
+    end_frame(store);
+    return true;
+}
+
+void HeapSnapshotWriter::begin_frame(ObjectStore &store, SnapshotMode mode)
+{
+    // diff имеет смысл только относительно предыдущего кадра с того же хранилища
+    if (source != &store || frame_count == 0 || !store.is_dirty_tracking())
+    {
+        mode = SnapshotMode::Full;
+    }
+    frame_mode = mode;
+    source = &store;
+    active = true;
+    cursor = 0;
+
+    put_u8(kSnapshotFrameBegin);
+    put_u8(mode == SnapshotMode::Full ? 0 : 1);
+    put_u64(frame_count);
+
+    if (mode == SnapshotMode::Full)
+    {
+        // Полный кадр запишет всех; учёт начинается с его начала
+        store.set_dirty_tracking(true);
+        return;
+    }
+
+    store.take_dirty(pending, removed);
+    for (int id : removed)
+    {
+        put_u8(kSnapshotRemove);
+        put_u32(static_cast<uint32_t>(id));
+    }
+}
+
+void HeapSnapshotWriter::write_object(const RCObject &obj)
+{
+    put_u8(kSnapshotObject);
+    put_u32(static_cast<uint32_t>(obj.id));
+    put_u32(static_cast<uint32_t>(obj.ref_count));
+    put_u32(static_cast<uint32_t>(obj.references.size()));
+    for (int child_id : obj.references)
+    {
+        put_u32(static_cast<uint32_t>(child_id));
+    }
+}
+
+void HeapSnapshotWriter::write_roots(const std::unordered_set<int> &roots)
+{
+    put_u8(kSnapshotRoots);
+    put_u32(static_cast<uint32_t>(roots.size()));
+    for (int root : roots)
+    {
+        put_u32(static_cast<uint32_t>(root));
+    }
+}
+
+void HeapSnapshotWriter::end_frame(const ObjectStore &store)
+{
+    put_u8(kSnapshotFrameEnd);
+    put_u64(store.size());
+    active = false;
+    frame_count++;
+}
+
+unsigned char *HeapSnapshotWriter::reserve(size_t bytes)
+{
+    if (used + bytes > buffer.size())
+    {
+        flush();
+    }
+    unsigned char *out = buffer.data() + used;
+    used += bytes;
+    return out;
+}
+
+void HeapSnapshotWriter::put_u32(uint32_t value)
+{
+    unsigned char *out = reserve(4);
+    for (int i = 0; i < 4; ++i)
+    {
+        out[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+}
+
+void HeapSnapshotWriter::put_u64(uint64_t value)
+{
+    put64(reserve(8), value);
+}
+
+void HeapSnapshotWriter::flush()
+{
+    if (used == 0)
+    {
+        return;
+    }
+    if (std::fwrite(buffer.data(), 1, used, file) != used)
+    {
+        throw std::runtime_error("Failed to write snapshot file");
+    }
+    bytes_written += used;
+    used = 0;
+}
+
+HeapSnapshotReader::HeapSnapshotReader(const std::string &filename) : cursor(0), frame_count(0)
+{
+    std::FILE *file = std::fopen(filename.c_str(), "rb");
+    if (file == nullptr)
+    {
+        throw std::runtime_error("Failed to open snapshot file: " + filename);
+    }
+    unsigned char chunk[1 << 16];
+    size_t got;
+    while ((got = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+        data.insert(data.end(), chunk, chunk + got);
+    }
+    std::fclose(file);
+
+    if (data.size() < kSnapshotHeaderSize || std::memcmp(data.data(), kSnapshotMagic, sizeof(kSnapshotMagic)) != 0)
+    {
+        throw std::runtime_error("Not a heap snapshot file: " + filename);
+    }
+    if (get16(data.data() + 4) != kSnapshotVersion)
+    {
+        throw std::runtime_error("Unsupported heap snapshot version in " + filename);
+    }
+    cursor = 8;
+    frame_count = get_u64();
+}
+
+bool HeapSnapshotReader::frame_complete() const
+{
+    size_t pos = cursor;
+    auto has = [&](size_t bytes) { return data.size() - pos >= bytes; };
+    if (!has(10))
+    {
+        return false;
+    }
+    if (data[pos] != kSnapshotFrameBegin)
+    {
+        corrupt();
+    }
+    pos += 10;
+    for (;;)
+    {
+        if (!has(1))
+        {
+            return false;
+        }
+        uint8_t tag = data[pos++];
+        size_t need;
+        switch (tag)
+        {
+        case kSnapshotRemove:
+            need = 4;
+            break;
+        case kSnapshotObject:
+            if (!has(12))
+            {
+                return false;
+            }
+            need = 12 + static_cast<size_t>(get32(data.data() + pos + 8)) * 4;
+            break;
+        case kSnapshotRoots:
+            if (!has(4))
+            {
+                return false;
+            }
+            need = 4 + static_cast<size_t>(get32(data.data() + pos)) * 4;
+            break;
+        case kSnapshotFrameEnd:
+            return has(8);
+        default:
+            corrupt();
+        }
+        if (!has(need))
+        {
+            return false;
+        }
+        pos += need;
+    }
+}
+
+bool HeapSnapshotReader::next_frame()
+{
+    // Кадр применяется, только если он дописан до kSnapshotFrameEnd
+    if (!frame_complete())
+    {
+        return false;
+    }
+
+    cursor++;
+    frame = SnapshotFrame();
+    frame.mode = get_u8() == 0 ? SnapshotMode::Full : SnapshotMode::Diff;
+    frame.number = get_u64();
+    if (frame.mode == SnapshotMode::Full)
+    {
+        objects.clear();
+        roots.clear();
+    }
+    for (;;)
+    {
+        uint8_t tag = get_u8();
+        if (tag == kSnapshotFrameEnd)
+        {
+            frame.heap_size = get_u64();
+            return true;
+        }
+        if (tag == kSnapshotRemove)
+        {
+            int id = static_cast<int32_t>(get_u32());
+            objects.erase(id);
+            frame.removed.push_back(id);
+        }
+        else if (tag == kSnapshotObject)
+        {
+            int id = static_cast<int32_t>(get_u32());
+            SnapshotObject &obj = objects[id];
+            obj.ref_count = static_cast<int32_t>(get_u32());
+            obj.references.resize(get_u32());
+            for (int &child_id : obj.references)
+            {
+                child_id = static_cast<int32_t>(get_u32());
+            }
+            frame.written.push_back(id);
+        }
+        else
+        {
+            roots.resize(get_u32());
+            for (int &root : roots)
+            {
+                root = static_cast<int32_t>(get_u32());
+            }
+            frame.roots_written = true;
+        }
+    }
+}
+
+HeapImage HeapSnapshotReader::capture_image() const
+{
+    std::vector<int32_t> ids;
+    std::vector<int32_t> ref_counts;
+    ids.reserve(objects.size());
+    ref_counts.reserve(objects.size());
+    size_t edges = 0;
+    for (const auto &entry : objects)
+    {
+        ids.push_back(entry.first);
+        ref_counts.push_back(entry.second.ref_count);
+        edges += entry.second.references.size();
+    }
+    if (edges > UINT32_MAX)
+    {
+        throw std::length_error("HeapImage: too many references for 32-bit edge offsets");
+    }
+
+    // ids упорядочены (objects — std::map), поэтому ID -> индекс двоичным поиском
+    auto index_of = [&ids](int id) {
+        auto it = std::lower_bound(ids.begin(), ids.end(), id);
+        return it != ids.end() && *it == id ? static_cast<uint32_t>(it - ids.begin()) : HeapImage::kNoIndex;
+    };
+    std::vector<uint32_t> edge_offsets;
+    std::vector<uint32_t> edge_targets;
+    edge_offsets.reserve(objects.size() + 1);
+    edge_targets.reserve(edges);
+    edge_offsets.push_back(0);
+    for (const auto &entry : objects)
+    {
+        for (int child_id : entry.second.references)
+        {
+            uint32_t child = index_of(child_id);
+            if (child != HeapImage::kNoIndex)
+            {
+                edge_targets.push_back(child);
+            }
+        }
+        edge_offsets.push_back(static_cast<uint32_t>(edge_targets.size()));
+    }
+
+    std::vector<uint32_t> root_indices;
+    for (int root_id : roots)
+    {
+        uint32_t root = index_of(root_id);
+        if (root != HeapImage::kNoIndex)
+        {
+            root_indices.push_back(root);
+        }
+    }
+    return HeapImage(std::move(ids), std::move(ref_counts), std::move(edge_offsets), std::move(edge_targets),
+                     std::move(root_indices));
+}
+
+void HeapSnapshotReader::dump(std::ostream &out) const
+{
+    out << "=== HEAP STATE ===\n";
+    out << "ROOTS: ";
+    if (roots.empty())
+    {
+        out << "[none]";
+    }
+    else
+    {
+        for (int root : roots)
+        {
+            out << root << " ";
+        }
+    }
+    out << "\n\n";
+
+    if (objects.empty())
+    {
+        out << "[empty]\n";
+    }
+    else
+    {
+        for (const auto &entry : objects)
+        {
+            out << "Object " << entry.first << " | ref_count=" << entry.second.ref_count << " | refs: ";
+            for (int ref : entry.second.references)
+            {
+                out << ref << " ";
+            }
+            out << "\n";
+        }
+    }
+    out << "=================\n\n";
+}
+
+bool HeapSnapshotReader::is_snapshot(const std::string &filename)
+{
+    std::FILE *file = std::fopen(filename.c_str(), "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+    char magic[sizeof(kSnapshotMagic)];
+    bool match = std::fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                 std::memcmp(magic, kSnapshotMagic, sizeof(magic)) == 0;
+    std::fclose(file);
+    return match;
+}
+
+uint32_t HeapSnapshotReader::get_u32()
+{
+    uint32_t value = get32(data.data() + cursor);
+    cursor += 4;
+    return value;
+}
+
+uint64_t HeapSnapshotReader::get_u64()
+{
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i)
+    {
+        value = value << 8 | data[cursor + i];
+    }
+    cursor += 8;
+    return value;
+}
+
+void HeapSnapshotReader::corrupt() const
+{
+    throw std::runtime_error("Corrupted heap snapshot at offset " + std::to_string(cursor));
+}
@@ -0,0 +1,100 @@
+#include "heap_view.h"
+
+#include <unordered_map>
+#include <utility>
+
+HeapView::HeapView(ObjectStore objects_, std::shared_ptr<const std::unordered_set<int>> roots_)
+    : objects(std::move(objects_)), roots(std::move(roots_))
+{
+}
+
+int HeapView::get_ref_count(int obj_id) const
+{
+    uint32_t slot = objects.slot_of(obj_id);
+    return slot == ObjectStore::kInvalidSlot ? -1 : objects.at_slot(slot).ref_count;
+}
+
+bool HeapView::is_reachable(int obj_id) const
+{
+    uint32_t target = objects.slot_of(obj_id);
+    if (target == ObjectStore::kInvalidSlot)
+    {
+        return false;
+    }
+
+    std::unordered_set<uint32_t> visited;
+    std::vector<uint32_t> stack;
+    for (int root_id : *roots)
+    {
+        uint32_t slot = objects.slot_of(root_id);
+        if (slot != ObjectStore::kInvalidSlot && visited.insert(slot).second)
+        {
+            stack.push_back(slot);
+        }
+    }
+
+    while (!stack.empty())
+    {
+        uint32_t slot = stack.back();
+        stack.pop_back();
+        if (slot == target)
+        {
+            return true;
+        }
+        for (int child_id : objects.at_slot(slot).references)
+        {
+            uint32_t child_slot = objects.slot_of(child_id);
+            if (child_slot != ObjectStore::kInvalidSlot && visited.insert(child_slot).second)
+            {
+                stack.push_back(child_slot);
+            }
+        }
+    }
+    return false;
+}
+
+bool HeapView::has_cycle(int start_id) const
+{
+    uint32_t start = objects.slot_of(start_id);
+    if (start == ObjectStore::kInvalidSlot)
+    {
+        return false;
+    }
+
+    // Серый — объект на пути DFS, чёрный — обойдён полностью
+    enum : uint8_t { Gray = 1, Black = 2 };
+    std::unordered_map<uint32_t, uint8_t> color;
+    // Слот и позиция следующей ссылки для просмотра
+    std::vector<std::pair<uint32_t, size_t>> path;
+    color[start] = Gray;
+    path.emplace_back(start, 0);
+
+    while (!path.empty())
+    {
+        const RCObject &current = objects.at_slot(path.back().first);
+        size_t &next = path.back().second;
+        if (next == current.references.size())
+        {
+            color[path.back().first] = Black;
+            path.pop_back();
+            continue;
+        }
+
+        uint32_t child_slot = objects.slot_of(current.references.begin()[next++]);
+        if (child_slot == ObjectStore::kInvalidSlot)
+        {
+            continue;
+        }
+        uint8_t &child_color = color[child_slot];
+        if (child_color == Gray)
+        {
+            return true;
+        }
+        if (child_color == 0)
+        {
+            child_color = Gray;
+            path.emplace_back(child_slot, 0);
+        }
+    }
+    return false;
+}
@@ -0,0 +1,273 @@
+#include "leak_report.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <ostream>
+#include <utility>
+
+#include "mark_bitmap.h"
+
+namespace
+{
+    const uint32_t kNone = UINT32_MAX;
+    const uint32_t kShared = UINT32_MAX - 1; ///< Компонента достижима из нескольких источников
+
+    void append_uint(std::string &out, const char *key, uint64_t value)
+    {
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), "\"%s\": %llu", key, static_cast<unsigned long long>(value));
+        out += buffer;
+    }
+
+    /**
+     * Компоненты сильной связности непомеченных объектов (итеративный Тарьян)
+     *
+     * Члены компоненты c — nodes[offsets[c] .. offsets[c + 1]). Компоненты
+     * нумеруются в порядке завершения: все ссылки между компонентами ведут
+     * от большего номера к меньшему.
+     */
+    struct Components
+    {
+        std::vector<uint32_t> of;      ///< Индекс образа -> компонента (kNone у помеченных)
+        std::vector<uint32_t> nodes;
+        std::vector<uint32_t> offsets;
+
+        uint32_t count() const { return static_cast<uint32_t>(offsets.size() - 1); }
+        uint32_t size(uint32_t c) const { return offsets[c + 1] - offsets[c]; }
+    };
+
+    void find_components(const HeapImage &image, const MarkBitmap &marks, Components &out)
+    {
+        const uint32_t n = static_cast<uint32_t>(image.size());
+        out.of.assign(n, kNone);
+        out.offsets.assign(1, 0);
+
+        // order == 0 — не посещён; посещённый без компоненты лежит на стеке Тарьяна
+        std::vector<uint32_t> order(n, 0);
+        std::vector<uint32_t> low(n, 0);
+        std::vector<uint32_t> stack;
+        std::vector<std::pair<uint32_t, const uint32_t *>> path; ///< Объект и следующая ссылка
+        uint32_t counter = 0;
+
+        for (uint32_t start = 0; start < n; ++start)
+        {
+            if (marks.test(start) || order[start] != 0)
+            {
+                continue;
+            }
+            order[start] = low[start] = ++counter;
+            stack.push_back(start);
+            path.emplace_back(start, image.edges_begin(start));
+
+            while (!path.empty())
+            {
+                const uint32_t node = path.back().first;
+                const uint32_t *&next = path.back().second;
+                if (next != image.edges_end(node))
+                {
+                    const uint32_t child = *next++;
+                    if (marks.test(child))
+                    {
+                        continue;
+                    }
+                    if (order[child] == 0)
+                    {
+                        order[child] = low[child] = ++counter;
+                        stack.push_back(child);
+                        path.emplace_back(child, image.edges_begin(child));
+                    }
+                    else if (out.of[child] == kNone)
+                    {
+                        low[node] = std::min(low[node], order[child]);
+                    }
+                    continue;
+                }
+
+                path.pop_back();
+                if (!path.empty())
+                {
+                    uint32_t &parent_low = low[path.back().first];
+                    parent_low = std::min(parent_low, low[node]);
+                }
+                if (low[node] != order[node])
+                {
+                    continue;
+                }
+                const uint32_t component = out.count();
+                uint32_t member;
+                do
+                {
+                    member = stack.back();
+                    stack.pop_back();
+                    out.of[member] = component;
+                    out.nodes.push_back(member);
+                } while (member != node);
+                out.offsets.push_back(static_cast<uint32_t>(out.nodes.size()));
+            }
+        }
+    }
+}
+
+LeakReport LeakReport::analyze(const HeapImage &image)
+{
+    LeakReport report;
+    MarkBitmap marks;
+    image.mark(marks);
+
+    Components components;
+    find_components(image, marks, components);
+
+    // Проход в топологическом порядке (источники первыми): к моменту обработки
+    // компоненты все ссылки в неё уже просмотрены, и её владелец известен
+    const uint32_t count = components.count();
+    std::vector<uint32_t> owner(count, kNone); ///< Номер группы, kShared или kNone
+    for (uint32_t c = count; c-- > 0;)
+    {
+        const uint32_t size = components.size(c);
+        const uint32_t *members = components.nodes.data() + components.offsets[c];
+        const bool source = owner[c] == kNone;
+        if (source)
+        {
+            owner[c] = static_cast<uint32_t>(report.groups.size());
+            report.groups.emplace_back();
+            LeakGroup &group = report.groups.back();
+            group.cycle.reserve(size);
+            for (uint32_t i = 0; i < size; ++i)
+            {
+                group.cycle.push_back(image.id(members[i]));
+            }
+            std::sort(group.cycle.begin(), group.cycle.end());
+        }
+        const uint32_t group = owner[c];
+
+        uint64_t edges = 0;
+        uint64_t internal = 0;
+        for (uint32_t i = 0; i < size; ++i)
+        {
+            const uint32_t node = members[i];
+            edges += image.edges_end(node) - image.edges_begin(node);
+            for (const uint32_t *edge = image.edges_begin(node); edge != image.edges_end(node); ++edge)
+            {
+                const uint32_t target = components.of[*edge];
+                if (target == c)
+                {
+                    internal++;
+                }
+                else if (target != kNone && owner[target] != group)
+                {
+                    owner[target] = owner[target] == kNone ? group : kShared;
+                }
+            }
+        }
+
+        report.leaked_objects += size;
+        report.leaked_edges += edges;
+        report.cycles += size > 1;
+        if (group == kShared)
+        {
+            report.shared_objects += size;
+            report.shared_edges += edges;
+            continue;
+        }
+        LeakGroup &target = report.groups[group];
+        target.retained_objects += size;
+        target.retained_edges += edges;
+        if (source)
+        {
+            target.cycle_edges = internal;
+        }
+        else
+        {
+            target.nested_cycles += size > 1;
+        }
+    }
+
+    std::sort(report.groups.begin(), report.groups.end(), [](const LeakGroup &a, const LeakGroup &b) {
+        if (a.retained_objects != b.retained_objects)
+        {
+            return a.retained_objects > b.retained_objects;
+        }
+        if (a.retained_edges != b.retained_edges)
+        {
+            return a.retained_edges > b.retained_edges;
+        }
+        return a.cycle.front() < b.cycle.front();
+    });
+    return report;
+}
+
+std::string LeakReport::to_json() const
+{
+    std::string out = "{";
+    append_uint(out, "leaked_objects", leaked_objects);
+    out += ", ";
+    append_uint(out, "leaked_edges", leaked_edges);
+    out += ", ";
+    append_uint(out, "cycles", cycles);
+    out += ", ";
+    append_uint(out, "shared_objects", shared_objects);
+    out += ", ";
+    append_uint(out, "shared_edges", shared_edges);
+    out += ", \"groups\": [";
+    for (size_t i = 0; i < groups.size(); ++i)
+    {
+        const LeakGroup &group = groups[i];
+        out += i == 0 ? "{" : ", {";
+        append_uint(out, "cycle_size", group.cycle.size());
+        out += ", ";
+        append_uint(out, "cycle_edges", group.cycle_edges);
+        out += ", ";
+        append_uint(out, "retained_objects", group.retained_objects);
+        out += ", ";
+        append_uint(out, "retained_edges", group.retained_edges);
+        out += ", ";
+        append_uint(out, "nested_cycles", group.nested_cycles);
+        out += ", \"cycle\": [";
+        const size_t shown = std::min(group.cycle.size(), kSampleIds);
+        for (size_t j = 0; j < shown; ++j)
+        {
+            if (j > 0)
+            {
+                out += ", ";
+            }
+            out += std::to_string(group.cycle[j]);
+        }
+        out += "]}";
+    }
+    out += "]}";
+    return out;
+}
+
+void LeakReport::dump(std::ostream &out, size_t limit) const
+{
+    out << "=== LEAK REPORT ===\n";
+    out << "leaked: " << leaked_objects << " objects, " << leaked_edges << " edges in " << groups.size()
+        << " groups (" << cycles << " cycles)\n";
+    if (shared_objects > 0)
+    {
+        out << "shared between groups: " << shared_objects << " objects, " << shared_edges << " edges\n";
+    }
+    const size_t shown = std::min(groups.size(), limit);
+    for (size_t i = 0; i < shown; ++i)
+    {
+        const LeakGroup &group = groups[i];
+        char line[160];
+        std::snprintf(line, sizeof(line), "  #%-4zu retained %-10llu edges %-10llu cycle %-8zu (%llu edges) nested %-6llu ids",
+                      i + 1, static_cast<unsigned long long>(group.retained_objects),
+                      static_cast<unsigned long long>(group.retained_edges), group.cycle.size(),
+                      static_cast<unsigned long long>(group.cycle_edges),
+                      static_cast<unsigned long long>(group.nested_cycles));
+        out << line;
+        const size_t ids = std::min(group.cycle.size(), kSampleIds);
+        for (size_t j = 0; j < ids; ++j)
+        {
+            out << ' ' << group.cycle[j];
+        }
+        out << (ids < group.cycle.size() ? " ...\n" : "\n");
+    }
+    if (shown < groups.size())
+    {
+        out << "  ... " << groups.size() - shown << " more groups\n";
+    }
+    out << "===================\n\n";
+}
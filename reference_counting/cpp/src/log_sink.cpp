@@ -0,0 +1,228 @@
+#include "log_sink.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    const unsigned char kMagic[4] = {'R', 'C', 'E', 'V'};
+    constexpr uint32_t kFormatVersion = 1;
+    constexpr size_t kHeaderSize = 12; ///< Магия, версия, размер записи
+
+    uint32_t get32(const unsigned char *in)
+    {
+        return static_cast<uint32_t>(in[0]) |
+               static_cast<uint32_t>(in[1]) << 8 |
+               static_cast<uint32_t>(in[2]) << 16 |
+               static_cast<uint32_t>(in[3]) << 24;
+    }
+
+    /**
+     * @brief Записать десятичное число со знаком, вернуть указатель за последней цифрой
+     */
+    char *put_int(char *out, int32_t value)
+    {
+        uint32_t magnitude = static_cast<uint32_t>(value);
+        if (value < 0)
+        {
+            *out++ = '-';
+            magnitude = 0u - magnitude;
+        }
+        char digits[10];
+        int n = 0;
+        do
+        {
+            digits[n++] = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude != 0);
+        while (n > 0)
+        {
+            *out++ = digits[--n];
+        }
+        return out;
+    }
+
+    char *put_str(char *out, const char *text)
+    {
+        size_t len = std::strlen(text);
+        std::memcpy(out, text, len);
+        return out + len;
+    }
+
+    const char *event_name(EventType type)
+    {
+        switch (type)
+        {
+        case EventType::Allocate:
+            return "allocate";
+        case EventType::AddRef:
+            return "add_ref";
+        case EventType::RemoveRef:
+            return "remove_ref";
+        case EventType::Delete:
+            return "delete";
+        case EventType::Leak:
+            return "leak";
+        case EventType::AddWeakRef:
+            return "add_weak_ref";
+        case EventType::RemoveWeakRef:
+            return "remove_weak_ref";
+        case EventType::WeakExpire:
+            return "weak_expire";
+        }
+        return "unknown";
+    }
+}
+
+size_t format_json_record(const LogRecord &record, char *out)
+{
+    char *p = put_str(out, "{\"event\":\"");
+    p = put_str(p, event_name(record.type));
+    if (record.type == EventType::AddRef || record.type == EventType::RemoveRef)
+    {
+        p = put_str(p, "\",\"from\":");
+        p = put_int(p, record.from);
+        p = put_str(p, ",\"to\":");
+        p = put_int(p, record.to);
+        p = put_str(p, ",\"ref_count\":");
+        p = put_int(p, record.ref_count);
+    }
+    else if (record.type == EventType::AddWeakRef || record.type == EventType::RemoveWeakRef)
+    {
+        p = put_str(p, "\",\"from\":");
+        p = put_int(p, record.from);
+        p = put_str(p, ",\"to\":");
+        p = put_int(p, record.to);
+        p = put_str(p, ",\"weak_count\":");
+        p = put_int(p, record.ref_count);
+    }
+    else if (record.type == EventType::WeakExpire)
+    {
+        p = put_str(p, "\",\"object\":");
+        p = put_int(p, record.from);
+        p = put_str(p, ",\"weak_count\":");
+        p = put_int(p, record.ref_count);
+    }
+    else
+    {
+        p = put_str(p, "\",\"object\":");
+        p = put_int(p, record.from);
+    }
+    *p++ = '}';
+    return static_cast<size_t>(p - out);
+}
+
+JsonLinesSink::JsonLinesSink(const std::string &filename)
+{
+    file.open(filename, std::ios::out | std::ios::trunc);
+}
+
+void JsonLinesSink::write(const LogRecord &record)
+{
+    if (file.is_open())
+    {
+        char line[kJsonRecordMax];
+        size_t len = format_json_record(record, line);
+        line[len++] = '\n';
+        file.write(line, static_cast<std::streamsize>(len));
+        file.flush(); // Убедиться, что данные записаны немедленно
+    }
+}
+
+void JsonLinesSink::sync()
+{
+    if (file.is_open())
+    {
+        file.flush();
+    }
+}
+
+BinaryLogSink::BinaryLogSink(const std::string &filename, size_t buffer_bytes)
+    : file(std::fopen(filename.c_str(), "wb")), used(0)
+{
+    // Буфер вмещает хотя бы одну запись и целое их число
+    size_t records = buffer_bytes / kRecordSize;
+    buffer.resize((records > 0 ? records : 1) * kRecordSize);
+
+    if (file != nullptr)
+    {
+        unsigned char header[kHeaderSize];
+        std::memcpy(header, kMagic, sizeof(kMagic));
+        put32(header + 4, kFormatVersion);
+        put32(header + 8, static_cast<uint32_t>(kRecordSize));
+        std::fwrite(header, 1, sizeof(header), file);
+    }
+}
+
+BinaryLogSink::~BinaryLogSink()
+{
+    if (file != nullptr)
+    {
+        sync();
+        std::fclose(file);
+    }
+}
+
+void BinaryLogSink::sync()
+{
+    if (file != nullptr && used > 0)
+    {
+        std::fwrite(buffer.data(), 1, used, file);
+        std::fflush(file);
+    }
+    used = 0;
+}
+
+LogRecord BinaryLogSink::decode(const unsigned char *in)
+{
+    LogRecord record;
+    record.type = static_cast<EventType>(get32(in));
+    record.from = static_cast<int32_t>(get32(in + 4));
+    record.to = static_cast<int32_t>(get32(in + 8));
+    record.ref_count = static_cast<int32_t>(get32(in + 12));
+    record.seq = static_cast<uint64_t>(get32(in + 16)) | static_cast<uint64_t>(get32(in + 20)) << 32;
+    return record;
+}
+
+BinaryLogReader::BinaryLogReader(const std::string &filename)
+    : file(std::fopen(filename.c_str(), "rb")), buffer(BinaryLogSink::kRecordSize * 4096), pos(0), filled(0)
+{
+    if (file == nullptr)
+    {
+        throw std::runtime_error("Failed to open log file: " + filename);
+    }
+
+    unsigned char header[kHeaderSize];
+    if (std::fread(header, 1, sizeof(header), file) != sizeof(header) ||
+        std::memcmp(header, kMagic, sizeof(kMagic)) != 0 ||
+        get32(header + 4) != kFormatVersion ||
+        get32(header + 8) != BinaryLogSink::kRecordSize)
+    {
+        std::fclose(file);
+        throw std::runtime_error("Not a binary event log: " + filename);
+    }
+}
+
+BinaryLogReader::~BinaryLogReader()
+{
+    std::fclose(file);
+}
+
+bool BinaryLogReader::next(LogRecord &record)
+{
+    if (filled - pos < BinaryLogSink::kRecordSize)
+    {
+        // Перенести хвост неполной записи в начало и дочитать буфер
+        size_t tail = filled - pos;
+        std::memmove(buffer.data(), buffer.data() + pos, tail);
+        filled = tail + std::fread(buffer.data() + tail, 1, buffer.size() - tail, file);
+        pos = 0;
+        if (filled < BinaryLogSink::kRecordSize)
+        {
+            return false;
+        }
+    }
+    record = BinaryLogSink::decode(buffer.data() + pos);
+    pos += BinaryLogSink::kRecordSize;
+    return true;
+}
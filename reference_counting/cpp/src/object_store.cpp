@@ -0,0 +1,219 @@
+#include "object_store.h"
+
+#include <algorithm>
+
+namespace
+{
+    // Плотная таблица ID -> слот растёт только пока ID остаются компактными:
+    // новый ID должен быть меньше kDenseIdFloor или учетверённого количества
+    // живых объектов. Таблица растёт удвоением, чтобы перенос из хеш-индекса
+    // выполнялся логарифмическое число раз.
+    constexpr size_t kDenseIdFloor = 1u << 16;
+}
+
+RCObject *ObjectStore::emplace(int id)
+{
+    if (id < 0 || contains(id))
+    {
+        return nullptr;
+    }
+
+    uint32_t slot;
+    if (!free_slots.empty())
+    {
+        slot = free_slots.back();
+        free_slots.pop_back();
+        slots[slot] = RCObject(id);
+    }
+    else
+    {
+        slot = static_cast<uint32_t>(slots.size());
+        slots.push_back(RCObject(id));
+        generations.push_back(0);
+    }
+
+    set_index(id, slot);
+    live_count++;
+    if (dirty_tracking)
+    {
+        mark_dirty(slot);
+    }
+    for (ObjectStoreListener *listener : listeners)
+    {
+        listener->on_emplace(slot);
+    }
+    return &slots[slot];
+}
+
+bool ObjectStore::erase(int id)
+{
+    uint32_t slot = slot_of(id);
+    if (slot == kInvalidSlot)
+    {
+        return false;
+    }
+
+    for (ObjectStoreListener *listener : listeners)
+    {
+        listener->on_erase(slot, slots[slot]);
+    }
+    clear_index(id);
+
+    // Сбросить слот (освобождает список ссылок) и сделать старые дескрипторы недействительными
+    slots[slot] = RCObject();
+    generations[slot]++;
+    free_slots.push_back(slot);
+    live_count--;
+    if (dirty_tracking)
+    {
+        removed_ids.push_back(id);
+    }
+    return true;
+}
+
+void ObjectStore::add_listener(ObjectStoreListener *listener)
+{
+    listeners.push_back(listener);
+}
+
+void ObjectStore::remove_listener(ObjectStoreListener *listener)
+{
+    listeners.erase(std::remove(listeners.begin(), listeners.end(), listener), listeners.end());
+}
+
+ObjectStore ObjectStore::snapshot()
+{
+    ObjectStore view;
+    view.slots = slots.share();
+    view.generations = generations.share();
+    view.dense_index = dense_index.share();
+    view.sparse_index = sparse_index;
+    view.live_count = live_count;
+    return view;
+}
+
+size_t ObjectStore::unshared_memory_usage() const
+{
+    size_t bytes = 0;
+    for (size_t chunk = 0; chunk < slots.chunk_count(); ++chunk)
+    {
+        if (slots.is_chunk_shared(chunk))
+        {
+            continue;
+        }
+        bytes += kSlotChunkSize * sizeof(RCObject);
+        size_t end = std::min(slots.size(), (chunk + 1) * kSlotChunkSize);
+        for (size_t slot = chunk * kSlotChunkSize; slot < end; ++slot)
+        {
+            bytes += slots[slot].references.memory_usage();
+        }
+    }
+    for (size_t chunk = 0; chunk < generations.chunk_count(); ++chunk)
+    {
+        bytes += generations.is_chunk_shared(chunk) ? 0 : decltype(generations)::kChunkSize * sizeof(uint32_t);
+    }
+    for (size_t chunk = 0; chunk < dense_index.chunk_count(); ++chunk)
+    {
+        bytes += dense_index.is_chunk_shared(chunk) ? 0 : decltype(dense_index)::kChunkSize * sizeof(uint32_t);
+    }
+    return bytes;
+}
+
+void ObjectStore::take_dirty(std::vector<uint32_t> &dirty, std::vector<int> &removed)
+{
+    for (uint32_t slot : dirty_slots)
+    {
+        dirty_flags[slot] = 0;
+    }
+    dirty.swap(dirty_slots);
+    removed.swap(removed_ids);
+    dirty_slots.clear();
+    removed_ids.clear();
+}
+
+void ObjectStore::clear_dirty()
+{
+    for (uint32_t slot : dirty_slots)
+    {
+        dirty_flags[slot] = 0;
+    }
+    dirty_slots.clear();
+    removed_ids.clear();
+}
+
+void ObjectStore::reserve(size_t count)
+{
+    slots.reserve(count);
+    generations.reserve(count);
+}
+
+size_t ObjectStore::memory_usage() const
+{
+    size_t bytes = slots.memory_usage() +
+                   generations.memory_usage() +
+                   free_slots.capacity() * sizeof(uint32_t) +
+                   dense_index.memory_usage();
+
+    // Узлы хеш-индекса: пара ключ/значение + указатель next, плюс массив бакетов
+    bytes += sparse_index->size() * (sizeof(std::pair<const int, uint32_t>) + sizeof(void *)) +
+             sparse_index->bucket_count() * sizeof(void *);
+
+    for (size_t slot = 0; slot < slots.size(); ++slot)
+    {
+        bytes += slots[slot].references.memory_usage();
+    }
+    return bytes;
+}
+
+void ObjectStore::set_index(int id, uint32_t slot)
+{
+    size_t key = static_cast<size_t>(id);
+    if (key < dense_index.size())
+    {
+        dense_index[key] = slot;
+        return;
+    }
+
+    size_t limit = std::max(kDenseIdFloor, 4 * (live_count + 1));
+    if (key >= limit)
+    {
+        sparse_for_write()[id] = slot;
+        return;
+    }
+
+    // Расширить плотную таблицу и перенести в неё попавшие в диапазон разреженные ID
+    size_t new_size = std::max(key + 1, 2 * dense_index.size());
+    dense_index.grow(new_size, kInvalidSlot);
+    if (sparse_index->empty())
+    {
+        dense_index[key] = slot;
+        return;
+    }
+    SparseIndex &sparse = sparse_for_write();
+    for (auto it = sparse.begin(); it != sparse.end();)
+    {
+        if (static_cast<size_t>(it->first) < new_size)
+        {
+            dense_index[it->first] = it->second;
+            it = sparse.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    dense_index[key] = slot;
+}
+
+void ObjectStore::clear_index(int id)
+{
+    size_t key = static_cast<size_t>(id);
+    if (key < dense_index.size())
+    {
+        dense_index[key] = kInvalidSlot;
+    }
+    else
+    {
+        sparse_for_write().erase(id);
+    }
+}
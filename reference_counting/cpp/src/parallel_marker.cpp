@@ -0,0 +1,180 @@
+#include "parallel_marker.h"
+
+#include <algorithm>
+#include <thread>
+
+ParallelMarker::ParallelMarker(const ObjectStore &heap_, unsigned threads)
+    : heap(heap_), thread_count(1)
+{
+    set_thread_count(threads);
+}
+
+void ParallelMarker::set_thread_count(unsigned threads)
+{
+    if (threads == 0)
+    {
+        threads = std::thread::hardware_concurrency();
+    }
+    thread_count = threads > 0 ? threads : 1;
+}
+
+size_t ParallelMarker::mark(const std::unordered_set<int> &roots, MarkBitmap &out)
+{
+    marks.reset(heap.slot_count());
+    idle.store(0, std::memory_order_relaxed);
+
+    // Деки пересоздаются: от прошлой пометки в них могли остаться выросшие буферы
+    deques.clear();
+    for (unsigned i = 0; i < thread_count; ++i)
+    {
+        deques.emplace_back(new WorkStealingDeque());
+    }
+
+    size_t marked = 0;
+    if (thread_count == 1)
+    {
+        marked = run_worker(0, roots);
+    }
+    else
+    {
+        std::vector<size_t> counts(thread_count, 0);
+        std::vector<std::thread> workers;
+        workers.reserve(thread_count - 1);
+        for (unsigned i = 1; i < thread_count; ++i)
+        {
+            workers.emplace_back([this, i, &roots, &counts]
+                                 { counts[i] = run_worker(i, roots); });
+        }
+        counts[0] = run_worker(0, roots);
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+        for (size_t count : counts)
+        {
+            marked += count;
+        }
+    }
+
+    out.copy_from(marks);
+    return marked;
+}
+
+size_t ParallelMarker::run_worker(unsigned index, const std::unordered_set<int> &roots)
+{
+    WorkStealingDeque &own = *deques[index];
+    // Горячая работа живёт в приватном стеке без атомарных операций; в дек
+    // (доступный ворам) часть стека выкладывается, только когда дек опустел
+    std::vector<uint32_t> local;
+    const uint32_t slot_count = heap.slot_count();
+
+    // Явные корни засевает поток 0
+    if (index == 0)
+    {
+        for (int root_id : roots)
+        {
+            uint32_t slot = heap.slot_of(root_id);
+            if (slot != ObjectStore::kInvalidSlot)
+            {
+                push(local, slot);
+            }
+        }
+    }
+
+    // Неявные корни: каждый поток просматривает свою полосу слотов
+    uint32_t stripe = slot_count / thread_count + 1;
+    uint32_t begin = std::min<uint64_t>(uint64_t(stripe) * index, slot_count);
+    uint32_t end = std::min<uint64_t>(uint64_t(begin) + stripe, slot_count);
+    for (uint32_t slot = begin; slot < end; ++slot)
+    {
+        if (heap.is_live_slot(slot) && heap.at_slot(slot).ref_count == 0)
+        {
+            push(local, slot);
+        }
+    }
+
+    size_t marked = 0;
+    uint32_t slot;
+    for (;;)
+    {
+        for (;;)
+        {
+            if (!local.empty())
+            {
+                slot = local.back();
+                local.pop_back();
+            }
+            else if (!own.pop(slot) && !steal(index, slot))
+            {
+                break;
+            }
+
+            marked++;
+            for (int child_id : heap.at_slot(slot).references)
+            {
+                uint32_t child_slot = heap.slot_of(child_id);
+                if (child_slot != ObjectStore::kInvalidSlot)
+                {
+                    push(local, child_slot);
+                }
+            }
+
+            if (local.size() > 1 && thread_count > 1 && own.looks_empty())
+            {
+                share(local, own);
+            }
+        }
+
+        // Работы нет: ждём, пока она появится у других или все потоки не опустеют.
+        // Свой стек и дек пусты, а пополняет их только сам поток, поэтому
+        // работа может появиться лишь в чужих деках.
+        idle.fetch_add(1, std::memory_order_acq_rel);
+        for (;;)
+        {
+            if (idle.load(std::memory_order_acquire) == thread_count)
+            {
+                return marked;
+            }
+            bool work_seen = false;
+            for (unsigned i = 0; i < thread_count; ++i)
+            {
+                if (i != index && !deques[i]->looks_empty())
+                {
+                    work_seen = true;
+                    break;
+                }
+            }
+            if (work_seen)
+            {
+                break;
+            }
+            std::this_thread::yield();
+        }
+        idle.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+void ParallelMarker::share(std::vector<uint32_t> &local, WorkStealingDeque &own)
+{
+    // Отдаём нижнюю (самую старую) половину стека: это корни крупных
+    // необойдённых поддеревьев, ворам выгоднее всего забрать именно их
+    size_t half = local.size() / 2;
+    for (size_t i = 0; i < half; ++i)
+    {
+        own.push(local[i]);
+    }
+    local.erase(local.begin(), local.begin() + half);
+}
+
+bool ParallelMarker::steal(unsigned index, uint32_t &slot)
+{
+    for (unsigned offset = 1; offset < thread_count; ++offset)
+    {
+        unsigned victim = (index + offset) % thread_count;
+        if (deques[victim]->steal(slot))
+        {
+            return true;
+        }
+    }
+    return false;
+}
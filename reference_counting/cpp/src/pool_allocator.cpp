@@ -0,0 +1,164 @@
+#include "pool_allocator.h"
+
+#include <algorithm>
+
+SizeClassPool::SizeClassPool()
+    : current{}, partial{}, empty(nullptr), live_blocks(0), empty_count(0), chunk_releases(0), remote(nullptr)
+{
+}
+
+SizeClassPool::~SizeClassPool()
+{
+    // Если блоки ещё кем-то заняты (куча пережила пул), их куски не трогаем
+    release_memory();
+}
+
+SizeClassPool &SizeClassPool::attach_thread()
+{
+    /// Удаляет пул потока при выходе из него
+    struct Retirer
+    {
+        SizeClassPool *pool = nullptr;
+        ~Retirer()
+        {
+            t_local = nullptr;
+            pool->retire();
+        }
+    };
+    thread_local Retirer retirer;
+    retirer.pool = new SizeClassPool();
+    t_local = retirer.pool;
+    return *retirer.pool;
+}
+
+void SizeClassPool::retire()
+{
+    // Блоки, которые ещё живы, освободятся позже через remote: пул должен их пережить
+    if (release_memory())
+    {
+        delete this;
+    }
+}
+
+bool SizeClassPool::release_memory()
+{
+    drain_remote();
+    for (uint32_t cls = 0; cls < kClassCount; ++cls)
+    {
+        Chunk *chunk = current[cls];
+        if (chunk != nullptr && chunk->live == 0)
+        {
+            current[cls] = nullptr;
+            link(empty, chunk);
+            empty_count++;
+        }
+    }
+    while (empty != nullptr)
+    {
+        char *memory = reinterpret_cast<char *>(empty);
+        unlink(empty, empty);
+        chunks.erase(std::find(chunks.begin(), chunks.end(), memory));
+        ::operator delete(memory, std::align_val_t(kChunkSize));
+    }
+    empty_count = 0;
+    if (chunks.empty())
+    {
+        chunks.shrink_to_fit();
+    }
+    return live_blocks == 0 && chunks.empty();
+}
+
+void SizeClassPool::drain_remote_slow()
+{
+    FreeBlock *block = remote.exchange(nullptr, std::memory_order_acquire);
+    while (block != nullptr)
+    {
+        FreeBlock *next = block->next;
+        free_local(chunk_of(block), block);
+        block = next;
+    }
+}
+
+SizeClassPool::Chunk *SizeClassPool::next_chunk(uint32_t cls)
+{
+    // Прежний текущий кусок заполнен: освободившиеся в нём блоки вернут его в partial
+    Chunk *chunk = partial[cls];
+    if (chunk != nullptr)
+    {
+        unlink(partial[cls], chunk);
+    }
+    else
+    {
+        chunk = empty;
+        if (chunk != nullptr)
+        {
+            unlink(empty, chunk);
+            empty_count--;
+        }
+        else
+        {
+            // Выравнивание по размеру куска: заголовок находится маской адреса блока
+            char *memory = static_cast<char *>(::operator new(kChunkSize, std::align_val_t(kChunkSize)));
+            chunks.push_back(memory);
+            chunk = reinterpret_cast<Chunk *>(memory);
+            chunk->owner = this;
+            chunk->prev = nullptr;
+            chunk->next = nullptr;
+            chunk->listed = false;
+        }
+        chunk->cls = cls;
+        chunk->live = 0;
+        chunk->free = nullptr;
+        chunk->bump = chunk->start();
+    }
+    current[cls] = chunk;
+    return chunk;
+}
+
+void SizeClassPool::release_chunk(Chunk *chunk)
+{
+    chunk_releases++;
+    chunk->free = nullptr;
+    chunk->bump = chunk->start();
+    if (chunk == current[chunk->cls])
+    {
+        return; // Текущий кусок класса остаётся текущим и нарезается заново
+    }
+    if (chunk->listed)
+    {
+        unlink(partial[chunk->cls], chunk);
+    }
+    link(empty, chunk);
+    empty_count++;
+}
+
+void SizeClassPool::link(Chunk *&head, Chunk *chunk)
+{
+    chunk->prev = nullptr;
+    chunk->next = head;
+    if (head != nullptr)
+    {
+        head->prev = chunk;
+    }
+    head = chunk;
+    chunk->listed = true;
+}
+
+void SizeClassPool::unlink(Chunk *&head, Chunk *chunk)
+{
+    if (chunk->prev != nullptr)
+    {
+        chunk->prev->next = chunk->next;
+    }
+    else
+    {
+        head = chunk->next;
+    }
+    if (chunk->next != nullptr)
+    {
+        chunk->next->prev = chunk->prev;
+    }
+    chunk->prev = nullptr;
+    chunk->next = nullptr;
+    chunk->listed = false;
+}
@@ -1,15 +1,19 @@
 #include "rc_heap.h"
+#include "scenario_reader.h"
+#include "binary_trace.h"
 
 #include <iostream>
 #include <algorithm>
 
 RCHeap::RCHeap(EventLogger &logger_)
-    : rc(objects, logger_), logger(logger_) {}
+    : roots(std::make_shared<RootSet>()), scc(objects), weak(objects, logger_), cycles(objects, logger_), rc(objects, logger_, &cycles),
+      tracer(objects, logger_), logger(logger_), trace_threshold(0), size_after_trace(0), roots_version(0),
+      snapshot_writer(nullptr) {}
 
 bool RCHeap::allocate(int obj_id)
 {
     // Проверить, не существует ли уже объект с таким ID
-    if (objects.count(obj_id) > 0)
+    if (objects.contains(obj_id))
     {
         std::cerr << "Error: Object " << obj_id << " already exists\n";
         return false;
@@ -23,8 +27,16 @@ bool RCHeap::allocate(int obj_id)
     }
 
     // Выделить новый объект
-    objects.emplace(obj_id, RCObject(obj_id));
+    objects.emplace(obj_id);
     logger.log_allocate(obj_id);
+    RC_STAT(rc.get_stats().allocations++;
+            rc.get_stats().note_heap_size(objects.size());)
+
+    // Резервная трассировка при росте кучи (новый объект с ref_count == 0 — корень)
+    if (trace_threshold > 0 && objects.size() >= size_after_trace + trace_threshold)
+    {
+        collect_garbage();
+    }
     return true;
 }
 
@@ -38,16 +50,21 @@ bool RCHeap::add_root(int obj_id)
     }
 
     // Проверить, не является ли объект уже корнем
-    if (roots.count(obj_id) > 0)
+    if (roots->count(obj_id) > 0)
     {
         std::cerr << "Warning: Object " << obj_id << " is already a root\n";
         return false;
     }
 
     // Добавить в корни и увеличить ref_count
-    roots.insert(obj_id);
-    objects[obj_id].ref_count++;
-    logger.log_add_ref(0, obj_id, objects[obj_id].ref_count); // 0 = root
+    roots_for_write().insert(obj_id);
+    roots_version++;
+    RCObject &obj = *objects.find(obj_id);
+    obj.ref_count++;
+    obj.color = GcColor::Black;
+    objects.touch(obj);
+    RC_STAT(rc.get_stats().add_roots++;)
+    logger.log_add_ref(0, obj_id, obj.ref_count); // 0 = root
     return true;
 }
 
@@ -61,30 +78,38 @@ bool RCHeap::remove_root(int obj_id)
     }
 
     // Проверить, является ли объект корнем
-    if (roots.count(obj_id) == 0)
+    if (roots->count(obj_id) == 0)
     {
         std::cerr << "Error: Object " << obj_id << " is not a root\n";
         return false;
     }
 
     // Удалить из корней и уменьшить ref_count
-    roots.erase(obj_id);
-    objects[obj_id].ref_count--;
+    roots_for_write().erase(obj_id);
+    roots_version++;
+    RCObject &obj = *objects.find(obj_id);
+    obj.ref_count--;
+    objects.touch(obj);
 
-    if (objects[obj_id].ref_count < 0)
+    if (obj.ref_count < 0)
     {
         std::cerr << "Error: ref_count became negative for root object " << obj_id << "\n";
-        objects[obj_id].ref_count = 0;
+        obj.ref_count = 0;
         return false;
     }
 
-    logger.log_remove_ref(0, obj_id, objects[obj_id].ref_count); // 0 = root
+    RC_STAT(rc.get_stats().remove_roots++;)
+    logger.log_remove_ref(0, obj_id, obj.ref_count); // 0 = root
 
-    // Если ref_count == 0, начать каскадное удаление
-    if (objects[obj_id].ref_count == 0)
+    // Если ref_count == 0, освободить объект (сразу или через ZCT),
+    // иначе объект может оказаться корнем мусорного цикла
+    if (obj.ref_count == 0)
     {
-        std::unordered_set<int> visited;
-        rc.cascade_delete(obj_id, visited);
+        rc.release(obj_id);
+    }
+    else
+    {
+        cycles.possible_root(obj);
     }
 
     return true;
@@ -150,19 +175,70 @@ bool RCHeap::remove_ref(int from, int to)
     return rc.remove_ref(from, to);
 }
 
+bool RCHeap::add_weak_ref(int from, int to)
+{
+    if (from < 0 || to < 0)
+    {
+        std::cerr << "Error: Invalid object IDs\n";
+        return false;
+    }
+
+    if (!object_exists(from))
+    {
+        std::cerr << "Error: Source object " << from << " does not exist\n";
+        return false;
+    }
+
+    if (!object_exists(to))
+    {
+        std::cerr << "Error: Target object " << to << " does not exist\n";
+        return false;
+    }
+
+    if (from == to)
+    {
+        std::cerr << "Error: Self-reference not allowed\n";
+        return false;
+    }
+
+    if (!weak.add(from, to))
+    {
+        std::cerr << "Warning: Weak reference " << from << " -> " << to << " already exists\n";
+        return false;
+    }
+    return true;
+}
+
+bool RCHeap::remove_weak_ref(int from, int to)
+{
+    if (!object_exists(from))
+    {
+        std::cerr << "Error: Source object " << from << " does not exist\n";
+        return false;
+    }
+
+    // Цель может быть уже освобождена: устаревшая слабая ссылка удаляется так же
+    if (!weak.remove(from, to))
+    {
+        std::cerr << "Error: No weak reference " << from << " -> " << to << "\n";
+        return false;
+    }
+    return true;
+}
+
 void RCHeap::dump_state() const
 {
     std::cout << "=== HEAP STATE ===\n";
 
     // Вывести корни
     std::cout << "ROOTS: ";
-    if (roots.empty())
+    if (roots->empty())
     {
         std::cout << "[none]";
     }
     else
     {
-        for (int root : roots)
+        for (int root : *roots)
         {
             std::cout << root << " ";
         }
@@ -175,19 +251,11 @@ void RCHeap::dump_state() const
     }
     else
     {
-        // Вывести объекты отсортированные по ID для консистентности
-        std::vector<int> ids;
-        for (const auto &[id, _] : objects)
+        // Вывести объекты в порядке ID для консистентности: компактные ID
+        // перечисляются по плотной таблице хранилища без сортировки
+        objects.for_each_in_id_order([](const RCObject &obj)
         {
-            ids.push_back(id);
-        }
-
-        std::sort(ids.begin(), ids.end());
-
-        for (int id : ids)
-        {
-            const RCObject &obj = objects.at(id);
-            std::cout << "Object " << id
+            std::cout << "Object " << obj.id
                       << " | ref_count=" << obj.ref_count
                       << " | refs: ";
 
@@ -198,87 +266,464 @@ void RCHeap::dump_state() const
             }
 
             std::cout << "\n";
-        }
+        });
     }
     std::cout << "=================\n\n";
 }
 
-void RCHeap::run_scenario(const ScenarioOp ops[], int size)
+bool RCHeap::apply(const ScenarioOp &op)
 {
-    for (int i = 0; i < size; ++i)
+    switch (op.op)
     {
-        const ScenarioOp &op = ops[i];
+    case OpCode::Allocate:
+        return allocate(op.id);
+    case OpCode::AddRoot:
+        return add_root(op.id);
+    case OpCode::RemoveRoot:
+        return remove_root(op.id);
+    case OpCode::AddRef:
+        return add_ref(op.from, op.to);
+    case OpCode::RemoveRef:
+        return remove_ref(op.from, op.to);
+    default:
+        std::cerr << "Unknown operation\n";
+        return false;
+    }
+}
 
-        if (op.op == "allocate")
+size_t RCHeap::apply_batch(const ScenarioOp *ops, size_t count)
+{
+    const uint32_t invalid = ObjectStore::kInvalidSlot;
+    size_t applied = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const ScenarioOp &op = ops[i];
+        switch (op.op)
+        {
+        case OpCode::Allocate:
         {
-            allocate(op.id);
+            // Повторное выделение удалённого в пачке ID и автозапуск трассировки
+            // должны видеть настоящее состояние кучи
+            if (trace_threshold > 0 || (objects.contains(op.id) && batch_slot(op.id) == invalid))
+            {
+                flush_batch();
+            }
+            applied += allocate(op.id) ? 1 : 0;
+            break;
         }
-        else if (op.op == "add_root")
+        case OpCode::AddRoot:
+        case OpCode::RemoveRoot:
         {
-            add_root(op.id);
+            const bool add = op.op == OpCode::AddRoot;
+            uint32_t slot = batch_slot(op.id);
+            if (slot == invalid)
+            {
+                std::cerr << "Error: Object " << op.id << " does not exist\n";
+                break;
+            }
+            if (add ? !roots_for_write().insert(op.id).second : roots_for_write().erase(op.id) == 0)
+            {
+                if (add)
+                {
+                    std::cerr << "Warning: Object " << op.id << " is already a root\n";
+                }
+                else
+                {
+                    std::cerr << "Error: Object " << op.id << " is not a root\n";
+                }
+                break;
+            }
+            roots_version++;
+            batch_note_edge(-1, op.id, add ? +1 : -1);
+            RC_STAT(add ? rc.get_stats().add_roots++ : rc.get_stats().remove_roots++;)
+            if (add)
+            {
+                batch_increment(slot);
+            }
+            else
+            {
+                batch_decrement(slot);
+            }
+            applied++;
+            break;
         }
-        else if (op.op == "remove_root")
+        case OpCode::AddRef:
+        case OpCode::RemoveRef:
         {
-            remove_root(op.id);
+            const bool add = op.op == OpCode::AddRef;
+            if (op.from < 0 || op.to < 0)
+            {
+                std::cerr << "Error: Invalid object IDs\n";
+                break;
+            }
+            uint32_t from_slot = batch_slot(op.from);
+            if (from_slot == invalid)
+            {
+                std::cerr << "Error: Source object " << op.from << " does not exist\n";
+                break;
+            }
+            uint32_t to_slot = batch_slot(op.to);
+            if (to_slot == invalid)
+            {
+                std::cerr << "Error: Target object " << op.to << " does not exist\n";
+                break;
+            }
+            if (add && op.from == op.to)
+            {
+                std::cerr << "Error: Self-reference not allowed\n";
+                break;
+            }
+
+            RCObject &from_obj = objects.at_slot(from_slot);
+            if (add)
+            {
+                if (!from_obj.add_outgoing_ref(op.to))
+                {
+                    std::cerr << "Warning: Reference from " << op.from << " to " << op.to << " already exists\n";
+                    break;
+                }
+                objects.touch(from_obj);
+                if (scc.is_attached())
+                {
+                    scc.add_edge(op.from, op.to);
+                }
+                batch_note_edge(op.from, op.to, +1);
+                batch_increment(to_slot);
+                RC_STAT(rc.get_stats().add_refs++;
+                        rc.get_stats().note_fan_out(from_obj.references.size());)
+            }
+            else
+            {
+                if (!from_obj.remove_outgoing_ref(op.to))
+                {
+                    std::cerr << "Error: No reference from " << op.from << " to " << op.to << "\n";
+                    break;
+                }
+                objects.touch(from_obj);
+                if (scc.is_attached())
+                {
+                    scc.remove_edge(op.from, op.to);
+                }
+                batch_note_edge(op.from, op.to, -1);
+                batch_decrement(to_slot);
+                RC_STAT(rc.get_stats().remove_refs++;)
+            }
+            applied++;
+            break;
+        }
+        default:
+            std::cerr << "Unknown operation\n";
+            break;
         }
-        else if (op.op == "add_ref")
+    }
+    flush_batch();
+    return applied;
+}
+
+uint32_t RCHeap::batch_slot(int obj_id) const
+{
+    uint32_t slot = objects.lookup(obj_id);
+    if (slot != ObjectStore::kInvalidSlot && slot < batch_slot_index.size() && batch_slot_index[slot] != 0 &&
+        batch_targets[batch_slot_index[slot] - 1].dead)
+    {
+        return ObjectStore::kInvalidSlot;
+    }
+    return slot;
+}
+
+RCHeap::BatchTarget &RCHeap::batch_target(uint32_t slot)
+{
+    if (slot >= batch_slot_index.size())
+    {
+        batch_slot_index.resize(objects.slot_count(), 0);
+    }
+    uint32_t &index = batch_slot_index[slot];
+    if (index == 0)
+    {
+        batch_targets.emplace_back(slot);
+        index = static_cast<uint32_t>(batch_targets.size());
+    }
+    return batch_targets[index - 1];
+}
+
+void RCHeap::batch_increment(uint32_t slot)
+{
+    BatchTarget &target = batch_target(slot);
+    target.delta++;
+    target.last_increment = true;
+}
+
+void RCHeap::batch_decrement(uint32_t slot)
+{
+    const bool eager = rc.get_mode() == DecrementMode::Eager;
+    const size_t base = batch_worklist.size();
+    for (;;)
+    {
+        BatchTarget &target = batch_target(slot);
+        RCObject &obj = objects.at_slot(slot);
+        target.delta--;
+        target.last_increment = false;
+        // Залипший счётчик (RC_COMPACT_HEADER) до нуля не доходит
+        if (obj.ref_count + target.delta > 0 || obj.has_sticky_count())
         {
-            add_ref(op.from, op.to);
+            target.decremented_alive = true;
         }
-        else if (op.op == "remove_ref")
+        else if (!eager)
         {
-            remove_ref(op.from, op.to);
+            // Отложенный режим: объект попадёт в ZCT при сбросе пачки
+            batch_freed.push_back(obj.id);
         }
         else
         {
-            std::cerr << "Unknown operation: " << op.op << "\n";
+            // Объект удалён для всех следующих операций пачки; его ссылки
+            // уменьшают счётчики детей в том же порядке, что и cascade_delete
+            target.dead = true;
+            batch_freed.push_back(obj.id);
+            for (auto it = obj.references.rbegin(); it != obj.references.rend(); ++it)
+            {
+                batch_worklist.push_back(objects.lookup(*it));
+            }
         }
 
-        dump_state();
+        slot = ObjectStore::kInvalidSlot;
+        while (slot == ObjectStore::kInvalidSlot && batch_worklist.size() > base)
+        {
+            slot = batch_worklist.back();
+            batch_worklist.pop_back();
+            if (slot != ObjectStore::kInvalidSlot && batch_slot(objects.at_slot(slot).id) != slot)
+            {
+                slot = ObjectStore::kInvalidSlot;
+            }
+        }
+        if (slot == ObjectStore::kInvalidSlot)
+        {
+            return;
+        }
     }
 }
 
-int RCHeap::get_ref_count(int obj_id) const
+void RCHeap::batch_note_edge(int from, int to, int change)
 {
-    auto it = objects.find(obj_id);
-    if (it != objects.end())
+    // Таблица заполнена не больше чем наполовину
+    if (2 * (batch_edges.size() + 1) > batch_edge_table.size())
     {
-        return it->second.ref_count;
+        batch_edge_table.assign(std::max<size_t>(64, 2 * batch_edge_table.size()), 0);
+        const size_t mask = batch_edge_table.size() - 1;
+        for (size_t k = 0; k < batch_edges.size(); ++k)
+        {
+            size_t bucket = (batch_edges[k].key * 0x9E3779B97F4A7C15ull >> 32) & mask;
+            while (batch_edge_table[bucket] != 0)
+            {
+                bucket = (bucket + 1) & mask;
+            }
+            batch_edge_table[bucket] = static_cast<uint32_t>(k + 1);
+            batch_edges[k].bucket = static_cast<uint32_t>(bucket);
+        }
     }
 
-    return -1; // Объект не существует
+    const uint64_t key = static_cast<uint64_t>(static_cast<uint32_t>(from)) << 32 | static_cast<uint32_t>(to);
+    const size_t mask = batch_edge_table.size() - 1;
+    size_t bucket = (key * 0x9E3779B97F4A7C15ull >> 32) & mask;
+    while (batch_edge_table[bucket] != 0)
+    {
+        BatchEdge &edge = batch_edges[batch_edge_table[bucket] - 1];
+        if (edge.key == key)
+        {
+            edge.net += change;
+            return;
+        }
+        bucket = (bucket + 1) & mask;
+    }
+    batch_edge_table[bucket] = static_cast<uint32_t>(batch_edges.size() + 1);
+    batch_edges.push_back({key, change, static_cast<uint32_t>(bucket)});
 }
 
-void RCHeap::detect_and_log_leaks()
+void RCHeap::flush_batch()
 {
-    for (const auto &[id, obj] : objects)
+    // Итоговые разности счётчиков
+    for (const BatchTarget &target : batch_targets)
     {
-        // Логировать объекты с ref_count > 0 (утечка памяти!)
-        if (obj.ref_count > 0)
+        if (!target.dead)
         {
-            logger.log_leak(id);
+            RCObject &obj = objects.at_slot(target.slot);
+            obj.ref_count += target.delta;
+            objects.touch(obj);
         }
     }
+
+    // Итоговые изменения ссылок в порядке первого обращения;
+    // взаимно погашенные пары в лог не попадают
+    for (const BatchEdge &edge : batch_edges)
+    {
+        batch_edge_table[edge.bucket] = 0;
+        if (edge.net == 0)
+        {
+            continue;
+        }
+        int from = static_cast<int32_t>(edge.key >> 32);
+        int to = static_cast<int32_t>(edge.key & 0xFFFFFFFFu);
+        uint32_t slot = batch_slot(to);
+        int count = slot != ObjectStore::kInvalidSlot ? objects.at_slot(slot).ref_count : 0;
+        from = from == -1 ? 0 : from; // 0 = root
+        if (edge.net > 0)
+        {
+            logger.log_add_ref(from, to, count);
+        }
+        else
+        {
+            logger.log_remove_ref(from, to, count);
+        }
+    }
+
+    // Цвета для сборщика циклов — как после последнего изменения счётчика
+    for (const BatchTarget &target : batch_targets)
+    {
+        batch_slot_index[target.slot] = 0;
+        if (target.dead)
+        {
+            continue;
+        }
+        RCObject &obj = objects.at_slot(target.slot);
+        if (target.decremented_alive)
+        {
+            cycles.possible_root(obj);
+        }
+        if (target.last_increment)
+        {
+            obj.color = GcColor::Black;
+        }
+    }
+
+    // Освобождение: удаление одним проходом (Eager) или постановка в ZCT (Deferred)
+    const bool eager = rc.get_mode() == DecrementMode::Eager;
+    RC_STAT(const uint64_t free_start = stats_now_ns();)
+    for (int obj_id : batch_freed)
+    {
+        if (eager)
+        {
+            objects.erase(obj_id);
+            logger.log_delete(obj_id);
+        }
+        else
+        {
+            rc.release(obj_id);
+        }
+    }
+    RC_STAT(if (eager && !batch_freed.empty())
+            {
+                // Проход удаления пачки учитывается как один каскад неизвестной глубины
+                rc.get_stats().cascade_pause_ns.record(stats_now_ns() - free_start);
+                rc.get_stats().frees += batch_freed.size();
+                rc.get_stats().record_cascade(batch_freed.size(), 0);
+            })
+
+    batch_targets.clear();
+    batch_edges.clear();
+    batch_freed.clear();
 }
 
-RCObject *RCHeap::get_object(int obj_id)
+void RCHeap::after_op(bool dump_each)
 {
-    auto it = objects.find(obj_id);
-    if (it != objects.end())
+    if (dump_each)
     {
-        return &it->second;
+        dump_state();
     }
+    if (snapshot_writer != nullptr)
+    {
+        write_snapshot(*snapshot_writer, SnapshotMode::Diff);
+    }
+}
 
-    return nullptr;
+bool RCHeap::write_snapshot(HeapSnapshotWriter &writer, SnapshotMode mode, std::chrono::nanoseconds time_slice)
+{
+    return writer.step(objects, *roots, roots_version, mode, time_slice);
 }
 
-const RCObject *RCHeap::get_object(int obj_id) const
+void RCHeap::run_scenario(const ScenarioOp ops[], int size, bool dump_each)
+{
+    for (int i = 0; i < size; ++i)
+    {
+        apply(ops[i]);
+        after_op(dump_each);
+    }
+}
+
+size_t RCHeap::replay(ScenarioReader &reader, bool dump_each)
+{
+    ScenarioOp op;
+    size_t count = 0;
+    while (reader.next(op))
+    {
+        apply(op);
+        count++;
+        after_op(dump_each);
+    }
+    return count;
+}
+
+size_t RCHeap::replay(BinaryTraceReader &reader, bool dump_each)
+{
+    ScenarioOp op;
+    size_t count = 0;
+    while (reader.next(op))
+    {
+        apply(op);
+        count++;
+        after_op(dump_each);
+    }
+    return count;
+}
+
+int RCHeap::get_ref_count(int obj_id) const
 {
-    auto it = objects.find(obj_id);
-    if (it != objects.end())
+    const RCObject *obj = objects.find(obj_id);
+    if (obj != nullptr)
     {
-        return &it->second;
+        return obj->ref_count;
     }
 
-    return nullptr;
+    return -1; // Объект не существует
+}
+
+void RCHeap::detect_and_log_leaks()
+{
+    // Логировать недостижимые объекты (у них всегда ref_count > 0 — утечка памяти!)
+    tracer.mark(*roots);
+    tracer.log_unmarked();
+}
+
+size_t RCHeap::collect_garbage()
+{
+    RC_STAT(PauseTimer pause(rc.get_stats().collector_pause_ns);)
+    tracer.mark(*roots);
+    size_t freed = tracer.sweep();
+    tracer.restore_sticky_counts(*roots);
+    size_after_trace = objects.size();
+    return freed;
+}
+
+RCStats RCHeap::get_stats() const
+{
+    RCStats snapshot = rc.get_stats();
+    snapshot.lookups = objects.get_lookup_count();
+    snapshot.hash_lookups = objects.get_hash_lookup_count();
+    snapshot.heap_size = objects.size();
+    return snapshot;
+}
+
+void RCHeap::reset_stats()
+{
+    rc.get_stats().reset();
+    rc.get_stats().note_heap_size(objects.size());
+    objects.reset_lookup_counts();
+}
+
+RCObject *RCHeap::get_object(int obj_id)
+{
+    return objects.find(obj_id);
+}
+
+const RCObject *RCHeap::get_object(int obj_id) const
+{
+    return objects.find(obj_id);
 }
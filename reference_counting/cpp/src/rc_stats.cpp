@@ -0,0 +1,177 @@
+#include "rc_stats.h"
+
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+
+namespace
+{
+    void append_uint(std::string &out, const char *key, uint64_t value)
+    {
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), "\"%s\": %llu", key, static_cast<unsigned long long>(value));
+        out += buffer;
+    }
+
+    void print_histogram(std::ostream &out, const char *name, const LogHistogram &histogram)
+    {
+        char line[192];
+        std::snprintf(line, sizeof(line), "  %-20s n=%-10llu min=%-8llu p50=%-8llu p90=%-8llu p99=%-8llu max=%llu\n",
+                      name, static_cast<unsigned long long>(histogram.count()),
+                      static_cast<unsigned long long>(histogram.min()),
+                      static_cast<unsigned long long>(histogram.percentile(0.5)),
+                      static_cast<unsigned long long>(histogram.percentile(0.9)),
+                      static_cast<unsigned long long>(histogram.percentile(0.99)),
+                      static_cast<unsigned long long>(histogram.max()));
+        out << line;
+    }
+}
+
+void LogHistogram::reset()
+{
+    std::memset(counts, 0, sizeof(counts));
+    total = 0;
+    sum = 0;
+    min_value = UINT64_MAX;
+    max_value = 0;
+}
+
+uint64_t LogHistogram::percentile(double fraction) const
+{
+    if (total == 0)
+    {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(fraction * total + 0.5);
+    rank = rank < 1 ? 1 : rank > total ? total : rank;
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < kBuckets; ++bucket)
+    {
+        seen += counts[bucket];
+        if (seen >= rank)
+        {
+            uint64_t high = bucket_high(bucket);
+            return high < max_value ? high : max_value;
+        }
+    }
+    return max_value;
+}
+
+std::string LogHistogram::to_json() const
+{
+    std::string out = "{";
+    append_uint(out, "count", total);
+    out += ", ";
+    append_uint(out, "min", min());
+    out += ", ";
+    append_uint(out, "max", max());
+    char mean_text[48];
+    std::snprintf(mean_text, sizeof(mean_text), ", \"mean\": %.1f", mean());
+    out += mean_text;
+    const struct
+    {
+        const char *key;
+        double fraction;
+    } points[] = {{"p50", 0.5}, {"p90", 0.9}, {"p99", 0.99}, {"p999", 0.999}};
+    for (const auto &point : points)
+    {
+        out += ", ";
+        append_uint(out, point.key, percentile(point.fraction));
+    }
+
+    out += ", \"buckets\": [";
+    bool first = true;
+    for (int bucket = 0; bucket < kBuckets; ++bucket)
+    {
+        if (counts[bucket] == 0)
+        {
+            continue;
+        }
+        char entry[80];
+        std::snprintf(entry, sizeof(entry), "%s[%llu, %llu, %llu]", first ? "" : ", ",
+                      static_cast<unsigned long long>(bucket_low(bucket)),
+                      static_cast<unsigned long long>(bucket_high(bucket)),
+                      static_cast<unsigned long long>(counts[bucket]));
+        out += entry;
+        first = false;
+    }
+    out += "]}";
+    return out;
+}
+
+void RCStats::reset()
+{
+    allocations = add_roots = remove_roots = add_refs = remove_refs = 0;
+    lookups = hash_lookups = 0;
+    frees = cascades = max_cascade_depth = max_fan_out = 0;
+    heap_size = peak_heap_size = 0;
+    cascade_length.reset();
+    cascade_pause_ns.reset();
+    collector_pause_ns.reset();
+}
+
+std::string RCStats::to_json() const
+{
+    if (!kStatsEnabled)
+    {
+        return "{\"enabled\": false}";
+    }
+
+    std::string out = "{\"enabled\": true, \"ops\": {";
+    append_uint(out, "allocate", allocations);
+    out += ", ";
+    append_uint(out, "add_root", add_roots);
+    out += ", ";
+    append_uint(out, "remove_root", remove_roots);
+    out += ", ";
+    append_uint(out, "add_ref", add_refs);
+    out += ", ";
+    append_uint(out, "remove_ref", remove_refs);
+    out += "}";
+
+    const struct
+    {
+        const char *key;
+        uint64_t value;
+    } counters[] = {{"lookups", lookups},
+                    {"hash_lookups", hash_lookups},
+                    {"frees", frees},
+                    {"cascades", cascades},
+                    {"max_cascade_depth", max_cascade_depth},
+                    {"max_fan_out", max_fan_out},
+                    {"heap_size", heap_size},
+                    {"peak_heap_size", peak_heap_size}};
+    for (const auto &counter : counters)
+    {
+        out += ", ";
+        append_uint(out, counter.key, counter.value);
+    }
+
+    out += ", \"cascade_length\": " + cascade_length.to_json();
+    out += ", \"cascade_pause_ns\": " + cascade_pause_ns.to_json();
+    out += ", \"collector_pause_ns\": " + collector_pause_ns.to_json();
+    out += "}";
+    return out;
+}
+
+void RCStats::dump(std::ostream &out) const
+{
+    out << "=== RC STATS ===\n";
+    if (!kStatsEnabled)
+    {
+        out << "disabled (build with -DRC_ENABLE_STATS)\n";
+        out << "================\n\n";
+        return;
+    }
+
+    out << "ops: allocate=" << allocations << " add_root=" << add_roots << " remove_root=" << remove_roots
+        << " add_ref=" << add_refs << " remove_ref=" << remove_refs << "\n";
+    out << "lookups: " << lookups << " (hash " << hash_lookups << ")\n";
+    out << "frees: " << frees << " in " << cascades << " cascades, max depth " << max_cascade_depth << "\n";
+    out << "max fan-out: " << max_fan_out << "\n";
+    out << "heap: " << heap_size << " objects, peak " << peak_heap_size << "\n";
+    print_histogram(out, "cascade_length", cascade_length);
+    print_histogram(out, "cascade_pause_ns", cascade_pause_ns);
+    print_histogram(out, "collector_pause_ns", collector_pause_ns);
+    out << "================\n\n";
+}
@@ -1,27 +1,29 @@
 #include "reference_counter.h"
 #include <iostream>
 
-ReferenceCounter::ReferenceCounter(std::unordered_map<int, RCObject> &heap_, EventLogger &logger_)
-    : heap(heap_), logger(logger_)
+ReferenceCounter::ReferenceCounter(ObjectStore &heap_, EventLogger &logger_, CycleCollector *cycles_)
+    : heap(heap_), logger(logger_), cycles(cycles_), scc(nullptr), mode(DecrementMode::Eager)
 {
 }
 
 bool ReferenceCounter::add_ref(int from, int to)
 {
     // Валидация: оба объекта должны существовать
-    if (heap.find(from) == heap.end())
+    RCObject *from_ptr = heap.find(from);
+    if (from_ptr == nullptr)
     {
         std::cerr << "Error: Source object " << from << " does not exist\n";
         return false;
     }
-    if (heap.find(to) == heap.end())
+    RCObject *to_ptr = heap.find(to);
+    if (to_ptr == nullptr)
     {
         std::cerr << "Error: Target object " << to << " does not exist\n";
         return false;
     }
 
-    RCObject &from_obj = heap[from];
-    RCObject &to_obj = heap[to];
+    RCObject &from_obj = *from_ptr;
+    RCObject &to_obj = *to_ptr;
 
     // Проверить, не существует ли уже такая ссылка
     if (from_obj.has_reference_to(to))
@@ -33,9 +35,19 @@ bool ReferenceCounter::add_ref(int from, int to)
 
     // Добавить исходящую ссылку от source к target
     from_obj.add_outgoing_ref(to);
+    if (scc != nullptr)
+    {
+        scc->add_edge(from, to);
+    }
 
-    // Увеличить счётчик входящих ссылок у целевого объекта
+    // Увеличить счётчик входящих ссылок у целевого объекта;
+    // объект с новой ссылкой заведомо жив для сборщика циклов
     to_obj.ref_count++;
+    to_obj.color = GcColor::Black;
+    heap.touch(from_obj);
+    heap.touch(to_obj);
+    RC_STAT(stats.add_refs++;
+            stats.note_fan_out(from_obj.references.size());)
 
     // Логировать операцию
     logger.log_add_ref(from, to, to_obj.ref_count);
@@ -46,19 +58,21 @@ bool ReferenceCounter::add_ref(int from, int to)
 bool ReferenceCounter::remove_ref(int from, int to)
 {
     // Валидация: оба объекта должны существовать
-    if (heap.find(from) == heap.end())
+    RCObject *from_ptr = heap.find(from);
+    if (from_ptr == nullptr)
     {
         std::cerr << "Error: Source object " << from << " does not exist\n";
         return false;
     }
-    if (heap.find(to) == heap.end())
+    RCObject *to_ptr = heap.find(to);
+    if (to_ptr == nullptr)
     {
         std::cerr << "Error: Target object " << to << " does not exist\n";
         return false;
     }
 
-    RCObject &from_obj = heap[from];
-    RCObject &to_obj = heap[to];
+    RCObject &from_obj = *from_ptr;
+    RCObject &to_obj = *to_ptr;
 
     // Проверить, существует ли такая ссылка
     if (!from_obj.has_reference_to(to))
@@ -69,9 +83,15 @@ bool ReferenceCounter::remove_ref(int from, int to)
 
     // Удалить исходящую ссылку
     from_obj.remove_outgoing_ref(to);
+    if (scc != nullptr)
+    {
+        scc->remove_edge(from, to);
+    }
 
     // Уменьшить счётчик входящих ссылок
     to_obj.ref_count--;
+    heap.touch(from_obj);
+    heap.touch(to_obj);
 
     // Защита от отрицательного счётчика
     if (to_obj.ref_count < 0)
@@ -81,125 +101,184 @@ bool ReferenceCounter::remove_ref(int from, int to)
         return false;
     }
 
+    RC_STAT(stats.remove_refs++;)
+
     // Логировать операцию
     logger.log_remove_ref(from, to, to_obj.ref_count);
 
-    // Если ref_count == 0, начать каскадное удаление
+    // Если ref_count == 0, освободить объект (сразу или через ZCT),
+    // иначе объект может оказаться корнем мусорного цикла
     if (to_obj.ref_count == 0)
     {
-        std::unordered_set<int> visited;
-        cascade_delete(to, visited);
+        release(to);
+    }
+    else
+    {
+        note_decrement(to_obj);
     }
 
     return true;
 }
 
-void ReferenceCounter::cascade_delete(int obj_id, std::unordered_set<int> &visited)
+void ReferenceCounter::cascade_delete(int obj_id)
 {
     // Проверить, существует ли объект
-    if (heap.find(obj_id) == heap.end())
-    {
-        return;
-    }
-
-    // Избежать циклического удаления
-    if (visited.count(obj_id))
+    RCObject *obj = heap.find(obj_id);
+    if (obj == nullptr)
     {
         return;
     }
 
-    RCObject &obj = heap[obj_id];
-
     // Удалить только если ref_count == 0
-    if (obj.ref_count > 0)
+    if (obj->ref_count > 0)
     {
         return;
     }
 
-    visited.insert(obj_id);
-
-    // Получить копию исходящих ссылок перед удалением объекта
-    std::vector<int> children = obj.references;
-
-    // Удалить объект из памяти
-    heap.erase(obj_id);
-    logger.log_delete(obj_id);
+    // Граница стека: каскад обрабатывает только свои записи
+    const size_t base = worklist.size();
+    RC_STAT(PauseTimer pause(stats.cascade_pause_ns);
+            uint64_t freed = 1;
+            uint32_t depth = 0, max_depth = 0;
+            cascade_depths.clear();)
+    free_object(*obj);
+    RC_STAT(cascade_depths.resize(worklist.size() - base, 1);)
 
-    // Рекурсивно удалить дочерние объекты с ref_count == 0
-    for (int child_id : children)
+    while (worklist.size() > base)
     {
-        if (heap.find(child_id) != heap.end())
+        int child_id = worklist.back();
+        worklist.pop_back();
+        RC_STAT(depth = cascade_depths.back();
+                cascade_depths.pop_back();)
+
+        RCObject *child = heap.find(child_id);
+        if (child == nullptr)
         {
-            RCObject &child = heap[child_id];
+            continue;
+        }
 
-            // Уменьшить счётчик, так как родитель удалён
-            child.ref_count--;
-            if (child.ref_count < 0)
-            {
-                child.ref_count = 0;
-            }
+        // Уменьшить счётчик, так как родитель удалён
+        child->ref_count--;
+        heap.touch(*child);
+        if (child->ref_count < 0)
+        {
+            child->ref_count = 0;
+        }
 
-            // Если счётчик стал 0, удалить дочерний объект
-            if (child.ref_count == 0)
-            {
-                cascade_delete(child_id, visited);
-            }
+        // Если счётчик стал 0, удалить дочерний объект
+        if (child->ref_count == 0)
+        {
+            free_object(*child);
+            RC_STAT(freed++;
+                    max_depth = depth > max_depth ? depth : max_depth;
+                    cascade_depths.resize(worklist.size() - base, depth + 1);)
+        }
+        else
+        {
+            note_decrement(*child);
         }
     }
+    RC_STAT(stats.record_cascade(freed, max_depth);)
 }
 
-bool ReferenceCounter::has_cycle(int start_id) const
+void ReferenceCounter::release(int obj_id)
 {
-    if (heap.find(start_id) == heap.end())
+    if (mode == DecrementMode::Eager)
     {
-        return false;
+        cascade_delete(obj_id);
+        return;
     }
 
-    std::unordered_set<int> visited;
-    std::unordered_set<int> rec_stack;
-
-    return has_cycle_dfs(start_id, visited, rec_stack);
+    ObjectHandle handle = heap.handle_of(obj_id);
+    if (handle.slot != ObjectStore::kInvalidSlot)
+    {
+        zct.push_back(handle);
+    }
 }
 
-bool ReferenceCounter::has_cycle_dfs(int current_id,
-                                     std::unordered_set<int> &visited,
-                                     std::unordered_set<int> &rec_stack) const
+void ReferenceCounter::set_mode(DecrementMode new_mode)
 {
-    // Пометить как посещённый
-    visited.insert(current_id);
-    rec_stack.insert(current_id);
-
-    if (heap.find(current_id) == heap.end())
+    if (new_mode == DecrementMode::Eager)
     {
-        return false;
+        collect(CollectBudget::unlimited());
     }
+    mode = new_mode;
+}
+
+size_t ReferenceCounter::collect(const CollectBudget &budget)
+{
+    using Clock = std::chrono::steady_clock;
 
-    const RCObject &current = heap.at(current_id);
+    RC_STAT(PauseTimer pause(stats.cascade_pause_ns);)
+    const bool timed = budget.time_slice.count() > 0;
+    const Clock::time_point deadline = timed ? Clock::now() + budget.time_slice : Clock::time_point();
+    size_t freed = 0;
 
-    // Проверить все исходящие ссылки
-    for (int neighbor : current.references)
+    while (!zct.empty())
     {
-        if (heap.find(neighbor) == heap.end())
+        if (budget.max_objects > 0 && freed >= budget.max_objects)
+        {
+            break;
+        }
+        // Часы опрашиваются раз в 16 объектов, чтобы не платить за вызов на каждом
+        if (timed && (freed & 15) == 0 && freed > 0 && Clock::now() >= deadline)
+        {
+            break;
+        }
+
+        ObjectHandle handle = zct.back();
+        zct.pop_back();
+
+        // Объект мог быть уже освобождён или снова получить ссылку
+        RCObject *obj = heap.get(handle);
+        if (obj == nullptr || obj->ref_count > 0)
         {
             continue;
         }
 
-        // Если сосед не посещён, рекурсивно проверить его
-        if (!visited.count(neighbor))
+        int obj_id = obj->id;
+        for (int child_id : obj->references)
         {
-            if (has_cycle_dfs(neighbor, visited, rec_stack))
+            RCObject *child = heap.find(child_id);
+            if (child == nullptr)
             {
-                return true;
+                continue;
+            }
+
+            child->ref_count--;
+            heap.touch(*child);
+            if (child->ref_count < 0)
+            {
+                child->ref_count = 0;
+            }
+            if (child->ref_count == 0)
+            {
+                zct.push_back(heap.handle_of(child_id));
+            }
+            else
+            {
+                note_decrement(*child);
             }
         }
-        // Если сосед находится в стеке рекурсии, то найден цикл
-        else if (rec_stack.count(neighbor))
-        {
-            return true;
-        }
+
+        heap.erase(obj_id);
+        logger.log_delete(obj_id);
+        RC_STAT(stats.frees++;)
+        freed++;
     }
 
-    // Удалить из стека рекурсии при возвращении
-    rec_stack.erase(current_id);
-    return false;
+    return freed;
+}
+
+void ReferenceCounter::free_object(RCObject &obj)
+{
+    int obj_id = obj.id;
+
+    // Перенести ссылки в стек без промежуточной копии списка
+    worklist.insert(worklist.end(), obj.references.rbegin(), obj.references.rend());
+
+    // Удалить объект из памяти
+    heap.erase(obj_id);
+    logger.log_delete(obj_id);
+    RC_STAT(stats.frees++;)
 }
@@ -0,0 +1,781 @@
+#include "scc_index.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+SccIndex::SccIndex(ObjectStore &store)
+    : heap(store), attached(false), visit_epoch(0), forward_next(0), backward_next(0), forward_work(0),
+      backward_work(0)
+{
+}
+
+SccIndex::~SccIndex()
+{
+    detach();
+}
+
+void SccIndex::attach()
+{
+    if (attached)
+    {
+        return;
+    }
+
+    const ObjectStore &store = heap;
+    const uint32_t slot_count = store.slot_count();
+    ensure_slots(slot_count);
+
+    // Входящие ссылки и список живых объектов
+    std::vector<uint32_t> live;
+    live.reserve(store.size());
+    for (uint32_t slot = 0; slot < slot_count; ++slot)
+    {
+        if (!store.is_live_slot(slot))
+        {
+            continue;
+        }
+        live.push_back(slot);
+        for (int child_id : store.at_slot(slot).references)
+        {
+            uint32_t child = store.slot_of(child_id);
+            if (child != ObjectStore::kInvalidSlot)
+            {
+                in_edges[child].insert(static_cast<int>(slot));
+            }
+        }
+    }
+
+    // Тарьян выдаёт компоненты стоками вперёд: метки раздаются с конца
+    tarjan(live, kNoComponent);
+    const size_t count = scc_offsets.size() - 1;
+    for (size_t k = 0; k < count; ++k)
+    {
+        uint32_t component = new_component(static_cast<uint64_t>(count - k) * kLabelGap);
+        for (uint32_t i = scc_offsets[k]; i < scc_offsets[k + 1]; ++i)
+        {
+            link_member(component, scc_nodes[i]);
+        }
+        labels.emplace_hint(labels.begin(), components[component].label, component);
+    }
+
+    heap.add_listener(this);
+    attached = true;
+}
+
+void SccIndex::detach()
+{
+    if (!attached)
+    {
+        return;
+    }
+    heap.remove_listener(this);
+    attached = false;
+
+    // Освободить память, а не только очистить
+    std::vector<uint32_t>().swap(node_component);
+    std::vector<uint32_t>().swap(member_next);
+    std::vector<uint32_t>().swap(member_prev);
+    std::vector<EdgeSet>().swap(in_edges);
+    std::vector<Component>().swap(components);
+    std::vector<uint32_t>().swap(free_components);
+    labels.clear();
+    std::vector<uint32_t>().swap(tarjan_index);
+    std::vector<uint32_t>().swap(tarjan_low);
+    std::vector<uint8_t>().swap(tarjan_on_stack);
+}
+
+bool SccIndex::add_edge(int from, int to)
+{
+    if (!attached)
+    {
+        return false;
+    }
+    stats.edges_added++;
+
+    const ObjectStore &store = heap;
+    uint32_t u = store.slot_of(from);
+    uint32_t v = store.slot_of(to);
+    if (u == ObjectStore::kInvalidSlot || v == ObjectStore::kInvalidSlot)
+    {
+        return false;
+    }
+    in_edges[v].insert(static_cast<int>(u));
+
+    // Разбиение одной компоненты может переместить объект другой, поэтому
+    // компоненту u перечитываем после очистки компоненты v
+    clean_component(u);
+    uint32_t cv = clean_component(v);
+    uint32_t cu = node_component[u];
+    if (cu == cv)
+    {
+        return components[cu].size > 1;
+    }
+
+    const uint64_t lower = components[cv].label;
+    const uint64_t upper = components[cu].label;
+    if (upper < lower)
+    {
+        return false;
+    }
+
+    // Ссылка против порядка. Компоненты, достижимые из v с меткой до upper
+    // (прямой поиск F), должны оказаться после всех, из которых достижим u
+    // с меткой от lower (обратный поиск B). Метки разрежены, поэтому
+    // достаточно переставить одну сторону: F — сразу за u, B — сразу перед v.
+    // Поиски идут поочерёдно (следующим продвигается тот, что просмотрел
+    // меньше ссылок), переставляется сторона, исчерпанная первой.
+    stats.reorders++;
+    start_search(cv, cu);
+    while (forward_next < forward.size() && backward_next < backward.size())
+    {
+        if (forward_work <= backward_work)
+        {
+            advance_forward(upper);
+        }
+        else
+        {
+            advance_backward(lower);
+        }
+    }
+    stats.components_visited += forward.size() + backward.size();
+    const bool forward_done = forward_next == forward.size();
+    std::vector<uint32_t> &side = forward_done ? forward : backward;
+    const uint64_t position = forward_done ? upper : lower - 1;
+    const uint32_t epoch = visit_epoch;
+    const bool cycle = forward_done ? components[cu].forward_visit == epoch : components[cv].backward_visit == epoch;
+
+    auto by_label = [this](uint32_t a, uint32_t b) { return components[a].label < components[b].label; };
+    std::sort(side.begin(), side.end(), by_label);
+    for (uint32_t component : side)
+    {
+        labels.erase(components[component].label);
+    }
+    if (!cycle)
+    {
+        relocate(side, position);
+        return false;
+    }
+
+    // Ссылка замкнула цикл: сливаются компоненты исчерпанной стороны,
+    // лежащие на путях v ->* u (все такие пути проходят внутри неё).
+    // Слитая встаёт ближе к другой стороне: за u идут M, F \ M; перед v — B \ M, M
+    stats.merges++;
+    const uint32_t mark = collect_cycle(forward_done ? cu : cv, forward_done, epoch);
+    std::vector<uint32_t> &order = work;
+    order.clear();
+    for (uint32_t component : side)
+    {
+        const uint32_t visit = forward_done ? components[component].backward_visit : components[component].forward_visit;
+        if (visit != mark)
+        {
+            order.push_back(component);
+        }
+    }
+    const uint32_t merged = merge(merge_buffer);
+    order.insert(forward_done ? order.begin() : order.end(), merged);
+    relocate(order, position);
+    return true;
+}
+
+void SccIndex::remove_edge(int from, int to)
+{
+    if (!attached)
+    {
+        return;
+    }
+    stats.edges_removed++;
+
+    const ObjectStore &store = heap;
+    uint32_t u = store.slot_of(from);
+    uint32_t v = store.slot_of(to);
+    if (u == ObjectStore::kInvalidSlot || v == ObjectStore::kInvalidSlot)
+    {
+        return;
+    }
+    in_edges[v].erase(static_cast<int>(u));
+
+    // Порядок остаётся верным; компонента могла распасться
+    uint32_t component = node_component[u];
+    if (component == node_component[v] && components[component].size > 1)
+    {
+        components[component].dirty = true;
+    }
+}
+
+bool SccIndex::in_cycle(int obj_id)
+{
+    uint32_t component = component_of(obj_id);
+    return component != kNoComponent && components[component].size > 1;
+}
+
+uint32_t SccIndex::component_of(int obj_id)
+{
+    if (!attached)
+    {
+        return kNoComponent;
+    }
+    const ObjectStore &store = heap;
+    uint32_t slot = store.slot_of(obj_id);
+    return slot == ObjectStore::kInvalidSlot ? kNoComponent : clean_component(slot);
+}
+
+void SccIndex::on_emplace(uint32_t slot)
+{
+    ensure_slots(slot + 1);
+    if (!labels.empty() && labels.rbegin()->first > kLabelLimit)
+    {
+        relabel_all(kLabelGap);
+    }
+    uint32_t component = new_component(next_label());
+    link_member(component, slot);
+    labels.emplace_hint(labels.end(), components[component].label, component);
+}
+
+void SccIndex::on_erase(uint32_t slot, const RCObject &obj)
+{
+    const ObjectStore &store = heap;
+    for (int child_id : obj.references)
+    {
+        uint32_t child = store.slot_of(child_id);
+        if (child != ObjectStore::kInvalidSlot && child != slot)
+        {
+            in_edges[child].erase(static_cast<int>(slot));
+        }
+    }
+    // Входящие ссылки остаются только от мусора, который удаляется следом
+    in_edges[slot].clear();
+
+    uint32_t component = node_component[slot];
+    unlink_member(slot);
+    Component &entry = components[component];
+    if (entry.size == 0)
+    {
+        labels.erase(entry.label);
+        free_component(component);
+    }
+    else if (entry.size > 1)
+    {
+        entry.dirty = true;
+    }
+    else
+    {
+        entry.dirty = false;
+    }
+}
+
+bool SccIndex::verify()
+{
+    if (!attached)
+    {
+        return true;
+    }
+    const ObjectStore &store = heap;
+
+    // Членство и размеры компонент
+    size_t members = 0;
+    for (uint32_t component = 0; component < components.size(); ++component)
+    {
+        const Component &entry = components[component];
+        if (entry.size == 0)
+        {
+            continue;
+        }
+        auto it = labels.find(entry.label);
+        if (it == labels.end() || it->second != component)
+        {
+            return false;
+        }
+        uint32_t slot = entry.head;
+        for (uint32_t i = 0; i < entry.size; ++i)
+        {
+            if (node_component[slot] != component || member_prev[member_next[slot]] != slot)
+            {
+                return false;
+            }
+            slot = member_next[slot];
+        }
+        if (slot != entry.head)
+        {
+            return false;
+        }
+        members += entry.size;
+    }
+    if (members != store.size() || labels.size() + free_components.size() != components.size())
+    {
+        return false;
+    }
+
+    // Порядок согласован со ссылками, входящие ссылки совпадают с исходящими
+    std::vector<uint32_t> live;
+    size_t edges = 0;
+    for (uint32_t slot = 0; slot < store.slot_count(); ++slot)
+    {
+        if (!store.is_live_slot(slot))
+        {
+            if (slot < node_component.size() && node_component[slot] != kNoComponent)
+            {
+                return false;
+            }
+            continue;
+        }
+        live.push_back(slot);
+        edges += in_edges[slot].size();
+        for (int child_id : store.at_slot(slot).references)
+        {
+            uint32_t child = store.slot_of(child_id);
+            if (child == ObjectStore::kInvalidSlot)
+            {
+                continue;
+            }
+            if (!in_edges[child].contains(static_cast<int>(slot)) ||
+                components[node_component[slot]].label > components[node_component[child]].label)
+            {
+                return false;
+            }
+            edges--;
+        }
+    }
+    if (edges != 0)
+    {
+        return false;
+    }
+
+    // Каждая настоящая компонента лежит в одной компоненте индекса и,
+    // если та не грязная, совпадает с ней
+    tarjan(live, kNoComponent);
+    for (size_t k = 0; k + 1 < scc_offsets.size(); ++k)
+    {
+        const Component &entry = components[node_component[scc_nodes[scc_offsets[k]]]];
+        for (uint32_t i = scc_offsets[k]; i < scc_offsets[k + 1]; ++i)
+        {
+            if (&components[node_component[scc_nodes[i]]] != &entry)
+            {
+                return false;
+            }
+        }
+        if (!entry.dirty && entry.size != scc_offsets[k + 1] - scc_offsets[k])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t SccIndex::new_component(uint64_t label)
+{
+    uint32_t component;
+    if (!free_components.empty())
+    {
+        component = free_components.back();
+        free_components.pop_back();
+    }
+    else
+    {
+        component = static_cast<uint32_t>(components.size());
+        components.emplace_back();
+    }
+    Component &entry = components[component];
+    entry.label = label;
+    entry.size = 0;
+    entry.dirty = false;
+    return component;
+}
+
+void SccIndex::free_component(uint32_t component)
+{
+    components[component].size = 0;
+    components[component].dirty = false;
+    free_components.push_back(component);
+}
+
+void SccIndex::link_member(uint32_t component, uint32_t slot)
+{
+    Component &entry = components[component];
+    node_component[slot] = component;
+    if (entry.size == 0)
+    {
+        entry.head = slot;
+        member_next[slot] = member_prev[slot] = slot;
+    }
+    else
+    {
+        uint32_t tail = member_prev[entry.head];
+        member_next[tail] = slot;
+        member_prev[slot] = tail;
+        member_next[slot] = entry.head;
+        member_prev[entry.head] = slot;
+    }
+    entry.size++;
+}
+
+void SccIndex::unlink_member(uint32_t slot)
+{
+    Component &entry = components[node_component[slot]];
+    node_component[slot] = kNoComponent;
+    entry.size--;
+    if (entry.size == 0)
+    {
+        return;
+    }
+    uint32_t next = member_next[slot];
+    uint32_t prev = member_prev[slot];
+    member_next[prev] = next;
+    member_prev[next] = prev;
+    if (entry.head == slot)
+    {
+        entry.head = next;
+    }
+}
+
+void SccIndex::ensure_slots(uint32_t slot_count)
+{
+    if (slot_count <= node_component.size())
+    {
+        return;
+    }
+    // Рост удвоением: on_emplace вызывается на каждый новый слот
+    size_t size = std::max<size_t>(slot_count, 2 * node_component.size());
+    node_component.resize(size, kNoComponent);
+    member_next.resize(size);
+    member_prev.resize(size);
+    in_edges.resize(size);
+    tarjan_index.resize(size, 0);
+    tarjan_low.resize(size);
+    tarjan_on_stack.resize(size, 0);
+}
+
+void SccIndex::tarjan(const std::vector<uint32_t> &nodes, uint32_t within)
+{
+    const ObjectStore &store = heap;
+    scc_nodes.clear();
+    scc_offsets.assign(1, 0);
+
+    std::vector<std::pair<uint32_t, uint32_t>> &path = tarjan_path;
+    path.clear();
+    std::vector<uint32_t> &stack = work;
+    stack.clear();
+    uint32_t counter = 0;
+
+    for (uint32_t root : nodes)
+    {
+        if (tarjan_index[root] != 0)
+        {
+            continue;
+        }
+        tarjan_index[root] = tarjan_low[root] = ++counter;
+        tarjan_on_stack[root] = 1;
+        stack.push_back(root);
+        path.emplace_back(root, 0);
+
+        while (!path.empty())
+        {
+            const uint32_t slot = path.back().first;
+            const RCObject &obj = store.at_slot(slot);
+            if (path.back().second < obj.references.size())
+            {
+                uint32_t child = store.slot_of(obj.references.begin()[path.back().second++]);
+                if (child == ObjectStore::kInvalidSlot ||
+                    (within != kNoComponent && node_component[child] != within))
+                {
+                    continue;
+                }
+                if (tarjan_index[child] == 0)
+                {
+                    tarjan_index[child] = tarjan_low[child] = ++counter;
+                    tarjan_on_stack[child] = 1;
+                    stack.push_back(child);
+                    path.emplace_back(child, 0);
+                }
+                else if (tarjan_on_stack[child] != 0)
+                {
+                    tarjan_low[slot] = std::min(tarjan_low[slot], tarjan_index[child]);
+                }
+                continue;
+            }
+
+            path.pop_back();
+            if (!path.empty())
+            {
+                uint32_t parent = path.back().first;
+                tarjan_low[parent] = std::min(tarjan_low[parent], tarjan_low[slot]);
+            }
+            if (tarjan_low[slot] == tarjan_index[slot])
+            {
+                uint32_t member;
+                do
+                {
+                    member = stack.back();
+                    stack.pop_back();
+                    tarjan_on_stack[member] = 0;
+                    scc_nodes.push_back(member);
+                } while (member != slot);
+                scc_offsets.push_back(static_cast<uint32_t>(scc_nodes.size()));
+            }
+        }
+    }
+
+    for (uint32_t slot : scc_nodes)
+    {
+        tarjan_index[slot] = 0;
+    }
+}
+
+void SccIndex::split(uint32_t component)
+{
+    stats.splits++;
+    std::vector<uint32_t> members;
+    members.reserve(components[component].size);
+    uint32_t slot = components[component].head;
+    for (uint32_t i = 0; i < components[component].size; ++i)
+    {
+        members.push_back(slot);
+        slot = member_next[slot];
+    }
+
+    tarjan(members, component);
+    const size_t count = scc_offsets.size() - 1;
+    components[component].dirty = false;
+    if (count == 1)
+    {
+        return;
+    }
+
+    // Части в топологическом порядке (обратном порядку Тарьяна) встают
+    // на метки от метки старой компоненты до следующей метки
+    uint64_t first = components[component].label;
+    auto next = labels.upper_bound(first);
+    uint64_t step = (next == labels.end() ? kLabelGap : (next->first - first) / count);
+    if (step == 0)
+    {
+        const uint64_t spacing = std::max<uint64_t>(kLabelGap, count);
+        relabel_all(spacing);
+        first = components[component].label;
+        step = spacing / count;
+    }
+
+    for (uint32_t member : members)
+    {
+        node_component[member] = kNoComponent;
+    }
+    components[component].size = 0;
+    for (size_t k = 0; k < count; ++k)
+    {
+        const size_t part = count - 1 - k;
+        uint32_t target = component;
+        if (k != 0)
+        {
+            target = new_component(first + step * k);
+            labels.emplace(components[target].label, target);
+        }
+        for (uint32_t i = scc_offsets[part]; i < scc_offsets[part + 1]; ++i)
+        {
+            link_member(target, scc_nodes[i]);
+        }
+    }
+}
+
+uint32_t SccIndex::merge(const std::vector<uint32_t> &parts)
+{
+    uint32_t merged = parts[0];
+    for (uint32_t component : parts)
+    {
+        if (components[component].size > components[merged].size)
+        {
+            merged = component;
+        }
+    }
+
+    Component &target = components[merged];
+    for (uint32_t component : parts)
+    {
+        if (component == merged)
+        {
+            continue;
+        }
+        Component &part = components[component];
+        uint32_t slot = part.head;
+        for (uint32_t i = 0; i < part.size; ++i)
+        {
+            node_component[slot] = merged;
+            slot = member_next[slot];
+        }
+        // Вклеить кольцо part перед головой target
+        uint32_t target_tail = member_prev[target.head];
+        uint32_t part_tail = member_prev[part.head];
+        member_next[target_tail] = part.head;
+        member_prev[part.head] = target_tail;
+        member_next[part_tail] = target.head;
+        member_prev[target.head] = part_tail;
+        target.size += part.size;
+        target.dirty = target.dirty || part.dirty;
+        free_component(component);
+    }
+    return merged;
+}
+
+void SccIndex::start_search(uint32_t forward_start, uint32_t backward_start)
+{
+    const uint32_t epoch = ++visit_epoch;
+    forward.assign(1, forward_start);
+    backward.assign(1, backward_start);
+    forward_next = backward_next = 0;
+    forward_work = backward_work = 0;
+    components[forward_start].forward_visit = epoch;
+    components[backward_start].backward_visit = epoch;
+}
+
+void SccIndex::advance_forward(uint64_t bound)
+{
+    const ObjectStore &store = heap;
+    const uint32_t epoch = visit_epoch;
+    const uint32_t component = forward[forward_next++];
+    uint32_t slot = components[component].head;
+    for (uint32_t i = 0; i < components[component].size; ++i, slot = member_next[slot])
+    {
+        const RCObject &obj = store.at_slot(slot);
+        forward_work += 1 + obj.references.size();
+        for (int child_id : obj.references)
+        {
+            uint32_t child = store.slot_of(child_id);
+            if (child == ObjectStore::kInvalidSlot)
+            {
+                continue;
+            }
+            Component &entry = components[node_component[child]];
+            if (entry.forward_visit != epoch && entry.label <= bound)
+            {
+                entry.forward_visit = epoch;
+                forward.push_back(node_component[child]);
+            }
+        }
+    }
+}
+
+void SccIndex::advance_backward(uint64_t bound)
+{
+    const uint32_t epoch = visit_epoch;
+    const uint32_t component = backward[backward_next++];
+    uint32_t slot = components[component].head;
+    for (uint32_t i = 0; i < components[component].size; ++i, slot = member_next[slot])
+    {
+        backward_work += 1 + in_edges[slot].size();
+        for (int source : in_edges[slot])
+        {
+            Component &entry = components[node_component[source]];
+            if (entry.backward_visit != epoch && entry.label >= bound)
+            {
+                entry.backward_visit = epoch;
+                backward.push_back(node_component[source]);
+            }
+        }
+    }
+}
+
+uint32_t SccIndex::collect_cycle(uint32_t start, bool forward_done, uint32_t epoch)
+{
+    // Внутри F ищем компоненты, из которых достижим u (обход по входящим
+    // ссылкам от u), внутри B — достижимые из v (обход по исходящим от v)
+    const ObjectStore &store = heap;
+    const uint32_t mark = ++visit_epoch;
+    std::vector<uint32_t> &cyclic = merge_buffer;
+    cyclic.assign(1, start);
+    (forward_done ? components[start].backward_visit : components[start].forward_visit) = mark;
+
+    auto reach = [&](uint32_t component)
+    {
+        Component &entry = components[component];
+        if (forward_done && entry.forward_visit == epoch && entry.backward_visit != mark)
+        {
+            entry.backward_visit = mark;
+            cyclic.push_back(component);
+        }
+        else if (!forward_done && entry.backward_visit == epoch && entry.forward_visit != mark)
+        {
+            entry.forward_visit = mark;
+            cyclic.push_back(component);
+        }
+    };
+
+    for (size_t next = 0; next < cyclic.size(); ++next)
+    {
+        const uint32_t component = cyclic[next];
+        uint32_t slot = components[component].head;
+        for (uint32_t i = 0; i < components[component].size; ++i, slot = member_next[slot])
+        {
+            if (forward_done)
+            {
+                for (int source : in_edges[slot])
+                {
+                    reach(node_component[source]);
+                }
+            }
+            else
+            {
+                for (int child_id : store.at_slot(slot).references)
+                {
+                    uint32_t child = store.slot_of(child_id);
+                    if (child != ObjectStore::kInvalidSlot)
+                    {
+                        reach(node_component[child]);
+                    }
+                }
+            }
+        }
+    }
+    stats.components_visited += cyclic.size();
+    return mark;
+}
+
+void SccIndex::relocate(const std::vector<uint32_t> &order, uint64_t position)
+{
+    // Промежуток между последней оставшейся меткой не больше position и следующей
+    auto it = labels.upper_bound(position);
+    const uint32_t low_component = it == labels.begin() ? kNoComponent : std::prev(it)->second;
+    const uint64_t parts = order.size() + 1;
+    uint64_t low, step;
+    for (;;)
+    {
+        low = low_component == kNoComponent ? 0 : components[low_component].label;
+        auto next = low_component == kNoComponent ? labels.begin() : labels.upper_bound(low);
+        const uint64_t high = next == labels.end() ? low + kLabelGap : next->first;
+        step = (high - low) / parts;
+        if (step != 0)
+        {
+            break;
+        }
+        relabel_all(kLabelGap);
+    }
+
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        const uint64_t label = low + step * (i + 1);
+        components[order[i]].label = label;
+        labels.emplace(label, order[i]);
+    }
+}
+
+void SccIndex::relabel_all(uint64_t spacing)
+{
+    stats.relabels++;
+    std::map<uint64_t, uint32_t> relabeled;
+    uint64_t label = 0;
+    for (const auto &entry : labels)
+    {
+        label += spacing;
+        components[entry.second].label = label;
+        relabeled.emplace_hint(relabeled.end(), label, entry.second);
+    }
+    labels.swap(relabeled);
+}
+
+uint32_t SccIndex::clean_component(uint32_t slot)
+{
+    uint32_t component = node_component[slot];
+    if (components[component].dirty)
+    {
+        split(component);
+        component = node_component[slot];
+    }
+    return component;
+}
@@ -0,0 +1,376 @@
+#include "scenario_reader.h"
+
+#include <climits>
+#include <iostream>
+#include <stdexcept>
+
+namespace
+{
+    const size_t kBufferSize = 1 << 16;
+}
+
+ScenarioReader::ScenarioReader(const std::string &filename_)
+    : filename(filename_), file(std::fopen(filename_.c_str(), "rb")), buffer(kBufferSize), pos(0), filled(0),
+      consumed(0), line(1), started(false), in_array(false), finished(false), parsed(0), skipped_ops(0)
+{
+    if (file == nullptr)
+    {
+        throw std::runtime_error("Failed to open scenario file: " + filename);
+    }
+}
+
+ScenarioReader::~ScenarioReader()
+{
+    std::fclose(file);
+}
+
+bool ScenarioReader::refill()
+{
+    consumed += filled;
+    pos = 0;
+    filled = std::fread(buffer.data(), 1, buffer.size(), file);
+    return filled > 0;
+}
+
+void ScenarioReader::fail(const std::string &message) const
+{
+    throw std::runtime_error(filename + ":" + std::to_string(line) + ": " + message);
+}
+
+void ScenarioReader::skip_whitespace()
+{
+    for (;;)
+    {
+        int c = peek();
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r')
+        {
+            return;
+        }
+        get();
+    }
+}
+
+void ScenarioReader::expect(char c)
+{
+    skip_whitespace();
+    int actual = get();
+    if (actual != c)
+    {
+        fail(std::string("expected '") + c + "', got " +
+             (actual == EOF ? std::string("end of file") : "'" + std::string(1, static_cast<char>(actual)) + "'"));
+    }
+}
+
+bool ScenarioReader::next(ScenarioOp &op)
+{
+    while (!finished)
+    {
+        skip_whitespace();
+        if (!started)
+        {
+            started = true;
+            if (peek() == '[')
+            {
+                get();
+                in_array = true;
+                continue;
+            }
+        }
+
+        int c = peek();
+        if (c == EOF)
+        {
+            if (in_array)
+            {
+                fail("unexpected end of file, expected ']'");
+            }
+            finished = true;
+            break;
+        }
+
+        if (in_array)
+        {
+            if (c == ']')
+            {
+                get();
+                skip_whitespace();
+                if (peek() != EOF)
+                {
+                    fail("unexpected data after ']'");
+                }
+                finished = true;
+                break;
+            }
+            if (parsed > 0)
+            {
+                expect(',');
+            }
+        }
+        else if (c == ',')
+        {
+            get(); // Запятые между объектами без массива допускаются
+            continue;
+        }
+
+        parsed++;
+        if (parse_op(op))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ScenarioReader::parse_op(ScenarioOp &op)
+{
+    const size_t op_line = line;
+    op = ScenarioOp();
+    bool has_op = false;
+
+    expect('{');
+    skip_whitespace();
+    if (peek() == '}')
+    {
+        get();
+    }
+    else
+    {
+        for (;;)
+        {
+            skip_whitespace();
+            parse_string(token);
+            expect(':');
+            skip_whitespace();
+
+            if (token == "op")
+            {
+                parse_string(token);
+                op.op = parse_op_code(token);
+                has_op = true;
+                if (op.op == OpCode::Unknown)
+                {
+                    std::cerr << "Warning: " << filename << ":" << op_line
+                              << ": unknown operation '" << token << "' skipped\n";
+                }
+            }
+            else if (token == "id")
+            {
+                op.id = parse_int();
+            }
+            else if (token == "from")
+            {
+                op.from = parse_int();
+            }
+            else if (token == "to")
+            {
+                op.to = parse_int();
+            }
+            else
+            {
+                skip_value();
+            }
+
+            skip_whitespace();
+            int c = get();
+            if (c == '}')
+            {
+                break;
+            }
+            if (c != ',')
+            {
+                fail("expected ',' or '}' in operation");
+            }
+        }
+    }
+
+    if (!has_op)
+    {
+        fail("operation without \"op\" field");
+    }
+    if (op.op == OpCode::Unknown)
+    {
+        skipped_ops++;
+        return false;
+    }
+    return true;
+}
+
+void ScenarioReader::parse_string(std::string &out)
+{
+    out.clear();
+    if (get() != '"')
+    {
+        fail("expected string");
+    }
+    for (;;)
+    {
+        int c = get();
+        if (c == EOF || c == '\n')
+        {
+            fail("unterminated string");
+        }
+        if (c == '"')
+        {
+            return;
+        }
+        if (c != '\\')
+        {
+            out.push_back(static_cast<char>(c));
+            continue;
+        }
+
+        c = get();
+        switch (c)
+        {
+        case '"':
+        case '\\':
+        case '/':
+            out.push_back(static_cast<char>(c));
+            break;
+        case 'b':
+            out.push_back('\b');
+            break;
+        case 'f':
+            out.push_back('\f');
+            break;
+        case 'n':
+            out.push_back('\n');
+            break;
+        case 'r':
+            out.push_back('\r');
+            break;
+        case 't':
+            out.push_back('\t');
+            break;
+        case 'u':
+        {
+            unsigned code = 0;
+            for (int i = 0; i < 4; ++i)
+            {
+                int h = get();
+                int digit = h >= '0' && h <= '9'   ? h - '0'
+                            : h >= 'a' && h <= 'f' ? h - 'a' + 10
+                            : h >= 'A' && h <= 'F' ? h - 'A' + 10
+                                                   : -1;
+                if (digit < 0)
+                {
+                    fail("invalid \\u escape");
+                }
+                code = code * 16 + static_cast<unsigned>(digit);
+            }
+            // Имена операций — ASCII; остальное кодируется в UTF-8 без склейки суррогатных пар
+            if (code < 0x80)
+            {
+                out.push_back(static_cast<char>(code));
+            }
+            else if (code < 0x800)
+            {
+                out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+                out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+            }
+            else
+            {
+                out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+                out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+            }
+            break;
+        }
+        default:
+            fail("invalid escape in string");
+        }
+    }
+}
+
+int ScenarioReader::parse_int()
+{
+    bool negative = false;
+    if (peek() == '-')
+    {
+        get();
+        negative = true;
+    }
+    int c = peek();
+    if (c < '0' || c > '9')
+    {
+        fail("expected integer");
+    }
+
+    long long value = 0;
+    while (c >= '0' && c <= '9')
+    {
+        value = value * 10 + (c - '0');
+        if (value > static_cast<long long>(INT_MAX) + 1)
+        {
+            fail("integer out of range");
+        }
+        get();
+        c = peek();
+    }
+    if (c == '.' || c == 'e' || c == 'E')
+    {
+        fail("expected integer");
+    }
+    value = negative ? -value : value;
+    if (value > INT_MAX)
+    {
+        fail("integer out of range");
+    }
+    return static_cast<int>(value);
+}
+
+void ScenarioReader::skip_value()
+{
+    // Вложенные объекты и массивы пропускаются по счётчику глубины
+    int depth = 0;
+    do
+    {
+        skip_whitespace();
+        int c = peek();
+        if (c == '"')
+        {
+            parse_string(token);
+        }
+        else if (c == '{' || c == '[')
+        {
+            get();
+            depth++;
+        }
+        else if (c == '}' || c == ']')
+        {
+            if (depth == 0)
+            {
+                fail("unexpected '" + std::string(1, static_cast<char>(c)) + "'");
+            }
+            get();
+            depth--;
+        }
+        else if (c == ',' || c == ':')
+        {
+            if (depth == 0)
+            {
+                fail("expected value");
+            }
+            get();
+        }
+        else if (c == EOF)
+        {
+            fail("unexpected end of file");
+        }
+        else
+        {
+            // Число или литерал true/false/null
+            size_t length = 0;
+            while (c != EOF && c != ',' && c != '}' && c != ']' && c != ' ' && c != '\t' && c != '\n' && c != '\r')
+            {
+                get();
+                c = peek();
+                length++;
+            }
+            if (length == 0)
+            {
+                fail("expected value");
+            }
+        }
+    } while (depth > 0);
+}
@@ -1,8 +1,20 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "rc_heap.h"
 #include "event_logger.h"
+#include "scenario_reader.h"
+#include "binary_trace.h"
+#include "heap_snapshot.h"
+#include "dominator_tree.h"
 
 using std::cout;
 using std::endl;
@@ -173,11 +185,152 @@ void scenario_multiple_refs(RCHeap &heap)
     cout << "✓ Scenario D completed\n\n";
 }
 
+/* =======================
+   Stats
+   ======================= */
+const char *kStatsPath = "logs/rc_stats.jsonl";
+
+/**
+ * Вывести статистику кучи и дописать JSON-снимок строкой в kStatsPath
+ */
+void report_stats(const RCHeap &heap, const std::string &source)
+{
+    heap.dump_stats();
+    std::ofstream out(kStatsPath, std::ios::app);
+    out << "{\"source\": \"" << source << "\", \"stats\": " << heap.stats_json() << "}\n";
+}
+
+const char *kLeaksPath = "logs/rc_leaks.jsonl";
+
+/**
+ * Вывести утечки, сгруппированные по циклам, и дописать отчёт строкой в kLeaksPath
+ */
+void report_leaks(const RCHeap &heap, const std::string &source)
+{
+    LeakReport report = heap.analyze_leaks();
+    report.dump(cout);
+    std::ofstream out(kLeaksPath, std::ios::app);
+    out << "{\"source\": \"" << source << "\", \"leaks\": " << report.to_json() << "}\n";
+}
+
+const char *kRetainedPath = "logs/rc_retained.jsonl";
+
+/**
+ * Вывести top объектов по удерживаемому размеру и дописать их строкой в kRetainedPath
+ */
+void report_retained(const RCHeap &heap, const std::string &source, size_t top)
+{
+    HeapImage image = heap.capture_image();
+    DominatorTree tree(image);
+    tree.dump(cout, top);
+    std::ofstream out(kRetainedPath, std::ios::app);
+    out << "{\"source\": \"" << source << "\", \"retained\": " << tree.to_json(top) << "}\n";
+}
+
+/* =======================
+   Scenario files
+   ======================= */
+void replay_file(EventLogger &logger, const std::string &path, bool dump_each, bool stats, bool leaks,
+                 size_t retained, HeapSnapshotWriter *snapshot)
+{
+    cout << "\n▶ Scenario file: " << path << "\n\n";
+
+    // Каждый файл выполняется на своей куче: ID в разных сценариях пересекаются
+    RCHeap heap(logger);
+    heap.attach_snapshot(snapshot);
+    size_t ops = 0;
+    size_t skipped = 0;
+    auto start = std::chrono::steady_clock::now();
+    if (BinaryTraceReader::is_binary_trace(path))
+    {
+        BinaryTraceReader reader(path);
+        ops = heap.replay(reader, dump_each);
+    }
+    else
+    {
+        ScenarioReader reader(path);
+        ops = heap.replay(reader, dump_each);
+        skipped = reader.skipped();
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!dump_each)
+    {
+        heap.dump_state();
+    }
+    heap.detect_and_log_leaks();
+
+    char rate[96];
+    std::snprintf(rate, sizeof(rate), "%zu ops in %.3f ms (%.0f ops/s)", ops, sec * 1e3, sec > 0 ? ops / sec : 0.0);
+    cout << "✓ " << rate;
+    if (skipped > 0)
+    {
+        cout << ", " << skipped << " unknown ops skipped";
+    }
+    cout << "\n"
+         << "  Heap size: " << heap.get_heap_size() << " objects, roots: " << heap.get_roots_count() << "\n";
+    if (stats)
+    {
+        report_stats(heap, path);
+    }
+    if (leaks)
+    {
+        report_leaks(heap, path);
+    }
+    if (retained > 0)
+    {
+        report_retained(heap, path, retained);
+    }
+}
+
 /* =======================
    MAIN
    ======================= */
-int main()
+int main(int argc, char **argv)
 {
+    // rc_simulator [--dump-each] [--stats] [--leak-report] [--retained K] [--snapshot file.rcsn]
+    //              [scenario.json | trace.rctr ...]
+    // Без файлов выполняются встроенные сценарии A–D. --stats выводит
+    // статистику кучи (сборка с -DRC_ENABLE_STATS) и пишет её в logs/rc_stats.jsonl.
+    // --leak-report выводит утечки, сгруппированные по циклам, и пишет отчёт в logs/rc_leaks.jsonl.
+    // --retained K выводит K объектов с наибольшим удерживаемым размером (дерево доминаторов)
+    // и пишет их в logs/rc_retained.jsonl.
+    // --snapshot пишет кадр снимка кучи после каждой операции файлов сценариев
+    // (просмотр — rc_snapshot_dump)
+    bool dump_each = false;
+    bool stats = false;
+    bool leaks = false;
+    size_t retained = 0;
+    std::string snapshot_path;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--dump-each") == 0)
+        {
+            dump_each = true;
+        }
+        else if (std::strcmp(argv[i], "--stats") == 0)
+        {
+            stats = true;
+        }
+        else if (std::strcmp(argv[i], "--leak-report") == 0)
+        {
+            leaks = true;
+        }
+        else if (std::strcmp(argv[i], "--retained") == 0 && i + 1 < argc)
+        {
+            retained = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc)
+        {
+            snapshot_path = argv[++i];
+        }
+        else
+        {
+            files.push_back(argv[i]);
+        }
+    }
+
     cout << "\n";
     cout << "╔════════════════════════════════════════════════════════════╗\n";
     cout << "║ Reference Counting GC Simulator (WITH ROOTS)               ║\n";
@@ -194,6 +347,26 @@ int main()
             return 1;
         }
 
+        if (!files.empty())
+        {
+            std::unique_ptr<HeapSnapshotWriter> snapshot;
+            if (!snapshot_path.empty())
+            {
+                snapshot.reset(new HeapSnapshotWriter(snapshot_path));
+            }
+            for (const std::string &path : files)
+            {
+                replay_file(logger, path, dump_each, stats, leaks, retained, snapshot.get());
+            }
+            if (snapshot)
+            {
+                snapshot->close();
+                cout << "Snapshot: " << snapshot->get_frame_count() << " frames, "
+                     << snapshot->get_bytes_written() << " bytes -> " << snapshot_path << "\n";
+            }
+            return 0;
+        }
+
         // Инициализировать кучу
         RCHeap heap(logger);
 
@@ -205,6 +378,18 @@ int main()
 
         // Обнаружить и залогировать остающиеся утечки
         heap.detect_and_log_leaks();
+        if (stats)
+        {
+            report_stats(heap, "builtin");
+        }
+        if (leaks)
+        {
+            report_leaks(heap, "builtin");
+        }
+        if (retained > 0)
+        {
+            report_retained(heap, "builtin", retained);
+        }
 
         cout << "╔════════════════════════════════════════════════════════════╗\n";
         cout << "║ ✓ All scenarios finished successfully                       ║\n";
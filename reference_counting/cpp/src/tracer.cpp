@@ -0,0 +1,184 @@
+#include "tracer.h"
+
+#include <algorithm>
+
+Tracer::Tracer(ObjectStore &heap_, EventLogger &logger_)
+    : heap(heap_), logger(logger_), parallel(heap_, 1), threads(1)
+{
+}
+
+void Tracer::set_threads(unsigned threads_)
+{
+    parallel.set_thread_count(threads_);
+    threads = parallel.get_thread_count();
+}
+
+size_t Tracer::mark(const std::unordered_set<int> &roots)
+{
+    if (threads > 1)
+    {
+        return parallel.mark(roots, marks);
+    }
+
+    // Пометка только читает кучу: константный доступ не копирует разделённые со срезом куски
+    const ObjectStore &store = heap;
+    const uint32_t slot_count = store.slot_count();
+    marks.reset(slot_count);
+    stack.clear();
+
+    // Явные корни
+    for (int root_id : roots)
+    {
+        uint32_t slot = store.slot_of(root_id);
+        if (slot != ObjectStore::kInvalidSlot)
+        {
+            push(slot);
+        }
+    }
+
+    // Неявные корни: объекты без входящих ссылок удерживает мутатор
+    for (uint32_t slot = 0; slot < slot_count; ++slot)
+    {
+        if (store.is_live_slot(slot) && store.at_slot(slot).ref_count == 0)
+        {
+            push(slot);
+        }
+    }
+
+    size_t marked = 0;
+    while (!stack.empty())
+    {
+        uint32_t slot = stack.back();
+        stack.pop_back();
+        marked++;
+
+        for (int child_id : store.at_slot(slot).references)
+        {
+            uint32_t child_slot = store.slot_of(child_id);
+            if (child_slot != ObjectStore::kInvalidSlot)
+            {
+                push(child_slot);
+            }
+        }
+    }
+    return marked;
+}
+
+size_t Tracer::sweep()
+{
+    garbage.clear();
+    const uint32_t slot_count = heap.slot_count();
+    for (uint32_t slot = 0; slot < slot_count; ++slot)
+    {
+        if (heap.is_live_slot(slot) && !is_marked(slot))
+        {
+            garbage.push_back(heap.at_slot(slot).id);
+        }
+    }
+
+    // Снять ссылки мусора с живых объектов до освобождения
+    for (int obj_id : garbage)
+    {
+        for (int child_id : heap.find(obj_id)->references)
+        {
+            uint32_t child_slot = heap.slot_of(child_id);
+            if (child_slot != ObjectStore::kInvalidSlot && is_marked(child_slot))
+            {
+                RCObject &child = heap.at_slot(child_slot);
+                if (child.ref_count > 0)
+                {
+                    child.ref_count--;
+                    heap.touch(child);
+                }
+            }
+        }
+    }
+
+    for (int obj_id : garbage)
+    {
+        logger.log_leak(obj_id);
+        heap.erase(obj_id);
+        logger.log_delete(obj_id);
+    }
+    return garbage.size();
+}
+
+size_t Tracer::log_unmarked()
+{
+    const ObjectStore &store = heap;
+    size_t leaks = 0;
+    const uint32_t slot_count = store.slot_count();
+    for (uint32_t slot = 0; slot < slot_count; ++slot)
+    {
+        if (store.is_live_slot(slot) && !is_marked(slot))
+        {
+            logger.log_leak(store.at_slot(slot).id);
+            leaks++;
+        }
+    }
+    return leaks;
+}
+
+size_t Tracer::restore_sticky_counts(const std::unordered_set<int> &roots)
+{
+    if (!kCompactHeader)
+    {
+        return 0;
+    }
+
+    // Проходы только читают кучу: константный доступ не копирует разделённые со срезом куски
+    const ObjectStore &store = heap;
+    sticky.clear();
+    const uint32_t slot_count = store.slot_count();
+    for (uint32_t slot = 0; slot < slot_count; ++slot)
+    {
+        if (store.is_live_slot(slot) && store.at_slot(slot).has_sticky_count())
+        {
+            sticky.push_back(slot);
+        }
+    }
+    if (sticky.empty())
+    {
+        return 0;
+    }
+
+    // Залипших объектов мало: счёт по отсортированному списку их слотов, отбор по битовой карте
+    MarkBitmap is_sticky;
+    is_sticky.reset(slot_count);
+    for (uint32_t slot : sticky)
+    {
+        is_sticky.set(slot);
+    }
+    std::vector<int> counts(sticky.size(), 0);
+    auto count_ref = [&](int target_id) {
+        uint32_t slot = store.slot_of(target_id);
+        if (slot != ObjectStore::kInvalidSlot && is_sticky.test(slot))
+        {
+            counts[std::lower_bound(sticky.begin(), sticky.end(), slot) - sticky.begin()]++;
+        }
+    };
+    for (int root_id : roots)
+    {
+        count_ref(root_id);
+    }
+    for (uint32_t slot = 0; slot < slot_count; ++slot)
+    {
+        if (store.is_live_slot(slot) && is_marked(slot))
+        {
+            for (int child_id : store.at_slot(slot).references)
+            {
+                count_ref(child_id);
+            }
+        }
+    }
+
+    size_t restored = 0;
+    for (size_t i = 0; i < sticky.size(); ++i)
+    {
+        RCObject &obj = heap.at_slot(sticky[i]);
+        obj.ref_count = counts[i];
+        heap.touch(obj);
+        restored += !obj.has_sticky_count();
+    }
+    return restored;
+}
@@ -0,0 +1,130 @@
+#include "weak_ref_table.h"
+
+#include <algorithm>
+
+WeakRefTable::WeakRefTable(ObjectStore &store_, EventLogger &logger_)
+    : store(store_), logger(logger_), attached(false), live_refs(0)
+{
+}
+
+WeakRefTable::~WeakRefTable()
+{
+    if (attached)
+    {
+        store.remove_listener(this);
+    }
+}
+
+void WeakRefTable::ensure_slots(uint32_t slot_count)
+{
+    if (held.size() < slot_count)
+    {
+        held.resize(slot_count);
+        counts.resize(slot_count, 0);
+    }
+}
+
+bool WeakRefTable::add(int from, int to)
+{
+    if (!attached)
+    {
+        store.add_listener(this);
+        attached = true;
+    }
+    const ObjectHandle target = store.handle_of(to);
+    const uint32_t holder = store.slot_of(from);
+    ensure_slots(store.slot_count());
+
+    // Устаревшая ссылка на тот же ID (прежний объект) заменяется новой
+    std::vector<WeakRef> &refs = held[holder];
+    auto it = std::find_if(refs.begin(), refs.end(), [to](const WeakRef &ref) { return ref.target_id == to; });
+    if (it != refs.end())
+    {
+        if (store.is_valid(it->target))
+        {
+            return false;
+        }
+        *it = refs.back();
+        refs.pop_back();
+    }
+    refs.push_back(WeakRef{to, target});
+    live_refs++;
+    logger.log_add_weak_ref(from, to, static_cast<int>(++counts[target.slot]));
+    return true;
+}
+
+bool WeakRefTable::remove(int from, int to)
+{
+    const uint32_t holder = store.slot_of(from);
+    if (holder == ObjectStore::kInvalidSlot || holder >= held.size())
+    {
+        return false;
+    }
+    std::vector<WeakRef> &refs = held[holder];
+    auto it = std::find_if(refs.begin(), refs.end(), [to](const WeakRef &ref) { return ref.target_id == to; });
+    if (it == refs.end())
+    {
+        return false;
+    }
+    uint32_t remaining = 0;
+    if (store.is_valid(it->target))
+    {
+        live_refs--;
+        remaining = --counts[it->target.slot];
+    }
+    *it = refs.back();
+    refs.pop_back();
+    logger.log_remove_weak_ref(from, to, static_cast<int>(remaining));
+    return true;
+}
+
+bool WeakRefTable::is_valid(int from, int to) const
+{
+    const uint32_t holder = store.slot_of(from);
+    if (holder == ObjectStore::kInvalidSlot || holder >= held.size())
+    {
+        return false;
+    }
+    for (const WeakRef &ref : held[holder])
+    {
+        if (ref.target_id == to && store.is_valid(ref.target))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t WeakRefTable::weak_count(int id) const
+{
+    const uint32_t slot = store.slot_of(id);
+    return slot == ObjectStore::kInvalidSlot || slot >= counts.size() ? 0 : counts[slot];
+}
+
+void WeakRefTable::on_erase(uint32_t slot, const RCObject &obj)
+{
+    if (slot >= held.size())
+    {
+        return;
+    }
+
+    // Слабые ссылки самого объекта исчезают вместе с ним
+    std::vector<WeakRef> &refs = held[slot];
+    for (const WeakRef &ref : refs)
+    {
+        if (store.is_valid(ref.target))
+        {
+            live_refs--;
+            logger.log_remove_weak_ref(obj.id, ref.target_id, static_cast<int>(--counts[ref.target.slot]));
+        }
+    }
+    refs.clear(); // память остаётся слоту: следующему объекту в нём не нужно выделять её заново
+
+    // Ссылки на объект устаревают вместе с поколением слота: держатели не трогаются
+    if (counts[slot] > 0)
+    {
+        live_refs -= counts[slot];
+        logger.log_weak_expire(obj.id, static_cast<int>(counts[slot]));
+        counts[slot] = 0;
+    }
+}
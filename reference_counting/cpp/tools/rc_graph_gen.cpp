@@ -0,0 +1,123 @@
+/**
+ * Генератор графов объектов в JSON-сценарий (см. graph_generators.h).
+ *
+ * Сценарий строит граф (allocate, add_ref, add_root) и выполняется
+ * симулятором как обычный файл из каталога scenarios/.
+ *
+ * Сборка (из каталога cpp/):
+ *   cmake -S . -B build && cmake --build build --target rc_graph_gen
+ * Запуск:
+ *   build/rc_graph_gen <chain|tree|erdos_renyi|power_law> n=<N> [p=<P>] [m=<M>] [roots=<R>] [seed=<S>] <output.json>
+ *   p — вероятность ссылки (erdos_renyi, по умолчанию 2/n), m — ссылок
+ *   на новую вершину (power_law, по умолчанию 2), roots — число корней
+ *   случайных графов (по умолчанию n/100 + 1), seed — по умолчанию 1.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+
+#include "graph_generators.h"
+
+namespace
+{
+    int usage(const char *program)
+    {
+        std::fprintf(stderr,
+                     "Usage: %s <chain|tree|erdos_renyi|power_law> n=<N> [p=<P>] [m=<M>] [roots=<R>] [seed=<S>] "
+                     "<output.json>\n",
+                     program);
+        return 2;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        return usage(argv[0]);
+    }
+    const std::string kind = argv[1];
+    const std::string output = argv[argc - 1];
+
+    int n = -1;
+    int m = 2;
+    int roots = -1;
+    double p = -1;
+    unsigned long long seed = 1;
+    for (int i = 2; i < argc - 1; ++i)
+    {
+        const char *eq = std::strchr(argv[i], '=');
+        if (eq == nullptr)
+        {
+            return usage(argv[0]);
+        }
+        const std::string key(argv[i], eq - argv[i]);
+        const char *value = eq + 1;
+        if (key == "n")
+        {
+            n = std::atoi(value);
+        }
+        else if (key == "p")
+        {
+            p = std::atof(value);
+        }
+        else if (key == "m")
+        {
+            m = std::atoi(value);
+        }
+        else if (key == "roots")
+        {
+            roots = std::atoi(value);
+        }
+        else if (key == "seed")
+        {
+            seed = std::strtoull(value, nullptr, 10);
+        }
+        else
+        {
+            return usage(argv[0]);
+        }
+    }
+    if (n <= 0)
+    {
+        return usage(argv[0]);
+    }
+    roots = roots >= 0 ? roots : n / 100 + 1;
+
+    Graph graph;
+    if (kind == "chain")
+    {
+        graph = make_chain(n);
+    }
+    else if (kind == "tree")
+    {
+        graph = make_binary_tree(n);
+    }
+    else if (kind == "erdos_renyi")
+    {
+        graph = make_erdos_renyi(n, p >= 0 ? p : 2.0 / n, roots, seed);
+    }
+    else if (kind == "power_law")
+    {
+        graph = make_power_law(n, m, roots, seed);
+    }
+    else
+    {
+        return usage(argv[0]);
+    }
+
+    try
+    {
+        graph.write_scenario_json(output);
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+    std::fprintf(stderr, "%s: %d objects, %zu refs, %zu roots\n", graph.name.c_str(), graph.node_count,
+                 graph.edges.size(), graph.roots.size());
+    return 0;
+}
@@ -0,0 +1,56 @@
+/**
+ * Конвертер бинарного лога событий (LogFormat::Binary) в JSON-строки —
+ * тот же формат, что пишет LogFormat::JsonLines и читает Python-аниматор.
+ *
+ * Сборка (из каталога cpp/):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target rc_log_to_json
+ * Запуск:
+ *   build/rc_log_to_json <binary_log> [output.log]   (без output — в stdout)
+ */
+#include <cstdio>
+#include <exception>
+
+#include "log_sink.h"
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "Usage: %s <binary_log> [output.log]\n", argv[0]);
+        return 2;
+    }
+
+    try
+    {
+        BinaryLogReader reader(argv[1]);
+        std::FILE *out = argc > 2 ? std::fopen(argv[2], "w") : stdout;
+        if (out == nullptr)
+        {
+            std::fprintf(stderr, "Error: cannot open %s\n", argv[2]);
+            return 1;
+        }
+
+        LogRecord record;
+        char line[kJsonRecordMax];
+        unsigned long long events = 0;
+        while (reader.next(record))
+        {
+            size_t len = format_json_record(record, line);
+            line[len++] = '\n';
+            std::fwrite(line, 1, len, out);
+            events++;
+        }
+
+        if (out != stdout)
+        {
+            std::fclose(out);
+        }
+        std::fprintf(stderr, "%llu events\n", events);
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,120 @@
+/**
+ * Просмотр файла снимков кучи (HeapSnapshotWriter, rc_simulator --snapshot).
+ *
+ * Применяет кадры по порядку и печатает состояние кучи в формате
+ * RCHeap::dump_state(): после последнего кадра или после кадра N.
+ * С --diffs для каждого кадра печатается, какие объекты он удалил и записал.
+ * С --retained K вместо состояния печатаются K объектов с наибольшим
+ * удерживаемым размером по дереву доминаторов (DominatorTree).
+ *
+ * Сборка (из каталога cpp/):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target rc_snapshot_dump
+ * Запуск:
+ *   build/rc_snapshot_dump <snapshot.rcsn> [--frame N] [--diffs] [--retained K]
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "dominator_tree.h"
+#include "heap_snapshot.h"
+
+namespace
+{
+    void print_ids(const char *label, const std::vector<int> &ids)
+    {
+        std::cout << "  " << label << " (" << ids.size() << "):";
+        for (int id : ids)
+        {
+            std::cout << " " << id;
+        }
+        std::cout << "\n";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "Usage: %s <snapshot.rcsn> [--frame N] [--diffs] [--retained K]\n", argv[0]);
+        return 2;
+    }
+
+    long long stop_frame = -1;
+    bool diffs = false;
+    size_t retained = 0;
+    for (int i = 2; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--frame") == 0 && i + 1 < argc)
+        {
+            stop_frame = std::atoll(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--diffs") == 0)
+        {
+            diffs = true;
+        }
+        else if (std::strcmp(argv[i], "--retained") == 0 && i + 1 < argc)
+        {
+            retained = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else
+        {
+            std::fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    try
+    {
+        HeapSnapshotReader reader(argv[1]);
+        unsigned long long frames = 0;
+        while (reader.next_frame())
+        {
+            frames++;
+            const SnapshotFrame &frame = reader.get_frame();
+            if (diffs)
+            {
+                std::cout << "Frame " << frame.number << " ("
+                          << (frame.mode == SnapshotMode::Full ? "full" : "diff") << "), heap size "
+                          << frame.heap_size << (frame.roots_written ? ", roots rewritten" : "") << "\n";
+                print_ids("removed", frame.removed);
+                print_ids("written", frame.written);
+            }
+            if (stop_frame >= 0 && frame.number == static_cast<uint64_t>(stop_frame))
+            {
+                break;
+            }
+        }
+
+        if (stop_frame >= 0 && (frames == 0 || reader.get_frame().number != static_cast<uint64_t>(stop_frame)))
+        {
+            std::fprintf(stderr, "Error: frame %lld not found (%llu complete frames)\n", stop_frame, frames);
+            return 1;
+        }
+        if (diffs)
+        {
+            std::cout << "\n";
+        }
+        if (retained > 0)
+        {
+            HeapImage image = reader.capture_image();
+            DominatorTree(image).dump(std::cout, retained);
+        }
+        else
+        {
+            reader.dump(std::cout);
+        }
+        std::fprintf(stderr, "%llu frames applied (%llu in header)\n", frames,
+                     static_cast<unsigned long long>(reader.get_frame_count()));
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
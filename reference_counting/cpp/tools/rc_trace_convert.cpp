@@ -0,0 +1,246 @@
+/**
+ * Конвертер сценариев и логов событий в бинарную трассу (binary_trace.h).
+ *
+ * Вход определяется по содержимому:
+ *   - JSON-сценарий (каталог scenarios/) — массив или поток объектов {"op": ...};
+ *   - лог событий logs/rc_events.log в JSON-строках ({"event": ...});
+ *   - бинарный лог событий (LogFormat::Binary).
+ * Из лога берутся только действия мутатора: allocate, add_ref и remove_ref
+ * (from = 0 — это add_root/remove_root). События delete и leak — следствия
+ * этих действий, при воспроизведении они возникают сами. Удаления, которые
+ * сделали сборщики циклов или трассировщик, в трассу не попадают.
+ * Слабых ссылок в трассе нет: события add_weak_ref, remove_weak_ref
+ * и weak_expire пропускаются.
+ *
+ * Сборка (из каталога cpp/):
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target rc_trace_convert
+ * Запуск:
+ *   build/rc_trace_convert [--varint] <input> <output.rctr>
+ */
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+
+#include "binary_trace.h"
+#include "log_sink.h"
+#include "scenario_reader.h"
+
+namespace
+{
+    enum class InputFormat
+    {
+        Scenario,
+        JsonEventLog,
+        BinaryEventLog
+    };
+
+    InputFormat detect_format(const std::string &path)
+    {
+        std::FILE *file = std::fopen(path.c_str(), "rb");
+        if (file == nullptr)
+        {
+            throw std::runtime_error("Failed to open input: " + path);
+        }
+        char head[4096];
+        size_t size = std::fread(head, 1, sizeof(head) - 1, file);
+        std::fclose(file);
+        head[size] = '\0';
+
+        if (size >= 4 && std::memcmp(head, "RCEV", 4) == 0)
+        {
+            return InputFormat::BinaryEventLog;
+        }
+        // Первый объект: сценарий содержит "op", лог событий — "event"
+        const char *object = std::strchr(head, '{');
+        const char *event = std::strstr(head, "\"event\"");
+        const char *op = std::strstr(head, "\"op\"");
+        if (object != nullptr && event != nullptr && (op == nullptr || event < op))
+        {
+            return InputFormat::JsonEventLog;
+        }
+        return InputFormat::Scenario;
+    }
+
+    /**
+     * Действие мутатора из события лога; false — событие не воспроизводится
+     */
+    bool event_to_op(EventType type, int from, int to, ScenarioOp &op)
+    {
+        switch (type)
+        {
+        case EventType::Allocate:
+            op = ScenarioOp(OpCode::Allocate, from);
+            return true;
+        case EventType::AddRef:
+            op = from == 0 ? ScenarioOp(OpCode::AddRoot, to) : ScenarioOp(OpCode::AddRef, -1, from, to);
+            return true;
+        case EventType::RemoveRef:
+            op = from == 0 ? ScenarioOp(OpCode::RemoveRoot, to) : ScenarioOp(OpCode::RemoveRef, -1, from, to);
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool find_int(const char *line, const char *key, int &value)
+    {
+        const char *p = std::strstr(line, key);
+        if (p == nullptr)
+        {
+            return false;
+        }
+        p += std::strlen(key);
+        while (*p == ' ' || *p == ':')
+        {
+            p++;
+        }
+        char *end;
+        long parsed = std::strtol(p, &end, 10);
+        if (end == p)
+        {
+            return false;
+        }
+        value = static_cast<int>(parsed);
+        return true;
+    }
+
+    bool parse_event_line(const char *line, EventType &type, int &from, int &to)
+    {
+        const char *p = std::strstr(line, "\"event\"");
+        if (p == nullptr || (p = std::strchr(p + 7, '"')) == nullptr)
+        {
+            return false;
+        }
+        p++;
+        size_t len = std::strcspn(p, "\"");
+        std::string name(p, len);
+        from = to = -1;
+        if (name == "allocate" || name == "delete" || name == "leak")
+        {
+            type = name == "allocate" ? EventType::Allocate : name == "delete" ? EventType::Delete : EventType::Leak;
+            return find_int(line, "\"object\"", from);
+        }
+        if (name == "add_ref" || name == "remove_ref")
+        {
+            type = name == "add_ref" ? EventType::AddRef : EventType::RemoveRef;
+            return find_int(line, "\"from\"", from) && find_int(line, "\"to\"", to);
+        }
+        if (name == "add_weak_ref" || name == "remove_weak_ref" || name == "weak_expire")
+        {
+            type = name == "add_weak_ref"      ? EventType::AddWeakRef
+                   : name == "remove_weak_ref" ? EventType::RemoveWeakRef
+                                               : EventType::WeakExpire;
+            return true;
+        }
+        return false;
+    }
+
+    uint64_t convert_json_log(const std::string &path, BinaryTraceWriter &writer)
+    {
+        std::FILE *in = std::fopen(path.c_str(), "r");
+        if (in == nullptr)
+        {
+            throw std::runtime_error("Failed to open input: " + path);
+        }
+        char line[1024];
+        unsigned long long line_no = 0;
+        uint64_t skipped = 0;
+        ScenarioOp op;
+        while (std::fgets(line, sizeof(line), in) != nullptr)
+        {
+            line_no++;
+            EventType type;
+            int from, to;
+            if (!parse_event_line(line, type, from, to))
+            {
+                bool blank = true;
+                for (const char *c = line; *c != '\0'; ++c)
+                {
+                    blank = blank && std::isspace(static_cast<unsigned char>(*c));
+                }
+                if (!blank)
+                {
+                    std::fprintf(stderr, "Warning: %s:%llu: unrecognised event skipped\n", path.c_str(), line_no);
+                    skipped++;
+                }
+                continue;
+            }
+            if (event_to_op(type, from, to, op))
+            {
+                writer.write(op);
+            }
+        }
+        std::fclose(in);
+        return skipped;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bool varint = false;
+    int arg = 1;
+    if (arg < argc && std::strcmp(argv[arg], "--varint") == 0)
+    {
+        varint = true;
+        arg++;
+    }
+    if (argc - arg != 2)
+    {
+        std::fprintf(stderr, "Usage: %s [--varint] <scenario.json | rc_events.log> <output.rctr>\n", argv[0]);
+        return 2;
+    }
+    const std::string input = argv[arg];
+    const std::string output = argv[arg + 1];
+
+    try
+    {
+        InputFormat format = detect_format(input);
+        BinaryTraceWriter writer(output, varint);
+        uint64_t skipped = 0;
+        ScenarioOp op;
+
+        if (format == InputFormat::Scenario)
+        {
+            ScenarioReader reader(input);
+            while (reader.next(op))
+            {
+                writer.write(op);
+            }
+            skipped = reader.skipped();
+        }
+        else if (format == InputFormat::JsonEventLog)
+        {
+            skipped = convert_json_log(input, writer);
+        }
+        else
+        {
+            BinaryLogReader reader(input);
+            LogRecord record;
+            while (reader.next(record))
+            {
+                if (event_to_op(record.type, record.from, record.to, op))
+                {
+                    writer.write(op);
+                }
+            }
+        }
+
+        writer.close();
+        std::fprintf(stderr, "%llu ops written%s", static_cast<unsigned long long>(writer.get_op_count()),
+                     varint ? " (varint)" : "");
+        if (skipped > 0)
+        {
+            std::fprintf(stderr, ", %llu skipped", static_cast<unsigned long long>(skipped));
+        }
+        std::fprintf(stderr, "\n");
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}